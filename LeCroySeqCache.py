@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Reader for the columnar cache (<file>.col) that seqtran -c builds from a
+SCSI sequence capture; see from_LeCroy/seqtran/seq_col.c for the layout.
+
+The raw samples of every plugin/channel are returned as numpy memmaps of
+shape (segments, samples), so a selection or analysis only touches the
+segments and channels it uses and never parses the packets again.
+"""
+
+import struct
+import sys
+import numpy as np
+
+MAX_PLUGINS = 2
+MAX_CHANNELS = 4
+
+TS_DTYPE = np.dtype([('umw', '<u2'), ('ulw', '<u2'), ('lmw', '<u2'), ('llw', '<u2')])
+
+# magic, block size, file size (lo, hi), segment offset (lo, hi)
+FILE_HDR = '<4sI2I2I'
+# num_segs ... end_last, desc/time/flash/fine positions, data positions
+PLUGIN_HDR = '<7l' + '2I' * 4 + '2I' * MAX_CHANNELS
+
+
+def _offset(lo, hi):
+    return lo + (hi << 32)
+
+
+def read_seq_cache(filename):
+
+    ret = {}
+
+    with open(filename, 'rb') as f:
+        head = f.read(struct.calcsize(FILE_HDR))
+        magic, block_size, fs_lo, fs_hi, so_lo, so_hi = struct.unpack(FILE_HDR, head)
+        if magic != b'SQCC':
+            print("ERROR: " + filename + " is not a seqtran columnar cache")
+            return ret
+
+        ret['block_size'] = block_size
+        ret['file_size'] = _offset(fs_lo, fs_hi)
+        ret['seg_offset'] = _offset(so_lo, so_hi)
+
+        plugins = []
+        for p in range(MAX_PLUGINS):
+            plugins.append(struct.unpack(PLUGIN_HDR, f.read(struct.calcsize(PLUGIN_HDR))))
+
+        for p in range(MAX_PLUGINS):
+            h = plugins[p]
+            num_segs, num_chan, array_size, desc_size, coeff_size = h[0:5]
+            if num_chan == 0:
+                continue
+
+            pos = [_offset(h[7 + 2*i], h[8 + 2*i]) for i in range(4 + MAX_CHANNELS)]
+            desc_pos, time_pos, flash_pos, fine_pos = pos[0:4]
+
+            plugin = {}
+            plugin['num_segs'] = num_segs
+
+            # descriptors (WAVEDESC) and filter coefficients as in the capture
+            plugin['descriptors'] = []
+            plugin['coefficients'] = []
+            f.seek(desc_pos)
+            for c in range(num_chan):
+                plugin['descriptors'].append(f.read(desc_size))
+                plugin['coefficients'].append(_read_coefficients(f.read(coeff_size)))
+
+            ts = np.memmap(filename, dtype=TS_DTYPE, mode='r', offset=time_pos, shape=(num_segs,)) \
+                if num_segs > 0 else np.zeros(0, TS_DTYPE)
+            plugin['time_stamp'] = ((ts['umw'].astype(np.float64) * 65536.0 + ts['ulw']) * 4294967296.0
+                                    + (ts['lmw'].astype(np.float64) * 65536.0 + ts['llw']))
+            plugin['last_flash'] = _column(filename, '<u2', flash_pos, (num_segs,))
+            plugin['fine_count'] = _column(filename, '<u2', fine_pos, (num_segs,))
+
+            # raw 8-bit samples, one row per segment
+            plugin['data'] = []
+            for c in range(num_chan):
+                plugin['data'].append(_column(filename, 'i1', pos[4 + c], (num_segs, array_size)))
+
+            ret['ABCD'[p]] = plugin
+
+    return ret
+
+
+def _column(filename, dtype, offset, shape):
+    if shape[0] == 0:
+        return np.zeros(shape, dtype)
+    return np.memmap(filename, dtype=dtype, mode='r', offset=offset, shape=shape)
+
+
+def _read_coefficients(buf):
+    # num filters, then per filter: num coefficients, coefficients;
+    # 9 filters means 8 flash filters followed by the 63-tap 7291 filter
+    ret = {'flash': [], 'p7291': []}
+    if len(buf) < 2:
+        return ret
+    words = struct.unpack('<' + str(len(buf) // 2) + 'h', buf[:len(buf) // 2 * 2])
+    num_filters = words[0]
+    i = 1
+    for n in range(8 if num_filters == 9 else num_filters):
+        num_coeffs = words[i]
+        ret['flash'].append(list(words[i + 1:i + 1 + num_coeffs]))
+        i += 1 + num_coeffs
+    if num_filters == 9:
+        num_coeffs = words[i]
+        ret['p7291'] = list(words[i + 1:i + 1 + num_coeffs])
+    return ret
+
+
+if __name__ == '__main__':
+
+    cache = read_seq_cache(sys.argv[1])
+    for name in 'AB':
+        if name not in cache:
+            continue
+        plugin = cache[name]
+        print("Plugin " + name + ": " + str(plugin['num_segs']) + " segments")
+        for c, data in enumerate(plugin['data']):
+            print("  " + name + str(c + 1) + ": " + str(data.shape[1]) + " samples/segment, "
+                  + str(len(plugin['coefficients'][c]['flash'])) + " flash filters")
@@ -30,9 +30,6 @@ extern VOID seq_print_usage();
 extern INT  compare_seg();
 extern INT  compare_time();
 
-BYTE plugin_field;
-BYTE channel_field[MAX_PLUGINS];
-
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
 
 CHAR *RIS_process_arguments(num_args, arguments)
@@ -61,13 +58,22 @@ char *arguments[];
     WORD max_chan;
     CHAR option[32];
 
-    static CHAR filename[80];
+    CHAR *filename;
+
+    /* The name is kept in the context */
+    filename = SEQ_ctxP->filename;
 
     /* Set default values */
     SEQ_options.packed = TRUE;
     SEQ_options.debug = FALSE;
     SEQ_options.test_mode = FALSE;
     SEQ_options.print_times = FALSE;
+    SEQ_options.build_index = FALSE;
+    SEQ_options.stream = FALSE;
+    SEQ_options.follow = 0;
+    SEQ_options.resume = FALSE;
+    SEQ_options.build_cache = FALSE;
+    SEQ_options.kernels = SEQ_KERNEL_AUTO;
     SEQ_options.output.type = SEQ_OUTPUT_SCREEN;
     SEQ_options.output.format = SEQ_SCREEN_OUTPUT_1;
     SEQ_options.format = SEQ_FORMAT_COMPENSATED;
@@ -371,6 +377,11 @@ char *arguments[];
 	    }
 	}
 
+        else if (!strncmp(arguments[i], "-i", 2)) /* build packet index */
+	{
+	    SEQ_options.build_index = TRUE;
+	}
+
         else if (!strncmp(arguments[i], "-v", 2)) /* select verbose mode */
 	{
 	    if (arguments[i][2] == '1')
@@ -471,6 +482,8 @@ static void seq_print_usage()
       -o1 = print data only in ASCII to the screen in 1 column\n\
       -o2 = print time,data in ASCII to the screen in 2 columns\n");
     printf("\
+-i  = Build packet index <file>.idx for faster seeks        (default = off)\n\
+      (an existing, up to date index is always used)\n\
 -v  = Verbose mode: print progress                          (default = off)\n");
 }
 
@@ -42,28 +42,33 @@ BOOL SEQ_Read_Blocks_Desc(FILE *seq_fP, BYTE *bufferP, CHAR plugin,
 						LONG size, LONG offset);
 VOID RIS_output_wave(BYTE plugin, INT chan);
 VOID RIS_interpret(FILE *seq_fP, BYTE action);
+BOOL SEQ_Map_Open(FILE *seq_fP);
+VOID SEQ_Map_Close(FILE *seq_fP);
+size_t SEQ_Map_Read(VOID *bufP, size_t size, size_t num, FILE *seq_fP);
+INT SEQ_Map_Seek(FILE *seq_fP, SEQ_OFFSET offset, INT origin);
+LONG SEQ_Map_Read_Blocks(FILE *seq_fP, BYTE *bufferP, LONG max_blocks,
+					INT plugin_mask, UWORD *iP);
+BOOL SEQ_Index_Open(FILE *seq_fP, CHAR *seq_filenameP, INT build);
+VOID SEQ_Index_Close(VOID);
+BOOL SEQ_Index_Read_Seg(FILE *seq_fP, SEQ_ACQ_DATA *dataP, INT read,
+							BOOL *statusP);
+BOOL SEQ_Index_Read_Desc(FILE *seq_fP, BYTE *bufferP, INT plugin,
+				LONG size, LONG offset, BOOL *statusP);
+BOOL SEQ_Dmx_Open(FILE *seq_fP);
+VOID SEQ_Dmx_Close(VOID);
+VOID SEQ_Dmx_Skip(FILE *seq_fP, INT packet, INT plugin);
+BOOL SEQ_Dmx_Read_Seg(FILE *seq_fP, SEQ_ACQ_DATA *dataP, INT read,
+							BOOL *statusP);
 
 /* -------------------------------------------------------------------- */
 
 #define MAX_TIME 3
 
-/* Global Variables. */
+/* Global Variables. The rest of the translator's variables are in the
+   current context (seq_ctx.c). */
 
-struct PCW_BLOCK    *PCW_blockP[MAX_PLUGINS][MAX_CHANNELS];
-BYTE   		    *PCW_waveformP[MAX_PLUGINS][MAX_CHANNELS];
 struct PCW_TEMPLATE *PCW_templateP = NULL;
 
-struct SEQ_OPTIONS  SEQ_options;
-struct SEQ_PARAMS   SEQ_params;
-
-WORD SEQ_desc_size;    /* size in BYTEs of the waveform descriptor */
-FILE *out_fP = NULL;
-
-/* -------------------------------------------------------------------- */
-
-/* Memory allocation for waveform descriptors */
-BYTE PCW_Waveform[MAX_PLUGINS][MAX_CHANNELS][800];
-
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
 
 VOID main(ac, av)
@@ -103,6 +108,10 @@ VOID main(ac, av)
 	fprintf(stderr, 
   "LeCroy 7200A SCSI Ris Data Translator (Version 1.1, Dec 22, 1993).\n");
 
+    /* Make the context to translate in */
+	if ((SEQ_ctxP = SEQ_Context_New()) == NULL)
+	    error_handler(OUT_OF_MEMORY);
+
     /* Process all the arguments to this routine */
 	seq_filenameP = RIS_process_arguments(ac, &av[0]);
 
@@ -113,12 +122,22 @@ VOID main(ac, av)
 	    EXIT
 	}
 
+    /* Map the data file into memory when the host supports it */
+	(VOID)SEQ_Map_Open(seq_fP);
+
     /* initialize the acquisition parameters in descriptor */
 	RIS_interpret(seq_fP, SEQ_INIT_PARAMETERS);
 
+    /* Use (or build) the packet index of the data file */
+	(VOID)SEQ_Index_Open(seq_fP, seq_filenameP,
+					(INT)SEQ_options.build_index);
+
     /* initialize the descriptor for all channels */
 	RIS_interpret(seq_fP, SEQ_READ_DESCRIPTOR);
 
+    /* Collect plugin B's blocks while plugin A is translated */
+	(VOID)SEQ_Dmx_Open(seq_fP);
+
     /* If the acquisition parameters should be displayed, print them out */
 	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
 	{
@@ -137,6 +156,9 @@ VOID main(ac, av)
 	RIS_interpret(seq_fP, SEQ_READ_SEGMENT_NUMBER);
 
     /* Close the file before ending program */
+	SEQ_Dmx_Close();
+	SEQ_Index_Close();
+	SEQ_Map_Close(seq_fP);
 	fclose(seq_fP);
 
     exit (0);
@@ -162,9 +184,6 @@ VOID RIS_interpret(FILE *seq_fP, BYTE action)
 --------------------------------------------------------------------------*/
 {   /* RIS_interpret() */
 
-extern BYTE plugin_field;
-extern BYTE channel_field[MAX_PLUGINS];
-
     INT   num_read;
     UWORD packet;
     UWORD num_chan;
@@ -173,7 +192,7 @@ extern BYTE channel_field[MAX_PLUGINS];
     UWORD other_plugin;
     BYTE  p,c;
     UWORD plugin;
-    WORD  search_size;
+    LONG  search_size;
     SEGS  *segP;
 
     if (action == SEQ_INIT_PARAMETERS)
@@ -190,9 +209,9 @@ extern BYTE channel_field[MAX_PLUGINS];
 	 ****************************************************************/
 
 	/* Initialize block size, plugins present, chan/plugin, descriptors */
-	fseek(seq_fP,0L,SEEK_SET);
+	SEQ_Map_Seek(seq_fP,0L,SEEK_SET);
 
-	num_read = fread((CHAR *)&packet,sizeof(UWORD),1,seq_fP);
+	num_read = SEQ_Map_Read((CHAR *)&packet,sizeof(UWORD),1,seq_fP);
 
 	if ((packet & 0x7fff) != 0)
 	{
@@ -215,10 +234,11 @@ extern BYTE channel_field[MAX_PLUGINS];
 	}
 
 	/* Read the block size */
-	num_read = fread((CHAR *)&SEQ_params.block_size,sizeof(ULONG),1,seq_fP);
+	num_read = SEQ_Map_Read((CHAR *)&SEQ_params.block_size,sizeof(ULONG),
+								1,seq_fP);
 
 	/* Read the number of channels and allocate buffers for them */
-	num_read = fread((CHAR *)&num_chan, sizeof(UWORD),1,seq_fP);
+	num_read = SEQ_Map_Read((CHAR *)&num_chan, sizeof(UWORD),1,seq_fP);
 	SEQ_params.last_channel[plugin] = num_chan - 1;
 	SEQ_params.bins_filled = 0;
 	SEQ_params.last_packet[plugin] = FALSE;
@@ -245,13 +265,13 @@ extern BYTE channel_field[MAX_PLUGINS];
 	 * a max descriptor size, don't search beyond num_chan for
 	 * the other plugin.
 	 */
-	fseek(seq_fP, (LONG)sizeof(UWORD), SEEK_SET);
+	SEQ_Map_Seek(seq_fP, (LONG)sizeof(UWORD), SEEK_SET);
 	search_size = num_chan * 400;
 	while(search_size > 0)
 	{
-	    fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+	    SEQ_Map_Seek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
 	    search_size -= (SEQ_params.block_size-2);
-	    num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+	    num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 	    if (num_read == 0)
 		break;
 	    else if ((packet & 0x8000) == other_plugin)
@@ -262,10 +282,10 @@ extern BYTE channel_field[MAX_PLUGINS];
 		plugin = (other_plugin >> 15);
 
 		/* Skip over the block size (the same for both plugins) */
-		fseek(seq_fP, (LONG)sizeof(ULONG), SEEK_CUR);
+		SEQ_Map_Seek(seq_fP, (LONG)sizeof(ULONG), SEEK_CUR);
 
 		/* Read the number of channels for this plugin */
-		num_read = fread((CHAR *)&num_chan, sizeof(UWORD),1,seq_fP);
+		num_read = SEQ_Map_Read((CHAR *)&num_chan, sizeof(UWORD),1,seq_fP);
 		SEQ_params.last_channel[plugin] = num_chan - 1;
 		SEQ_params.last_packet[plugin] = FALSE;
 
@@ -692,7 +712,7 @@ VOID RIS_build_waveform(FILE *seq_fP, BYTE plugin)
     bin_numP = (UWORD *)(array1P + block_size - 2);
 
     /* Seek to the start of the segment information before scanning */
-    fseek(seq_fP, SEQ_params.seg_offset, SEEK_SET);
+    SEQ_Map_Seek(seq_fP, SEQ_params.seg_offset, SEEK_SET);
     acq_data.block_offset = 0;
     acq_data.byte_offset = 0;
     acq_data.plugin = plugin;
@@ -805,6 +825,17 @@ register LONG num_packets;
     LONG byte_skip;
     BYTE *bufferP;
     BYTE direction;
+    BOOL status;
+    LONG blocks;
+    UWORD last_i;
+
+    /* Go straight to the block if the file has a packet index */
+    if (SEQ_Index_Read_Seg(seq_fP, dataP, (INT)read, &status) == TRUE)
+	return (status);
+
+    /* Or use the blocks collected while another plugin was read */
+    if (SEQ_Dmx_Read_Seg(seq_fP, dataP, (INT)read, &status) == TRUE)
+	return (status);
 
     /* Setup the mask to determine which blocks are significant */
     plugin_mask = (dataP->plugin << 15);
@@ -815,7 +846,7 @@ register LONG num_packets;
     size = dataP->size;
     dataP->bytes_read = 0L;
     num_packets = 0;
-    num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+    num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 
     if (offset >= 0)
 	direction = 1;
@@ -844,7 +875,23 @@ register LONG num_packets;
 			++i;
 		    if ((packet & 0x7fff) != 0)
 			offset -= (SEQ_params.block_size-2);
-		    fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+		    SEQ_Map_Seek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+
+		    /* Skip the whole blocks that follow in one go */
+		    if ((offset >= (SEQ_params.block_size-2)) &&
+			(i != 0) && (i != 0x7fff) && (SEQ_options.debug != 1))
+		    {
+			last_i = (i == 1) ? 0x7ffe : i - 1;
+			blocks = SEQ_Map_Read_Blocks(seq_fP, (BYTE *)NULL,
+				offset / (LONG)(SEQ_params.block_size-2),
+				(INT)plugin_mask, &last_i);
+			if (blocks > 0)
+			{
+			    i = (last_i == 0x7ffe) ? 1 : last_i + 1;
+			    offset -= blocks * (SEQ_params.block_size-2);
+			    num_packets += blocks;
+			}
+		    }
 		}
 		else if ((packet & 0x7fff) != 0x7fff)  /* 7fff = last packet */
 		{
@@ -863,7 +910,7 @@ register LONG num_packets;
 			--i;
 		    if ((packet & 0x7fff) != 0)
 			offset += (SEQ_params.block_size-2);
-		    fseek(seq_fP, (LONG)(-SEQ_params.block_size-2), SEEK_CUR);
+		    SEQ_Map_Seek(seq_fP, (LONG)(-SEQ_params.block_size-2), SEEK_CUR);
 		}
 		else if ((packet & 0x7fff) != 0x7fff)  /* 7fff = last packet */
 		{
@@ -877,12 +924,12 @@ register LONG num_packets;
 	{
 	    /* skip over other plugin data to the next/previous block */
 	    if (direction > 0)
-		fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+		SEQ_Dmx_Skip(seq_fP, (INT)packet, (INT)dataP->plugin);
 	    else
-		fseek(seq_fP, (LONG)(-SEQ_params.block_size-2), SEEK_CUR);
+		SEQ_Map_Seek(seq_fP, (LONG)(-SEQ_params.block_size-2), SEEK_CUR);
 	}
 
-	num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+	num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 	if ((i == 0x7fff) && ((packet & 0x8000) == plugin_mask))
 	    i = packet & 0x7fff;
 	num_packets++;
@@ -897,7 +944,7 @@ register LONG num_packets;
       if (size > 0)
       {
 	/* Found block, now seek to offset within block */
-	fseek(seq_fP, (LONG)offset, SEEK_CUR);
+	SEQ_Map_Seek(seq_fP, (LONG)offset, SEEK_CUR);
 	bytes_remaining = (UWORD)(SEQ_params.block_size - 2 - offset);
 
 	while (size > 0)
@@ -909,12 +956,12 @@ register LONG num_packets;
 
 	    /* Read the bytes into the supplied buffer */
 	    if (read == TRUE)
-		num_read = fread((CHAR *)bufferP, sizeof(BYTE), 
+		num_read = SEQ_Map_Read((CHAR *)bufferP, sizeof(BYTE), 
 				    (size_t)count, seq_fP);
 	    else
 	    {
 		num_read = (LONG)count;
-		fseek(seq_fP, (LONG)count, SEEK_CUR);
+		SEQ_Map_Seek(seq_fP, (LONG)count, SEEK_CUR);
 	    }
 
 	    if (num_read != (UWORD)count)
@@ -932,21 +979,37 @@ register LONG num_packets;
 	    {
 		bufferP += count;
 
+		/* Take the whole blocks that follow in one go, leaving
+		   the last one to be read below */
+		last_i = i;
+		blocks = SEQ_Map_Read_Blocks(seq_fP,
+				(read == TRUE) ? bufferP : (BYTE *)NULL,
+				(size-1) / (LONG)(SEQ_params.block_size-2),
+				(INT)plugin_mask, &last_i);
+		if (blocks > 0)
+		{
+		    i = last_i;
+		    count = (UWORD)(SEQ_params.block_size - 2);
+		    size -= blocks * count;
+		    dataP->bytes_read += blocks * count;
+		    bufferP += blocks * count;
+		}
+
 		if (i == 0x7ffe)
 		    i = 1;	/* wrap */
 		else if (i != 0x7fff)
 		    ++i;
 
 		/* Read the beginning of the next block */
-		num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+		num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 		if (i == 0x7fff)
 		    i = packet & 0x7fff;
 
 		while ( ((packet & 0x8000) != plugin_mask) && (num_read != 0))
 		{
 		    /* skip to the next block */
-		    fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
-		    num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+		    SEQ_Dmx_Skip(seq_fP, (INT)packet, (INT)dataP->plugin);
+		    num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 		    num_packets++;
 		}
 
@@ -975,10 +1038,10 @@ register LONG num_packets;
 	} /* WHILE */
 
 	/* Seek back to the beginning of this block: offset+2 */
-	fseek(seq_fP, (LONG)(-offset-2), SEEK_CUR);
+	SEQ_Map_Seek(seq_fP, (LONG)(-offset-2), SEEK_CUR);
       }
       else
-	fseek(seq_fP, (LONG)(-2), SEEK_CUR);
+	SEQ_Map_Seek(seq_fP, (LONG)(-2), SEEK_CUR);
 
       /* Update the params so we know where we left off */
 	dataP->block_offset = offset;
@@ -992,7 +1055,7 @@ register LONG num_packets;
     {
 #ifndef RIS
 	printf("Could not find requested block in data file.\n");
-	fseek(seq_fP, SEQ_params.seg_offset, SEEK_SET);
+	SEQ_Map_Seek(seq_fP, SEQ_params.seg_offset, SEEK_SET);
 #endif /* RIS */
 	return (FALSE);
     }
@@ -1036,13 +1099,19 @@ BOOL SEQ_Read_Blocks_Desc(FILE *seq_fP, BYTE *bufferP, CHAR plugin,
     UWORD i;
     UWORD bytes_remaining;
     UWORD count;
+    BOOL  status;
+
+    /* Go straight to the block if the file has a packet index */
+    if (SEQ_Index_Read_Desc(seq_fP, bufferP, (INT)plugin, size, offset,
+							&status) == TRUE)
+	return (status);
 
     /* Setup the mask to determine which blocks are significant */
     plugin_mask = (plugin << 15);
 
     /* Advance to the nearest whole block before the required data */
-    fseek(seq_fP, 0L, SEEK_SET);
-    num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+    SEQ_Map_Seek(seq_fP, 0L, SEEK_SET);
+    num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 
     if (SEQ_options.debug == 1)
 	printf("Found packet 0x%04x...mask = 0x%04x\n", packet, plugin_mask);
@@ -1070,8 +1139,8 @@ BOOL SEQ_Read_Blocks_Desc(FILE *seq_fP, BYTE *bufferP, CHAR plugin,
 	}
 
 	/* skip to the next block */
-	fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
-	num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+	SEQ_Map_Seek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+	num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 
 	if (SEQ_options.debug == 1)
 	    printf("Found packet 0x%04x...offset = %ld\n", packet,offset);
@@ -1081,7 +1150,7 @@ BOOL SEQ_Read_Blocks_Desc(FILE *seq_fP, BYTE *bufferP, CHAR plugin,
     if (num_read != 0)
     {
 	/* Found block, now seek to offset within block */
-	fseek(seq_fP, (LONG)offset, SEEK_CUR);
+	SEQ_Map_Seek(seq_fP, (LONG)offset, SEEK_CUR);
 	bytes_remaining = (UWORD)(SEQ_params.block_size - 2 - offset);
 
 	while (size > 0)
@@ -1091,7 +1160,7 @@ BOOL SEQ_Read_Blocks_Desc(FILE *seq_fP, BYTE *bufferP, CHAR plugin,
 	    else
 		count = bytes_remaining;
 
-	    num_read = fread((CHAR *)bufferP, sizeof(BYTE), 
+	    num_read = SEQ_Map_Read((CHAR *)bufferP, sizeof(BYTE), 
 				    (size_t)count, seq_fP);
 
 	    if (num_read != (UWORD)count)
@@ -1112,13 +1181,13 @@ BOOL SEQ_Read_Blocks_Desc(FILE *seq_fP, BYTE *bufferP, CHAR plugin,
 	    if (size > 0)
 	    {
 		/* Read the beginning of the next block */
-		num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+		num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 
 		while ( ((packet & 0x8000) != plugin_mask) && (num_read != 0))
 		{
 		    /* skip to the next block */
-		    fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
-		    num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+		    SEQ_Map_Seek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+		    num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 		}
 
 		if (num_read == 0)
@@ -1195,7 +1264,7 @@ VOID RIS_output_wave(BYTE plugin, INT chan)
     {
 	/* write the descriptor to a created file */
 	sprintf(filename, "trace_%c%d.000", plugin+'a', chan+1);
-	if ((out_fP = fopen(filename,"wb")) == NULL)
+	if ((SEQ_ctxP->out_fP = fopen(filename,"wb")) == NULL)
 	{
 	    printf("Could not open file %s for writing.\n", filename);
 	    EXIT
@@ -1208,14 +1277,17 @@ VOID RIS_output_wave(BYTE plugin, INT chan)
 
 	/* Write the corrected descriptor to a file */
 	fwrite(PCW_Waveform[plugin][chan], sizeof(BYTE),
-					    (size_t)SEQ_desc_size, out_fP);
+					    (size_t)SEQ_desc_size,
+					    SEQ_ctxP->out_fP);
 
 	/* write the data*/
 	fwrite(SEQ_params.waveP[plugin][chan], sizeof(WORD),
-					    (size_t)NUM_PTS_WAVE, out_fP);
+					    (size_t)NUM_PTS_WAVE,
+					    SEQ_ctxP->out_fP);
 
 	/* close file */
-	fclose(out_fP);
+	fclose(SEQ_ctxP->out_fP);
+	SEQ_ctxP->out_fP = NULL;
     }
     else  /* SEQ_OUTPUT_SCREEN */
     {
@@ -0,0 +1,332 @@
+/************************** seq_ahd.c **************************************
+
+Read-ahead of the raw data of long segments.
+
+A segment longer than MAX_BUF_SIZE points is translated a piece at a time:
+SEQ_Process_Seg() reads a piece with SEQ_Read_Blocks_Seg(), filters it and
+SEQ_Output_Seg() writes it out before the next piece is read, so reading
+and filtering never overlap.
+
+When compiled with SEQ_THREADS defined (POSIX threads only), a reader
+thread is started for every channel of a translated segment that takes
+more than one piece. It reads the pieces, in the same sizes and order as
+the translation loop would, into three buffers of its own while the main
+thread filters and writes the previous ones. SEQ_Process_Seg() then takes
+each piece from these buffers instead of reading the file.
+
+While the reader runs it is the only one to use the data file, the
+block readers and everything behind them (packet index, demultiplexer).
+It works in the context of the thread that started it (seq_ctx.c).
+Without SEQ_THREADS every call does nothing and the pieces are read as
+before.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "seq_tran.h"
+
+#ifdef SEQ_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif /* SEQ_THREADS */
+
+/* -------------------------------------------------------------------- */
+
+extern BOOL   SEQ_Read_Blocks_Seg();
+
+#ifdef SEQ_THREADS
+
+#define SEQ_AHEAD_SLOTS	3
+
+typedef struct SEQ_AHEAD_SLOT
+{
+    BYTE  *bufP;		/* MAX_BUF_SIZE BYTEs */
+    LONG  size;			/* BYTEs read into bufP */
+    LONG  bytes_read;		/* as returned by SEQ_Read_Blocks_Seg() */
+    LONG  block_offset;		/* position after reading this piece */
+    BOOL  status;		/* returned by SEQ_Read_Blocks_Seg() */
+    BOOL  full;			/* TRUE until taken by SEQ_Ahead_Get() */
+} SEQ_AHEAD_SLOT;
+
+typedef struct SEQ_AHEAD
+{
+    SEQ_CONTEXT *ctxP;		/* context the reader works for */
+    FILE  *seq_fP;
+    SEQ_ACQ_DATA data;		/* the reader's copy of the position */
+    LONG  left;			/* BYTEs the reader has still to read */
+    LONG  first;		/* size of the first piece */
+    INT   get;			/* slot SEQ_Ahead_Get() takes next */
+    BOOL  stop;			/* tells the reader to finish */
+    SEQ_AHEAD_SLOT slot[SEQ_AHEAD_SLOTS];
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+} SEQ_AHEAD;
+
+static VOID *seq_ahead_reader();
+
+#endif /* SEQ_THREADS */
+
+/* State of the module in the current context (seq_ctx.c) */
+typedef struct SEQ_AHD_STATE
+{
+#ifdef SEQ_THREADS
+    SEQ_AHEAD ahead;
+#endif /* SEQ_THREADS */
+    BOOL      running;
+} SEQ_AHD_STATE;
+
+#define seq_ahead	  (SEQ_MODULE(SEQ_MOD_AHEAD, SEQ_AHD_STATE)->ahead)
+#define seq_ahead_running (SEQ_MODULE(SEQ_MOD_AHEAD, SEQ_AHD_STATE)->running)
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Ahead_Start(seq_fP, acq_dataP, total)
+  FILE          *seq_fP;
+  SEQ_ACQ_DATA  *acq_dataP;
+  LONG          total;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Start reading the pieces of a channel's data ahead of the
+		translation loop.
+
+    Inputs: seq_fP    = FILE pointer to the opened data file
+	    acq_dataP = position and size of the first piece, as it would
+			be passed to SEQ_Process_Seg()
+	    total     = BYTEs of data in the channel
+
+    Outputs: TRUE if a reader thread was started; SEQ_Process_Seg() then
+		gets every piece from SEQ_Ahead_Get() and SEQ_Ahead_Stop()
+		must be called when the channel is done.
+
+    Machine dependencies: Needs POSIX threads and SEQ_THREADS.
+
+    Notes: Not used with debug output (-v), which the block readers
+	   would print from the reader thread, nor on a single processor,
+	   where reading and filtering cannot overlap.
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Ahead_Start() */
+
+#ifdef SEQ_THREADS
+    INT n;
+
+    if ((seq_ahead_running == TRUE) || (SEQ_options.debug == 1) ||
+	(acq_dataP->size <= 0) || (total <= acq_dataP->size) ||
+	(sysconf(_SC_NPROCESSORS_ONLN) < 2))
+	return (FALSE);
+
+    for (n=0; n < SEQ_AHEAD_SLOTS; ++n)
+    {
+	seq_ahead.slot[n].bufP = (BYTE *)malloc((size_t)MAX_BUF_SIZE);
+	seq_ahead.slot[n].full = FALSE;
+	if (seq_ahead.slot[n].bufP == NULL)
+	{
+	    while (--n >= 0)
+		free(seq_ahead.slot[n].bufP);
+	    return (FALSE);
+	}
+    }
+
+    seq_ahead.ctxP = SEQ_ctxP;
+    seq_ahead.seq_fP = seq_fP;
+    seq_ahead.data = *acq_dataP;
+    seq_ahead.left = total;
+    seq_ahead.first = acq_dataP->size;
+    seq_ahead.get = 0;
+    seq_ahead.stop = FALSE;
+
+    pthread_mutex_init(&seq_ahead.lock, NULL);
+    pthread_cond_init(&seq_ahead.cond, NULL);
+    if (pthread_create(&seq_ahead.thread, NULL, seq_ahead_reader,
+						(VOID *)&seq_ahead) != 0)
+    {
+	pthread_cond_destroy(&seq_ahead.cond);
+	pthread_mutex_destroy(&seq_ahead.lock);
+	for (n=0; n < SEQ_AHEAD_SLOTS; ++n)
+	    free(seq_ahead.slot[n].bufP);
+	return (FALSE);
+    }
+
+    seq_ahead_running = TRUE;
+    return (TRUE);
+#else
+    return (FALSE);
+#endif /* SEQ_THREADS */
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Ahead_Get(acq_dataP, statusP)
+  SEQ_ACQ_DATA  *acq_dataP;
+  BOOL          *statusP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Read_Blocks_Seg() for SEQ_Process_Seg() while the reader
+		thread is running.
+
+    Inputs: acq_dataP = as for SEQ_Read_Blocks_Seg(); size must be that
+			of the next piece
+
+    Outputs: TRUE if the piece was taken from the reader; *statusP is then
+		what SEQ_Read_Blocks_Seg() returned for it.
+	     FALSE if no reader is running.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Ahead_Get() */
+
+#ifdef SEQ_THREADS
+    SEQ_AHEAD_SLOT *slotP;
+
+    if (seq_ahead_running == FALSE)
+	return (FALSE);
+
+    slotP = &seq_ahead.slot[seq_ahead.get];
+
+    pthread_mutex_lock(&seq_ahead.lock);
+    while (slotP->full == FALSE)
+	pthread_cond_wait(&seq_ahead.cond, &seq_ahead.lock);
+    pthread_mutex_unlock(&seq_ahead.lock);
+
+    if (slotP->size != acq_dataP->size)
+    {
+	printf("Read-ahead expected %ld bytes, got %ld\n",
+					    acq_dataP->size, slotP->size);
+	EXIT
+    }
+
+    memcpy((VOID *)acq_dataP->bufP, (VOID *)slotP->bufP,
+					    (size_t)slotP->bytes_read);
+    acq_dataP->bytes_read = slotP->bytes_read;
+    acq_dataP->block_offset = slotP->block_offset;
+    *statusP = slotP->status;
+
+    pthread_mutex_lock(&seq_ahead.lock);
+    slotP->full = FALSE;
+    pthread_cond_broadcast(&seq_ahead.cond);
+    pthread_mutex_unlock(&seq_ahead.lock);
+
+    seq_ahead.get = (seq_ahead.get + 1) % SEQ_AHEAD_SLOTS;
+    return (TRUE);
+#else
+    return (FALSE);
+#endif /* SEQ_THREADS */
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Ahead_Stop()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Wait for the reader thread to finish and release its buffers.
+
+    Notes: If the translation loop stopped before taking every piece the
+	   file has been read further than the loop knows; the loop only
+	   stops early on an error, after which nothing more is read.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Ahead_Stop() */
+
+#ifdef SEQ_THREADS
+    INT n;
+
+    if (seq_ahead_running == FALSE)
+	return;
+
+    pthread_mutex_lock(&seq_ahead.lock);
+    seq_ahead.stop = TRUE;
+    pthread_cond_broadcast(&seq_ahead.cond);
+    pthread_mutex_unlock(&seq_ahead.lock);
+
+    pthread_join(seq_ahead.thread, NULL);
+    pthread_cond_destroy(&seq_ahead.cond);
+    pthread_mutex_destroy(&seq_ahead.lock);
+
+    for (n=0; n < SEQ_AHEAD_SLOTS; ++n)
+	free(seq_ahead.slot[n].bufP);
+
+    seq_ahead_running = FALSE;
+#endif /* SEQ_THREADS */
+}
+
+#ifdef SEQ_THREADS
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID *seq_ahead_reader(argP)
+  VOID  *argP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Reader thread: read the pieces of the channel one after the
+		other into the free slots.
+
+    Notes: The pieces are MAX_BUF_SIZE BYTEs except for the first one,
+	   whose size is given, and the last one, which takes the rest;
+	   this is how SEQ_Read_Segment_Number() asks for them.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_ahead_reader() */
+
+    SEQ_AHEAD      *aheadP;
+    SEQ_AHEAD_SLOT *slotP;
+    LONG size;
+    BOOL status;
+    BOOL stop;
+    INT  n;
+
+    aheadP = (SEQ_AHEAD *)argP;
+    SEQ_ctxP = aheadP->ctxP;
+    n = 0;
+    size = aheadP->first;
+    while (aheadP->left > 0)
+    {
+	if (size > aheadP->left)
+	    size = aheadP->left;
+
+	slotP = &aheadP->slot[n];
+	pthread_mutex_lock(&aheadP->lock);
+	while ((slotP->full == TRUE) && (aheadP->stop == FALSE))
+	    pthread_cond_wait(&aheadP->cond, &aheadP->lock);
+	stop = aheadP->stop;
+	pthread_mutex_unlock(&aheadP->lock);
+	if (stop == TRUE)
+	    break;
+
+	aheadP->data.bufP = slotP->bufP;
+	aheadP->data.size = size;
+	status = SEQ_Read_Blocks_Seg(aheadP->seq_fP, &aheadP->data, TRUE);
+
+	pthread_mutex_lock(&aheadP->lock);
+	slotP->size = size;
+	slotP->bytes_read = aheadP->data.bytes_read;
+	slotP->block_offset = aheadP->data.block_offset;
+	slotP->status = status;
+	slotP->full = TRUE;
+	pthread_cond_broadcast(&aheadP->cond);
+	pthread_mutex_unlock(&aheadP->lock);
+
+	if (status == FALSE)
+	    break;
+
+	aheadP->left -= size;
+	size = MAX_BUF_SIZE;
+	n = (n + 1) % SEQ_AHEAD_SLOTS;
+    }
+
+    return (NULL);
+}
+
+#endif /* SEQ_THREADS */
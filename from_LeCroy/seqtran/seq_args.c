@@ -27,12 +27,10 @@ Author: Christopher Eck		LeCroy Corporation
 /* -------------------------------------------------------------------- */
 
 extern VOID seq_print_usage();
+extern VOID SEQ_default_options();
 extern INT  compare_seg();
 extern INT  compare_time();
 
-BYTE plugin_field;
-BYTE channel_field[MAX_PLUGINS];
-
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
 
 CHAR *SEQ_process_arguments(num_args, arguments)
@@ -91,37 +89,21 @@ Dim 4     :       : ....  :       :        :       : .....  :       :
     CHAR option[32];
     BOOL no_segs;
 
-    static CHAR filename[80];
+    CHAR *filename;
+
+    /* The name is kept in the context */
+    filename = SEQ_ctxP->filename;
 
     /* Set default values */
-    SEQ_options.debug = FALSE;
-    SEQ_options.print_coeffs = FALSE;
-    SEQ_options.test_mode = FALSE;
-    SEQ_options.print_times = FALSE;
-    SEQ_options.output.type = SEQ_OUTPUT_SCREEN;
-    SEQ_options.output.format = SEQ_SCREEN_OUTPUT_1;
-    SEQ_options.format = SEQ_FORMAT_COMPENSATED;
-    strcpy (SEQ_options.prt_fmt, "%g");
+    SEQ_default_options();
     no_segs = TRUE;
-    plugin_field = 0;
 
     for (p=0; p < MAX_PLUGINS; ++p)
     {
-	channel_field[p] = 0;
 	for (c=0; c < MAX_CHANNELS; ++c)
 	{
-	    SEQ_options.all_segs[p][c] = FALSE;
-	    SEQ_options.print_params[p][c] = FALSE;
-	    t = SEQ_SEGNO;
-	    index[p][c][t] = 0;
-	    segP = SEQ_options.seg[p][c][t];
-	    segP->select.n.start = -1L;
-	    segP->select.n.end = -1L;
-	    t = SEQ_TIME;
-	    index[p][c][t] = 0;
-	    segP = SEQ_options.seg[p][c][t];
-	    segP->select.t.start = (DOUBLE)-1;
-	    segP->select.t.end = (DOUBLE)-1;
+	    index[p][c][SEQ_SEGNO] = 0;
+	    index[p][c][SEQ_TIME] = 0;
 	}
     }
 
@@ -130,7 +112,7 @@ Dim 4     :       : ....  :       :        :       : .....  :       :
 	seq_print_usage();
 	EXIT
     }
-    else if (arguments[1][0] == '-')
+    else if ((arguments[1][0] == '-') && (arguments[1][1] != EOS))
     {
 	i = 1;
 	strcpy(filename,"UNKNOWN");
@@ -793,6 +775,110 @@ Dim 4     :       : ....  :       :        :       : .....  :       :
 	    }
 	}
 
+        else if (!strncmp(arguments[i], "-i", 2)) /* build index, seg directory */
+	{
+	    SEQ_options.build_index = TRUE;
+	}
+
+        else if (!strncmp(arguments[i], "-w", 2)) /* file still being written */
+	{
+	    SEQ_options.stream = TRUE;
+	    if (arguments[i][2] != EOS)
+		SEQ_options.follow = atoi(&arguments[i][2]);
+	    else
+		SEQ_options.follow = SEQ_FOLLOW_SECS;
+	}
+
+        else if (!strncmp(arguments[i], "-c", 2)) /* build columnar cache */
+	{
+	    SEQ_options.build_cache = TRUE;
+	    SEQ_options.build_index = TRUE;
+	}
+
+        else if (!strncmp(arguments[i], "-k", 2)) /* select filter kernels */
+	{
+	    argP = &arguments[i][2];
+	    if ((*argP == EOS) && ((i+1) < num_args))
+		argP = &arguments[++i][0];
+
+	    if (!strcmp(argP, "scalar"))
+		SEQ_options.kernels = SEQ_KERNEL_SCALAR;
+	    else if (!strcmp(argP, "sse4.1"))
+		SEQ_options.kernels = SEQ_KERNEL_SSE41;
+	    else if (!strcmp(argP, "avx2"))
+		SEQ_options.kernels = SEQ_KERNEL_AVX2;
+	    else if (!strcmp(argP, "avx512"))
+		SEQ_options.kernels = SEQ_KERNEL_AVX512;
+	    else if (!strcmp(argP, "auto"))
+		SEQ_options.kernels = SEQ_KERNEL_AUTO;
+	    else
+	    {
+		printf("Invalid filter kernels: %s\n", argP);
+		printf("Valid options are: scalar, sse4.1, avx2, avx512 or auto\n");
+		EXIT
+	    }
+	}
+
+        else if (!strncmp(arguments[i], "-j", 2)) /* threads translating */
+	{
+	    argP = &arguments[i][2];
+	    if ((*argP == EOS) && ((i+1) < num_args))
+		argP = &arguments[++i][0];
+
+	    SEQ_options.jobs = atoi(argP);
+	    if ((SEQ_options.jobs < 1) || (SEQ_options.jobs > SEQ_MAX_JOBS))
+	    {
+		printf("Invalid number of threads: %s\n", argP);
+		printf("Valid numbers are 1 to %d\n", SEQ_MAX_JOBS);
+		EXIT
+	    }
+	}
+
+        else if (!strncmp(arguments[i], "-q", 2)) /* read, filter, write */
+	{
+	    SEQ_options.pipeline = TRUE;
+	}
+
+        else if (!strncmp(arguments[i], "-b", 2)) /* a list of data files */
+	{
+	    SEQ_options.file_list = TRUE;
+	}
+
+        else if (!strncmp(arguments[i], "-m", 2)) /* processes, one a shard */
+	{
+	    argP = &arguments[i][2];
+	    if ((*argP == EOS) && ((i+1) < num_args))
+		argP = &arguments[++i][0];
+
+	    SEQ_options.shards = atoi(argP);
+	    if ((SEQ_options.shards < 1) ||
+		(SEQ_options.shards > SEQ_MAX_SHARDS))
+	    {
+		printf("Invalid number of processes: %s\n", argP);
+		printf("Valid numbers are 1 to %d\n", SEQ_MAX_SHARDS);
+		EXIT
+	    }
+	}
+
+        else if (!strncmp(arguments[i], "-n", 2)) /* one shard of -m */
+	{
+	    argP = &arguments[i][2];
+	    if ((*argP == EOS) && ((i+1) < num_args))
+		argP = &arguments[++i][0];
+
+	    SEQ_options.shard = atoi(argP);
+	    if ((!isdigit(*argP)) || (SEQ_options.shard >= SEQ_MAX_SHARDS))
+	    {
+		printf("Invalid shard: %s\n", argP);
+		EXIT
+	    }
+	}
+
+        else if (!strncmp(arguments[i], "-r", 2)) /* only segs added since */
+	{
+	    SEQ_options.resume = TRUE;
+	}
+
         else if (!strncmp(arguments[i], "-v", 2)) /* select verbose mode */
 	{
 	    if (arguments[i][2] == '1')
@@ -813,9 +899,21 @@ Dim 4     :       : ....  :       :        :       : .....  :       :
         }
     }
 
+    /* Every data file of a list goes into trace files */
+    if (SEQ_options.file_list == TRUE)
+	SEQ_options.output.type = SEQ_OUTPUT_FILE;
+
     if (SEQ_options.output.type == SEQ_OUTPUT_FILE)
 	SEQ_options.format = SEQ_FORMAT_CORRECTED;
 
+    /* The shards of -m are cut from the segment directory */
+    if (SEQ_options.shards > 1)
+	SEQ_options.build_index = TRUE;
+
+    /* A file name of - reads the data from a pipe */
+    if (!strcmp(filename, "-"))
+	SEQ_options.stream = TRUE;
+
     if ((no_segs == TRUE) && (SEQ_options.test_mode == FALSE))
     {
 	fprintf(stderr, "\nNO SEGMENTS TO TRANSLATE.\n\n");
@@ -880,6 +978,63 @@ Dim 4     :       : ....  :       :        :       : .....  :       :
 
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
 
+VOID SEQ_default_options()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: To set the options of the current context to what they are
+		when no arguments are given: no segments selected,
+		compensated points printed in one column.
+
+    Notes: Also for SEQ_Open(), which has no arguments to process.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_default_options() */
+
+    BYTE p,c;
+    SEGS *segP;
+
+    SEQ_options.debug = FALSE;
+    SEQ_options.print_coeffs = FALSE;
+    SEQ_options.test_mode = FALSE;
+    SEQ_options.print_times = FALSE;
+    SEQ_options.build_index = FALSE;
+    SEQ_options.stream = FALSE;
+    SEQ_options.follow = 0;
+    SEQ_options.resume = FALSE;
+    SEQ_options.build_cache = FALSE;
+    SEQ_options.kernels = SEQ_KERNEL_AUTO;
+    SEQ_options.jobs = 1;
+    SEQ_options.pipeline = FALSE;
+    SEQ_options.file_list = FALSE;
+    SEQ_options.shards = 1;
+    SEQ_options.shard = -1;
+    SEQ_options.output.type = SEQ_OUTPUT_SCREEN;
+    SEQ_options.output.format = SEQ_SCREEN_OUTPUT_1;
+    SEQ_options.format = SEQ_FORMAT_COMPENSATED;
+    strcpy (SEQ_options.prt_fmt, "%g");
+    plugin_field = 0;
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	channel_field[p] = 0;
+	for (c=0; c < MAX_CHANNELS; ++c)
+	{
+	    SEQ_options.all_segs[p][c] = FALSE;
+	    SEQ_options.print_params[p][c] = FALSE;
+	    segP = SEQ_options.seg[p][c][SEQ_SEGNO];
+	    segP->select.n.start = -1L;
+	    segP->select.n.end = -1L;
+	    segP = SEQ_options.seg[p][c][SEQ_TIME];
+	    segP->select.t.start = (DOUBLE)-1;
+	    segP->select.t.end = (DOUBLE)-1;
+	}
+    }
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
 static void seq_print_usage()
 
 /*--------------------------------------------------------------------------
@@ -903,7 +1058,7 @@ static void seq_print_usage()
     printf("\nusage: seqtran <file> [ options ]\n\n");
     printf("options are:\n");
     printf("\
-file= SCSI data file\n\
+file= SCSI data file, or - to read it from standard input as it arrives\n\
 -t  = Print the times of all segments relative to segment 1 (default = off)\n\
       to the screen as hours:minutes:seconds\n\
 -a  = print acquisition parameters (descriptors) to screen  (default = off)\n\
@@ -947,6 +1102,29 @@ file= SCSI data file\n\
 -d  = Diagnostic test mode: compare last segment to corrected segment\n\
        (all channels) and print any differences as a byte offset.\n\
 -p  = Print filter coefficients to the screen	            (default = off)\n\
+-i  = Build packet index <file>.idx and segment directory   (default = off)\n\
+      <file>.sdr for faster seeks (up to date ones are always used)\n\
+-c  = Also convert the file once into the columnar cache <file>.col, from\n\
+      which later runs read the segments (not with -d, -w or -r)\n\
+-w  = The file is still being written: translate segments as they arrive,\n\
+      and stop after no data for -wN seconds               (default = 10)\n\
+-k  = Filter kernels: scalar (the original loops, for comparisons), sse4.1,\n\
+      avx2, avx512 or auto (the best the processor has)     (default = auto)\n\
+-j  = Translate the segments with -jN threads, the output the same as\n\
+      with one (not with -d, -t, -r or -v)                  (default = 1)\n\
+-q  = Read, filter and write the data in three threads, and print how\n\
+      full the queues between them were (not with -d, -t, -r, -v or -j)\n\
+-b  = The file is a list of data files, @list with a name on each line, or\n\
+      a pattern like \"run/*.dat\": translate each into trace files as\n\
+      with -oF, in the directory <file>.trc, sharing the work out among\n\
+      -jN threads, and print the throughput (not with -d, -t, -r, -v, -w\n\
+      or -q)\n\
+-m  = Split the segments into -mN shards and translate each in a process\n\
+      of its own, the output the same as with one (not with -d, -r, -v, -w\n\
+      or -b)                                                (default = 1)\n\
+-n  = Translate only shard N of -m (the processes of -m are given -nN)\n\
+-r  = Resume: translate only the segments added since the last run with -r\n\
+      (the place reached is kept in <file>.sck)\n\
 -v  = Verbose mode: print progress                          (default = off)\n");
 }
 
@@ -0,0 +1,271 @@
+/************************** seq_bat.c **************************************
+
+Flash filtering of short segments in batches.
+
+A capture of many short segments (a few dozen points each) is filtered a
+segment at a time by SEQ_fir(), and for such segments most of the work is
+not in the vector loops of seq_vec.c at all: the kernel and its rows are
+set up again for every segment, and the points before the first full
+vector and after the last are done one at a time.
+
+When the segments are read from the columnar cache (-c), the data of a
+channel of all segments lies in one column, and the segments that follow
+the one being translated can be had without disturbing the reader. The
+first time a short segment of a run of translated segments is read,
+SEQ_Batch_Fir() therefore gathers it and the SEQ_BATCH - 1 segments
+after it of the same channel, transposes their samples so that a segment
+is a lane (structure of arrays), and filters them all at once with
+SEQ_Vec_Fir_Batch(), every lane with the rows of its own last flash. The
+corrected points are kept, and as each of these segments is read in its
+turn its points are only copied out.
+
+Only segments of up to SEQ_BATCH_POINTS points and the filters below
+2 GSa/s are batched: past that the transposing and copying out cost more
+than the batch saves. The 7291 filter and a segment whose last flash
+differs from what the cache said are left to SEQ_fir(). The points are
+bit for bit those of SEQ_fir(). Without the AVX2 kernel (-k scalar or
+sse4.1, or not compiled with SEQ_SIMD) nothing is batched.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "seq_filt.h"
+#include "seq_tran.h"
+
+/* -------------------------------------------------------------------- */
+
+extern BOOL   SEQ_Col_Last_Read();
+extern LONG   SEQ_Col_Gather();
+extern BYTE   *SEQ_fir_index();
+extern LONG   SEQ_Vec_Fir_Batch();
+
+#define SEQ_BATCH_POINTS 128L		/* longest segment batched */
+
+/* The batch of a channel, the channels taking turns in every segment */
+typedef struct SEQ_BAT
+{
+    LONG  first;		/* its first segment, 0 = first */
+    LONG  count;		/* segments in it, 0 if none */
+    LONG  size;			/* raw samples of each */
+    LONG  next;			/* segment after the last one translated */
+    struct FILTER *filterP;
+    WORD  coeffs[8][13];	/* coefficients it was filtered with */
+    WORD  flash[SEQ_BATCH];	/* last flash of each segment, -1 if bad */
+    WORD  *outP;		/* [SEQ_BATCH_POINTS][SEQ_BATCH] points */
+} SEQ_BAT;
+
+/* State of the module in the current context (seq_ctx.c): the batches,
+   and where a batch is gathered and transposed before it is filtered */
+typedef struct SEQ_BAT_STATE
+{
+    SEQ_BAT bat[MAX_PLUGINS][MAX_CHANNELS];
+    BYTE   *gatherP;		/* [SEQ_BATCH][SEQ_BATCH_POINTS] */
+    BYTE   *rawP;		/* [SEQ_BATCH_POINTS][SEQ_BATCH] */
+} SEQ_BAT_STATE;
+
+#define seq_bat		(SEQ_MODULE(SEQ_MOD_BATCH, SEQ_BAT_STATE)->bat)
+#define bat_gatherP	(SEQ_MODULE(SEQ_MOD_BATCH, SEQ_BAT_STATE)->gatherP)
+#define bat_rawP	(SEQ_MODULE(SEQ_MOD_BATCH, SEQ_BAT_STATE)->rawP)
+
+static BOOL   seq_bat_fill();
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Batch_Fir(acq_dataP, filt_dataP)
+  SEQ_ACQ_DATA  *acq_dataP;
+  SEQ_FILTER_DATA *filt_dataP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_fir() for the first piece of a segment, from a batch.
+
+    Inputs: acq_dataP  = the piece just read by SEQ_Read_Blocks_Seg()
+	    filt_dataP = as for SEQ_fir()
+
+    Outputs: TRUE if the corrected points have been put into
+			filt_dataP->corrP
+	     FALSE if SEQ_fir() has to filter the piece
+
+    Notes: A batch is only started for a segment that follows the last
+	   one translated of its channel (or is the first), so that
+	   picking a few segments here and there does not filter
+	   SEQ_BATCH segments for each.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Batch_Fir() */
+
+    struct FILTER *filterP;
+    SEQ_BAT *batP;
+    LONG  seg;
+    LONG  size;
+    LONG  n;
+    WORD  *outP;
+    WORD  *corr_dataP;
+    INT   channel;
+    INT   plugin;
+    INT   lane;
+    BOOL  run;
+
+    filterP = filt_dataP->paramsP;
+    size = acq_dataP->array_size;
+    plugin = acq_dataP->plugin;
+    if ((filterP->p91_mode == TRUE) || (filterP->num_filters >= 8) ||
+	(acq_dataP->size != size) || (size > SEQ_BATCH_POINTS) ||
+	(size < filterP->num_coeffs) || (filt_dataP->size != size) ||
+	(SEQ_Col_Last_Read(plugin, &seg, &channel) == FALSE) ||
+	(channel != acq_dataP->channel))
+	return (FALSE);
+
+    batP = &seq_bat[plugin][channel];
+    run = (batP->next == seg);
+    batP->next = seg + 1;
+
+    if ((batP->filterP != filterP) || (batP->size != size) ||
+	(seg < batP->first) || (seg >= batP->first + batP->count) ||
+	(memcmp(batP->coeffs, filterP->coeffP,
+					sizeof(batP->coeffs)) != 0))
+    {
+	if ((run == FALSE) || (seq_bat_fill(batP, filterP, plugin, channel,
+						    seg, size) == FALSE))
+	    return (FALSE);
+    }
+
+    lane = (INT)(seg - batP->first);
+    if (batP->flash[lane] != filterP->last_flash)
+	return (FALSE);
+
+    /* Copy the segment's lane out */
+    outP = &batP->outP[lane];
+    corr_dataP = filt_dataP->corrP;
+    for (n=filterP->num_coeffs-1; n < size; ++n)
+    {
+	*corr_dataP++ = *outP;
+	outP += SEQ_BATCH;
+    }
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Batch_Close()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Release the memory of the batches.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Batch_Close() */
+
+    BYTE  p,c;
+
+    if (SEQ_ctxP->moduleP[SEQ_MOD_BATCH] == NULL)
+	return;
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+	for (c=0; c < MAX_CHANNELS; ++c)
+	{
+	    free(seq_bat[p][c].outP);
+	    seq_bat[p][c].outP = NULL;
+	    seq_bat[p][c].count = 0L;
+	}
+    free(bat_gatherP);
+    free(bat_rawP);
+    bat_gatherP = NULL;
+    bat_rawP = NULL;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_bat_fill(batP, filterP, plugin, channel, seg, size)
+  SEQ_BAT *batP;
+  struct FILTER *filterP;
+  INT   plugin;
+  INT   channel;
+  LONG  seg;
+  LONG  size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Gather and filter the batch of a channel's segments starting
+		at seg.
+
+    Outputs: TRUE if the batch is there
+	     FALSE if not (no memory, no vector kernel, nothing in the cache)
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_bat_fill() */
+
+    BYTE  *indexP[SEQ_BATCH];
+    UWORD flash[SEQ_BATCH];
+    BYTE  *rawP;
+    BYTE  *toP;
+    LONG  count;
+    LONG  n;
+    INT   l;
+
+    batP->count = 0L;
+
+    if (bat_gatherP == NULL)
+    {
+	bat_gatherP = (BYTE *)malloc((size_t)(SEQ_BATCH * SEQ_BATCH_POINTS));
+	bat_rawP = (BYTE *)malloc((size_t)(SEQ_BATCH_POINTS * SEQ_BATCH));
+	if ((bat_gatherP == NULL) || (bat_rawP == NULL))
+	{
+	    free(bat_gatherP);
+	    free(bat_rawP);
+	    bat_gatherP = NULL;
+	    return (FALSE);
+	}
+    }
+    if ((batP->outP == NULL) && ((batP->outP = (WORD *)malloc(
+	    (size_t)(SEQ_BATCH_POINTS * SEQ_BATCH) * sizeof(WORD))) == NULL))
+	return (FALSE);
+
+    count = SEQ_Col_Gather(plugin, channel, seg, (LONG)SEQ_BATCH,
+						    bat_gatherP, flash);
+    if (count <= 0)
+	return (FALSE);
+
+    /* A lane per segment, no filter for the lanes past the last one or
+       for a last flash that is not one of the sampling rate */
+    for (l=0; l < SEQ_BATCH; ++l)
+    {
+	indexP[l] = NULL;
+	batP->flash[l] = -1;
+	if (l < count)
+	    indexP[l] = SEQ_fir_index(filterP->num_filters, (WORD)flash[l]);
+	if (indexP[l] != NULL)
+	    batP->flash[l] = (WORD)flash[l];
+    }
+
+    /* Transpose: sample n of every segment side by side */
+    if (count < SEQ_BATCH)
+	memset(&bat_gatherP[count * size], 0,
+				(size_t)((SEQ_BATCH - count) * size));
+    toP = bat_rawP;
+    for (n=0; n < size; ++n)
+    {
+	rawP = &bat_gatherP[n];
+	for (l=0; l < SEQ_BATCH; ++l, rawP += size)
+	    *toP++ = *rawP;
+    }
+
+    if (SEQ_Vec_Fir_Batch(filterP, indexP, bat_rawP, batP->outP,
+		    (LONG)(filterP->num_coeffs-1), size) <= 0)
+	return (FALSE);
+
+    batP->first = seg;
+    batP->count = count;
+    batP->size = size;
+    batP->filterP = filterP;
+    memcpy(batP->coeffs, filterP->coeffP, sizeof(batP->coeffs));
+
+    return (TRUE);
+}
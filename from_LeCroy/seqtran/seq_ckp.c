@@ -0,0 +1,638 @@
+/************************** seq_ckp.c **************************************
+
+Checkpoints for translating a data file that keeps growing.
+
+A long monitoring capture is translated again and again while acquire is
+still adding to it. With the -r option, each run records how far it got
+and the next run carries on from there instead of starting over at
+SEQ_params.seg_offset, so only the segments added in between are
+translated.
+
+After every segment the translation loop gets through, the place where the
+next segment starts is written to a state file next to the data file with
+the extension .sck:
+
+	CHAR  magic[4]		"SQCK"
+	UBYTE layout[20]	how this build lays out what follows
+				(SEQ_Sidecar_Head(), seq_idx.c)
+	SEQ_OFFSET block_size	block size of the data file
+	SEQ_OFFSET seg_offset	SEQ_params.seg_offset
+	SEQ_CKP_PLUGIN plugin[MAX_PLUGINS]
+
+Per plugin this is the next segment number, the reader's position kept the
+way SEQ_Read_Blocks_Seg() keeps it (start of a block plus the offset into
+it), the packet number of that block, SEQ_params.last_packet and the time
+stamp of segment 1, which all later times are relative to. Per channel it
+is the number of the last trace_PC.nnn file written and how far
+SEQ_Check_Seg() has got through the selections. The filters start afresh
+with each segment, so there is no filter history to keep.
+
+The state file is only used if its block size, segment offset and (unless
+the input is streamed) the packet number at each position still match the
+data file. A segment that is not all in the file yet is left for the next
+run, unless the input is streamed (-w), where the data is only known as it
+arrives.
+
+The same state starts each shard of -m (seq_shd.c) part way into the data
+file: SEQ_Ckpt_Seed() writes it for the first segment of the shard, from
+the segment directory, as <file>.shd/<shard>.sck. The process translating
+the shard carries on from it as -r would, but keeps no state of its own.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "seq_tran.h"
+
+/* -------------------------------------------------------------------- */
+
+extern WORD   *SEQ_Check_Index();
+extern size_t SEQ_Map_Read();
+extern INT    SEQ_Map_Seek(FILE *seq_fP, SEQ_OFFSET offset, INT origin);
+extern SEQ_OFFSET SEQ_Map_Tell();
+extern SEQ_OFFSET SEQ_Index_Left();
+extern VOID   SEQ_Sidecar_Name();
+extern BOOL   SEQ_Sidecar_Head();
+extern VOID   SEQ_Shard_Name();
+extern BOOL   SEQ_Dir_Seek();
+extern DOUBLE SEQ_Dir_Stamp();
+
+#define SEQ_CKP_MAGIC	"SQCK"
+#define SEQ_CKP_EXT	".sck"
+
+typedef struct SEQ_CKP_PLUGIN
+{
+    LONG  next_segno;		/* first segment not got through yet */
+    SEQ_OFFSET pos;		/* start of block holding its channel tag */
+    LONG  block_offset;		/* offset of the tag in the block */
+    LONG  packet;		/* packet number of the block at pos */
+    LONG  last_packet;		/* SEQ_params.last_packet at this point */
+    DOUBLE first_time;		/* time of segment 1 in seconds */
+    WORD  file_ext[MAX_CHANNELS];		/* last trace_PC.nnn */
+    WORD  check[MAX_CHANNELS][MAX_SEG_TYPES];	/* SEQ_Check_Seg() */
+} SEQ_CKP_PLUGIN;
+
+typedef struct SEQ_CKP
+{
+    CHAR  name[128];		/* the .sck file */
+    SEQ_CKP_PLUGIN plugin[MAX_PLUGINS];
+} SEQ_CKP;
+
+/* State of the module in the current context (seq_ctx.c) */
+typedef struct SEQ_CKP_STATE
+{
+    SEQ_CKP ckp;
+    BOOL    open;
+    BOOL    keep;		/* FALSE for the seed of a shard */
+} SEQ_CKP_STATE;
+
+#define seq_ckp		(SEQ_MODULE(SEQ_MOD_CKPT, SEQ_CKP_STATE)->ckp)
+#define seq_ckp_open	(SEQ_MODULE(SEQ_MOD_CKPT, SEQ_CKP_STATE)->open)
+#define seq_ckp_keep	(SEQ_MODULE(SEQ_MOD_CKPT, SEQ_CKP_STATE)->keep)
+
+static BOOL       seq_ckp_load();
+static BOOL       seq_ckp_save();
+static UWORD      seq_ckp_packet();
+static SEQ_OFFSET seq_ckp_left();
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Ckpt_Open(seq_fP, seq_filenameP, startP)
+  FILE        *seq_fP;
+  CHAR        *seq_filenameP;
+  SEQ_OFFSET  startP[];
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Load the state left by the last run from the .sck file and
+		start keeping it for this run.
+
+    Inputs: seq_fP        = FILE pointer to the opened data file
+	    seq_filenameP = name of the data file
+
+    Outputs: startP[p] = where the translation of plugin p starts:
+			SEQ_params.seg_offset or the position reached
+	     TRUE if any plugin carries on from an earlier run
+
+    Machine dependencies:
+
+    Notes: Must be called after SEQ_READ_DESCRIPTOR. Does nothing
+	   without the -r option or when reading standard input, which
+	   has no name to keep the state under. A shard of -m after the
+	   first starts from its seed, and fails without it.
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Ckpt_Open() */
+
+    SEQ_CKP_PLUGIN *plugP;
+    WORD  *checkP;
+    BOOL  resumed;
+    BOOL  loaded;
+    BYTE  p,c;
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+	startP[p] = SEQ_params.seg_offset;
+
+    if ((seq_ckp_open == TRUE) || (SEQ_options.resume == FALSE))
+	return (FALSE);
+
+    if (!strcmp(seq_filenameP, "-"))
+    {
+	fprintf(stderr, "Cannot resume translation of standard input.\n");
+	return (FALSE);
+    }
+
+    seq_ckp_keep = (SEQ_options.shard < 0);
+    if (seq_ckp_keep == TRUE)
+	SEQ_Sidecar_Name(seq_filenameP, SEQ_CKP_EXT, seq_ckp.name,
+					    (INT)sizeof(seq_ckp.name));
+    else
+	SEQ_Shard_Name(seq_filenameP, SEQ_options.shard, SEQ_CKP_EXT,
+			    seq_ckp.name, (INT)sizeof(seq_ckp.name));
+
+    /* Nothing done yet: segment 1 is next */
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	plugP = &seq_ckp.plugin[p];
+	plugP->next_segno = 1L;
+	plugP->pos = SEQ_params.seg_offset;
+	plugP->block_offset = 0L;
+	plugP->packet = 0L;
+	plugP->last_packet = FALSE;
+	plugP->first_time = 0.0;
+	for (c=0; c < MAX_CHANNELS; ++c)
+	{
+	    plugP->file_ext[c] = SEQ_file_ext[p][c];
+	    checkP = SEQ_Check_Index(p, c);
+	    plugP->check[c][SEQ_SEGNO] = checkP[SEQ_SEGNO];
+	    plugP->check[c][SEQ_TIME] = checkP[SEQ_TIME];
+	}
+    }
+
+    resumed = seq_ckp_load(seq_fP, &loaded);
+    seq_ckp_open = TRUE;
+
+    if ((seq_ckp_keep == FALSE) && (SEQ_options.shard > 0) &&
+	(loaded == FALSE))
+    {
+	printf("Could not start shard %d from %s\n", SEQ_options.shard,
+							    seq_ckp.name);
+	EXIT
+    }
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+	startP[p] = seq_ckp.plugin[p].pos;
+
+    return (resumed);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Ckpt_Resume(seq_fP, plugin, block_offsetP, first_timeP)
+  FILE    *seq_fP;
+  INT     plugin;
+  LONG    *block_offsetP;
+  DOUBLE  *first_timeP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Put the translation loop of a plugin back where the last run
+		left it.
+
+    Inputs: seq_fP = FILE pointer, at SEQ_params.seg_offset
+
+    Outputs: the segment number to carry on with, 1 if starting over
+	     seq_fP, *block_offsetP = position of that segment's channel tag
+	     *first_timeP           = time of segment 1 in seconds
+
+    Notes: Also restores SEQ_params.last_packet, the trace_PC.nnn file
+	   numbers and SEQ_Check_Seg()'s place in the selections.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Ckpt_Resume() */
+
+    SEQ_CKP_PLUGIN *plugP;
+    WORD  *checkP;
+    BYTE  c;
+
+    plugP = &seq_ckp.plugin[plugin];
+    if ((seq_ckp_open == FALSE) || (plugP->next_segno <= 1))
+	return (1L);
+
+    SEQ_Map_Seek(seq_fP, plugP->pos, SEEK_SET);
+    *block_offsetP = plugP->block_offset;
+    *first_timeP = plugP->first_time;
+    SEQ_params.last_packet[plugin] = (BOOL)plugP->last_packet;
+
+    for (c=0; c < MAX_CHANNELS; ++c)
+    {
+	SEQ_file_ext[plugin][c] = plugP->file_ext[c];
+	checkP = SEQ_Check_Index(plugin, c);
+	checkP[SEQ_SEGNO] = plugP->check[c][SEQ_SEGNO];
+	checkP[SEQ_TIME] = plugP->check[c][SEQ_TIME];
+    }
+
+    if (seq_ckp_keep == TRUE)
+	fprintf(stderr, "\nPlugin %c: carrying on from segment %ld\n",
+					    plugin+'A', plugP->next_segno);
+
+    return (plugP->next_segno);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Ckpt_Whole(seq_fP, plugin, segno, block_offset, size)
+  FILE  *seq_fP;
+  INT   plugin;
+  LONG  segno;
+  LONG  block_offset;
+  LONG  size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Tell whether a segment is all in the data file yet.
+
+    Inputs: seq_fP, block_offset = position of the segment's channel tag,
+			as kept by SEQ_Read_Blocks_Seg()
+	    size = BYTEs of the plugin's data in the segment
+
+    Outputs: TRUE if the segment can be read, or if checkpoints are not
+			kept (as for a shard of -m, which translates what
+			is there as a single run would)
+	     FALSE if the data file ends before the segment does
+
+    Notes: Asked before anything of a segment is written out, so that a
+	   segment acquire is still writing is translated once, in full,
+	   by a later run. The position of seq_fP is restored.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Ckpt_Whole() */
+
+    SEQ_OFFSET left;
+
+    if ((seq_ckp_open == FALSE) || (seq_ckp_keep == FALSE) ||
+	(SEQ_options.stream == TRUE) || (SEQ_options.test_mode == TRUE))
+	return (TRUE);
+
+    left = SEQ_Index_Left(seq_fP, plugin, block_offset);
+    if (left < 0)
+	left = seq_ckp_left(seq_fP, plugin, block_offset, size);
+    if (left >= size)
+	return (TRUE);
+
+    if (SEQ_params.last_packet[plugin] == FALSE)
+	fprintf(stderr, "\n%c, Segment %ld: not all there yet\n",
+							plugin+'A', segno);
+    return (FALSE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Ckpt_Mark(seq_fP, plugin, segno, block_offset, first_time)
+  FILE    *seq_fP;
+  INT     plugin;
+  LONG    segno;
+  LONG    block_offset;
+  DOUBLE  first_time;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Record that the translation loop got through every segment
+		of the plugin before segno, and save the state file.
+
+    Inputs: seq_fP, block_offset = position of segment segno's channel
+			tag, as kept by SEQ_Read_Blocks_Seg()
+	    first_time = time of segment 1 in seconds
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Ckpt_Mark() */
+
+    SEQ_CKP_PLUGIN *plugP;
+    WORD  *checkP;
+    BYTE  c;
+
+    if ((seq_ckp_open == FALSE) || (seq_ckp_keep == FALSE))
+	return;
+
+    plugP = &seq_ckp.plugin[plugin];
+    plugP->next_segno = segno;
+    plugP->pos = SEQ_Map_Tell(seq_fP);
+    plugP->block_offset = block_offset;
+    plugP->packet = (LONG)seq_ckp_packet(seq_fP);
+    plugP->last_packet = (LONG)SEQ_params.last_packet[plugin];
+    plugP->first_time = first_time;
+
+    for (c=0; c < MAX_CHANNELS; ++c)
+    {
+	plugP->file_ext[c] = SEQ_file_ext[plugin][c];
+	checkP = SEQ_Check_Index(plugin, c);
+	plugP->check[c][SEQ_SEGNO] = checkP[SEQ_SEGNO];
+	plugP->check[c][SEQ_TIME] = checkP[SEQ_TIME];
+    }
+
+    if (seq_ckp_save(&seq_ckp) == FALSE)
+	seq_ckp_open = FALSE;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Ckpt_Seed(seq_fP, nameP, segno)
+  FILE  *seq_fP;
+  CHAR  *nameP;
+  LONG  segno[];
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Write the state that starts a shard of -m, each plugin p at
+		segment segno[p].
+
+    Inputs: seq_fP = FILE pointer to the opened data file
+	    nameP  = the state file to write, <file>.shd/<shard>.sck
+
+    Outputs: TRUE if it was written
+
+    Notes: The places come from the segment directory, which must be
+	   open, and how far SEQ_Check_Seg() has got from the current
+	   context (seq_shd.c takes it through the segments before the
+	   shard). Nothing has been written out yet, so the trace_PC.nnn
+	   files of the shard are numbered from 000. The position of
+	   seq_fP and SEQ_params.last_packet are restored.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Ckpt_Seed() */
+
+    SEQ_CKP ckp;
+    SEQ_CKP_PLUGIN *plugP;
+    SEQ_OFFSET pos;
+    BOOL  last_packet[MAX_PLUGINS];
+    WORD  *checkP;
+    BYTE  p,c;
+
+    pos = SEQ_Map_Tell(seq_fP);
+    memset((VOID *)&ckp, 0, sizeof(ckp));
+    strncpy(ckp.name, nameP, sizeof(ckp.name) - 1);
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	last_packet[p] = SEQ_params.last_packet[p];
+	plugP = &ckp.plugin[p];
+	plugP->next_segno = 1L;
+	plugP->pos = SEQ_params.seg_offset;
+	for (c=0; c < MAX_CHANNELS; ++c)
+	{
+	    plugP->file_ext[c] = -1;
+	    checkP = SEQ_Check_Index(p, c);
+	    plugP->check[c][SEQ_SEGNO] = checkP[SEQ_SEGNO];
+	    plugP->check[c][SEQ_TIME] = checkP[SEQ_TIME];
+	}
+
+	if ((p < SEQ_params.first_plugin) || (p > SEQ_params.last_plugin) ||
+	    (segno[p] <= 1) || (SEQ_Dir_Seek(seq_fP, (INT)p, segno[p],
+					&plugP->block_offset) == FALSE))
+	    continue;
+
+	plugP->next_segno = segno[p];
+	plugP->pos = SEQ_Map_Tell(seq_fP);
+	plugP->packet = (LONG)seq_ckp_packet(seq_fP);
+	plugP->last_packet = (LONG)SEQ_params.last_packet[p];
+	plugP->first_time = SEQ_Dir_Stamp((INT)p, 1L);
+    }
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+	SEQ_params.last_packet[p] = last_packet[p];
+    SEQ_Map_Seek(seq_fP, pos, SEEK_SET);
+
+    return (seq_ckp_save(&ckp));
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_ckp_load(seq_fP, loadedP)
+  FILE  *seq_fP;
+  BOOL  *loadedP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Read the state file if there is one and it belongs to this
+		data file.
+
+    Outputs: TRUE if any plugin carries on from an earlier run
+	     *loadedP = TRUE if the file was read
+
+    Notes: seq_ckp is left as it was unless the whole file is usable.
+	   The seed of a shard of -m may start every plugin at segment 1
+	   and still be read.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_ckp_load() */
+
+    FILE *ckp_fP;
+    SEQ_OFFSET sizes[2];
+    SEQ_OFFSET pos;
+    SEQ_CKP_PLUGIN plugin[MAX_PLUGINS];
+    BOOL ok;
+    BOOL resumed;
+    BYTE p;
+
+    *loadedP = FALSE;
+    if ((ckp_fP = fopen(seq_ckp.name, "rb")) == NULL)
+	return (FALSE);
+
+    ok = (SEQ_Sidecar_Head(ckp_fP, SEQ_CKP_MAGIC,
+			(LONG)(sizeof(sizes) + sizeof(plugin)), 0L,
+			FALSE) == TRUE) &&
+	 (fread((CHAR *)sizes, sizeof(sizes), 1, ckp_fP) == 1) &&
+	 (fread((CHAR *)plugin, sizeof(plugin), 1, ckp_fP) == 1) &&
+	 (sizes[0] == (SEQ_OFFSET)SEQ_params.block_size) &&
+	 (sizes[1] == SEQ_params.seg_offset);
+    fclose(ckp_fP);
+
+    /* The blocks where the last run stopped must still be there; a
+       streamed input cannot be looked at ahead of the translation */
+    resumed = FALSE;
+    pos = SEQ_Map_Tell(seq_fP);
+    for (p=0; (p < MAX_PLUGINS) && (ok == TRUE); ++p)
+    {
+	if (plugin[p].next_segno <= 1)
+	    continue;
+
+	if ((p < SEQ_params.first_plugin) || (p > SEQ_params.last_plugin) ||
+	    (plugin[p].pos < SEQ_params.seg_offset))
+	    ok = FALSE;
+	else if (SEQ_options.stream == FALSE)
+	{
+	    SEQ_Map_Seek(seq_fP, plugin[p].pos, SEEK_SET);
+	    if ((LONG)seq_ckp_packet(seq_fP) != plugin[p].packet)
+		ok = FALSE;
+	}
+	resumed = TRUE;
+    }
+    SEQ_Map_Seek(seq_fP, pos, SEEK_SET);
+
+    if (ok == FALSE)
+    {
+	fprintf(stderr, "%s does not belong to this data file, starting over\n",
+							    seq_ckp.name);
+	return (FALSE);
+    }
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+	seq_ckp.plugin[p] = plugin[p];
+    *loadedP = TRUE;
+
+    if (SEQ_options.debug == 1)
+    {
+	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+	    printf("Checkpoint %c: segment %ld at %.0f+%ld\n", p+'A',
+		    plugin[p].next_segno, (DOUBLE)plugin[p].pos,
+		    plugin[p].block_offset);
+    }
+
+    return (resumed);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_ckp_save(ckpP)
+  SEQ_CKP *ckpP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Write the state to its .sck file. If that fails the next run
+		starts over, or from an earlier checkpoint.
+
+    Outputs: TRUE if it was written
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_ckp_save() */
+
+    FILE *ckp_fP;
+    SEQ_OFFSET sizes[2];
+    BOOL ok;
+
+    if ((ckp_fP = fopen(ckpP->name, "wb")) == NULL)
+    {
+	fprintf(stderr, "Could not create checkpoint %s\n", ckpP->name);
+	return (FALSE);
+    }
+
+    sizes[0] = SEQ_params.block_size;
+    sizes[1] = SEQ_params.seg_offset;
+
+    ok = (SEQ_Sidecar_Head(ckp_fP, SEQ_CKP_MAGIC,
+			(LONG)(sizeof(sizes) + sizeof(ckpP->plugin)), 0L,
+			TRUE) == TRUE) &&
+	 (fwrite((CHAR *)sizes, sizeof(sizes), 1, ckp_fP) == 1) &&
+	 (fwrite((CHAR *)ckpP->plugin, sizeof(ckpP->plugin), 1,
+							ckp_fP) == 1);
+
+    if (fclose(ckp_fP) != 0)
+	ok = FALSE;
+
+    if (ok == FALSE)
+    {
+	fprintf(stderr, "Could not write checkpoint %s\n", ckpP->name);
+	remove(ckpP->name);
+    }
+
+    return (ok);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static UWORD seq_ckp_packet(seq_fP)
+  FILE  *seq_fP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Return the packet number (with the plugin bit) of the block
+		seq_fP is at, 0xffff if there is none. The position of
+		seq_fP is restored.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_ckp_packet() */
+
+    UWORD packet;
+
+    if (SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP) != 1)
+	return (0xffff);
+
+    SEQ_Map_Seek(seq_fP, -2L, SEEK_CUR);
+    return (packet);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_OFFSET seq_ckp_left(seq_fP, plugin, block_offset, size)
+  FILE  *seq_fP;
+  INT   plugin;
+  LONG  block_offset;
+  LONG  size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Count the BYTEs of the plugin's data in the file from the
+		position block_offset into the current block, up to size.
+
+    Notes: For SEQ_Ckpt_Whole() when there is no packet index. With one
+	   plugin every block is the plugin's own; with two, the packet
+	   numbers of the blocks are read, but not their data. The
+	   position of seq_fP is restored.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_ckp_left() */
+
+    SEQ_OFFSET pos;
+    SEQ_OFFSET blk;
+    SEQ_OFFSET file_size;
+    SEQ_OFFSET left;
+    LONG  payload;
+    UWORD packet;
+
+    payload = SEQ_params.block_size - 2;
+    pos = SEQ_Map_Tell(seq_fP);
+    SEQ_Map_Seek(seq_fP, 0L, SEEK_END);
+    file_size = SEQ_Map_Tell(seq_fP);
+
+    left = -(SEQ_OFFSET)block_offset;
+    if (SEQ_params.first_plugin == SEQ_params.last_plugin)
+    {
+	blk = pos + ((file_size - pos) / SEQ_params.block_size) *
+						    SEQ_params.block_size;
+	left += ((blk - pos) / SEQ_params.block_size) * payload;
+	if (file_size - blk > 2)
+	    left += file_size - blk - 2;
+    }
+    else
+    {
+	for (blk = pos; (left < size) && (blk + 2 < file_size);
+					    blk += SEQ_params.block_size)
+	{
+	    SEQ_Map_Seek(seq_fP, blk, SEEK_SET);
+	    if (SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP) != 1)
+		break;
+	    if (((INT)(packet >> 15) != plugin) || ((packet & 0x7fff) == 0))
+		continue;
+
+	    if (file_size - blk - 2 < payload)
+		left += file_size - blk - 2;
+	    else
+		left += payload;
+	}
+    }
+
+    SEQ_Map_Seek(seq_fP, pos, SEEK_SET);
+    return (left);
+}
@@ -0,0 +1,1196 @@
+/************************** seq_col.c **************************************
+
+Columnar cache of a SCSI sequence data file.
+
+A capture that is examined again and again (different segments, formats,
+corrections) has its packets walked and its plugins taken apart on every
+run, although nothing in it ever changes. With the -c option the data file
+is converted once into a cache kept next to it with the extension .col,
+in which the data is laid out by column instead of in acquisition order:
+
+	CHAR  magic[4]		"SQCC"
+	ULONG block_size	block size of the data file
+	ULONG file_size[2]	size of the data file when built (low, high)
+	ULONG seg_offset[2]	SEQ_params.seg_offset (low, high)
+	SEQ_COL_HDR plugin[MAX_PLUGINS]
+
+followed, for each plugin, by the areas the header points to:
+
+	descriptor and filter coefficients of every channel, as they are
+	    in the data file (desc_size + coeff_size BYTEs per channel)
+	TS    time_stamp[num_segs]
+	UWORD last_flash[num_segs]
+	UWORD fine_count[num_segs]
+	BYTE  data[num_segs][array_size] of every channel, in turn
+
+The header is written a BYTE at a time, every field of it 32 bits wide
+and little endian whatever size a LONG has on the host (24 BYTEs, then
+92 per plugin), and offsets into the cache are split into a low and a
+high ULONG. The areas are little endian as written on a PC, and every
+one starts on a SEQ_COL_ALIGN boundary, so that the cache can be mapped
+and read as plain arrays by other programs as well (see
+LeCroySeqCache.py).
+
+When an up to date cache exists, SEQ_Col_Read_Seg() serves the reads of
+the translation loop from it: positions are then kept as the offset into
+a segment's record (channel tag, SEQ_ACQ_PARAMS, then the data of each
+channel) instead of into a block of the data file, and the segment the
+reader is in is kept here. Jumping to a segment is only setting it, and
+every pass of the loop over the segments starts it at the first again
+(SEQ_Col_Rewind()), as it does the data file.
+
+Only complete segments are cached. The channel tag that follows the last
+of them (the diagnostic block, the padding at the end of the data, or a
+segment cut short) is kept as well, so the translation loop stops where
+it always did. The diagnostic data itself is not cached: with -d, or when
+the input is streamed (-w) or a translation is resumed (-r), the data file
+is read as before.
+
+Because a channel's data of all segments is one column, the segments
+after the one being read can also be had without moving the reader:
+SEQ_Col_Gather() hands them to seq_bat.c, which filters short segments
+in batches.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "seq_tran.h"
+#include "seq_hdr.h"
+
+#ifdef SEQ_MMAP
+#include <sys/types.h>
+#include <sys/mman.h>
+#endif /* SEQ_MMAP */
+
+#ifdef SEQ_LARGE_FILES
+#define SEQ_FSEEK(fP, offset, origin)	fseeko(fP, (off_t)(offset), origin)
+#define SEQ_FTELL(fP)			((SEQ_OFFSET)ftello(fP))
+#else
+#define SEQ_FSEEK(fP, offset, origin)	fseek(fP, (LONG)(offset), origin)
+#define SEQ_FTELL(fP)			ftell(fP)
+#endif /* SEQ_LARGE_FILES */
+
+/* -------------------------------------------------------------------- */
+
+extern BOOL   SEQ_Read_Blocks_Seg();
+extern BOOL   SEQ_Read_Blocks_Desc();
+extern INT    SEQ_Map_Seek(FILE *seq_fP, SEQ_OFFSET offset, INT origin);
+extern SEQ_OFFSET SEQ_Map_Tell();
+extern SEQ_OFFSET SEQ_Map_Size();
+extern SEQ_OFFSET SEQ_Index_Left();
+extern VOID   SEQ_Sidecar_Name();
+extern VOID   SEQ_Put32();
+extern ULONG  SEQ_Get32();
+
+#define SEQ_COL_MAGIC	"SQCC"
+#define SEQ_COL_EXT	".col"
+#define SEQ_COL_ALIGN	64L		/* start of every area */
+#define SEQ_COL_BUF	32768L		/* data copied at a time */
+
+/* Channel tag and acquisition parameters at the start of a segment */
+#define SEQ_COL_PARAMS	(2L + (LONG)sizeof(SEQ_ACQ_PARAMS))
+
+/* The header in the cache: magic, block size, file size and segment
+   offset, then the fields of a SEQ_COL_HDR per plugin, 32 bits each */
+#define SEQ_COL_FIELDS	(7 + 2 * (4 + MAX_CHANNELS))
+#define SEQ_COL_SIGNED	7		/* num_segs .. end_last */
+#define SEQ_COL_HEAD	(4 + 4 * 5 + MAX_PLUGINS * 4 * SEQ_COL_FIELDS)
+
+/* A plugin's header: SEQ_COL_FIELDS LONGs and ULONGs, the LONGs first,
+   which seq_col_load() and seq_col_build() take as an array of them */
+typedef struct SEQ_COL_HDR
+{
+    LONG  num_segs;		/* complete segments in the cache */
+    LONG  num_chan;		/* channels of the plugin */
+    LONG  array_size;		/* BYTEs of a channel in a segment */
+    LONG  desc_size;		/* BYTEs of a channel's descriptor */
+    LONG  coeff_size;		/* BYTEs of a channel's coefficients */
+    LONG  end_tag;		/* tag after the last segment, -1 if none */
+    LONG  end_last;		/* SEQ_params.last_packet after reading it */
+    ULONG desc_pos[2];		/* descriptors and coefficients */
+    ULONG time_pos[2];		/* TS time_stamp[num_segs] */
+    ULONG flash_pos[2];		/* UWORD last_flash[num_segs] */
+    ULONG fine_pos[2];		/* UWORD fine_count[num_segs] */
+    ULONG data_pos[MAX_CHANNELS][2]; /* BYTE data[num_segs][array_size] */
+} SEQ_COL_HDR;
+
+typedef struct SEQ_COL_ENTRY
+{
+    SEQ_OFFSET pos;		/* start of block holding the channel tag */
+    LONG  block_offset;		/* offset of the channel tag in the block */
+    SEQ_ACQ_PARAMS params;	/* last flash, TDC, time stamp */
+} SEQ_COL_ENTRY;
+
+typedef struct SEQ_COL
+{
+    SEQ_COL_HDR hdr;
+    BOOL  used;			/* plugin present in the cache */
+    LONG  seg_size;		/* tag, parameters and all channels */
+    SEQ_OFFSET time_pos;
+    SEQ_OFFSET flash_pos;
+    SEQ_OFFSET fine_pos;
+    SEQ_OFFSET data_pos[MAX_CHANNELS];
+    LONG  seg;			/* segment the reader is in, 0 = first */
+    LONG  read_seg;		/* segment and channel whose data the last */
+    LONG  read_chan;		/*   read was exactly, -1 if it was not */
+} SEQ_COL;
+
+/* State of the module in the current context (seq_ctx.c) */
+typedef struct SEQ_COL_STATE
+{
+    SEQ_COL    col[MAX_PLUGINS];
+    BOOL       open;
+    FILE       *fP;		/* cache, when not mapped */
+    BYTE       *baseP;		/* cache, when mapped */
+    SEQ_OFFSET size;
+} SEQ_COL_STATE;
+
+#define seq_col		(SEQ_MODULE(SEQ_MOD_COL, SEQ_COL_STATE)->col)
+#define seq_col_open	(SEQ_MODULE(SEQ_MOD_COL, SEQ_COL_STATE)->open)
+#define seq_col_fP	(SEQ_MODULE(SEQ_MOD_COL, SEQ_COL_STATE)->fP)
+#define seq_col_baseP	(SEQ_MODULE(SEQ_MOD_COL, SEQ_COL_STATE)->baseP)
+#define seq_col_size	(SEQ_MODULE(SEQ_MOD_COL, SEQ_COL_STATE)->size)
+
+static BOOL   seq_col_load();
+static BOOL   seq_col_build();
+static LONG   seq_col_scan();
+static BOOL   seq_col_copy_data();
+static BOOL   seq_col_write();
+static BOOL   seq_col_fetch();
+static LONG   seq_col_field();
+static VOID   seq_col_put();
+static BOOL   seq_col_get();
+static SEQ_OFFSET seq_col_align();
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Col_Open(seq_fP, seq_filenameP, build)
+  FILE  *seq_fP;
+  CHAR  *seq_filenameP;
+  INT   build;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Open the columnar cache of the data file from its .col file,
+		or build it first if requested.
+
+    Inputs: seq_fP        = FILE pointer to the opened data file
+	    seq_filenameP = name of the data file
+	    build         = TRUE to build the cache if there is no usable
+				.col file
+
+    Outputs: TRUE if the translation will read the segments from the cache
+	     FALSE if it will read the data file
+
+    Machine dependencies: mapping the cache requires SEQ_MMAP.
+
+    Notes: Must be called after SEQ_READ_DESCRIPTOR. Building requires
+	   the packet index (SEQ_Index_Open()). The position of seq_fP is
+	   restored before returning.
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Col_Open() */
+
+    CHAR  col_name[128];
+    SEQ_OFFSET file_size;
+    SEQ_OFFSET pos;
+    BOOL  loaded;
+    BYTE  p;
+
+    if ((seq_col_open == TRUE) || (SEQ_options.stream == TRUE) ||
+	(SEQ_options.resume == TRUE) || (SEQ_options.test_mode == TRUE))
+	return (FALSE);
+
+    SEQ_Sidecar_Name(seq_filenameP, SEQ_COL_EXT, col_name,
+						(INT)sizeof(col_name));
+
+    pos = SEQ_Map_Tell(seq_fP);
+    file_size = SEQ_Map_Size(seq_fP);
+    if (file_size < 0)
+    {
+	SEQ_Map_Seek(seq_fP, pos, SEEK_SET);
+	if (SEQ_options.debug == 1)
+	    printf("No columnar cache: the size of %s is not known\n",
+							    seq_filenameP);
+	return (FALSE);
+    }
+
+    loaded = seq_col_load(col_name, file_size);
+    if ((loaded == FALSE) && (build == TRUE))
+    {
+	if (seq_col_build(seq_fP, col_name, file_size) == TRUE)
+	    loaded = seq_col_load(col_name, file_size);
+	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+	    SEQ_params.last_packet[p] = FALSE;
+    }
+
+    SEQ_Map_Seek(seq_fP, pos, SEEK_SET);
+
+    if (loaded == FALSE)
+	return (FALSE);
+
+    seq_col_open = TRUE;
+
+    if (SEQ_options.debug == 1)
+    {
+	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+	    printf("Columnar cache %c: %ld segments\n", p+'A',
+						seq_col[p].hdr.num_segs);
+    }
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Col_Close()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Release the columnar cache.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Col_Close() */
+
+#ifdef SEQ_MMAP
+    if (seq_col_baseP != NULL)
+	(VOID)munmap((VOID *)seq_col_baseP, (size_t)seq_col_size);
+#endif /* SEQ_MMAP */
+    seq_col_baseP = NULL;
+
+    if (seq_col_fP != NULL)
+	fclose(seq_col_fP);
+    seq_col_fP = NULL;
+
+    seq_col_open = FALSE;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Col_Seek(plugin, segno, block_offsetP)
+  INT   plugin;
+  LONG  segno;
+  LONG  *block_offsetP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Position the reader of the cache at the channel tag of a
+		segment.
+
+    Inputs: plugin = 0 for plugin A, 1 for plugin B
+	    segno  = 1..num_segs, or num_segs+1 for the tag after them
+
+    Outputs: TRUE and *block_offsetP set for SEQ_Read_Blocks_Seg()
+	     FALSE if the segments are not read from the cache
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Col_Seek() */
+
+    SEQ_COL *colP;
+
+    colP = &seq_col[plugin];
+    if ((seq_col_open == FALSE) || (colP->used == FALSE) || (segno < 1))
+	return (FALSE);
+
+    if (segno > colP->hdr.num_segs + 1)
+	segno = colP->hdr.num_segs + 1;
+
+    colP->seg = segno - 1;
+    *block_offsetP = 0L;
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Col_Rewind(plugin)
+  INT   plugin;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Put the reader of the cache back at the first segment, as
+		the translation loop does with the data file when it starts
+		a pass over the segments.
+
+    Inputs: plugin = 0 for plugin A, 1 for plugin B
+
+    Notes: Needed when the same context translates more than once, as
+	   SEQ_Decode() does: the reader would otherwise carry on from the
+	   segment the last pass stopped in.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Col_Rewind() */
+
+    SEQ_COL *colP;
+
+    colP = &seq_col[plugin];
+    if ((seq_col_open == FALSE) || (colP->used == FALSE))
+	return;
+
+    colP->seg = 0L;
+    colP->read_seg = -1L;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Col_Read_Seg(seq_fP, dataP, read, statusP)
+  FILE  *seq_fP;
+  SEQ_ACQ_DATA  *dataP;
+  INT   read;
+  BOOL  *statusP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Read_Blocks_Seg() from the columnar cache.
+
+    Inputs: same as SEQ_Read_Blocks_Seg(), except that
+		dataP->block_offset is the offset into the record of the
+		segment the reader is in
+
+    Outputs: TRUE if the read was handled here; *statusP is then what
+			SEQ_Read_Blocks_Seg() must return.
+	     FALSE if the data file has to be read
+
+    Notes: The data file is not touched.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Col_Read_Seg() */
+
+    SEQ_COL *colP;
+    LONG  offset;
+    LONG  size;
+    LONG  seg;
+    LONG  count;
+    BYTE  *bufferP;
+
+    colP = &seq_col[dataP->plugin];
+    if ((seq_col_open == FALSE) || (colP->used == FALSE))
+	return (FALSE);
+
+    offset = dataP->block_offset + dataP->byte_offset;
+    bufferP = (read == TRUE) ? dataP->bufP : (BYTE *)NULL;
+    size = dataP->size;
+    seg = colP->seg;
+    dataP->bytes_read = 0L;
+    colP->read_seg = -1L;
+    *statusP = TRUE;
+
+    for (;;)
+    {
+	while ((offset >= colP->seg_size) && (seg < colP->hdr.num_segs))
+	{
+	    offset -= colP->seg_size;
+	    seg++;
+	}
+	while ((offset < 0) && (seg > 0))
+	{
+	    offset += colP->seg_size;
+	    seg--;
+	}
+
+	/* Note a read of exactly one channel of a segment */
+	if ((bufferP == dataP->bufP) && (bufferP != NULL) &&
+	    (size == colP->hdr.array_size) && (seg < colP->hdr.num_segs) &&
+	    (offset >= SEQ_COL_PARAMS) &&
+	    ((offset - SEQ_COL_PARAMS) % colP->hdr.array_size == 0L))
+	{
+	    colP->read_seg = seg;
+	    colP->read_chan = (offset - SEQ_COL_PARAMS) / colP->hdr.array_size;
+	}
+
+	count = 0L;
+	if (offset >= 0)
+	    count = seq_col_field(colP, seg, offset, bufferP, size);
+	if ((count <= 0) && ((size > 0) || (offset < 0)))
+	{
+	    printf("Could not find requested block in data file.\n");
+	    colP->read_seg = -1L;
+	    *statusP = FALSE;
+	    return (TRUE);
+	}
+	if (size <= 0)
+	    break;
+
+	offset += count;
+	size -= count;
+	dataP->bytes_read += count;
+	if (bufferP != NULL)
+	    bufferP += count;
+    }
+
+    colP->seg = seg;
+    dataP->block_offset = offset;
+    dataP->packet = 0;
+
+    if (seg == colP->hdr.num_segs)
+	SEQ_params.last_packet[dataP->plugin] = (BOOL)colP->hdr.end_last;
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Col_Last_Read(plugin, segP, channelP)
+  INT   plugin;
+  LONG  *segP;
+  INT   *channelP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Tell which channel of which segment the last read from the
+		cache was.
+
+    Outputs: TRUE and *segP (0 = first) and *channelP set if the last
+			SEQ_Col_Read_Seg() read the data of one channel of
+			a segment, all of it and nothing else
+	     FALSE otherwise
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Col_Last_Read() */
+
+    SEQ_COL *colP;
+
+    colP = &seq_col[plugin];
+    if ((seq_col_open == FALSE) || (colP->used == FALSE) ||
+	(colP->read_seg < 0))
+	return (FALSE);
+
+    *segP = colP->read_seg;
+    *channelP = (INT)colP->read_chan;
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Col_Gather(plugin, channel, seg, count, bufferP, flashP)
+  INT   plugin;
+  INT   channel;
+  LONG  seg;
+  LONG  count;
+  BYTE  *bufferP;
+  UWORD *flashP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Copy the data of one channel of consecutive segments, and
+		their last flash, out of the cache.
+
+    Inputs: seg   = first segment, 0 = first
+	    count = most segments wanted
+
+    Outputs: number of segments copied (0 if none): their data one after
+		the other into bufferP (array_size BYTEs each) and their
+		last flash into flashP[]
+
+    Notes: The reader is not moved.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Col_Gather() */
+
+    SEQ_COL *colP;
+
+    colP = &seq_col[plugin];
+    if ((seq_col_open == FALSE) || (colP->used == FALSE) || (seg < 0) ||
+	(channel < 0) || (channel >= colP->hdr.num_chan))
+	return (0L);
+
+    if (count > colP->hdr.num_segs - seg)
+	count = colP->hdr.num_segs - seg;
+    if (count <= 0)
+	return (0L);
+
+    if ((seq_col_fetch(colP->data_pos[channel] +
+		(SEQ_OFFSET)seg * colP->hdr.array_size, bufferP,
+		count * colP->hdr.array_size) == FALSE) ||
+	(seq_col_fetch(colP->flash_pos + seg * 2L, (BYTE *)flashP,
+		count * 2L) == FALSE))
+	return (0L);
+
+    return (count);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static LONG seq_col_field(colP, seg, offset, bufferP, size)
+  SEQ_COL *colP;
+  LONG  seg;
+  LONG  offset;
+  BYTE  *bufferP;
+  LONG  size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Copy what is asked for of one field of a segment's record:
+		the channel tag and acquisition parameters, or the data
+		of one channel.
+
+    Inputs: seg     = segment, 0 = first, num_segs for the tag after them
+	    offset  = offset into the record, 0 <= offset
+	    bufferP = where to copy to, NULL to only check the data is there
+	    size    = most BYTEs wanted
+
+    Outputs: BYTEs copied (at most size, 0 if size is 0)
+	     -1 if the record has nothing at offset
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_col_field() */
+
+    BYTE  head[SEQ_COL_PARAMS];
+    SEQ_ACQ_PARAMS params;
+    UWORD tag;
+    LONG  count;
+    LONG  c;
+
+    if (seg >= colP->hdr.num_segs)
+    {
+	/* Only the channel tag that followed the last segment */
+	if ((colP->hdr.end_tag < 0) || (offset >= 2L))
+	    return (-1L);
+	tag = (UWORD)colP->hdr.end_tag;
+	count = ((2L - offset) < size) ? (2L - offset) : size;
+	if (bufferP != NULL)
+	    memcpy(bufferP, (BYTE *)&tag + offset, (size_t)count);
+	return (count);
+    }
+
+    if (offset < SEQ_COL_PARAMS)
+    {
+	count = ((SEQ_COL_PARAMS - offset) < size) ?
+				(SEQ_COL_PARAMS - offset) : size;
+	if ((bufferP == NULL) || (count <= 0))
+	    return (count);
+
+	tag = SEQ_SEGMENT_BLOCK;
+	if ((seq_col_fetch(colP->flash_pos + seg * 2L,
+			(BYTE *)&params.last_flash, 2L) == FALSE) ||
+	    (seq_col_fetch(colP->fine_pos + seg * 2L,
+			(BYTE *)&params.fine_count, 2L) == FALSE) ||
+	    (seq_col_fetch(colP->time_pos + seg * (LONG)sizeof(TS),
+			(BYTE *)&params.time_stamp, (LONG)sizeof(TS)) == FALSE))
+	    return (-1L);
+	memcpy(head, (BYTE *)&tag, 2);
+	memcpy(head + 2, (BYTE *)&params, sizeof(params));
+	memcpy(bufferP, head + offset, (size_t)count);
+	return (count);
+    }
+
+    /* The data of one channel */
+    offset -= SEQ_COL_PARAMS;
+    c = offset / colP->hdr.array_size;
+    if (c >= colP->hdr.num_chan)
+	return (-1L);
+    offset -= c * colP->hdr.array_size;
+    count = ((colP->hdr.array_size - offset) < size) ?
+				(colP->hdr.array_size - offset) : size;
+    if ((bufferP != NULL) && (count > 0) &&
+	(seq_col_fetch(colP->data_pos[c] +
+		(SEQ_OFFSET)seg * colP->hdr.array_size + offset,
+		bufferP, count) == FALSE))
+	return (-1L);
+
+    return (count);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_col_fetch(pos, bufferP, size)
+  SEQ_OFFSET pos;
+  BYTE  *bufferP;
+  LONG  size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Copy size BYTEs at pos of the cache into bufferP.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_col_fetch() */
+
+    if ((pos < 0) || (pos + size > seq_col_size))
+	return (FALSE);
+
+    if (seq_col_baseP != NULL)
+    {
+	memcpy(bufferP, seq_col_baseP + pos, (size_t)size);
+	return (TRUE);
+    }
+
+    if (SEQ_FSEEK(seq_col_fP, pos, SEEK_SET) != 0)
+	return (FALSE);
+
+    return (fread((CHAR *)bufferP, 1, (size_t)size, seq_col_fP) ==
+							    (size_t)size);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_col_load(col_nameP, file_size)
+  CHAR        *col_nameP;
+  SEQ_OFFSET  file_size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Open the .col file if it exists and was built from this data
+		file as it is now, and map it if the host allows.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_col_load() */
+
+    FILE  *col_fP;
+    UBYTE head[SEQ_COL_HEAD];
+    ULONG block_size;
+    ULONG sizes[2][2];
+    ULONG *fieldP;
+    ULONG field;
+    SEQ_COL_HDR hdr[MAX_PLUGINS];
+    SEQ_OFFSET value;
+    SEQ_COL *colP;
+    LONG  *array_sizeP;
+    BOOL  ok;
+    INT   i;
+    BYTE  p,c;
+
+    if ((col_fP = fopen(col_nameP, "rb")) == NULL)
+	return (FALSE);
+
+    ok = (fread((CHAR *)head, sizeof(head), 1, col_fP) == 1) &&
+	 (strncmp((CHAR *)head, SEQ_COL_MAGIC, 4) == 0);
+
+    /* The 32 bit fields, the LONGs of the plugins' headers signed */
+    block_size = SEQ_Get32(&head[4]);
+    for (i=0; i < 4; ++i)
+	sizes[i / 2][i % 2] = SEQ_Get32(&head[8 + 4*i]);
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	fieldP = (ULONG *)&hdr[p];
+	for (i=0; i < SEQ_COL_FIELDS; ++i)
+	{
+	    field = SEQ_Get32(&head[24 + 4 * (p * SEQ_COL_FIELDS + i)]);
+	    if ((i < SEQ_COL_SIGNED) && (field & 0x80000000L))
+		field = (ULONG)(-(LONG)(~field & 0x7fffffffL) - 1L);
+	    fieldP[i] = field;
+	}
+    }
+
+    ok = (ok == TRUE) &&
+	 (block_size == (ULONG)SEQ_params.block_size) &&
+	 (seq_col_get(sizes[0], &value) == TRUE) && (value == file_size) &&
+	 (seq_col_get(sizes[1], &value) == TRUE) &&
+	 (value == SEQ_params.seg_offset);
+
+    /* Size of the cache, for checking the areas against */
+    if (ok == TRUE)
+    {
+	ok = (SEQ_FSEEK(col_fP, 0L, SEEK_END) == 0);
+	seq_col_size = SEQ_FTELL(col_fP);
+    }
+
+    for (p=0; (p < MAX_PLUGINS) && (ok == TRUE); ++p)
+    {
+	colP = &seq_col[p];
+	colP->hdr = hdr[p];
+	colP->seg = 0L;
+	colP->read_seg = -1L;
+	colP->used = (p >= SEQ_params.first_plugin) &&
+		     (p <= SEQ_params.last_plugin);
+	if (colP->used == FALSE)
+	    continue;
+
+	array_sizeP = (LONG *)PCW_Find_Value_From_Name(PCW_waveformP[p][0],
+			  (LONG)0, PCW_blockP[p][0], "WAVE_ARRAY_1");
+	colP->seg_size = SEQ_COL_PARAMS + hdr[p].num_chan * *array_sizeP;
+
+	ok = (hdr[p].num_chan == SEQ_params.last_channel[p] + 1) &&
+	     (hdr[p].array_size == *array_sizeP) &&
+	     (hdr[p].array_size > 0) && (hdr[p].num_segs >= 0) &&
+	     (seq_col_get(hdr[p].time_pos, &colP->time_pos) == TRUE) &&
+	     (seq_col_get(hdr[p].flash_pos, &colP->flash_pos) == TRUE) &&
+	     (seq_col_get(hdr[p].fine_pos, &colP->fine_pos) == TRUE) &&
+	     (colP->time_pos + hdr[p].num_segs * (SEQ_OFFSET)sizeof(TS) <=
+							    seq_col_size);
+	for (c=0; (c < hdr[p].num_chan) && (ok == TRUE); ++c)
+	    ok = (seq_col_get(hdr[p].data_pos[c], &colP->data_pos[c]) == TRUE)
+		 && (colP->data_pos[c] + (SEQ_OFFSET)hdr[p].num_segs *
+				hdr[p].array_size <= seq_col_size);
+    }
+
+    if (ok == FALSE)
+    {
+	if (SEQ_options.debug == 1)
+	    printf("Columnar cache %s is out of date\n", col_nameP);
+	fclose(col_fP);
+	return (FALSE);
+    }
+
+#ifdef SEQ_MMAP
+    if (((SEQ_OFFSET)(size_t)seq_col_size == seq_col_size) &&
+	(seq_col_size > 0))
+    {
+	VOID *addrP;
+
+	addrP = mmap(NULL, (size_t)seq_col_size, PROT_READ, MAP_SHARED,
+						    fileno(col_fP), (off_t)0);
+	if (addrP != MAP_FAILED)
+	{
+	    seq_col_baseP = (BYTE *)addrP;
+	    fclose(col_fP);
+	    return (TRUE);
+	}
+    }
+#endif /* SEQ_MMAP */
+
+    seq_col_fP = col_fP;
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_col_build(seq_fP, col_nameP, file_size)
+  FILE        *seq_fP;
+  CHAR        *col_nameP;
+  SEQ_OFFSET  file_size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Convert the data file into the .col file.
+
+    Outputs: TRUE if the cache was written
+
+    Notes: Each plugin is stepped through once to find its segments and
+	   their acquisition parameters, then each channel's data is
+	   copied segment after segment, so the cache is written in order.
+	   Failure to build only costs reading the data file as before.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_col_build() */
+
+    FILE  *col_fP;
+    SEQ_COL_HDR hdr[MAX_PLUGINS];
+    SEQ_COL_ENTRY *entryP[MAX_PLUGINS];
+    UBYTE head[SEQ_COL_HEAD];
+    ULONG sizes[2][2];
+    ULONG *fieldP;
+    LONG  *array_sizeP;
+    LONG  *desc_sizeP;
+    LONG  *time_sizeP;
+    LONG  offset;
+    LONG  size;
+    LONG  k;
+    SEQ_OFFSET pos;
+    SEQ_OFFSET end;
+    BYTE  *bufferP;
+    BOOL  ok;
+    INT   i;
+    BYTE  p,c;
+
+    memset((CHAR *)hdr, 0, sizeof(hdr));
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	entryP[p] = NULL;
+	hdr[p].end_tag = -1L;
+    }
+
+    bufferP = (BYTE *)malloc((size_t)SEQ_COL_BUF);
+    if (bufferP == NULL)
+    {
+	fprintf(stderr, "Not enough memory for columnar cache.\n");
+	return (FALSE);
+    }
+
+    /* Find the segments of every plugin and lay out the cache */
+    ok = TRUE;
+    pos = seq_col_align((SEQ_OFFSET)SEQ_COL_HEAD);
+    for (p=SEQ_params.first_plugin; (p <= SEQ_params.last_plugin) &&
+						(ok == TRUE); ++p)
+    {
+	array_sizeP = (LONG *)PCW_Find_Value_From_Name(PCW_waveformP[p][0],
+			  (LONG)0, PCW_blockP[p][0], "WAVE_ARRAY_1");
+	desc_sizeP = (LONG *)PCW_Find_Value_From_Name(PCW_waveformP[p][0],
+		      (LONG)0, PCW_blockP[p][0], "WAVE_DESCRIPTOR");
+	time_sizeP = (LONG *)PCW_Find_Value_From_Name(PCW_waveformP[p][0],
+		      (LONG)0, PCW_blockP[p][0], "TRIGTIME_ARRAY");
+
+	hdr[p].num_chan = SEQ_params.last_channel[p] + 1;
+	hdr[p].array_size = *array_sizeP;
+	hdr[p].desc_size = *desc_sizeP;
+	hdr[p].coeff_size = *time_sizeP;
+
+	hdr[p].num_segs = seq_col_scan(seq_fP, p, &hdr[p], &entryP[p]);
+	if (hdr[p].num_segs < 0)
+	{
+	    ok = FALSE;
+	    break;
+	}
+
+	seq_col_put(hdr[p].desc_pos, pos);
+	pos = seq_col_align(pos + hdr[p].num_chan *
+			    (SEQ_OFFSET)(hdr[p].desc_size + hdr[p].coeff_size));
+	seq_col_put(hdr[p].time_pos, pos);
+	pos = seq_col_align(pos + hdr[p].num_segs * (SEQ_OFFSET)sizeof(TS));
+	seq_col_put(hdr[p].flash_pos, pos);
+	pos = seq_col_align(pos + hdr[p].num_segs * (SEQ_OFFSET)2);
+	seq_col_put(hdr[p].fine_pos, pos);
+	pos = seq_col_align(pos + hdr[p].num_segs * (SEQ_OFFSET)2);
+	for (c=0; c < hdr[p].num_chan; ++c)
+	{
+	    seq_col_put(hdr[p].data_pos[c], pos);
+	    pos = seq_col_align(pos + (SEQ_OFFSET)hdr[p].num_segs *
+							hdr[p].array_size);
+	}
+    }
+    end = pos;
+
+    col_fP = NULL;
+    if ((ok == TRUE) && ((col_fP = fopen(col_nameP, "wb")) == NULL))
+    {
+	fprintf(stderr, "Could not create columnar cache %s\n", col_nameP);
+	ok = FALSE;
+    }
+
+    if (ok == TRUE)
+    {
+	seq_col_put(sizes[0], file_size);
+	seq_col_put(sizes[1], SEQ_params.seg_offset);
+	memcpy((CHAR *)head, SEQ_COL_MAGIC, 4);
+	SEQ_Put32(&head[4], (ULONG)SEQ_params.block_size);
+	for (i=0; i < 4; ++i)
+	    SEQ_Put32(&head[8 + 4*i], sizes[i / 2][i % 2]);
+	for (p=0; p < MAX_PLUGINS; ++p)
+	{
+	    fieldP = (ULONG *)&hdr[p];
+	    for (i=0; i < SEQ_COL_FIELDS; ++i)
+		SEQ_Put32(&head[24 + 4 * (p * SEQ_COL_FIELDS + i)],
+								fieldP[i]);
+	}
+	ok = (fwrite((CHAR *)head, sizeof(head), 1, col_fP) == 1);
+    }
+
+    for (p=SEQ_params.first_plugin; (p <= SEQ_params.last_plugin) &&
+						(ok == TRUE); ++p)
+    {
+	/* Descriptors and filter coefficients as read by SEQ_Read_Desc() */
+	offset = 8;
+	seq_col_get(hdr[p].desc_pos, &pos);
+	for (c=0; (c < hdr[p].num_chan) && (ok == TRUE); ++c)
+	{
+	    size = hdr[p].desc_size + hdr[p].coeff_size;
+	    ok = (size <= SEQ_COL_BUF) &&
+		 (SEQ_Read_Blocks_Desc(seq_fP, bufferP, p, size, offset)
+								== TRUE) &&
+		 (seq_col_write(col_fP, pos, bufferP, size) == TRUE);
+	    offset += size;
+	    pos += size;
+	}
+
+	/* Time stamps, last flashes and fine counts */
+	seq_col_get(hdr[p].time_pos, &pos);
+	for (k=0; (k < hdr[p].num_segs) && (ok == TRUE); ++k)
+	    ok = seq_col_write(col_fP, pos + k * (SEQ_OFFSET)sizeof(TS),
+		    (BYTE *)&entryP[p][k].params.time_stamp, (LONG)sizeof(TS));
+	seq_col_get(hdr[p].flash_pos, &pos);
+	for (k=0; (k < hdr[p].num_segs) && (ok == TRUE); ++k)
+	    ok = seq_col_write(col_fP, pos + k * (SEQ_OFFSET)2,
+		    (BYTE *)&entryP[p][k].params.last_flash, 2L);
+	seq_col_get(hdr[p].fine_pos, &pos);
+	for (k=0; (k < hdr[p].num_segs) && (ok == TRUE); ++k)
+	    ok = seq_col_write(col_fP, pos + k * (SEQ_OFFSET)2,
+		    (BYTE *)&entryP[p][k].params.fine_count, 2L);
+
+	/* The data of each channel, one segment after the other */
+	for (c=0; (c < hdr[p].num_chan) && (ok == TRUE); ++c)
+	    ok = seq_col_copy_data(seq_fP, col_fP, p, c, &hdr[p], entryP[p],
+								    bufferP);
+    }
+
+    /* Pad the cache to the end of the last area, so that every area
+       (even an empty one) lies within it */
+    if ((ok == TRUE) && (SEQ_FSEEK(col_fP, 0L, SEEK_END) == 0) &&
+	(SEQ_FTELL(col_fP) < end))
+    {
+	bufferP[0] = 0;
+	ok = seq_col_write(col_fP, end - 1, bufferP, 1L);
+    }
+
+    if ((col_fP != NULL) && (fclose(col_fP) != 0))
+	ok = FALSE;
+
+    if ((ok == FALSE) && (col_fP != NULL))
+    {
+	fprintf(stderr, "Could not write columnar cache %s\n", col_nameP);
+	remove(col_nameP);
+    }
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+	if (entryP[p] != NULL)
+	    free(entryP[p]);
+    free(bufferP);
+
+    return (ok);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static LONG seq_col_scan(seq_fP, plugin, hdrP, entryPP)
+  FILE  *seq_fP;
+  INT   plugin;
+  SEQ_COL_HDR *hdrP;
+  SEQ_COL_ENTRY **entryPP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Step through all complete segments of a plugin, reading only
+		the channel tag and acquisition parameters of each one,
+		and then the channel tag that follows them.
+
+    Outputs: number of segments, their positions in *entryPP
+	     -1 if the plugin cannot be cached
+
+    Notes: As seq_dir_build() in seq_dir.c, stops in front of the first
+	   segment that is not complete, so the block readers never run
+	   into the end of the data here.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_col_scan() */
+
+    SEQ_COL_ENTRY *entryP;
+    SEQ_ACQ_DATA  data;
+    SEQ_ACQ_PARAMS params;
+    LONG  seg_size;
+    LONG  num_segs;
+    LONG  max_segs;
+    SEQ_OFFSET pos;
+    LONG  block_offset;
+    SEQ_OFFSET left;
+    UWORD channel_tag;
+
+    seg_size = hdrP->num_chan * hdrP->array_size;
+
+    SEQ_Map_Seek(seq_fP, SEQ_params.seg_offset, SEEK_SET);
+    if (SEQ_Index_Left(seq_fP, plugin, 0L) < 0)
+	return (-1L);
+
+    num_segs = 0;
+    max_segs = 0;
+    *entryPP = NULL;
+
+    data.plugin = plugin;
+    data.block_offset = 0L;
+    for (;;)
+    {
+	pos = SEQ_Map_Tell(seq_fP);
+	block_offset = data.block_offset;
+
+	/* Tag, parameters and all channels, and a byte to spare so that
+	   skipping the data does not leave the file */
+	left = SEQ_Index_Left(seq_fP, plugin, block_offset);
+	if (left <= (SEQ_OFFSET)(SEQ_COL_PARAMS + seg_size))
+	    break;
+
+	data.bufP = (BYTE *)&channel_tag;
+	data.size = 2L;
+	data.byte_offset = 0L;
+	if (SEQ_Read_Blocks_Seg(seq_fP, &data, TRUE) == FALSE)
+	    return (-1L);
+	if (channel_tag != SEQ_SEGMENT_BLOCK)
+	    break;
+
+	data.bufP = (BYTE *)&params;
+	data.size = (LONG)sizeof(params);
+	if (SEQ_Read_Blocks_Seg(seq_fP, &data, TRUE) == FALSE)
+	    return (-1L);
+
+	if (num_segs == max_segs)
+	{
+	    max_segs = (max_segs == 0) ? 1024L : 2 * max_segs;
+	    entryP = (SEQ_COL_ENTRY *)realloc((VOID *)*entryPP,
+			    (size_t)(max_segs * sizeof(SEQ_COL_ENTRY)));
+	    if (entryP == NULL)
+	    {
+		fprintf(stderr, "Not enough memory for columnar cache.\n");
+		return (-1L);
+	    }
+	    *entryPP = entryP;
+	}
+
+	entryP = &(*entryPP)[num_segs++];
+	entryP->pos = pos;
+	entryP->block_offset = block_offset;
+	entryP->params = params;
+
+	/* Skip over the data of all channels */
+	data.bufP = NULL;
+	data.size = 0L;
+	data.byte_offset = seg_size;
+	if (SEQ_Read_Blocks_Seg(seq_fP, &data, FALSE) == FALSE)
+	    return (-1L);
+    }
+
+    /* The channel tag the translation loop will stop at, if any */
+    SEQ_Map_Seek(seq_fP, pos, SEEK_SET);
+    hdrP->end_tag = -1L;
+    if (left >= 2)
+    {
+	data.bufP = (BYTE *)&channel_tag;
+	data.size = 2L;
+	data.block_offset = block_offset;
+	data.byte_offset = 0L;
+	if (SEQ_Read_Blocks_Seg(seq_fP, &data, TRUE) == TRUE)
+	    hdrP->end_tag = (LONG)channel_tag;
+    }
+    hdrP->end_last = (LONG)SEQ_params.last_packet[plugin];
+
+    return (num_segs);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_col_copy_data(seq_fP, col_fP, plugin, channel, hdrP,
+							entryP, bufferP)
+  FILE  *seq_fP;
+  FILE  *col_fP;
+  INT   plugin;
+  INT   channel;
+  SEQ_COL_HDR *hdrP;
+  SEQ_COL_ENTRY *entryP;
+  BYTE  *bufferP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Copy a channel's data of every segment into its area of the
+		cache, SEQ_COL_BUF BYTEs at a time.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_col_copy_data() */
+
+    SEQ_ACQ_DATA data;
+    SEQ_OFFSET pos;
+    LONG  left;
+    LONG  k;
+
+    seq_col_get(hdrP->data_pos[channel], &pos);
+    data.plugin = plugin;
+    for (k=0; k < hdrP->num_segs; ++k)
+    {
+	SEQ_Map_Seek(seq_fP, entryP[k].pos, SEEK_SET);
+	data.block_offset = entryP[k].block_offset;
+	data.byte_offset = SEQ_COL_PARAMS + channel * hdrP->array_size;
+	data.bufP = bufferP;
+	for (left = hdrP->array_size; left > 0; left -= data.size)
+	{
+	    data.size = (left < SEQ_COL_BUF) ? left : SEQ_COL_BUF;
+	    if ((SEQ_Read_Blocks_Seg(seq_fP, &data, TRUE) == FALSE) ||
+		(seq_col_write(col_fP, pos, bufferP, data.size) == FALSE))
+		return (FALSE);
+	    pos += data.size;
+	    data.byte_offset = 0L;
+	}
+    }
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_col_write(col_fP, pos, bufferP, size)
+  FILE  *col_fP;
+  SEQ_OFFSET pos;
+  BYTE  *bufferP;
+  LONG  size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Write size BYTEs at pos of the cache being built.
+
+    Notes: The cache is written in order, so seeking only skips the
+	   padding between the areas.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_col_write() */
+
+    if (SEQ_FSEEK(col_fP, pos, SEEK_SET) != 0)
+	return (FALSE);
+
+    return (fwrite((CHAR *)bufferP, 1, (size_t)size, col_fP) ==
+							    (size_t)size);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_OFFSET seq_col_align(pos)
+  SEQ_OFFSET pos;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Round pos up to the start of the next area.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_col_align() */
+
+    return (((pos + SEQ_COL_ALIGN - 1) / SEQ_COL_ALIGN) * SEQ_COL_ALIGN);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_col_put(twoP, value)
+  ULONG *twoP;
+  SEQ_OFFSET value;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Store an offset as its low and high 32 bits.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_col_put() */
+
+    twoP[0] = (ULONG)(value & 0xffffffffL);
+    twoP[1] = (ULONG)((value >> 16) >> 16);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_col_get(twoP, valueP)
+  ULONG *twoP;
+  SEQ_OFFSET *valueP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Read back an offset stored by seq_col_put().
+
+    Outputs: FALSE if the offset does not fit a SEQ_OFFSET
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_col_get() */
+
+    if (sizeof(SEQ_OFFSET) <= 4)
+    {
+	if ((twoP[1] != 0) || (twoP[0] > 0x7fffffffL))
+	    return (FALSE);
+	*valueP = (SEQ_OFFSET)twoP[0];
+	return (TRUE);
+    }
+
+    *valueP = (((SEQ_OFFSET)twoP[1] << 16) << 16) + (SEQ_OFFSET)twoP[0];
+    return (TRUE);
+}
@@ -0,0 +1,255 @@
+/************************** seq_ctx.c **************************************
+
+Translator contexts.
+
+Everything a translation works on used to be a global variable or a
+static of the function or module that needed it, so that only one data
+file could be translated at a time in a program. All of it now lives in a
+SEQ_CONTEXT (seq_tran.h): the options, the data file's parameters,
+descriptors and filter coefficients, how far the output has got, and for
+every module with state of its own (packet index, segment directory,
+columnar cache, ...) a block of that state, made the first time the module
+is used in the context (SEQ_Module()).
+
+The translator works on the current context, SEQ_ctxP. The names of the
+old globals (SEQ_options, SEQ_params, PCW_waveformP, ...) are macros
+for their place in it, so the translator reads as before. With
+SEQ_THREADS and GCC the current context is per thread: each thread
+translating a data file makes a context of its own current, and a
+thread working for one (the reader of seq_ahd.c) takes on that of the
+thread it works for.
+
+Left to the whole program are the things that are the same for every
+data file once they are set: the machine template (seq_wfd.c), the
+filter kernels bound by SEQ_Vec_Init() and the engine timings of
+seq_filt.c. SEQ_Lock() guards the setting of them.
+
+Errors that used to end the program (EXIT, error_handler()) go through
+SEQ_Exit(), which returns to the library call in hand instead (see
+seq_lib.c) when there is one.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <setjmp.h>
+#include "seq_tran.h"
+
+#if defined(SEQ_THREADS)
+#include <pthread.h>
+#endif /* SEQ_THREADS */
+
+/* -------------------------------------------------------------------- */
+
+#if defined(SEQ_THREADS) && defined(__GNUC__)
+__thread SEQ_CONTEXT *SEQ_ctxP = NULL;
+__thread VOID *SEQ_jumpP = NULL;
+#else
+SEQ_CONTEXT *SEQ_ctxP = NULL;
+VOID *SEQ_jumpP = NULL;
+#endif
+
+#if defined(SEQ_THREADS)
+static pthread_mutex_t seq_ctx_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* SEQ_THREADS */
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+SEQ_CONTEXT *SEQ_Context_New()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Make a context to translate a data file in.
+
+    Outputs: the context, NULL if there is no memory for it
+
+    Notes: The options are all 0 (FALSE); the caller sets them (as
+	   SEQ_process_arguments() or SEQ_Open() do) after making the
+	   context current. No module has any state yet.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Context_New() */
+
+    SEQ_CONTEXT *ctxP;
+    BYTE  p,c;
+
+    ctxP = (SEQ_CONTEXT *)calloc((size_t)1, sizeof(SEQ_CONTEXT));
+    if (ctxP == NULL)
+	return (NULL);
+
+    /* No trace_PC.nnn file written, no segment output yet */
+    for (p=0; p < MAX_PLUGINS; ++p)
+	for (c=0; c < MAX_CHANNELS; ++c)
+	{
+	    ctxP->file_ext[p][c] = -1;
+	    ctxP->old_segno[p][c] = -1L;
+	}
+
+    return (ctxP);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+SEQ_CONTEXT *SEQ_Context_Copy()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Make a context for a thread that translates for the current
+		one (seq_job.c, seq_pip.c), or for a data file of a list
+		translated with the options of the current one (seq_wsp.c).
+
+    Outputs: a copy of the current context without the data file, any
+		output open or module state, NULL if there is no memory
+
+    Notes: It has the options, parameters, descriptors and filters the
+	   current context has now.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Context_Copy() */
+
+    SEQ_CONTEXT *ctxP;
+
+    ctxP = (SEQ_CONTEXT *)malloc(sizeof(SEQ_CONTEXT));
+    if (ctxP == NULL)
+	return (NULL);
+
+    memcpy((VOID *)ctxP, (VOID *)SEQ_ctxP, sizeof(SEQ_CONTEXT));
+    memset((VOID *)ctxP->moduleP, 0, sizeof(ctxP->moduleP));
+    ctxP->seq_fP = NULL;
+    ctxP->out_fP = NULL;
+    ctxP->spool_fP = NULL;
+
+    return (ctxP);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Context_Free(ctxP)
+  SEQ_CONTEXT *ctxP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Release a context and the state of its modules.
+
+    Notes: The modules must have been closed (SEQ_Close()); what they
+	   allocated themselves is not released here. If the context is
+	   the current one, there is no current context afterwards.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Context_Free() */
+
+    INT   id;
+
+    if (ctxP == NULL)
+	return;
+
+    for (id=0; id < SEQ_MODULES; ++id)
+	free(ctxP->moduleP[id]);
+
+    if (SEQ_ctxP == ctxP)
+	SEQ_ctxP = NULL;
+    free(ctxP);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID *SEQ_Module(id, size)
+  INT     id;
+  size_t  size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Make the state of a module in the current context, the
+		first time the module is used in it (SEQ_MODULE()).
+
+    Inputs: id   = SEQ_MOD_...
+	    size = size of the module's state
+
+    Outputs: the state, all 0 (FALSE, NULL)
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Module() */
+
+    if (SEQ_ctxP->moduleP[id] == NULL)
+    {
+	SEQ_ctxP->moduleP[id] = calloc((size_t)1, size);
+	if (SEQ_ctxP->moduleP[id] == NULL)
+	{
+	    printf("Out of memory\n");
+	    SEQ_Exit();
+	}
+    }
+
+    return (SEQ_ctxP->moduleP[id]);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Exit()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Give up the translation after an error.
+
+    Outputs: Returns to the library call in hand (seq_lib.c), which then
+		fails, or else ends the program.
+
+    Notes: Memory allocated by the translation that was given up is
+	   not released.
+
+	   SEQ_jumpP is per thread: a thread working for the one in the
+	   library call (the reader of seq_ahd.c) has none, and still
+	   ends the program, as it cannot return to another's call.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Exit() */
+
+    if (SEQ_jumpP != NULL)
+	longjmp(*(jmp_buf *)SEQ_jumpP, 1);
+
+    exit(1);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Lock()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Keep the other threads off what the contexts share (the
+		machine template, the engine timings) until SEQ_Unlock().
+
+    Machine dependencies: Does nothing without SEQ_THREADS.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Lock() */
+
+#if defined(SEQ_THREADS)
+    pthread_mutex_lock(&seq_ctx_lock);
+#endif /* SEQ_THREADS */
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Unlock()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Let the other threads at what the contexts share again.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Unlock() */
+
+#if defined(SEQ_THREADS)
+    pthread_mutex_unlock(&seq_ctx_lock);
+#endif /* SEQ_THREADS */
+}
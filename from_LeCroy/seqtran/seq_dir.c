@@ -0,0 +1,726 @@
+/************************** seq_dir.c **************************************
+
+Segment directory for SCSI sequence data files.
+
+SEQ_Read_Segment_Number() finds segment N by starting at
+SEQ_params.seg_offset and stepping over segments 1 to N-1 one channel at a
+time. For every plugin this module records, once, where each segment's
+channel tag (SEQ_SEGMENT_BLOCK) is in the file together with its
+SEQ_ACQ_PARAMS (last flash, TDC fine count, time stamp). The translation
+loop can then jump straight to the next segment that was selected by
+number or by time.
+
+A position is kept the way SEQ_Read_Blocks_Seg() keeps it: the offset of
+the start of a block in the file plus the offset into that block. After
+the last complete segment the directory records the position where the
+translation loop has to carry on by itself: the diagnostic block, the
+padding at the end of the data, or a segment cut short by the end of the
+file. Jumping there gives exactly what stepping would have given.
+
+The directory is built (with the packet index, which is needed to find the
+end of the data quietly) when the -i option is given, and is saved next to
+the data file with the extension .sdr:
+
+	CHAR  magic[4]		"SQSD"
+	UBYTE layout[20]	how this build lays out what follows
+				(SEQ_Sidecar_Head(), seq_idx.c)
+	SEQ_OFFSET block_size	block size of the data file
+	SEQ_OFFSET file_size	size of the data file when built
+	SEQ_OFFSET seg_offset	SEQ_params.seg_offset
+	SEQ_DIR_HDR  plugin[MAX_PLUGINS]
+	SEQ_DIR_ENTRY entries of plugin A, then of plugin B
+
+Time selections are resolved by a binary search, which assumes that the
+time stamps increase from segment to segment. If they do not, only
+segment number selections are used to jump.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "seq_tran.h"
+#include "seq_hdr.h"
+
+/* -------------------------------------------------------------------- */
+
+extern BOOL   SEQ_Read_Blocks_Seg();
+extern INT    SEQ_Map_Seek(FILE *seq_fP, SEQ_OFFSET offset, INT origin);
+extern SEQ_OFFSET SEQ_Map_Tell();
+extern SEQ_OFFSET SEQ_Map_Size();
+extern SEQ_OFFSET SEQ_Index_Left();
+extern VOID   SEQ_Sidecar_Name();
+extern BOOL   SEQ_Sidecar_Head();
+
+#define SEQ_DIR_MAGIC	"SQSD"
+#define SEQ_DIR_EXT	".sdr"
+
+typedef struct SEQ_DIR_ENTRY
+{
+    SEQ_OFFSET pos;		/* start of block holding the channel tag */
+    LONG  block_offset;		/* offset of the channel tag in the block */
+    LONG  last_packet;		/* SEQ_params.last_packet at this point */
+    SEQ_ACQ_PARAMS params;	/* last flash, TDC, time stamp */
+} SEQ_DIR_ENTRY;
+
+typedef struct SEQ_DIR_HDR
+{
+    LONG  num_segs;		/* complete segments in the directory */
+    SEQ_OFFSET end_pos;		/* where stepping has to take over */
+    LONG  end_offset;
+    LONG  end_last;		/* SEQ_params.last_packet at the end */
+    LONG  monotonic;		/* TRUE if the time stamps increase */
+} SEQ_DIR_HDR;
+
+typedef struct SEQ_DIR
+{
+    SEQ_DIR_HDR   hdr;
+    SEQ_DIR_ENTRY *entryP;
+    DOUBLE        time_per_pt;
+} SEQ_DIR;
+
+/* State of the module in the current context (seq_ctx.c) */
+typedef struct SEQ_DIR_STATE
+{
+    SEQ_DIR dir[MAX_PLUGINS];
+    BOOL    open;
+} SEQ_DIR_STATE;
+
+#define seq_dir		(SEQ_MODULE(SEQ_MOD_DIR, SEQ_DIR_STATE)->dir)
+#define seq_dir_open	(SEQ_MODULE(SEQ_MOD_DIR, SEQ_DIR_STATE)->open)
+
+static BOOL   seq_dir_load();
+static BOOL   seq_dir_build();
+static VOID   seq_dir_save();
+static DOUBLE seq_dir_time();
+static LONG   seq_dir_first();
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Dir_Open(seq_fP, seq_filenameP, build)
+  FILE  *seq_fP;
+  CHAR  *seq_filenameP;
+  INT   build;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Load the segment directory from the .sdr file, or build it
+		(and save it) if requested.
+
+    Inputs: seq_fP        = FILE pointer to the opened data file
+	    seq_filenameP = name of the data file
+	    build         = TRUE to build the directory if there is no
+				usable .sdr file
+
+    Outputs: TRUE if the translation loop can jump between segments
+
+    Machine dependencies:
+
+    Notes: Must be called after SEQ_READ_DESCRIPTOR, since the segment
+	   size and SEQ_params.seg_offset are needed. Building requires
+	   the packet index (SEQ_Index_Open()).
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Dir_Open() */
+
+    CHAR  dir_name[128];
+    FLOAT *time_per_ptP;
+    SEQ_OFFSET file_size;
+    SEQ_OFFSET pos;
+    BOOL  loaded;
+    BYTE  p;
+
+    if (seq_dir_open == TRUE)
+	return (TRUE);
+
+    SEQ_Sidecar_Name(seq_filenameP, SEQ_DIR_EXT, dir_name,
+						(INT)sizeof(dir_name));
+
+    pos = SEQ_Map_Tell(seq_fP);
+    file_size = SEQ_Map_Size(seq_fP);
+    if (file_size < 0)
+    {
+	SEQ_Map_Seek(seq_fP, pos, SEEK_SET);
+	if (SEQ_options.debug == 1)
+	    printf("No segment directory: the size of %s is not known\n",
+							    seq_filenameP);
+	return (FALSE);
+    }
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	seq_dir[p].hdr.num_segs = 0;
+	seq_dir[p].entryP = NULL;
+	seq_dir[p].time_per_pt = 0.0;
+	if ((p >= SEQ_params.first_plugin) && (p <= SEQ_params.last_plugin))
+	{
+	    time_per_ptP = (FLOAT *)PCW_Find_Value_From_Name(PCW_waveformP
+		    [p][0], (LONG)0, PCW_blockP[p][0], "HORIZ_INTERVAL");
+	    seq_dir[p].time_per_pt = *time_per_ptP;
+	}
+    }
+
+    loaded = seq_dir_load(dir_name, file_size);
+    if ((loaded == FALSE) && (build == TRUE))
+    {
+	loaded = TRUE;
+	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+	{
+	    if (seq_dir_build(seq_fP, p) == FALSE)
+		loaded = FALSE;
+	    SEQ_params.last_packet[p] = FALSE;
+	}
+
+	if (loaded == TRUE)
+	    seq_dir_save(dir_name, file_size);
+    }
+
+    SEQ_Map_Seek(seq_fP, pos, SEEK_SET);
+
+    if (loaded == FALSE)
+    {
+	for (p=0; p < MAX_PLUGINS; ++p)
+	{
+	    if (seq_dir[p].entryP != NULL)
+		free(seq_dir[p].entryP);
+	    seq_dir[p].entryP = NULL;
+	    seq_dir[p].hdr.num_segs = 0;
+	}
+	return (FALSE);
+    }
+
+    seq_dir_open = TRUE;
+
+    if (SEQ_options.debug == 1)
+    {
+	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+	    printf("Segment directory %c: %ld segments\n", p+'A',
+						seq_dir[p].hdr.num_segs);
+    }
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Dir_Close()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Release the memory used by the segment directory.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Dir_Close() */
+
+    BYTE p;
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	if (seq_dir[p].entryP != NULL)
+	    free(seq_dir[p].entryP);
+	seq_dir[p].entryP = NULL;
+	seq_dir[p].hdr.num_segs = 0;
+    }
+    seq_dir_open = FALSE;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Dir_Count(plugin)
+  INT   plugin;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Tell how many complete segments a plugin has.
+
+    Outputs: the number of segments in the directory, -1 if there is no
+		directory
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Dir_Count() */
+
+    if (seq_dir_open == FALSE)
+	return (-1L);
+
+    return (seq_dir[plugin].hdr.num_segs);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Next_Seg(plugin, segno)
+  INT   plugin;
+  LONG  segno;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Find the next segment, from segno on, that any channel of
+		the plugin could want translated.
+
+    Inputs: plugin = 0 for plugin A, 1 for plugin B
+	    segno  = segment the translation loop is about to read
+
+    Outputs: segment number to continue with; segno if nothing can be
+		skipped or nothing more is wanted at all (the loop then
+		finds out by itself), num_segs+1 if only segments past the
+		directory can be wanted (the loop carries on from the end
+		position).
+
+    Notes: Errs on the side of returning too early a segment; the loop
+	   still asks SEQ_Check_Seg() about every segment it reads.
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Next_Seg() */
+
+    SEQ_DIR *dirP;
+    SEGS    *segP;
+    LONG    next;
+    LONG    k;
+    BOOL    wanted;
+    BYTE    c;
+
+    dirP = &seq_dir[plugin];
+    if ((seq_dir_open == FALSE) || (segno > dirP->hdr.num_segs))
+	return (segno);
+
+    if ((SEQ_options.print_times == TRUE) || (segno < 2))
+	return (segno);
+
+    next = dirP->hdr.num_segs + 1;
+    wanted = FALSE;
+    for (c=0; c <= SEQ_params.last_channel[plugin]; ++c)
+    {
+	if (SEQ_options.all_segs[plugin][c] == TRUE)
+	    return (segno);
+
+	/* Selections by number are sorted by their start */
+	for (segP = SEQ_options.seg[plugin][c][SEQ_SEGNO];
+	     segP->select.n.start != -1L; ++segP)
+	{
+	    if (segP->select.n.end >= segno)
+	    {
+		k = (segP->select.n.start > segno) ?
+					    segP->select.n.start : segno;
+		if (k < next)
+		    next = k;
+		wanted = TRUE;
+		break;
+	    }
+	}
+
+	/* Selections by time, relative to the first segment */
+	segP = SEQ_options.seg[plugin][c][SEQ_TIME];
+	if (segP->select.t.start == (DOUBLE)-1)
+	    continue;
+
+	if (dirP->hdr.monotonic == FALSE)
+	    return (segno);
+
+	for (; segP->select.t.start != (DOUBLE)-1; ++segP)
+	{
+	    if (segP->select.t.start == segP->select.t.end)
+	    {
+		/* Only the first segment at or after this time */
+		k = seq_dir_first(dirP, 1L, segP->select.t.start);
+		if (k < segno)
+		    continue;
+	    }
+	    else
+	    {
+		k = seq_dir_first(dirP, segno, segP->select.t.start);
+		if ((k <= dirP->hdr.num_segs) &&
+		    (seq_dir_time(dirP, k) > segP->select.t.end))
+		    continue;
+	    }
+	    if (k < next)
+		next = k;
+	    wanted = TRUE;
+	}
+    }
+
+    if (wanted == FALSE)
+	return (segno);
+
+    return (next);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Dir_Seek(seq_fP, plugin, segno, block_offsetP)
+  FILE  *seq_fP;
+  INT   plugin;
+  LONG  segno;
+  LONG  *block_offsetP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Position the data file at the channel tag of a segment.
+
+    Inputs: plugin = 0 for plugin A, 1 for plugin B
+	    segno  = 1..num_segs, or num_segs+1 for the end position
+
+    Outputs: TRUE and *block_offsetP set for SEQ_Read_Blocks_Seg()
+	     FALSE if the segment is not in the directory
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Dir_Seek() */
+
+    SEQ_DIR *dirP;
+
+    dirP = &seq_dir[plugin];
+    if ((seq_dir_open == FALSE) || (segno < 1) ||
+	(segno > dirP->hdr.num_segs + 1))
+	return (FALSE);
+
+    if (segno > dirP->hdr.num_segs)
+    {
+	SEQ_Map_Seek(seq_fP, dirP->hdr.end_pos, SEEK_SET);
+	*block_offsetP = dirP->hdr.end_offset;
+	SEQ_params.last_packet[plugin] = (BOOL)dirP->hdr.end_last;
+    }
+    else
+    {
+	SEQ_Map_Seek(seq_fP, dirP->entryP[segno-1].pos, SEEK_SET);
+	*block_offsetP = dirP->entryP[segno-1].block_offset;
+	SEQ_params.last_packet[plugin] =
+				(BOOL)dirP->entryP[segno-1].last_packet;
+    }
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+DOUBLE SEQ_Dir_Stamp(plugin, segno)
+  INT   plugin;
+  LONG  segno;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Time stamp of a segment in seconds, computed as
+		SEQ_Read_Segment_Number() computes it from the segment's
+		acquisition parameters.
+
+    Inputs: plugin = 0 for plugin A, 1 for plugin B
+	    segno  = 1..num_segs
+
+    Notes: For the shards of -m (seq_shd.c), which start the loop part
+	   way into the segments.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Dir_Stamp() */
+
+    SEQ_DIR *dirP;
+    DOUBLE  stamp;
+    FLOAT   time_per_pt;
+#ifdef RESOLUTION_1_PSEC
+    FLOAT   trigger_delay;
+#endif  /* RESOLUTION_1_PSEC */
+
+    dirP = &seq_dir[plugin];
+    time_per_pt = (FLOAT)dirP->time_per_pt;
+    stamp = GET_DOUBLE(dirP->entryP[segno-1].params.time_stamp) *
+							    time_per_pt;
+#ifdef RESOLUTION_1_PSEC
+    trigger_delay = ((FLOAT)dirP->entryP[segno-1].params.fine_count *
+						time_per_pt) / 32768.0;
+    stamp += trigger_delay;
+#endif  /* RESOLUTION_1_PSEC */
+
+    return (stamp);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_dir_build(seq_fP, plugin)
+  FILE  *seq_fP;
+  INT   plugin;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Step through all segments of a plugin, reading only the
+		channel tag and acquisition parameters of each one.
+
+    Notes: Stops in front of the first segment that is not complete in
+	   the file, so the block readers never run into the end of the
+	   data here.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_dir_build() */
+
+    SEQ_DIR       *dirP;
+    SEQ_DIR_ENTRY *entryP;
+    SEQ_ACQ_DATA  data;
+    SEQ_ACQ_PARAMS params;
+    LONG  *array_sizeP;
+    LONG  seg_size;
+    LONG  max_segs;
+    SEQ_OFFSET pos;
+    LONG  block_offset;
+    SEQ_OFFSET left;
+    BOOL  last_packet;
+    UWORD channel_tag;
+
+    dirP = &seq_dir[plugin];
+
+    array_sizeP = (LONG *)PCW_Find_Value_From_Name(PCW_waveformP[plugin][0],
+			  (LONG)0, PCW_blockP[plugin][0], "WAVE_ARRAY_1");
+    seg_size = (SEQ_params.last_channel[plugin] + 1) * *array_sizeP;
+
+    SEQ_Map_Seek(seq_fP, SEQ_params.seg_offset, SEEK_SET);
+    if (SEQ_Index_Left(seq_fP, plugin, 0L) < 0)
+	return (FALSE);
+
+    max_segs = 0;
+    dirP->entryP = NULL;
+    dirP->hdr.num_segs = 0;
+    dirP->hdr.monotonic = TRUE;
+
+    data.plugin = plugin;
+    data.block_offset = 0L;
+    for (;;)
+    {
+	pos = SEQ_Map_Tell(seq_fP);
+	block_offset = data.block_offset;
+	last_packet = SEQ_params.last_packet[plugin];
+
+	/* Tag, parameters and all channels, and a byte to spare so that
+	   skipping the data does not leave the file */
+	left = SEQ_Index_Left(seq_fP, plugin, block_offset);
+	if (left <= (SEQ_OFFSET)(2L + (LONG)sizeof(params) + seg_size))
+	    break;
+
+	data.bufP = (BYTE *)&channel_tag;
+	data.size = 2L;
+	data.byte_offset = 0L;
+	if (SEQ_Read_Blocks_Seg(seq_fP, &data, TRUE) == FALSE)
+	    break;
+	if (channel_tag != SEQ_SEGMENT_BLOCK)
+	    break;
+
+	data.bufP = (BYTE *)&params;
+	data.size = (LONG)sizeof(params);
+	if (SEQ_Read_Blocks_Seg(seq_fP, &data, TRUE) == FALSE)
+	    break;
+
+	if (dirP->hdr.num_segs == max_segs)
+	{
+	    max_segs = (max_segs == 0) ? 1024L : 2 * max_segs;
+	    entryP = (SEQ_DIR_ENTRY *)realloc((VOID *)dirP->entryP,
+			    (size_t)(max_segs * sizeof(SEQ_DIR_ENTRY)));
+	    if (entryP == NULL)
+	    {
+		fprintf(stderr, "Not enough memory for segment directory.\n");
+		return (FALSE);
+	    }
+	    dirP->entryP = entryP;
+	}
+
+	entryP = &dirP->entryP[dirP->hdr.num_segs++];
+	entryP->pos = pos;
+	entryP->block_offset = block_offset;
+	entryP->last_packet = (LONG)last_packet;
+	entryP->params = params;
+
+	if ((dirP->hdr.num_segs > 1) &&
+	    (seq_dir_time(dirP, dirP->hdr.num_segs) <
+			seq_dir_time(dirP, dirP->hdr.num_segs - 1)))
+	    dirP->hdr.monotonic = FALSE;
+
+	/* Skip over the data of all channels */
+	data.bufP = NULL;
+	data.size = 0L;
+	data.byte_offset = seg_size;
+	if (SEQ_Read_Blocks_Seg(seq_fP, &data, FALSE) == FALSE)
+	    return (FALSE);
+    }
+
+    dirP->hdr.end_pos = pos;
+    dirP->hdr.end_offset = block_offset;
+    dirP->hdr.end_last = (LONG)last_packet;
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_dir_load(dir_nameP, file_size)
+  CHAR        *dir_nameP;
+  SEQ_OFFSET  file_size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Read the directory from the .sdr file if it exists and was
+		built from this data file as it is now.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_dir_load() */
+
+    FILE *dir_fP;
+    SEQ_OFFSET sizes[3];
+    SEQ_DIR_HDR hdr[MAX_PLUGINS];
+    BOOL ok;
+    BYTE p;
+
+    if ((dir_fP = fopen(dir_nameP, "rb")) == NULL)
+	return (FALSE);
+
+    ok = (SEQ_Sidecar_Head(dir_fP, SEQ_DIR_MAGIC,
+			(LONG)(sizeof(sizes) + sizeof(hdr)),
+			(LONG)sizeof(SEQ_DIR_ENTRY), FALSE) == TRUE) &&
+	 (fread((CHAR *)sizes, sizeof(sizes), 1, dir_fP) == 1) &&
+	 (fread((CHAR *)hdr, sizeof(hdr), 1, dir_fP) == 1) &&
+	 (sizes[0] == (SEQ_OFFSET)SEQ_params.block_size) &&
+	 (sizes[1] == file_size) &&
+	 (sizes[2] == SEQ_params.seg_offset);
+
+    for (p=0; (p < MAX_PLUGINS) && (ok == TRUE); ++p)
+    {
+	seq_dir[p].hdr = hdr[p];
+	if (hdr[p].num_segs == 0)
+	    continue;
+
+	seq_dir[p].entryP = (SEQ_DIR_ENTRY *)malloc((size_t)
+				(hdr[p].num_segs * sizeof(SEQ_DIR_ENTRY)));
+	ok = (seq_dir[p].entryP != NULL) &&
+	     (fread((CHAR *)seq_dir[p].entryP, sizeof(SEQ_DIR_ENTRY),
+		    (size_t)hdr[p].num_segs, dir_fP) ==
+					    (size_t)hdr[p].num_segs);
+    }
+
+    if ((ok == FALSE) && (SEQ_options.debug == 1))
+	printf("Segment directory %s is out of date\n", dir_nameP);
+
+    fclose(dir_fP);
+    return (ok);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_dir_save(dir_nameP, file_size)
+  CHAR        *dir_nameP;
+  SEQ_OFFSET  file_size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Write the directory to the .sdr file. Failure to do so only
+		costs building it again on the next run.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_dir_save() */
+
+    FILE *dir_fP;
+    SEQ_OFFSET sizes[3];
+    SEQ_DIR_HDR hdr[MAX_PLUGINS];
+    BOOL ok;
+    BYTE p;
+
+    if ((dir_fP = fopen(dir_nameP, "wb")) == NULL)
+    {
+	fprintf(stderr, "Could not create segment directory %s\n",
+							    dir_nameP);
+	return;
+    }
+
+    sizes[0] = SEQ_params.block_size;
+    sizes[1] = file_size;
+    sizes[2] = SEQ_params.seg_offset;
+    for (p=0; p < MAX_PLUGINS; ++p)
+	hdr[p] = seq_dir[p].hdr;
+
+    ok = (SEQ_Sidecar_Head(dir_fP, SEQ_DIR_MAGIC,
+			(LONG)(sizeof(sizes) + sizeof(hdr)),
+			(LONG)sizeof(SEQ_DIR_ENTRY), TRUE) == TRUE) &&
+	 (fwrite((CHAR *)sizes, sizeof(sizes), 1, dir_fP) == 1) &&
+	 (fwrite((CHAR *)hdr, sizeof(hdr), 1, dir_fP) == 1);
+
+    for (p=0; (p < MAX_PLUGINS) && (ok == TRUE); ++p)
+    {
+	if (hdr[p].num_segs != 0)
+	    ok = (fwrite((CHAR *)seq_dir[p].entryP, sizeof(SEQ_DIR_ENTRY),
+			 (size_t)hdr[p].num_segs, dir_fP) ==
+					    (size_t)hdr[p].num_segs);
+    }
+
+    if (fclose(dir_fP) != 0)
+	ok = FALSE;
+
+    if (ok == FALSE)
+    {
+	fprintf(stderr, "Could not write segment directory %s\n", dir_nameP);
+	remove(dir_nameP);
+    }
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static DOUBLE seq_dir_time(dirP, segno)
+  SEQ_DIR *dirP;
+  LONG    segno;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Time of a segment relative to segment 1, computed as in
+		SEQ_Read_Segment_Number().
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_dir_time() */
+
+    DOUBLE first_seg_time;
+    DOUBLE next_seg_time;
+    FLOAT  time_per_pt;
+
+    time_per_pt = (FLOAT)dirP->time_per_pt;
+    first_seg_time = GET_DOUBLE(dirP->entryP[0].params.time_stamp) *
+							    time_per_pt;
+    next_seg_time = GET_DOUBLE(dirP->entryP[segno-1].params.time_stamp) *
+							    time_per_pt;
+
+    return (next_seg_time - first_seg_time);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static LONG seq_dir_first(dirP, segno, time)
+  SEQ_DIR *dirP;
+  LONG    segno;
+  DOUBLE  time;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Return the first segment, from segno on, acquired at or
+		after time (num_segs+1 if none). Time stamps must increase.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_dir_first() */
+
+    LONG lo, hi, mid;
+
+    lo = segno;
+    hi = dirP->hdr.num_segs + 1;
+    while (lo < hi)
+    {
+	mid = lo + (hi - lo) / 2;
+	if (seq_dir_time(dirP, mid) < time)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+
+    return (lo);
+}
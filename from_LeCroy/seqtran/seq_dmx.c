@@ -0,0 +1,595 @@
+/************************** seq_dmx.c **************************************
+
+Single pass demultiplexing of the two plugins of a SCSI sequence data file.
+
+The blocks of plugin A and plugin B are interleaved in the data file in the
+order they were acquired. The plugins are translated one after the other,
+and SEQ_Read_Blocks_Seg() finds a plugin's data by walking every block of
+the file and skipping those of the other plugin, so a file holding both
+plugins used to be read once for A and a second time for B.
+
+While plugin A is translated, the block walker now hands every block of
+plugin B that it comes across to SEQ_Dmx_Skip() instead of seeking past
+it. Each block is classified once, in file order, and the payload of a
+B block is kept (by address if the file is mapped, see seq_map.c, or in a
+copy otherwise). When plugin B is translated, SEQ_Dmx_Read_Seg() serves
+its reads from these blocks and the data file is only positioned, never
+read again.
+
+Whatever was not collected (the part of the file after the point where
+plugin A was finished, a block out of sequence, or everything once memory
+runs out) is left to the block walker, which reads it from the file as it
+always did and reports any errors just as before.
+
+A streamed input (see seq_map.c) cannot be read a second time, so there the
+blocks after the point where plugin A was finished are collected too, as
+plugin B's reads come to need them.
+
+A translation that carries on from an earlier run (see seq_ckp.c) starts
+each plugin where that run left it, and collecting starts at the earlier
+of these places instead of at the beginning of the segment data.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "seq_tran.h"
+
+/* -------------------------------------------------------------------- */
+
+extern BYTE   *SEQ_Map_Ptr();
+extern size_t SEQ_Map_Read();
+extern INT    SEQ_Map_Seek(FILE *seq_fP, SEQ_OFFSET offset, INT origin);
+extern SEQ_OFFSET SEQ_Map_Tell();
+
+typedef struct SEQ_DMX_BLOCK
+{
+    SEQ_OFFSET pos;		/* file offset of the block */
+    BYTE  *dataP;		/* payload of the block */
+    UWORD packet;		/* packet number, plugin bit removed */
+    BOOL  copied;		/* TRUE if dataP was allocated here */
+} SEQ_DMX_BLOCK;
+
+typedef struct SEQ_DMX_PLUGIN
+{
+    SEQ_DMX_BLOCK *blockP;	/* blocks collected, in file order */
+    LONG  num;			/* blocks in blockP */
+    LONG  max;			/* room in blockP */
+    LONG  hint;			/* entry of blockP used last */
+    UWORD expect;		/* next packet number in sequence */
+    BOOL  any;			/* TRUE if any packet number may follow */
+    BOOL  stopped;		/* TRUE if no more blocks are collected */
+} SEQ_DMX_PLUGIN;
+
+typedef struct SEQ_DMX
+{
+    SEQ_OFFSET first;		/* where collecting started */
+    SEQ_OFFSET next;		/* first block not yet classified */
+    SEQ_DMX_PLUGIN plugin[MAX_PLUGINS];
+} SEQ_DMX;
+
+/* State of the module in the current context (seq_ctx.c) */
+typedef struct SEQ_DMX_STATE
+{
+    SEQ_DMX dmx;
+    BOOL    open;
+} SEQ_DMX_STATE;
+
+#define seq_dmx		(SEQ_MODULE(SEQ_MOD_DMX, SEQ_DMX_STATE)->dmx)
+#define seq_dmx_open	(SEQ_MODULE(SEQ_MOD_DMX, SEQ_DMX_STATE)->open)
+
+static VOID seq_dmx_keep();
+static VOID seq_dmx_free();
+static LONG seq_dmx_find();
+static BOOL seq_dmx_more();
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Dmx_Open(seq_fP)
+  FILE  *seq_fP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Prepare to collect the blocks of the later plugins while the
+		first one is translated.
+
+    Inputs: seq_fP = FILE pointer to the opened data file
+
+    Outputs: TRUE if both plugins are present and blocks will be collected
+
+    Machine dependencies:
+
+    Notes: Must be called after SEQ_READ_DESCRIPTOR, since the segment
+	   data starts at SEQ_params.seg_offset.
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Dmx_Open() */
+
+    BYTE p;
+
+    if ((seq_dmx_open == TRUE) ||
+	(SEQ_params.first_plugin == SEQ_params.last_plugin))
+	return (FALSE);
+
+    seq_dmx.first = SEQ_params.seg_offset;
+    seq_dmx.next = SEQ_params.seg_offset;
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	seq_dmx.plugin[p].blockP = NULL;
+	seq_dmx.plugin[p].num = 0;
+	seq_dmx.plugin[p].max = 0;
+	seq_dmx.plugin[p].hint = 0;
+	seq_dmx.plugin[p].expect = 0;
+	seq_dmx.plugin[p].any = TRUE;
+	seq_dmx.plugin[p].stopped = (p <= SEQ_params.first_plugin);
+    }
+
+    seq_dmx_open = TRUE;
+
+    if (SEQ_options.debug == 1)
+	printf("Demultiplexing plugins %c-%c in one pass\n",
+		    SEQ_params.first_plugin+'A', SEQ_params.last_plugin+'A');
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Dmx_Resume(seq_fP, startP)
+  FILE        *seq_fP;
+  SEQ_OFFSET  startP[];
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Collect from where the plugins' translation starts when it
+		carries on from an earlier run.
+
+    Inputs: seq_fP    = FILE pointer to the opened data file
+	    startP[p] = position where plugin p's translation starts
+
+    Notes: Must be called after SEQ_Dmx_Open() and before anything is
+	   read. If a later plugin starts before the first one, the blocks
+	   in between are classified here, since the first plugin's reads
+	   never pass over them. The position of seq_fP is restored.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Dmx_Resume() */
+
+    SEQ_OFFSET first;
+    BYTE p;
+
+    if (seq_dmx_open == FALSE)
+	return;
+
+    first = startP[SEQ_params.first_plugin];
+    for (p=SEQ_params.first_plugin+1; p <= SEQ_params.last_plugin; ++p)
+	if (startP[p] < first)
+	    first = startP[p];
+
+    seq_dmx.first = first;
+    seq_dmx.next = first;
+
+    while ((seq_dmx.next < startP[SEQ_params.first_plugin]) &&
+	   (seq_dmx_more(seq_fP, (INT)SEQ_params.last_plugin) == TRUE))
+	;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Dmx_Close()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Release the blocks collected for all plugins.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Dmx_Close() */
+
+    BYTE p;
+
+    if (seq_dmx_open == FALSE)
+	return;
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+	seq_dmx_free(p);
+    seq_dmx_open = FALSE;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Dmx_Skip(seq_fP, packet, plugin)
+  FILE  *seq_fP;
+  INT   packet;
+  INT   plugin;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Step over a block of another plugin, keeping its payload if
+		that plugin is still to be translated.
+
+    Inputs: seq_fP = FILE pointer, just past the packet number of the block
+	    packet = packet number just read, including the plugin bit
+	    plugin = plugin being read by the caller
+
+    Outputs: seq_fP is left at the start of the next block.
+
+    Notes: Replaces the forward seek over another plugin's block in the
+	   block walker. The walker moves through the file one block at
+	   a time, so every block between the last one classified and
+	   this one belongs to the plugin being read.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Dmx_Skip() */
+
+    SEQ_OFFSET pos;
+    LONG payload;
+    INT  other;
+
+    payload = SEQ_params.block_size - 2;
+    pos = SEQ_Map_Tell(seq_fP) - 2;
+    other = ((UWORD)packet >> 15);
+
+    if ((seq_dmx_open == FALSE) || (pos < seq_dmx.next) ||
+	(other <= plugin))
+    {
+	SEQ_Map_Seek(seq_fP, payload, SEEK_CUR);
+	return;
+    }
+
+    seq_dmx.next = pos + SEQ_params.block_size;
+    seq_dmx_keep(seq_fP, other, (UWORD)(packet & 0x7fff), pos);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Dmx_Read_Seg(seq_fP, dataP, read, statusP)
+  FILE          *seq_fP;
+  SEQ_ACQ_DATA  *dataP;
+  INT           read;
+  BOOL          *statusP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Read_Blocks_Seg() from the blocks collected for a plugin.
+
+    Inputs: same as SEQ_Read_Blocks_Seg()
+
+    Outputs: TRUE if the request was handled; *statusP is then the value
+			SEQ_Read_Blocks_Seg() must return.
+	     FALSE if some of the blocks needed were not collected and the
+			caller has to walk the file itself. Nothing has
+			been changed in that case.
+
+    Machine dependencies:
+
+    Notes: Positions are kept exactly as SEQ_Read_Blocks_Seg() keeps them:
+	   seq_fP is left at the start of the block where reading stopped
+	   and dataP->block_offset is set accordingly, so that the block
+	   walker can take over at any time.
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Dmx_Read_Seg() */
+
+    SEQ_DMX_PLUGIN *plugP;
+    SEQ_DMX_BLOCK  *blockP;
+    LONG  payload;
+    LONG  ord;
+    LONG  last;
+    SEQ_OFFSET logical;
+    LONG  offset;
+    LONG  size;
+    LONG  count;
+    SEQ_OFFSET pos;
+    BYTE  *bufferP;
+    WORD  p;
+
+    p = dataP->plugin;
+    if (seq_dmx_open == FALSE)
+	return (FALSE);
+
+    plugP = &seq_dmx.plugin[p];
+    if (plugP->num == 0)
+	return (FALSE);
+
+    payload = SEQ_params.block_size - 2;
+    blockP = plugP->blockP;
+    pos = SEQ_Map_Tell(seq_fP);
+    offset = dataP->block_offset + dataP->byte_offset;
+
+    /* Nothing before the point where collecting started was looked at */
+    if (pos < seq_dmx.first)
+	return (FALSE);
+
+    /* First collected block at or after the current one */
+    ord = seq_dmx_find(p, pos);
+    if ((ord < plugP->num) && (blockP[ord].packet == 0))   /* descriptor */
+	ord++;
+
+    /* Going backwards is only defined from one of this plugin's blocks */
+    if ((offset < 0) && ((ord >= plugP->num) || (blockP[ord].pos != pos)))
+	return (FALSE);
+
+    logical = (SEQ_OFFSET)ord * payload + offset;
+    if (logical < 0)
+	return (FALSE);
+    ord = (LONG)(logical / payload);
+    offset = (LONG)(logical % payload);
+
+    /* All blocks up to the last BYTE wanted must have been collected */
+    size = dataP->size;
+    last = (size > 0) ? (LONG)((logical + size - 1) / payload) : ord;
+    if (SEQ_options.stream == TRUE)
+    {
+	while ((last >= plugP->num) && (seq_dmx_more(seq_fP, p) == TRUE))
+	    ;
+	blockP = plugP->blockP;
+    }
+    if (last >= plugP->num)
+	return (FALSE);
+
+    dataP->bytes_read = 0L;
+    dataP->packet = 0;
+
+    bufferP = dataP->bufP;
+    if (size > 0)
+    {
+	count = payload - offset;
+	while (size > 0)
+	{
+	    if (size < count)
+		count = size;
+
+	    if (read == TRUE)
+	    {
+		memcpy((VOID *)bufferP, (VOID *)(blockP[ord].dataP + offset),
+							    (size_t)count);
+		bufferP += count;
+	    }
+
+	    size -= count;
+	    offset += count;
+	    dataP->bytes_read += count;
+
+	    if (size > 0)
+	    {
+		++ord;
+		count = payload;
+		offset = 0;
+	    }
+	}
+    }
+
+    /* Leave the file at the beginning of this block */
+    SEQ_Map_Seek(seq_fP, blockP[ord].pos, SEEK_SET);
+    plugP->hint = ord;
+
+    dataP->block_offset = offset;
+
+    if (blockP[ord].packet == 0x7fff)
+	SEQ_params.last_packet[p] = TRUE;
+
+    *statusP = TRUE;
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_dmx_keep(seq_fP, plugin, packet, pos)
+  FILE  *seq_fP;
+  INT   plugin;
+  UWORD packet;
+  SEQ_OFFSET pos;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Add a block to the plugin's collection and step over it.
+
+    Notes: The sequence rules are those of the packet index (seq_idx.c).
+	   Collection of a plugin stops for good at the first block that
+	   is out of sequence, cut short by the end of the file, or that
+	   there is no memory for; the walker deals with the rest.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_dmx_keep() */
+
+    SEQ_DMX_PLUGIN *plugP;
+    SEQ_DMX_BLOCK  *blockP;
+    LONG  payload;
+    LONG  bytes;
+    LONG  max;
+    BYTE  *dataP;
+    BOOL  copied;
+
+    plugP = &seq_dmx.plugin[plugin];
+    payload = SEQ_params.block_size - 2;
+
+    if (plugP->stopped == FALSE)
+    {
+	if (packet == 0x7fff)
+	    plugP->any = TRUE;
+	else if ((packet == plugP->expect) ||
+		 ((plugP->any == TRUE) && ((packet != 0) || (plugP->num == 0))))
+	{
+	    plugP->any = FALSE;
+	    plugP->expect = (packet == 0x7ffe) ? 1 : packet + 1;
+	}
+	else
+	    plugP->stopped = TRUE;
+    }
+
+    if ((plugP->stopped == FALSE) && (plugP->num == plugP->max))
+    {
+	max = (plugP->max == 0) ? 256L : 2 * plugP->max;
+	bytes = max * (LONG)sizeof(SEQ_DMX_BLOCK);
+	blockP = NULL;
+	if ((LONG)(size_t)bytes == bytes)
+	    blockP = (SEQ_DMX_BLOCK *)realloc((VOID *)plugP->blockP,
+							    (size_t)bytes);
+	if (blockP == NULL)
+	    plugP->stopped = TRUE;
+	else
+	{
+	    plugP->blockP = blockP;
+	    plugP->max = max;
+	}
+    }
+
+    if (plugP->stopped == TRUE)
+    {
+	SEQ_Map_Seek(seq_fP, payload, SEEK_CUR);
+	return;
+    }
+
+    /* Keep the address of a mapped block, or a copy of it */
+    copied = FALSE;
+    dataP = SEQ_Map_Ptr(seq_fP, payload);
+    if (dataP == NULL)
+    {
+	copied = TRUE;
+	dataP = (BYTE *)malloc((size_t)payload);
+	if ((dataP == NULL) ||
+	    (SEQ_Map_Read((CHAR *)dataP, sizeof(BYTE), (size_t)payload,
+					    seq_fP) != (size_t)payload))
+	{
+	    if (dataP != NULL)
+		free(dataP);
+	    plugP->stopped = TRUE;
+	    SEQ_Map_Seek(seq_fP, pos + SEQ_params.block_size, SEEK_SET);
+	    return;
+	}
+    }
+
+    blockP = &plugP->blockP[plugP->num++];
+    blockP->pos = pos;
+    blockP->dataP = dataP;
+    blockP->packet = packet;
+    blockP->copied = copied;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_dmx_free(plugin)
+  INT   plugin;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Release the blocks collected for a plugin.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_dmx_free() */
+
+    SEQ_DMX_PLUGIN *plugP;
+    LONG n;
+
+    plugP = &seq_dmx.plugin[plugin];
+    for (n=0; n < plugP->num; ++n)
+	if (plugP->blockP[n].copied == TRUE)
+	    free(plugP->blockP[n].dataP);
+
+    if (plugP->blockP != NULL)
+	free(plugP->blockP);
+    plugP->blockP = NULL;
+    plugP->num = 0;
+    plugP->max = 0;
+    plugP->stopped = TRUE;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static LONG seq_dmx_find(plugin, pos)
+  INT         plugin;
+  SEQ_OFFSET  pos;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Return the first collected block of the plugin at or after
+		file offset pos (num if none).
+
+    Notes: Reads usually continue where the last one stopped, so the
+	   entry used last time is tried before searching.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_dmx_find() */
+
+    SEQ_DMX_PLUGIN *plugP;
+    LONG lo, hi, mid;
+
+    plugP = &seq_dmx.plugin[plugin];
+    lo = plugP->hint;
+    if ((lo < plugP->num) && (plugP->blockP[lo].pos == pos))
+	return (lo);
+
+    lo = 0;
+    hi = plugP->num;
+    while (lo < hi)
+    {
+	mid = lo + (hi - lo) / 2;
+	if (plugP->blockP[mid].pos < pos)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+
+    return (lo);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_dmx_more(seq_fP, plugin)
+  FILE  *seq_fP;
+  INT   plugin;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Classify the next block of the file that has not been looked
+		at yet, collecting it if it belongs to the plugin.
+
+    Outputs: TRUE if a block was classified
+	     FALSE at the end of the data, or if the plugin's collection
+		has stopped
+
+    Notes: The position of seq_fP is restored.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_dmx_more() */
+
+    SEQ_OFFSET pos;
+    UWORD packet;
+    BOOL  more;
+
+    if (seq_dmx.plugin[plugin].stopped == TRUE)
+	return (FALSE);
+
+    pos = SEQ_Map_Tell(seq_fP);
+    SEQ_Map_Seek(seq_fP, seq_dmx.next, SEEK_SET);
+
+    more = FALSE;
+    if (SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP) == 1)
+    {
+	more = TRUE;
+	if ((INT)(packet >> 15) == plugin)
+	{
+	    seq_dmx_keep(seq_fP, plugin, (UWORD)(packet & 0x7fff),
+							    seq_dmx.next);
+	}
+	seq_dmx.next += SEQ_params.block_size;
+    }
+
+    SEQ_Map_Seek(seq_fP, pos, SEEK_SET);
+    return (more);
+}
@@ -13,6 +13,8 @@ Author: Christopher Eck		LeCroy Corporation
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <string.h>
+#include <time.h>
 #include "seq_filt.h"
 #include "seq_tran.h"
 #include "aagen.h"
@@ -87,6 +89,212 @@ static BYTE index_1flash[1][4] =   /* <= 200 MSa/sec */
 extern CHAR *read_data_points();
 extern VOID SEQ_fir();
 extern VOID SEQ_fir_7291();
+extern LONG SEQ_Vec_Fir();
+extern LONG SEQ_Vec_Fir_Interleaved();
+extern LONG SEQ_Vec_Fir_7291();
+extern LONG SEQ_Vec_Compensate();
+
+extern BYTE *SEQ_fir_index();
+extern VOID SEQ_fir_engine();
+extern VOID SEQ_fir_free();
+extern VOID SEQ_Compensate();
+
+static VOID seq_fir_kernel();
+static INT  seq_fir_bench();
+static DOUBLE seq_fir_time();
+static BOOL seq_fir_lut();
+
+/***************************************************************
+
+  Specialized flash filter kernels.
+
+  For the common combinations of num_filters and num_coeffs there is
+  a copy of the filter loop with the number of flashes (phases) and
+  taps fixed, so the compiler can unroll it completely. Instead of
+  going through the index table for every point, the rows are laid
+  out once per segment in flash_bank[] in the order the points use
+  them, twice over, so that &flash_bank[flash % phases] is the bank
+  rotated to any point. Each kernel filters whole groups of phases
+  points and returns how many it did; SEQ_fir() does the rest.
+
+ ***************************************************************/
+
+/* Limit and round a flash filter sum like the DSP, <= 1 GSa/s */
+#define FIR_LIMIT(temp)	((temp) > CA_OVERFLOW ? OVERFLOW :		\
+			 (temp) < CA_UNDERFLOW ? UNDERFLOW :		\
+			 (short)(((temp) >> 7) << 1))
+
+/* The same with the saturation of the 2 GSa/s filter */
+#define FIR_LIMIT_2G(temp) ((temp) > POS_SATURATION ? SATURATION :	\
+			 (temp) < CA_UNDERFLOW ? UNDERFLOW :		\
+			 (short)(((temp) >> 7) << 1))
+
+#define FIR_KERNEL(name, phases, taps, stride, limit)			\
+static LONG name(bankP, raw_data, corr_dataP, first, count)		\
+  WORD  (*bankP)[13];							\
+  BYTE  *raw_data;							\
+  WORD  *corr_dataP;							\
+  LONG  first;								\
+  LONG  count;								\
+{									\
+    register LONG  temp;						\
+    register INT   k;							\
+	     INT   l;							\
+	     LONG  n;							\
+									\
+    for (n=first; n + (phases) <= count; n += (phases))			\
+	for (l=0; l < (phases); ++l)					\
+	{								\
+	    temp = 0;							\
+	    for (k=0; k < (taps); ++k)					\
+		temp += (bankP[l][k] * (long)raw_data[n+l-(stride)*k]);	\
+	    *corr_dataP++ = limit(temp);				\
+	}								\
+    return (n - first);							\
+}
+
+FIR_KERNEL(fir_1x2,  1,  2, 1, FIR_LIMIT)
+FIR_KERNEL(fir_1x7,  1,  7, 1, FIR_LIMIT)
+FIR_KERNEL(fir_1x13, 1, 13, 1, FIR_LIMIT)
+FIR_KERNEL(fir_2x2,  2,  2, 1, FIR_LIMIT)
+FIR_KERNEL(fir_2x7,  2,  7, 1, FIR_LIMIT)
+FIR_KERNEL(fir_2x13, 2, 13, 1, FIR_LIMIT)
+FIR_KERNEL(fir_4x2,  4,  2, 1, FIR_LIMIT)
+FIR_KERNEL(fir_4x7,  4,  7, 1, FIR_LIMIT)
+FIR_KERNEL(fir_4x13, 4, 13, 1, FIR_LIMIT)
+FIR_KERNEL(fir_8x2,  8,  2, 2, FIR_LIMIT_2G)
+FIR_KERNEL(fir_8x7,  8,  7, 2, FIR_LIMIT_2G)
+FIR_KERNEL(fir_8x13, 8, 13, 2, FIR_LIMIT_2G)
+
+/***************************************************************
+
+  Lookup table flash filter kernels.
+
+  The raw samples are single BYTEs, so every product a filter can
+  form is known in advance: lut_tables[] holds, for every row and tap,
+  the 256 values coeff * sample, and a point is then only table
+  lookups and adds. lut_bank[] points at the tables in the order the
+  points use them, like flash_bank[]. Whether this beats multiplying
+  (including the vector kernels of seq_vec.c) depends on the machine
+  and on num_coeffs, so seq_fir_bench() times both the first time a
+  combination is met and the faster one is used from then on.
+
+ ***************************************************************/
+
+#define LUT_KERNEL(name, phases, taps, stride, limit)			\
+static LONG name(lutP, raw_data, corr_dataP, first, count)		\
+  LONG  *(*lutP)[13];							\
+  BYTE  *raw_data;							\
+  WORD  *corr_dataP;							\
+  LONG  first;								\
+  LONG  count;								\
+{									\
+    register LONG  temp;						\
+    register INT   k;							\
+	     INT   l;							\
+	     LONG  n;							\
+									\
+    for (n=first; n + (phases) <= count; n += (phases))			\
+	for (l=0; l < (phases); ++l)					\
+	{								\
+	    temp = 0;							\
+	    for (k=0; k < (taps); ++k)					\
+		temp += lutP[l][k][(UBYTE)raw_data[n+l-(stride)*k]];	\
+	    *corr_dataP++ = limit(temp);				\
+	}								\
+    return (n - first);							\
+}
+
+LUT_KERNEL(lut_1x2,  1,  2, 1, FIR_LIMIT)
+LUT_KERNEL(lut_1x7,  1,  7, 1, FIR_LIMIT)
+LUT_KERNEL(lut_1x13, 1, 13, 1, FIR_LIMIT)
+LUT_KERNEL(lut_2x2,  2,  2, 1, FIR_LIMIT)
+LUT_KERNEL(lut_2x7,  2,  7, 1, FIR_LIMIT)
+LUT_KERNEL(lut_2x13, 2, 13, 1, FIR_LIMIT)
+LUT_KERNEL(lut_4x2,  4,  2, 1, FIR_LIMIT)
+LUT_KERNEL(lut_4x7,  4,  7, 1, FIR_LIMIT)
+LUT_KERNEL(lut_4x13, 4, 13, 1, FIR_LIMIT)
+LUT_KERNEL(lut_8x2,  8,  2, 2, FIR_LIMIT_2G)
+LUT_KERNEL(lut_8x7,  8,  7, 2, FIR_LIMIT_2G)
+LUT_KERNEL(lut_8x13, 8, 13, 2, FIR_LIMIT_2G)
+
+/* Engines for a combination (seq_filt.h), FIR_ENGINE_NONE until it has
+   been timed */
+static struct
+{
+    WORD  num_filters;	  /* as read with the coefficients, 9 = 2 GSa/s */
+    WORD  num_coeffs;
+    INT   phases;
+    LONG  (*kernelP)();
+    LONG  (*lutP)();
+    INT   engine;
+} fir_kernels[] =
+{
+    1,  2, 1, fir_1x2,  lut_1x2,  FIR_ENGINE_NONE,
+    1,  7, 1, fir_1x7,  lut_1x7,  FIR_ENGINE_NONE,
+    1, 13, 1, fir_1x13, lut_1x13, FIR_ENGINE_NONE,
+    2,  2, 2, fir_2x2,  lut_2x2,  FIR_ENGINE_NONE,
+    2,  7, 2, fir_2x7,  lut_2x7,  FIR_ENGINE_NONE,
+    2, 13, 2, fir_2x13, lut_2x13, FIR_ENGINE_NONE,
+    4,  2, 4, fir_4x2,  lut_4x2,  FIR_ENGINE_NONE,
+    4,  7, 4, fir_4x7,  lut_4x7,  FIR_ENGINE_NONE,
+    4, 13, 4, fir_4x13, lut_4x13, FIR_ENGINE_NONE,
+    9,  2, 8, fir_8x2,  lut_8x2,  FIR_ENGINE_NONE,
+    9,  7, 8, fir_8x7,  lut_8x7,  FIR_ENGINE_NONE,
+    9, 13, 8, fir_8x13, lut_8x13, FIR_ENGINE_NONE,
+    0,  0, 0, NULL,     NULL,     FIR_ENGINE_NONE
+};
+
+/* Raw samples seq_fir_bench() times the engines on */
+#define FIR_BENCH	4096
+
+/* At 2 GSa/s the flash filtered points are 7291 filtered FIR_TILE at a
+   time while they are still in the cache: p91_tile[] holds the
+   num_91coeffs-1 points before the tile, carried over from the last
+   tile and block, followed by the tile (p91_fill points in all) */
+#define FIR_TILE	2048
+
+/* State of the filters in the current context (seq_ctx.c); the engine
+   timings in fir_kernels[] are shared by all contexts */
+typedef struct SEQ_FIR_STATE
+{
+    BYTE  flash;			/* flash counter of the next point */
+
+    /* Kernel of the current segment, its rows and number of phases */
+    LONG  (*kernelP)();
+    WORD  bank[16][13];
+    INT   phases;
+
+    /* Lookup table kernel of the current segment (instead of the above
+       and the vector kernels), its tables and the coefficients they are
+       for */
+    LONG  (*lutP)();
+    LONG  *lut_bank[16][13];
+    LONG  *lut_tables;
+    WORD  lut_coeffs[8][13];
+    WORD  lut_num_coeffs;
+
+    /* Engine for every combination instead of the faster
+       (SEQ_fir_engine()), FIR_ENGINE_NONE (0) for the faster */
+    INT   engine;
+
+    WORD  p91_tile[MAX_91_COEFFS + FIR_TILE];
+    LONG  p91_fill;
+} SEQ_FIR_STATE;
+
+#define FIR_STATE	SEQ_MODULE(SEQ_MOD_FIR, SEQ_FIR_STATE)
+#define fir_flash	(FIR_STATE->flash)
+#define flash_kernelP	(FIR_STATE->kernelP)
+#define flash_bank	(FIR_STATE->bank)
+#define flash_phases	(FIR_STATE->phases)
+#define flash_lutP	(FIR_STATE->lutP)
+#define lut_bank	(FIR_STATE->lut_bank)
+#define lut_tables	(FIR_STATE->lut_tables)
+#define lut_coeffs	(FIR_STATE->lut_coeffs)
+#define lut_num_coeffs	(FIR_STATE->lut_num_coeffs)
+#define fir_engine	(FIR_STATE->engine)
+#define p91_tile	(FIR_STATE->p91_tile)
+#define p91_fill	(FIR_STATE->p91_fill)
 
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
 
@@ -210,11 +418,15 @@ BOOL new_block;
     	     WORD  i;
 
 	     LONG  count; 
+	     LONG  done;
+	     LONG  end;
+	     LONG  history;
+	     WORD  *out_dataP;
     struct FILTER  *filterP;
 	     BYTE  *indexP;
     	     INT   max_coeffs;
 
-      static BYTE  flash;
+	     BYTE  flash;
 
       static BOOL  direction = 0;
 
@@ -242,6 +454,11 @@ BOOL new_block;
 		break; 
 	}
 
+    /* Pick the specialized kernel once per segment */
+	if (new_block == TRUE)
+	    seq_fir_kernel(filterP, indexP);
+	flash = fir_flash;
+
 
     if (filterP->num_filters < 8)   /* <= 1GSa/sec */
     {
@@ -249,7 +466,30 @@ BOOL new_block;
 	    flash = 0;
 	count = filt_dataP->size;
 	corr_dataP = filt_dataP->corrP;
-	for (n=filterP->num_coeffs-1; n < count; ++n,++flash)
+	n = filterP->num_coeffs-1;
+
+	/* Filter what can be done a vector at a time (seq_vec.c), or with
+	   the lookup tables, the remaining points one at a time */
+	if (flash_lutP != NULL)
+	    done = (*flash_lutP)(&lut_bank[flash & (flash_phases-1)],
+				raw_data, corr_dataP, n, count);
+	else
+	    done = SEQ_Vec_Fir(filterP, indexP, (INT)flash, raw_data,
+				corr_dataP, n, count);
+	n += done;
+	corr_dataP += done;
+	flash = (BYTE)((flash + done) & 7);
+
+	if (flash_kernelP != NULL)
+	{
+	    done = (*flash_kernelP)(&flash_bank[flash & (flash_phases-1)],
+				raw_data, corr_dataP, n, count);
+	    n += done;
+	    corr_dataP += done;
+	    flash = (BYTE)((flash + done) & 7);
+	}
+
+	for (; n < count; ++n,++flash)
 	{
 	    temp=0;
 	    coeffP = &filterP->coeffP[indexP[flash & 3]][0];
@@ -298,38 +538,431 @@ BOOL new_block;
 	    max_coeffs = 2*filterP->num_coeffs;
 	    count = filt_dataP->size_91;
 
+	    history = filterP->num_91coeffs-1;
+
 	/* Each channel's data located at every other point */
 	    if (new_block == TRUE)
+	    {
 		flash = 0;
-	    corr_dataP = filt_dataP->p91P;
-	    for (n=max_coeffs-2; n < count; ++n,++flash)
+		p91_fill = 0;
+	    }
+	    out_dataP = filt_dataP->corrP;
+	    for (n=max_coeffs-2; n < count; )
 	    {
-		temp=0;
-		coeffP = &filterP->coeffP[indexP[flash & 7]][0];
+		end = n + FIR_TILE;
+		if (end > count)
+		    end = count;
+		corr_dataP = &p91_tile[p91_fill];
+		p91_fill += end - n;
+
+	    /* Vectors (seq_vec.c) or lookup tables first, then the points
+	       left over */
+		if (flash_lutP != NULL)
+		    done = (*flash_lutP)(&lut_bank[flash & 7], raw_data,
+				corr_dataP, n, end);
+		else
+		    done = SEQ_Vec_Fir_Interleaved(filterP, indexP,
+				(INT)flash, raw_data, corr_dataP, n, end);
+		n += done;
+		corr_dataP += done;
+		flash = (BYTE)((flash + done) & 7);
+
+		if (flash_kernelP != NULL)
+		{
+		    done = (*flash_kernelP)(&flash_bank[flash & 7], raw_data,
+				corr_dataP, n, end);
+		    n += done;
+		    corr_dataP += done;
+		    flash = (BYTE)((flash + done) & 7);
+		}
+
+		for (; n < end; ++n,++flash)
+		{
+		    temp=0;
+		    coeffP = &filterP->coeffP[indexP[flash & 7]][0];
+
+		    for (k=0; k < max_coeffs; k += 2)
+		    {
+			temp += (*coeffP++ * (long)raw_data[n-k]);
+		    }
 
-		for (k=0; k < max_coeffs; k += 2)
+		    /* Rail the output using DSP saturation mode arithmetic. */
+		    /* These limitations are due to the DSP's fixed word     */
+		    /* length.                                               */
+			if (temp > POS_SATURATION)
+			    *corr_dataP++ = SATURATION;
+			else if (temp < CA_UNDERFLOW)
+			    *corr_dataP++ = UNDERFLOW;
+			else
+			  /* round the result like the DSP does it. The DSP
+			     does it this way to use saturation mode
+			     arithemetic. Note that this is different than
+			     just (temp >> 6) by 1 LSB */
+			    *corr_dataP++ = (short)((temp >> 7) << 1);
+		}
+
+	    /* 7291 filter the tile and keep the points the next one needs */
+		if (p91_fill > history)
 		{
-		    temp += (*coeffP++ * (long)raw_data[n-k]);
+		    SEQ_fir_7291(filterP, p91_fill, p91_tile, out_dataP);
+		    out_dataP += p91_fill - history;
+		    for (i=0; i < history; ++i)
+			p91_tile[i] = p91_tile[p91_fill - history + i];
+		    p91_fill = history;
 		}
+	    }
+    }
+    fir_flash = flash;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BYTE *SEQ_fir_index(num_filters, last_flash)
+WORD num_filters;
+WORD last_flash;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Give the row of the flash index table SEQ_fir() uses for a
+		segment.
+
+    Outputs: the row, NULL if last_flash is not one of the sampling rate
+
+    Notes: For the segments seq_bat.c filters before they are read, whose
+	   last flash has not been checked by anyone yet.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_fir_index() */
+
+    if (last_flash < 0)
+	return (NULL);
+
+    switch (num_filters)
+    {
+	case 1:	/* <= 200 MSa/sec */
+	    return ((last_flash < 1) ? &index_1flash[last_flash][0] : NULL);
+
+	case 2:	/* 400 MSa/sec */
+	    return ((last_flash < 3) ? &index_2flash[last_flash][0] : NULL);
+
+	case 4:	/* 1 GSa/sec */
+	    return ((last_flash < 4) ? &index_4flash[last_flash][0] : NULL);
+
+	default:	/* 2 GSa/sec */
+	    return ((last_flash < 8) ? &index_8flash[last_flash][0] : NULL);
+    }
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_fir_engine(engine)
+INT engine;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: To make SEQ_fir() use one flash filter engine instead of
+		timing both and using the faster.
+
+    Inputs: engine = FIR_ENGINE_MULTIPLY or FIR_ENGINE_LUT, or
+			FIR_ENGINE_NONE to go back to the faster
+
+    Notes: For seq_test.c, which checks every engine against the
+	   original loops. Takes effect from the next segment on.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_fir_engine() */
+
+    fir_engine = engine;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_fir_free()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: To release the lookup tables of the current context.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_fir_free() */
+
+    if (SEQ_ctxP->moduleP[SEQ_MOD_FIR] == NULL)
+	return;
+
+    free(lut_tables);
+    lut_tables = NULL;
+    flash_lutP = NULL;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_fir_kernel(filterP, indexP)
+struct FILTER *filterP;
+BYTE   *indexP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: To pick the specialized flash filter kernel for a segment,
+		multiplying or with lookup tables, and lay out its rows.
+
+    Inputs: filterP = num_filters, num_coeffs and coefficients of the
+			segment
+	    indexP = row of the index table for filterP->last_flash
+
+    Outputs: flash_kernelP = kernel, NULL if there is none for this
+			num_filters and num_coeffs
+	     flash_bank[j] = row for the point at flash counter j, for
+			j < 2 * flash_phases
+	     flash_lutP = lookup table kernel if that is the faster or the
+			one SEQ_fir_engine() asked for (then instead of
+			flash_kernelP), else NULL
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_fir_kernel() */
 
-		/* Rail the output using DSP saturation mode arithmetic.     */
-		/* These limitations are due to the DSP's fixed word length. */
-		    if (temp > POS_SATURATION)
-			*corr_dataP++ = SATURATION;
-		    else if (temp < CA_UNDERFLOW)
-			*corr_dataP++ = UNDERFLOW;
-		    else
-		      /* round the result like the DSP does it. The DSP does it
-		         this way to use saturation mode arithemetic. Note that
-		         this is different than just (temp >> 6) by 1 LSB */
-			*corr_dataP++ = (short)((temp >> 7) << 1);
-
-		/* Print completion status  */
+    INT   i, j, k;
+    INT   mask;
+    INT   engine;
+
+    /* -k scalar runs the original loops only */
+    flash_kernelP = NULL;
+    flash_lutP = NULL;
+    if (SEQ_options.kernels == SEQ_KERNEL_SCALAR)
+	return;
+
+    for (i=0; fir_kernels[i].kernelP != NULL; ++i)
+    {
+	if ((fir_kernels[i].num_filters == filterP->num_filters) &&
+	    (fir_kernels[i].num_coeffs == filterP->num_coeffs))
+	    break;
+    }
+    if (fir_kernels[i].kernelP == NULL)
+	return;
+
+    flash_phases = fir_kernels[i].phases;
+    mask = (flash_phases == 8) ? 7 : 3;
+    for (j=0; j < 2 * flash_phases; ++j)
+	for (k=0; k < filterP->num_coeffs; ++k)
+	    flash_bank[j][k] = filterP->coeffP[indexP[j & mask]][k];
+
+    flash_kernelP = fir_kernels[i].kernelP;
+
+    /* Time both engines the first time, then use the faster */
+    engine = fir_engine;
+    if (engine == FIR_ENGINE_NONE)
+    {
+	SEQ_Lock();
+	if (fir_kernels[i].engine == FIR_ENGINE_NONE)
+	    fir_kernels[i].engine = seq_fir_bench(filterP, indexP, i);
+	engine = fir_kernels[i].engine;
+	SEQ_Unlock();
+    }
+
+    if ((engine == FIR_ENGINE_LUT) &&
+	(seq_fir_lut(filterP, indexP) == TRUE))
+    {
+	flash_lutP = fir_kernels[i].lutP;
+	flash_kernelP = NULL;
+    }
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_fir_lut(filterP, indexP)
+struct FILTER *filterP;
+BYTE   *indexP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: To fill the lookup tables for the coefficients of a segment
+		and point lut_bank[] at them.
+
+    Inputs: filterP, indexP as for seq_fir_kernel(), flash_phases set
+
+    Outputs: returns TRUE if the tables are ready, FALSE if there is no
+		memory for them
+
+    Notes: The tables are only filled again when the coefficients have
+	   changed since the last segment.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_fir_lut() */
+
+    LONG  *tableP;
+    INT   r, j, k, b;
+    INT   mask;
+
+    if (lut_tables == NULL)
+    {
+	lut_tables = (LONG *)malloc((size_t)(sizeof(LONG) * 8 * 13 * 256));
+	if (lut_tables == NULL)
+	    return (FALSE);
+	lut_num_coeffs = 0;
+    }
+
+    if ((lut_num_coeffs != filterP->num_coeffs) ||
+	memcmp(lut_coeffs, filterP->coeffP, sizeof(lut_coeffs)))
+    {
+	for (r=0; r < 8; ++r)
+	    for (k=0; k < filterP->num_coeffs; ++k)
+	    {
+		tableP = &lut_tables[(r*13 + k) * 256];
+		for (b=0; b < 256; ++b)
+		    tableP[b] = filterP->coeffP[r][k] * (long)(BYTE)b;
+	    }
+	memcpy(lut_coeffs, filterP->coeffP, sizeof(lut_coeffs));
+	lut_num_coeffs = filterP->num_coeffs;
+    }
+
+    mask = (flash_phases == 8) ? 7 : 3;
+    for (j=0; j < 2 * flash_phases; ++j)
+	for (k=0; k < filterP->num_coeffs; ++k)
+	    lut_bank[j][k] = &lut_tables[(indexP[j & mask]*13 + k) * 256];
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static INT seq_fir_bench(filterP, indexP, i)
+struct FILTER *filterP;
+BYTE   *indexP;
+INT    i;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: To find out whether multiplying or the lookup tables filter
+		fir_kernels[i] faster on this machine.
+
+    Inputs: filterP, indexP as for seq_fir_kernel(), flash_bank[] and
+		flash_phases set for fir_kernels[i]
+
+    Outputs: returns FIR_ENGINE_MULTIPLY or FIR_ENGINE_LUT
+
+    Notes: Multiplying means the vector kernels of seq_vec.c, when there
+	   are any, followed by the specialized kernel, as in SEQ_fir().
+	   Both are run on FIR_BENCH made up samples, 3 times for about
+	   5 ms each.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_fir_bench() */
+
+    BYTE  *rawP;
+    WORD  *outP;
+    ULONG seed;
+    LONG  n;
+    INT   engine;
+    DOUBLE t, t_mul, t_lut;
+
+    rawP = (BYTE *)malloc((size_t)FIR_BENCH);
+    outP = (WORD *)malloc((size_t)(sizeof(WORD) * FIR_BENCH));
+    engine = FIR_ENGINE_MULTIPLY;
+
+    if ((rawP != NULL) && (outP != NULL) &&
+	(seq_fir_lut(filterP, indexP) == TRUE))
+    {
+	seed = 1;
+	for (n=0; n < FIR_BENCH; ++n)
+	{
+	    seed = seed * 1103515245L + 12345;
+	    rawP[n] = (BYTE)(seed >> 16);
+	}
+
+	/* Best of 3 each, taken in turn so neither is favoured by what
+	   else the machine is doing */
+	t_mul = t_lut = 0;
+	for (n=0; n < 3; ++n)
+	{
+	    t = seq_fir_time(filterP, indexP, i, FALSE, rawP, outP);
+	    if ((n == 0) || (t < t_mul))
+		t_mul = t;
+	    t = seq_fir_time(filterP, indexP, i, TRUE, rawP, outP);
+	    if ((n == 0) || (t < t_lut))
+		t_lut = t;
 	}
 
-	SEQ_fir_7291(filterP, filt_dataP->size, filt_dataP->p91_baseP,
-			filt_dataP->corrP);
+	/* The tables take memory and time to fill, so they must win by
+	   a clear margin */
+	if (t_lut < 0.9 * t_mul)
+	    engine = FIR_ENGINE_LUT;
     }
+
+    if (SEQ_options.debug == 1)
+	printf("Flash filters %d x %d taps: %s\n", fir_kernels[i].phases,
+		filterP->num_coeffs, (engine == FIR_ENGINE_LUT) ?
+		"lookup tables" : "multiply");
+
+    if (rawP != NULL)
+	free(rawP);
+    if (outP != NULL)
+	free(outP);
+    return (engine);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static DOUBLE seq_fir_time(filterP, indexP, i, lut, rawP, outP)
+struct FILTER *filterP;
+BYTE   *indexP;
+INT    i;
+BOOL   lut;
+BYTE   *rawP;
+WORD   *outP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: To time one engine for seq_fir_bench().
+
+    Inputs: lut = TRUE for the lookup tables, FALSE for multiplying
+	    rawP = FIR_BENCH samples, outP = room for as many points
+
+    Outputs: returns the clock ticks one pass over the samples takes
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_fir_time() */
+
+    clock_t start, now;
+    LONG  reps;
+    LONG  first;
+    LONG  done;
+    INT   phases;
+
+    phases = fir_kernels[i].phases;
+    if (phases == 8)
+	first = 2*filterP->num_coeffs-2;
+    else
+	first = filterP->num_coeffs-1;
+
+    reps = 0;
+    start = clock();
+    do
+    {
+	if (lut)
+	    (VOID)(*fir_kernels[i].lutP)(&lut_bank[0], rawP, outP, first,
+						(LONG)FIR_BENCH);
+	else
+	{
+	    if (phases == 8)
+		done = SEQ_Vec_Fir_Interleaved(filterP, indexP, 0, rawP,
+						outP, first, (LONG)FIR_BENCH);
+	    else
+		done = SEQ_Vec_Fir(filterP, indexP, 0, rawP, outP, first,
+						(LONG)FIR_BENCH);
+	    (VOID)(*fir_kernels[i].kernelP)(&flash_bank[done & (phases-1)],
+			rawP, &outP[done], first + done, (LONG)FIR_BENCH);
+	}
+	++reps;
+	now = clock();
+    } while (now - start < CLOCKS_PER_SEC / 200);
+
+    return ((DOUBLE)(now - start) / reps);
 }
 
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
@@ -375,8 +1008,15 @@ register WORD   *coeffP;
 register LONG   temp;
 register LONG   n;
 register WORD   i,k;
+	 LONG   done;
+
+    /* Vectors first (seq_vec.c), then the points left over */
+    n = filterP->num_91coeffs-1;
+    done = SEQ_Vec_Fir_7291(filterP, size, data, corr_dataP, n);
+    n += done;
+    corr_dataP += done;
 
-    for (n=filterP->num_91coeffs-1; n < size; ++n)
+    for (; n < size; ++n)
     {
 	temp=0;
 	coeffP = &filterP->coeff_7291[0];
@@ -402,6 +1042,81 @@ register WORD   i,k;
 
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
 
+VOID SEQ_Compensate(filt_dataP, new_block)
+SEQ_FILTER_DATA *filt_dataP;
+BOOL new_block;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Put the points SEQ_fir() has just corrected in physical
+		units, with the time of each.
+
+    Inputs: new_block  = TRUE for the first block of a segment
+	    filt_dataP = as after SEQ_fir(); waveP holds the vertical gain
+			 and offset and the times of the segment
+
+    Outputs: filt_dataP->valuesP[]   = gain * point - offset, as FLOATs,
+	     filt_dataP->values64P[] = the same as DOUBLEs,
+	     filt_dataP->timesP[]    = time of each point,
+				       each if not NULL
+
+    Notes: Called right after the block is filtered, so the corrected
+	   points are still in the cache. The times are added up point
+	   after point, not multiplied out, so they are exactly what the
+	   screen output always printed.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Compensate() */
+
+    struct WAVE_PARAMS *waveP;
+    WORD  *corrP;
+    DOUBLE time;
+    DOUBLE step;
+    FLOAT gain;
+    FLOAT offset;
+    LONG  count;
+    LONG  done;
+    LONG  n;
+
+    waveP = filt_dataP->waveP;
+    corrP = filt_dataP->corrP;
+    if (filt_dataP->paramsP->p91_mode == TRUE)
+	count = filt_dataP->size - (filt_dataP->paramsP->num_91coeffs-1);
+    else
+	count = filt_dataP->size - (filt_dataP->paramsP->num_coeffs-1);
+
+    gain = waveP->vertical_gain;
+    offset = waveP->vertical_offset;
+
+    /* Vectors first (seq_vec.c), then the points left over */
+    done = SEQ_Vec_Compensate(corrP, count, (DOUBLE)gain, (DOUBLE)offset,
+				filt_dataP->valuesP, filt_dataP->values64P);
+    if (filt_dataP->valuesP != NULL)
+	for (n=done; n < count; ++n)
+	    filt_dataP->valuesP[n] = (gain * corrP[n]) - offset;
+    if (filt_dataP->values64P != NULL)
+	for (n=done; n < count; ++n)
+	    filt_dataP->values64P[n] = ((DOUBLE)gain * corrP[n]) -
+							    (DOUBLE)offset;
+
+    if (new_block == TRUE)
+	filt_dataP->time = waveP->seg_start_time + waveP->horizontal_offset;
+    if (filt_dataP->timesP != NULL)
+    {
+	time = filt_dataP->time;
+	step = waveP->time_per_point;
+	for (n=0; n < count; ++n)
+	{
+	    filt_dataP->timesP[n] = time;
+	    time += step;
+	}
+	filt_dataP->time = time;
+    }
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
 VOID SEQ_read_filter_coefficients(bufP, filterP)
 WORD *bufP;
 struct FILTER *filterP;
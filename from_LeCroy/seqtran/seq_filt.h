@@ -17,6 +17,13 @@ Author: Christopher Eck		LeCroy Corporation
 #define MAX_91_COEFFS  64 /* Although we have a 63-point filter, 64 samples */
 			  /* are always acquired, 32 from Ch1, 32 from Ch2 */
 
+#define SEQ_BATCH      16 /* Short segments filtered together (seq_bat.c) */
+
+/* Flash filter engines of SEQ_fir(), see SEQ_fir_engine() */
+#define FIR_ENGINE_NONE	    0 /* none picked: time both, use the faster    */
+#define FIR_ENGINE_MULTIPLY 1 /* vector and specialized kernels            */
+#define FIR_ENGINE_LUT	    2 /* lookup tables                             */
+
 typedef struct FILTER
 {
     WORD  last_flash;	  /* different filters for different flashes       */
@@ -77,24 +77,25 @@ struct PCW_TEMPLATE{
 
 
 
-#ifdef PCW_UTIL_C
-
 #define  NUM_REG_BLOCKS 2       /* max number of regular blocks in template */
 #define  NUM_ARRAYS     6       /* max number of arrays in template */
 
-static struct {
-    CHAR    Name[NAMELENGTH];
-    LONG    Offset;
-} regular_blocks[NUM_REG_BLOCKS];
-
-static struct {
-    CHAR    Name[NAMELENGTH];
-    LONG    Array_Offset;
-    LONG    Array_Length;
-    LONG    Array_Count;
-} array_blocks[NUM_ARRAYS];
-
-#endif
+struct PCW_OFFSETS{
+    struct {
+        CHAR    Name[NAMELENGTH];
+        LONG    Offset;
+    } regular_blocks[NUM_REG_BLOCKS];
+
+    struct {
+        CHAR    Name[NAMELENGTH];
+        LONG    Array_Offset;
+        LONG    Array_Length;
+        LONG    Array_Count;
+    } array_blocks[NUM_ARRAYS];
+};
+            /* Where the blocks and arrays are in the last waveform
+               descriptor -- see PCW_Load_Block_Offsets function header.
+               Kept in the translator's context (seq_tran.h)         */
 
 
 
@@ -0,0 +1,914 @@
+/************************** seq_idx.c **************************************
+
+Packet index for SCSI sequence data files.
+
+A data file written by acquire is a string of fixed size blocks, each one
+starting with a packet number whose MSB identifies the plugin. To find a
+given byte of one plugin's data, SEQ_Read_Blocks_Seg() and
+SEQ_Read_Blocks_Desc() walk the file one block at a time from a known
+position, which makes every descriptor read and every backward seek
+proportional to the size of the file.
+
+This module scans the file once and records the packet number of every
+block. Since all blocks are SEQ_params.block_size long, the file offset of
+block n is n * block_size and need not be stored. From the packet numbers
+a list of the blocks belonging to each plugin is built, so that the n-th
+block of a plugin can be addressed directly (SEQ_BLOCK_POS()), however
+large the file.
+
+The index is saved next to the data file with the extension .idx:
+
+	CHAR  magic[4]		"SQIX"
+	UBYTE layout[20]	how this build lays out what follows
+				(SEQ_Sidecar_Head())
+	LONG  block_size	block size of the data file
+	SEQ_OFFSET file_size	size of the data file when indexed
+	LONG  num_blocks	number of blocks that follow
+	UWORD packet[num_blocks] packet number of each block
+
+and is used by later runs of a build with the same layout as long as the
+block and file sizes still match.
+A plugin whose packet numbers are not in sequence is left to the block
+walking readers so that the error is reported where it was before.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "seq_tran.h"
+
+/* -------------------------------------------------------------------- */
+
+extern size_t SEQ_Map_Read();
+extern INT    SEQ_Map_Seek(FILE *seq_fP, SEQ_OFFSET offset, INT origin);
+extern SEQ_OFFSET SEQ_Map_Tell();
+extern SEQ_OFFSET SEQ_Map_Size();
+
+#define SEQ_IDX_MAGIC	"SQIX"
+#define SEQ_IDX_EXT	".idx"
+
+typedef struct SEQ_IDX_HDR
+{
+    LONG  block_size;		/* block size of the data file */
+    SEQ_OFFSET file_size;	/* size of the data file when indexed */
+    LONG  num_blocks;		/* number of packet numbers that follow */
+} SEQ_IDX_HDR;
+
+typedef struct SEQ_INDEX
+{
+    LONG  block_size;			/* block size of the data file */
+    SEQ_OFFSET file_size;		/* size of the data file */
+    LONG  num_blocks;			/* blocks in the data file */
+    UWORD *packetP;			/* packet number of every block */
+    BOOL  valid[MAX_PLUGINS];		/* plugin's packets in sequence */
+    LONG  num[MAX_PLUGINS];		/* blocks belonging to plugin */
+    LONG  *blockP[MAX_PLUGINS];		/* block number of n-th block */
+    LONG  hint[MAX_PLUGINS];		/* last entry of blockP used */
+} SEQ_INDEX;
+
+/* State of the module in the current context (seq_ctx.c) */
+typedef struct SEQ_IDX_STATE
+{
+    SEQ_INDEX index;
+    BOOL      open;
+} SEQ_IDX_STATE;
+
+#define seq_index	(SEQ_MODULE(SEQ_MOD_INDEX, SEQ_IDX_STATE)->index)
+#define seq_index_open	(SEQ_MODULE(SEQ_MOD_INDEX, SEQ_IDX_STATE)->open)
+
+VOID        SEQ_Sidecar_Name();
+BOOL        SEQ_Sidecar_Head();
+VOID        SEQ_Put32();
+ULONG       SEQ_Get32();
+static BOOL seq_idx_load();
+static BOOL seq_idx_scan();
+static VOID seq_idx_save();
+static BOOL seq_idx_plugins();
+static LONG seq_idx_find();
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Index_Open(seq_fP, seq_filenameP, build)
+  FILE  *seq_fP;
+  CHAR  *seq_filenameP;
+  INT   build;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Load the packet index of the data file from its .idx file,
+		or build it (and save it) if requested.
+
+    Inputs: seq_fP        = FILE pointer to the opened data file
+	    seq_filenameP = name of the data file
+	    build         = TRUE to scan the data file when there is no
+				usable .idx file
+
+    Outputs: TRUE if the index will be used by the block readers
+	     FALSE if the block readers will walk the file
+
+    Machine dependencies:
+
+    Notes: SEQ_params.block_size must be known (SEQ_INIT_PARAMETERS).
+	   The position of seq_fP is restored before returning.
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Index_Open() */
+
+    CHAR  idx_name[128];
+    SEQ_OFFSET pos;
+    BOOL  loaded;
+    BYTE  p;
+
+    if ((seq_index_open == TRUE) || (SEQ_params.block_size <= 2))
+	return (FALSE);
+
+    SEQ_Sidecar_Name(seq_filenameP, SEQ_IDX_EXT, idx_name,
+						(INT)sizeof(idx_name));
+
+    /* The size of the data file tells whether the .idx file is current */
+    pos = SEQ_Map_Tell(seq_fP);
+    seq_index.file_size = SEQ_Map_Size(seq_fP);
+    if (seq_index.file_size < 0)
+    {
+	SEQ_Map_Seek(seq_fP, pos, SEEK_SET);
+	if (SEQ_options.debug == 1)
+	    printf("No packet index: the size of %s is not known\n",
+							    seq_filenameP);
+	return (FALSE);
+    }
+    seq_index.block_size = SEQ_params.block_size;
+    seq_index.num_blocks = 0;
+    seq_index.packetP = NULL;
+
+    loaded = seq_idx_load(idx_name);
+    if ((loaded == FALSE) && (build == TRUE))
+    {
+	if (seq_idx_scan(seq_fP) == TRUE)
+	{
+	    seq_idx_save(idx_name);
+	    loaded = TRUE;
+	}
+    }
+
+    SEQ_Map_Seek(seq_fP, pos, SEEK_SET);
+
+    if (loaded == FALSE)
+	return (FALSE);
+
+    if (seq_idx_plugins() == FALSE)
+    {
+	free(seq_index.packetP);
+	seq_index.packetP = NULL;
+	return (FALSE);
+    }
+
+    seq_index_open = TRUE;
+
+    if (SEQ_options.debug == 1)
+    {
+	printf("Packet index %s: %ld blocks\n", idx_name,
+						    seq_index.num_blocks);
+	for (p=0; p < MAX_PLUGINS; ++p)
+	    if (seq_index.num[p] != 0)
+		printf("%c: %ld blocks%s\n", p+'A', seq_index.num[p],
+		  (seq_index.valid[p] == TRUE) ? "" : " (out of sequence)");
+    }
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Index_Close()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Release the memory used by the packet index.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Index_Close() */
+
+    BYTE p;
+
+    if (seq_index_open == FALSE)
+	return;
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	if (seq_index.blockP[p] != NULL)
+	    free(seq_index.blockP[p]);
+	seq_index.blockP[p] = NULL;
+    }
+    free(seq_index.packetP);
+    seq_index.packetP = NULL;
+    seq_index_open = FALSE;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Index_Read_Seg(seq_fP, dataP, read, statusP)
+  FILE          *seq_fP;
+  SEQ_ACQ_DATA  *dataP;
+  INT           read;
+  BOOL          *statusP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Read_Blocks_Seg() using the packet index.
+
+    Inputs: same as SEQ_Read_Blocks_Seg()
+
+    Outputs: TRUE if the request was handled; *statusP is then the value
+			SEQ_Read_Blocks_Seg() must return.
+	     FALSE if the index cannot be used for this request and the
+			caller has to walk the blocks itself. Nothing has
+			been changed in that case.
+
+    Machine dependencies:
+
+    Notes: The position within the plugin's data is counted in payload
+	   BYTEs (block_size-2 per block) from the plugin's first block,
+	   skipping the descriptor block (packet 0) just as the walking
+	   reader does. seq_fP is left at the start of the block where
+	   reading stopped and dataP->block_offset is set accordingly.
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Index_Read_Seg() */
+
+    UWORD plugin_mask;
+    UWORD packet;
+    UWORD next;
+    LONG  payload;
+    LONG  block;
+    LONG  ord;
+    SEQ_OFFSET logical;
+    LONG  offset;
+    LONG  size;
+    LONG  count;
+    LONG  num_read;
+    SEQ_OFFSET pos;
+    LONG  *blockP;
+    LONG  num;
+    BYTE  *bufferP;
+    WORD  p;
+
+    p = dataP->plugin;
+    if ((seq_index_open == FALSE) || (seq_index.valid[p] == FALSE))
+	return (FALSE);
+
+    payload = seq_index.block_size - 2;
+    blockP = seq_index.blockP[p];
+    num = seq_index.num[p];
+    plugin_mask = (p << 15);
+
+    /* Must be sitting at the start of a block */
+    pos = SEQ_Map_Tell(seq_fP);
+    if ((pos < 0) || (pos % seq_index.block_size))
+	return (FALSE);
+    block = (LONG)(pos / seq_index.block_size);
+    offset = dataP->block_offset + dataP->byte_offset;
+
+    /* First block of this plugin at or after the current one */
+    ord = seq_idx_find(p, block);
+    if ((ord < num) &&
+	((seq_index.packetP[blockP[ord]] & 0x7fff) == 0))   /* descriptor */
+	ord++;
+
+    /* Going backwards is only defined from one of this plugin's blocks */
+    if ((offset < 0) && ((ord >= num) || (blockP[ord] != block)))
+	return (FALSE);
+
+    logical = (SEQ_OFFSET)ord * payload + offset;
+    ord = (LONG)(logical / payload);
+    offset = (LONG)(logical % payload);
+
+    /* Never back into this plugin's descriptor block */
+    if ((logical < 0) || (ord < 1))
+	return (FALSE);
+
+    dataP->bytes_read = 0L;
+    dataP->packet = 0;
+
+    if (ord >= num)
+    {
+	printf("Could not find requested block in data file.\n");
+	SEQ_Map_Seek(seq_fP, SEQ_params.seg_offset, SEEK_SET);
+	*statusP = FALSE;
+	return (TRUE);
+    }
+
+    bufferP = dataP->bufP;
+    size = dataP->size;
+    if (size > 0)
+    {
+	SEQ_Map_Seek(seq_fP, SEQ_BLOCK_POS(blockP[ord], 2 + offset), SEEK_SET);
+	count = payload - offset;
+
+	while (size > 0)
+	{
+	    if (size < count)
+		count = size;
+
+	    /* Read the bytes into the supplied buffer */
+	    if (read == TRUE)
+		num_read = (LONG)SEQ_Map_Read((CHAR *)bufferP, sizeof(BYTE),
+					    (size_t)count, seq_fP);
+	    else
+	    {
+		num_read = count;
+		SEQ_Map_Seek(seq_fP, count, SEEK_CUR);
+	    }
+
+	    if (num_read != count)
+	    {
+		printf("Only read %ld bytes out of %ld from input file.\n",
+				num_read, count);
+		EXIT
+	    }
+
+	    size -= count;
+	    offset += count;
+	    dataP->bytes_read += count;
+
+	    if (size > 0)
+	    {
+		bufferP += count;
+
+		packet = seq_index.packetP[blockP[ord]] & 0x7fff;
+		if (++ord >= num)
+		{
+		    next = (packet == 0x7ffe) ? 1 : packet + 1;
+		    printf("Could not find packet %d...ran out of data\n",
+						next | plugin_mask);
+		    EXIT
+		}
+
+		SEQ_Map_Seek(seq_fP, SEQ_BLOCK_POS(blockP[ord], 2), SEEK_SET);
+		count = payload;
+		offset = 0;
+	    }
+	}
+    }
+
+    /* Leave the file at the beginning of this block */
+    SEQ_Map_Seek(seq_fP, SEQ_BLOCK_POS(blockP[ord], 0), SEEK_SET);
+    seq_index.hint[p] = ord;
+
+    dataP->block_offset = offset;
+
+    if ((seq_index.packetP[blockP[ord]] & 0x7fff) == 0x7fff)
+	SEQ_params.last_packet[p] = TRUE;
+
+    *statusP = TRUE;
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Index_Read_Desc(seq_fP, bufferP, plugin, size, offset, statusP)
+  FILE  *seq_fP;
+  BYTE  *bufferP;
+  INT   plugin;
+  LONG  size;
+  LONG  offset;
+  BOOL  *statusP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Read_Blocks_Desc() using the packet index.
+
+    Inputs: same as SEQ_Read_Blocks_Desc()
+
+    Outputs: TRUE if the request was handled; *statusP is then the value
+			SEQ_Read_Blocks_Desc() must return.
+	     FALSE if the caller has to walk the blocks itself.
+
+    Notes: offset counts payload BYTEs from the plugin's first block.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Index_Read_Desc() */
+
+    UWORD packet;
+    UWORD next;
+    LONG  payload;
+    LONG  ord;
+    LONG  count;
+    LONG  num_read;
+    LONG  *blockP;
+    LONG  num;
+
+    if ((seq_index_open == FALSE) || (seq_index.valid[plugin] == FALSE) ||
+	(offset < 0))
+	return (FALSE);
+
+    payload = seq_index.block_size - 2;
+    blockP = seq_index.blockP[plugin];
+    num = seq_index.num[plugin];
+
+    ord = offset / payload;
+    offset = offset % payload;
+
+    if (ord >= num)
+    {
+	printf("Could not find requested block in data file.\n");
+	*statusP = FALSE;
+	return (TRUE);
+    }
+
+    SEQ_Map_Seek(seq_fP, SEQ_BLOCK_POS(blockP[ord], 2 + offset), SEEK_SET);
+    count = payload - offset;
+
+    while (size > 0)
+    {
+	if (size < count)
+	    count = size;
+
+	num_read = (LONG)SEQ_Map_Read((CHAR *)bufferP, sizeof(BYTE),
+					    (size_t)count, seq_fP);
+	if (num_read != count)
+	{
+	    printf("Only read %ld bytes out of %ld from input file.\n",
+				num_read, count);
+	    EXIT
+	}
+
+	bufferP += count;
+	size -= count;
+
+	if (size > 0)
+	{
+	    packet = seq_index.packetP[blockP[ord]] & 0x7fff;
+	    if (++ord >= num)
+	    {
+		next = (packet == 0x7ffe) ? 1 : packet + 1;
+		printf("Could not find packet %d...ran out of data\n",
+					    next | (plugin << 15));
+		EXIT
+	    }
+
+	    SEQ_Map_Seek(seq_fP, SEQ_BLOCK_POS(blockP[ord], 2), SEEK_SET);
+	    count = payload;
+	}
+    }
+
+    *statusP = TRUE;
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+SEQ_OFFSET SEQ_Index_Left(seq_fP, plugin, block_offset)
+  FILE  *seq_fP;
+  INT   plugin;
+  LONG  block_offset;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Tell how many BYTEs of the plugin's data are left in the file
+		from the position block_offset into the current block.
+
+    Inputs: seq_fP       = FILE pointer, at the start of a block
+	    plugin       = 0 for plugin A, 1 for plugin B
+	    block_offset = as kept by SEQ_Read_Blocks_Seg()
+
+    Outputs: number of BYTEs left
+	     -1 if there is no usable index for this plugin
+
+    Notes: Lets a caller find the end of the data without having the
+	   block readers report running into it.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Index_Left() */
+
+    LONG  payload;
+    SEQ_OFFSET pos;
+    LONG  ord;
+    SEQ_OFFSET last;
+    SEQ_OFFSET total;
+    LONG  num;
+
+    if ((seq_index_open == FALSE) || (seq_index.valid[plugin] == FALSE))
+	return ((SEQ_OFFSET)-1);
+
+    num = seq_index.num[plugin];
+    pos = SEQ_Map_Tell(seq_fP);
+    if ((pos < 0) || (pos % seq_index.block_size) || (num == 0))
+	return ((SEQ_OFFSET)-1);
+
+    payload = seq_index.block_size - 2;
+    ord = seq_idx_find(plugin, (LONG)(pos / seq_index.block_size));
+    if ((ord < num) &&
+	((seq_index.packetP[seq_index.blockP[plugin][ord]] & 0x7fff) == 0))
+	ord++;
+
+    /* The last block may have been cut short */
+    last = seq_index.file_size -
+			SEQ_BLOCK_POS(seq_index.blockP[plugin][num-1], 2);
+    if (last > payload)
+	last = payload;
+    total = (SEQ_OFFSET)(num - 1) * payload + last;
+
+    total -= (SEQ_OFFSET)ord * payload + block_offset;
+    return ((total < 0) ? (SEQ_OFFSET)0 : total);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Sidecar_Name(seq_filenameP, extP, nameP, max)
+  CHAR  *seq_filenameP;
+  CHAR  *extP;
+  CHAR  *nameP;
+  INT   max;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Build the name of a file kept next to the data file by
+		replacing (or adding) the extension of the data file name.
+
+    Inputs: seq_filenameP = name of the data file
+	    extP          = new extension, including the '.'
+	    nameP         = buffer of max CHARs for the result
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Sidecar_Name() */
+
+    CHAR *dotP;
+    CHAR *charP;
+    INT  len;
+
+    len = max - (INT)strlen(extP) - 1;
+    strncpy(nameP, seq_filenameP, (size_t)len);
+    nameP[len] = EOS;
+
+    dotP = NULL;
+    for (charP = nameP; *charP != EOS; ++charP)
+    {
+	if (*charP == '.')
+	    dotP = charP;
+	else if ((*charP == '/') || (*charP == '\\') || (*charP == ':'))
+	    dotP = NULL;
+    }
+
+    if (dotP != NULL)
+	*dotP = EOS;
+    strcat(nameP, extP);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Sidecar_Head(fP, magicP, head_size, entry_size, write)
+  FILE  *fP;
+  CHAR  *magicP;
+  LONG  head_size;
+  LONG  entry_size;
+  BOOL  write;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Write or check the start of a file kept next to the data
+		file: its magic, then the layout of what follows.
+
+    Inputs: magicP     = the 4 CHARs of the magic
+	    head_size  = BYTEs of the header struct the file holds
+	    entry_size = BYTEs of each entry after it, 0 if none
+	    write      = TRUE to write, FALSE to read and check
+
+    Outputs: TRUE if written, or read and the file was written by a
+		build with the same layout
+
+    Notes: The .idx, .sdr and .sck files hold LONGs and SEQ_OFFSETs as
+	   the host keeps them, so their size, the padding of the structs
+	   and the byte order depend on the compiler and on
+	   SEQ_LARGE_FILES. These are recorded as 32 bit little endian
+	   fields (SEQ_Put32()), and a file from a build that differs is
+	   not used.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Sidecar_Head() */
+
+    static UBYTE order[2] = { 1, 2 };
+    UBYTE stamp[4 + 4*5];
+    UBYTE read[sizeof(stamp)];
+
+    memcpy((CHAR *)stamp, magicP, 4);
+    SEQ_Put32(&stamp[4], (ULONG)sizeof(LONG));
+    SEQ_Put32(&stamp[8], (ULONG)sizeof(SEQ_OFFSET));
+    SEQ_Put32(&stamp[12], (ULONG)head_size);
+    SEQ_Put32(&stamp[16], (ULONG)entry_size);
+    SEQ_Put32(&stamp[20], (ULONG)*(UWORD *)order);
+
+    if (write == TRUE)
+	return (fwrite((CHAR *)stamp, sizeof(stamp), 1, fP) == 1);
+
+    return ((fread((CHAR *)read, sizeof(read), 1, fP) == 1) &&
+	    (memcmp((CHAR *)read, (CHAR *)stamp, sizeof(stamp)) == 0));
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Put32(bufP, value)
+  UBYTE *bufP;
+  ULONG value;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Store the low 32 bits of a field of a file header, little
+		endian, whatever size a ULONG has on the host.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Put32() */
+
+    bufP[0] = (UBYTE)(value & 0xff);
+    bufP[1] = (UBYTE)((value >> 8) & 0xff);
+    bufP[2] = (UBYTE)((value >> 16) & 0xff);
+    bufP[3] = (UBYTE)((value >> 24) & 0xff);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+ULONG SEQ_Get32(bufP)
+  UBYTE *bufP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Read back a field stored by SEQ_Put32().
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Get32() */
+
+    return ((ULONG)bufP[0] | ((ULONG)bufP[1] << 8) |
+	    ((ULONG)bufP[2] << 16) | ((ULONG)bufP[3] << 24));
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_idx_load(idx_nameP)
+  CHAR  *idx_nameP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Read the packet numbers from the .idx file if it exists and
+		was made from a data file of the current block and file size.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_idx_load() */
+
+    FILE        *idx_fP;
+    SEQ_IDX_HDR hdr;
+    BOOL        ok;
+
+    if ((idx_fP = fopen(idx_nameP, "rb")) == NULL)
+	return (FALSE);
+
+    ok = FALSE;
+    if ((SEQ_Sidecar_Head(idx_fP, SEQ_IDX_MAGIC, (LONG)sizeof(hdr),
+			    (LONG)sizeof(UWORD), FALSE) == TRUE) &&
+	(fread((CHAR *)&hdr, sizeof(hdr), 1, idx_fP) == 1) &&
+	(hdr.block_size == seq_index.block_size) &&
+	(hdr.file_size == seq_index.file_size) &&
+	((SEQ_OFFSET)hdr.num_blocks == (hdr.file_size + hdr.block_size - 2) /
+							hdr.block_size))
+    {
+	seq_index.packetP = (UWORD *)malloc((size_t)(sizeof(UWORD) *
+						(hdr.num_blocks + 1)));
+	if ((seq_index.packetP != NULL) &&
+	    (fread((CHAR *)seq_index.packetP, sizeof(UWORD),
+		   (size_t)hdr.num_blocks, idx_fP) == (size_t)hdr.num_blocks))
+	{
+	    seq_index.num_blocks = hdr.num_blocks;
+	    ok = TRUE;
+	}
+	else if (seq_index.packetP != NULL)
+	{
+	    free(seq_index.packetP);
+	    seq_index.packetP = NULL;
+	}
+    }
+    else if (SEQ_options.debug == 1)
+	printf("Packet index %s is out of date\n", idx_nameP);
+
+    fclose(idx_fP);
+    return (ok);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_idx_scan(seq_fP)
+  FILE  *seq_fP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Read the packet number of every block of the data file.
+
+    Notes: A trailing piece of a block is indexed as long as its packet
+	   number is complete, as the block walking readers would read it.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_idx_scan() */
+
+    LONG  num_blocks;
+    LONG  b;
+
+    num_blocks = (LONG)((seq_index.file_size + seq_index.block_size - 2) /
+						    seq_index.block_size);
+    seq_index.packetP = (UWORD *)malloc((size_t)(sizeof(UWORD) *
+						    (num_blocks + 1)));
+    if (seq_index.packetP == NULL)
+    {
+	fprintf(stderr, "Not enough memory for the packet index.\n");
+	return (FALSE);
+    }
+
+    for (b=0; b < num_blocks; ++b)
+    {
+	SEQ_Map_Seek(seq_fP, SEQ_BLOCK_POS(b, 0), SEEK_SET);
+	if (SEQ_Map_Read((CHAR *)&seq_index.packetP[b], sizeof(UWORD), 1,
+							    seq_fP) != 1)
+	    break;
+    }
+
+    seq_index.num_blocks = b;
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_idx_save(idx_nameP)
+  CHAR  *idx_nameP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Write the packet numbers to the .idx file. Failure to do so
+		only costs the scan on the next run.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_idx_save() */
+
+    FILE        *idx_fP;
+    SEQ_IDX_HDR hdr;
+    BOOL        ok;
+
+    if ((idx_fP = fopen(idx_nameP, "wb")) == NULL)
+    {
+	fprintf(stderr, "Could not create packet index %s\n", idx_nameP);
+	return;
+    }
+
+    memset((CHAR *)&hdr, 0, sizeof(hdr));
+    hdr.block_size = seq_index.block_size;
+    hdr.file_size = seq_index.file_size;
+    hdr.num_blocks = seq_index.num_blocks;
+
+    ok = (SEQ_Sidecar_Head(idx_fP, SEQ_IDX_MAGIC, (LONG)sizeof(hdr),
+			    (LONG)sizeof(UWORD), TRUE) == TRUE) &&
+	 (fwrite((CHAR *)&hdr, sizeof(hdr), 1, idx_fP) == 1) &&
+	 (fwrite((CHAR *)seq_index.packetP, sizeof(UWORD),
+		(size_t)hdr.num_blocks, idx_fP) == (size_t)hdr.num_blocks);
+
+    if (fclose(idx_fP) != 0)
+	ok = FALSE;
+
+    if (ok == FALSE)
+    {
+	fprintf(stderr, "Could not write packet index %s\n", idx_nameP);
+	remove(idx_nameP);
+    }
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_idx_plugins()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Split the packet numbers into a block list per plugin and
+		check that each plugin's packets are in sequence.
+
+    Notes: The sequence rules are those of the block walking readers:
+	   the first block is packet 0, the next ones count up from 1 and
+	   wrap from 0x7ffe to 1, and 0x7fff (last packet) may appear in
+	   place of any number, after which counting continues from the
+	   next packet found.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_idx_plugins() */
+
+    UWORD packet;
+    UWORD expect;
+    BOOL  any;
+    LONG  b;
+    LONG  n;
+    BYTE  p;
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	seq_index.num[p] = 0;
+	seq_index.hint[p] = 0;
+	seq_index.valid[p] = FALSE;
+	seq_index.blockP[p] = NULL;
+    }
+
+    for (b=0; b < seq_index.num_blocks; ++b)
+	seq_index.num[seq_index.packetP[b] >> 15]++;
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	if (seq_index.num[p] == 0)
+	    continue;
+
+	seq_index.blockP[p] = (LONG *)malloc((size_t)(sizeof(LONG) *
+						    seq_index.num[p]));
+	if (seq_index.blockP[p] == NULL)
+	{
+	    fprintf(stderr, "Not enough memory for the packet index.\n");
+	    for (p=0; p < MAX_PLUGINS; ++p)
+		if (seq_index.blockP[p] != NULL)
+		    free(seq_index.blockP[p]);
+	    return (FALSE);
+	}
+
+	n = 0;
+	expect = 0;
+	any = FALSE;
+	seq_index.valid[p] = TRUE;
+	for (b=0; b < seq_index.num_blocks; ++b)
+	{
+	    if ((seq_index.packetP[b] >> 15) != p)
+		continue;
+
+	    seq_index.blockP[p][n++] = b;
+	    packet = seq_index.packetP[b] & 0x7fff;
+
+	    if (packet == 0x7fff)
+		any = TRUE;
+	    else if ((packet == expect) || ((any == TRUE) && (packet != 0)))
+	    {
+		any = FALSE;
+		expect = (packet == 0x7ffe) ? 1 : packet + 1;
+	    }
+	    else
+		seq_index.valid[p] = FALSE;
+	}
+    }
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static LONG seq_idx_find(plugin, block)
+  INT   plugin;
+  LONG  block;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Return the entry of the plugin's block list that is the
+		first block at or after the given block (num if none).
+
+    Notes: Reads usually continue where the last one stopped, so the
+	   entry used last time is tried before searching.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_idx_find() */
+
+    LONG *blockP;
+    LONG lo, hi, mid;
+
+    blockP = seq_index.blockP[plugin];
+    lo = seq_index.hint[plugin];
+    if ((lo < seq_index.num[plugin]) && (blockP[lo] == block))
+	return (lo);
+
+    lo = 0;
+    hi = seq_index.num[plugin];
+    while (lo < hi)
+    {
+	mid = lo + (hi - lo) / 2;
+	if (blockP[mid] < block)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+
+    return (lo);
+}
@@ -0,0 +1,651 @@
+/************************** seq_job.c **************************************
+
+Translation of the segments in parallel (-j).
+
+SEQ_Read_Segment_Number() translates one segment after the other: it
+reads a segment's channel, filters it and writes it out before it goes on
+to the next, so that all the filtering is done by one processor however
+many the machine has.
+
+When compiled with SEQ_THREADS defined (POSIX threads only) and run with
+-jN, N threads are started the first time a segment is to be translated.
+The main thread still walks the data file as before (selections, channel
+tags, acquisition parameters, SEQ_Init_Descriptor()), but instead of
+filtering a segment's channel it reads all of its pieces into a job and
+goes on to the next. A thread takes the job, runs the translation loop of
+SEQ_Read_Segment_Number() over it with SEQ_Process_Seg() and
+SEQ_Output_Seg() in a context of its own, and writes the output into
+memory (open_memstream()) instead of to the screen or a trace file. The
+main thread puts the output of the jobs on the screen, or into the
+trace_PC.nnn files, in the order the segments were read, so that it is
+byte for byte the same as without -j.
+
+There are two jobs for every thread; when all are taken, the main thread
+waits for the oldest one to be done and writes it out. Every job holds a
+whole channel of a segment, raw and translated.
+
+Not used with -d, -t, -r or -v, whose output comes from the main thread
+in between that of the segments, nor with SEQ_Decode() (seq_lib.c).
+A message about the data file (a bad packet, say) comes out when the
+main thread reads it, which may be before the output of the last few
+segments read before it.
+
+Without SEQ_THREADS every call does nothing and the segments are
+translated as before.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "seq_filt.h"
+#include "seq_tran.h"
+
+#ifdef SEQ_THREADS
+#include <pthread.h>
+#endif /* SEQ_THREADS */
+
+/* -------------------------------------------------------------------- */
+
+extern BOOL   SEQ_Read_Blocks_Seg();
+extern BOOL   SEQ_Process_Seg();
+extern VOID   SEQ_Output_Seg();
+extern FILE   *SEQ_Open_Trace();
+extern VOID   SEQ_update_time();
+extern VOID   SEQ_Batch_Close();
+extern VOID   SEQ_fir_free();
+extern VOID   SEQ_Loop_Buffers();
+extern VOID   SEQ_Loop_Free();
+
+#ifdef SEQ_THREADS
+
+#define SEQ_JOB_FREE	0	/* nothing in it */
+#define SEQ_JOB_READY	1	/* read, for a thread to take */
+#define SEQ_JOB_BUSY	2	/* being translated */
+#define SEQ_JOB_DONE	3	/* translated, to be written out */
+
+/* A channel of a segment, as SEQ_Read_Segment_Number() had it ready to
+   translate, with its raw data */
+typedef struct SEQ_JOB
+{
+    INT   state;			/* SEQ_JOB_... */
+    LONG  segno;
+    SEQ_ACQ_DATA    acq_data;		/* position and first piece */
+    SEQ_FILTER_DATA filt_data;
+    FILTER          filter;		/* *filt_data.paramsP */
+    WAVE_PARAMS     wave;		/* *filt_data.waveP */
+    BYTE  desc[sizeof(PCW_Waveform[0][0])];	/* its descriptor */
+    BYTE  *rawP;			/* the pieces, one after the other */
+    LONG  raw_size;			/* BYTEs allocated at rawP */
+    LONG  size;				/* BYTEs read into rawP */
+    LONG  total;			/* BYTEs of the channel */
+    CHAR  *outP;			/* its output, open_memstream() */
+    size_t out_size;
+} SEQ_JOB;
+
+#endif /* SEQ_THREADS */
+
+/* State of the module in the current context (seq_ctx.c): in the main
+   thread's the threads and the jobs, in a thread's the job it is
+   translating */
+typedef struct SEQ_JOB_STATE
+{
+    INT   workers;			/* threads, 0 = none, -1 = failed */
+#ifdef SEQ_THREADS
+    pthread_t   thread[SEQ_MAX_JOBS];
+    SEQ_CONTEXT *ctxP[SEQ_MAX_JOBS];	/* the context of each */
+    SEQ_JOB *jobP;			/* [slots] */
+    INT   slots;
+    INT   put;				/* job the next segment goes in */
+    INT   take;				/* job a thread takes next */
+    INT   commit;			/* job written out next */
+    INT   pending;			/* jobs not yet written out */
+    BOOL  stop;				/* tells the threads to finish */
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+
+    struct SEQ_JOB_STATE *poolP;	/* a thread's: whose jobs */
+    SEQ_JOB *currentP;			/* a thread's: job in hand */
+    LONG  get;				/* BYTEs of it taken so far */
+#endif /* SEQ_THREADS */
+} SEQ_JOB_STATE;
+
+#define seq_jobsP	SEQ_MODULE(SEQ_MOD_JOBS, SEQ_JOB_STATE)
+
+#ifdef SEQ_THREADS
+static BOOL   seq_job_start();
+static VOID   seq_job_commit();
+static VOID   *seq_job_worker();
+static VOID   seq_job_run();
+#endif /* SEQ_THREADS */
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Job_Submit(seq_fP, segno, acq_dataP, filt_dataP, total,
+							    keep_goingP)
+  FILE          *seq_fP;
+  LONG          segno;
+  SEQ_ACQ_DATA  *acq_dataP;
+  SEQ_FILTER_DATA *filt_dataP;
+  LONG          total;
+  BOOL          *keep_goingP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Read a channel of a segment that is to be translated and
+		leave the translating to the threads of -j.
+
+    Inputs: seq_fP     = FILE pointer to the opened data file
+	    segno      = segment number
+	    acq_dataP  = position and size of the first piece, as it would
+			 be passed to SEQ_Process_Seg()
+	    filt_dataP = as it would be passed to SEQ_Process_Seg(), with
+			 the descriptor and waveP set up for the segment
+	    total      = BYTEs of data in the channel
+
+    Outputs: TRUE if the channel has been read (as far as it could be)
+		and will be translated and written out by the threads;
+		acq_dataP->block_offset is then where the reading ended,
+		and *keep_goingP is FALSE if a piece could not be read.
+	     FALSE if the caller has to translate it itself.
+
+    Notes: Waits for a free job first, writing out those done.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Job_Submit() */
+
+#ifdef SEQ_THREADS
+    SEQ_JOB_STATE *jobsP;
+    SEQ_JOB       *jobP;
+    SEQ_ACQ_DATA  data;
+    LONG  size;
+    LONG  read;
+
+    jobsP = seq_jobsP;
+    if ((SEQ_options.jobs < 2) || (jobsP->workers < 0) ||
+	(SEQ_options.debug != FALSE) || (SEQ_options.print_times == TRUE) ||
+	(SEQ_options.test_mode == TRUE) || (SEQ_options.resume == TRUE) ||
+	(SEQ_options.output.type == SEQ_OUTPUT_BUFFER) || (total <= 0))
+	return (FALSE);
+
+    if ((jobsP->workers == 0) && (seq_job_start(jobsP) == FALSE))
+    {
+	jobsP->workers = -1;
+	return (FALSE);
+    }
+
+    /* Write out the jobs done, waiting for the oldest if none is free */
+    seq_job_commit(jobsP, FALSE);
+    if (jobsP->pending == jobsP->slots)
+	seq_job_commit(jobsP, TRUE);
+
+    jobP = &jobsP->jobP[jobsP->put];
+    if (jobP->raw_size < total)
+    {
+	free(jobP->rawP);
+	jobP->rawP = (BYTE *)malloc((size_t)total);
+	jobP->raw_size = (jobP->rawP != NULL) ? total : 0L;
+	if (jobP->rawP == NULL)
+	    return (FALSE);
+    }
+
+    /* Read the pieces, in the sizes the translation loop asks for */
+    data = *acq_dataP;
+    size = acq_dataP->size;
+    read = 0L;
+    while (read < total)
+    {
+	if (size > total - read)
+	    size = total - read;
+	data.bufP = jobP->rawP + read;
+	data.size = size;
+	if (SEQ_Read_Blocks_Seg(seq_fP, &data, TRUE) == FALSE)
+	{
+	    *keep_goingP = FALSE;
+	    break;
+	}
+	read += size;
+	size = MAX_BUF_SIZE;
+	SEQ_update_time(TRUE, total, total - read);
+    }
+    acq_dataP->block_offset = data.block_offset;
+    acq_dataP->byte_offset = data.byte_offset;
+    acq_dataP->bytes_read = data.bytes_read;
+
+    jobP->segno = segno;
+    jobP->acq_data = *acq_dataP;
+    jobP->filt_data = *filt_dataP;
+    jobP->filter = *filt_dataP->paramsP;
+    jobP->wave = *filt_dataP->waveP;
+    memcpy((VOID *)jobP->desc, (VOID *)PCW_Waveform[acq_dataP->plugin]
+			[acq_dataP->channel], sizeof(jobP->desc));
+    jobP->size = read;
+    jobP->total = total;
+
+    pthread_mutex_lock(&jobsP->lock);
+    jobP->state = SEQ_JOB_READY;
+    pthread_cond_broadcast(&jobsP->cond);
+    pthread_mutex_unlock(&jobsP->lock);
+
+    jobsP->put = (jobsP->put + 1) % jobsP->slots;
+    ++jobsP->pending;
+    return (TRUE);
+#else
+    return (FALSE);
+#endif /* SEQ_THREADS */
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Job_Get(acq_dataP, statusP)
+  SEQ_ACQ_DATA  *acq_dataP;
+  BOOL          *statusP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Read_Blocks_Seg() for SEQ_Process_Seg() in a thread of
+		-j: the next piece of the job in hand.
+
+    Inputs: acq_dataP = as for SEQ_Read_Blocks_Seg(); size must be that
+			of the next piece
+
+    Outputs: TRUE if the piece was taken from the job; *statusP is FALSE
+		if the main thread could not read it.
+	     FALSE if there is no job in hand (not a thread of -j).
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Job_Get() */
+
+#ifdef SEQ_THREADS
+    SEQ_JOB_STATE *jobsP;
+    SEQ_JOB       *jobP;
+
+    jobsP = seq_jobsP;
+    if ((jobP = jobsP->currentP) == NULL)
+	return (FALSE);
+
+    *statusP = FALSE;
+    if (jobsP->get + acq_dataP->size <= jobP->size)
+    {
+	memcpy((VOID *)acq_dataP->bufP, (VOID *)(jobP->rawP + jobsP->get),
+						(size_t)acq_dataP->size);
+	acq_dataP->bytes_read = acq_dataP->size;
+	jobsP->get += acq_dataP->size;
+	*statusP = TRUE;
+    }
+
+    return (TRUE);
+#else
+    return (FALSE);
+#endif /* SEQ_THREADS */
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Job_Drain()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Wait for the threads of -j to translate every segment given
+		to them, and write them all out.
+
+    Notes: Called by SEQ_Read_Segment_Number() before anything else is
+	   printed and when it is done.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Job_Drain() */
+
+#ifdef SEQ_THREADS
+    SEQ_JOB_STATE *jobsP;
+
+    if (SEQ_ctxP->moduleP[SEQ_MOD_JOBS] == NULL)
+	return;
+
+    jobsP = seq_jobsP;
+    while ((jobsP->workers > 0) && (jobsP->pending > 0))
+	seq_job_commit(jobsP, TRUE);
+#endif /* SEQ_THREADS */
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Job_Stop()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Write out what the threads of -j have still, stop them and
+		release their jobs and contexts.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Job_Stop() */
+
+#ifdef SEQ_THREADS
+    SEQ_JOB_STATE *jobsP;
+    INT   n;
+
+    if (SEQ_ctxP->moduleP[SEQ_MOD_JOBS] == NULL)
+	return;
+
+    jobsP = seq_jobsP;
+    if (jobsP->workers <= 0)
+	return;
+
+    SEQ_Job_Drain();
+
+    pthread_mutex_lock(&jobsP->lock);
+    jobsP->stop = TRUE;
+    pthread_cond_broadcast(&jobsP->cond);
+    pthread_mutex_unlock(&jobsP->lock);
+
+    for (n=0; n < jobsP->workers; ++n)
+    {
+	pthread_join(jobsP->thread[n], NULL);
+	SEQ_Context_Free(jobsP->ctxP[n]);
+    }
+    pthread_cond_destroy(&jobsP->cond);
+    pthread_mutex_destroy(&jobsP->lock);
+
+    for (n=0; n < jobsP->slots; ++n)
+	free(jobsP->jobP[n].rawP);
+    free(jobsP->jobP);
+    jobsP->jobP = NULL;
+    jobsP->workers = 0;
+#endif /* SEQ_THREADS */
+}
+
+#ifdef SEQ_THREADS
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_job_start(jobsP)
+  SEQ_JOB_STATE *jobsP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Start the threads of -j and make their jobs.
+
+    Outputs: TRUE if at least one thread was started
+
+    Notes: A thread works in a copy of the current context, made now
+	   (SEQ_Context_Copy()); its descriptors are put in from the jobs.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_job_start() */
+
+    SEQ_CONTEXT   *ctxP;
+    SEQ_JOB_STATE *stateP;
+    INT   n;
+
+    jobsP->slots = 2 * SEQ_options.jobs;
+    jobsP->jobP = (SEQ_JOB *)calloc((size_t)jobsP->slots, sizeof(SEQ_JOB));
+    if (jobsP->jobP == NULL)
+	return (FALSE);
+
+    jobsP->put = jobsP->take = jobsP->commit = 0;
+    jobsP->pending = 0;
+    jobsP->stop = FALSE;
+    pthread_mutex_init(&jobsP->lock, NULL);
+    pthread_cond_init(&jobsP->cond, NULL);
+
+    for (n=0; n < SEQ_options.jobs; ++n)
+    {
+	ctxP = SEQ_Context_Copy();
+	stateP = (SEQ_JOB_STATE *)calloc((size_t)1, sizeof(SEQ_JOB_STATE));
+	if ((ctxP == NULL) || (stateP == NULL))
+	{
+	    free(ctxP);
+	    free(stateP);
+	    break;
+	}
+
+	stateP->poolP = jobsP;
+	ctxP->moduleP[SEQ_MOD_JOBS] = (VOID *)stateP;
+
+	if (pthread_create(&jobsP->thread[n], NULL, seq_job_worker,
+						    (VOID *)ctxP) != 0)
+	{
+	    SEQ_Context_Free(ctxP);
+	    break;
+	}
+	jobsP->ctxP[n] = ctxP;
+    }
+
+    jobsP->workers = n;
+    if (n == 0)
+    {
+	pthread_cond_destroy(&jobsP->cond);
+	pthread_mutex_destroy(&jobsP->lock);
+	free(jobsP->jobP);
+	jobsP->jobP = NULL;
+	return (FALSE);
+    }
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_job_commit(jobsP, wait)
+  SEQ_JOB_STATE *jobsP;
+  BOOL  wait;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Write out the output of the jobs done, oldest first, up to
+		the first one not done.
+
+    Inputs: wait = TRUE to wait for the oldest job to be done
+
+    Notes: Trace files are numbered as they are created, so they are
+	   only created here, in the order of the segments.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_job_commit() */
+
+    SEQ_JOB *jobP;
+    FILE  *fP;
+    INT   state;
+
+    while (jobsP->pending > 0)
+    {
+	jobP = &jobsP->jobP[jobsP->commit];
+	pthread_mutex_lock(&jobsP->lock);
+	while ((wait == TRUE) && (jobP->state != SEQ_JOB_DONE))
+	    pthread_cond_wait(&jobsP->cond, &jobsP->lock);
+	state = jobP->state;
+	pthread_mutex_unlock(&jobsP->lock);
+	if (state != SEQ_JOB_DONE)
+	    return;
+
+	if (jobP->out_size > 0)
+	{
+	    if (SEQ_options.output.type == SEQ_OUTPUT_FILE)
+	    {
+		fP = SEQ_Open_Trace((WORD)jobP->acq_data.plugin,
+			    (WORD)jobP->acq_data.channel, jobP->segno);
+		fwrite(jobP->outP, sizeof(CHAR), jobP->out_size, fP);
+		fclose(fP);
+	    }
+	    else
+		fwrite(jobP->outP, sizeof(CHAR), jobP->out_size, stdout);
+	}
+	free(jobP->outP);
+	jobP->outP = NULL;
+
+	/* Let a reader of the output see each segment as it arrives */
+	if (SEQ_options.stream == TRUE)
+	    fflush(stdout);
+
+	pthread_mutex_lock(&jobsP->lock);
+	jobP->state = SEQ_JOB_FREE;
+	pthread_mutex_unlock(&jobsP->lock);
+
+	jobsP->commit = (jobsP->commit + 1) % jobsP->slots;
+	--jobsP->pending;
+	wait = FALSE;
+    }
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID *seq_job_worker(argP)
+  VOID  *argP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: A thread of -j: translate the jobs in turn until told to
+		finish.
+
+    Inputs: argP = the thread's context
+
+    Notes: Its buffers are those of SEQ_Read_Segment_Number(),
+	   SEQ_Loop_Buffers().
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_job_worker() */
+
+    SEQ_JOB_STATE *poolP;
+    SEQ_JOB *jobP;
+    BYTE  *array1P;
+    WORD  *array3P;
+    FLOAT *valuesP;
+    DOUBLE *timesP;
+
+    SEQ_ctxP = (SEQ_CONTEXT *)argP;
+    poolP = seq_jobsP->poolP;
+
+    SEQ_Loop_Buffers(&array1P, &array3P, &valuesP, &timesP);
+
+    for (;;)
+    {
+	pthread_mutex_lock(&poolP->lock);
+	jobP = &poolP->jobP[poolP->take];
+	while ((jobP->state != SEQ_JOB_READY) && (poolP->stop == FALSE))
+	{
+	    pthread_cond_wait(&poolP->cond, &poolP->lock);
+	    jobP = &poolP->jobP[poolP->take];
+	}
+	if (jobP->state != SEQ_JOB_READY)
+	{
+	    pthread_mutex_unlock(&poolP->lock);
+	    break;
+	}
+	jobP->state = SEQ_JOB_BUSY;
+	poolP->take = (poolP->take + 1) % poolP->slots;
+	pthread_mutex_unlock(&poolP->lock);
+
+	seq_job_run(jobP, array1P, array3P, valuesP, timesP);
+
+	pthread_mutex_lock(&poolP->lock);
+	jobP->state = SEQ_JOB_DONE;
+	pthread_cond_broadcast(&poolP->cond);
+	pthread_mutex_unlock(&poolP->lock);
+    }
+
+    SEQ_Loop_Free();
+    SEQ_Batch_Close();
+    SEQ_fir_free();
+    return (NULL);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_job_run(jobP, array1P, array3P, valuesP, timesP)
+  SEQ_JOB *jobP;
+  BYTE    *array1P;
+  WORD    *array3P;
+  FLOAT   *valuesP;
+  DOUBLE  *timesP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Translate a job into its output: the loop of
+		SEQ_Read_Segment_Number() over the channel of a segment.
+
+    Inputs: array1P, ... = the thread's buffers
+
+    Outputs: jobP->outP, out_size = what SEQ_Output_Seg() wrote
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_job_run() */
+
+    SEQ_JOB_STATE *jobsP;
+    SEQ_ACQ_DATA  acq_data;
+    SEQ_FILTER_DATA filt_data;
+    LONG  data_size;
+    BOOL  first_seg;
+    BYTE  status;
+
+    jobsP = seq_jobsP;
+    acq_data = jobP->acq_data;
+    acq_data.baseP = array1P;
+    acq_data.bufP = array1P;
+    filt_data = jobP->filt_data;
+    filt_data.paramsP = &jobP->filter;
+    filt_data.waveP = &jobP->wave;
+    filt_data.rawP = array1P;
+    filt_data.corrP = array3P;
+    filt_data.valuesP = valuesP;
+    filt_data.timesP = timesP;
+
+    jobP->outP = NULL;
+    jobP->out_size = 0;
+    SEQ_ctxP->spool_fP = open_memstream(&jobP->outP, &jobP->out_size);
+    if (SEQ_ctxP->spool_fP == NULL)
+	error_handler(OUT_OF_MEMORY);
+
+    /* The descriptor SEQ_Init_Descriptor() made for the segment */
+    memcpy((VOID *)PCW_Waveform[acq_data.plugin][acq_data.channel],
+			    (VOID *)jobP->desc, sizeof(jobP->desc));
+
+    jobsP->currentP = jobP;
+    jobsP->get = 0L;
+    first_seg = TRUE;
+    data_size = jobP->total;
+    while (data_size > 0)
+    {
+	if (SEQ_Process_Seg(NULL, first_seg, &acq_data, &filt_data,
+							    TRUE) == FALSE)
+	    break;
+
+	/* Adjust data_size for amount just read */
+	data_size -= acq_data.size;
+
+	if (first_seg == FALSE)
+	{
+	    if (data_size == 0)
+		status = SEQ_LAST_BLOCK;
+	    else
+		status = SEQ_NEXT_BLOCK;
+	}
+	else
+	{
+	    status = SEQ_FIRST_BLOCK;
+	    if (data_size == 0)
+		status |= SEQ_LAST_BLOCK;
+	}
+	SEQ_Output_Seg(jobP->segno, status, &acq_data, &filt_data,
+							    &jobP->wave);
+
+	first_seg = FALSE;
+
+	if (data_size < MAX_BUF_SIZE)
+	    acq_data.size = data_size;
+    }
+    jobsP->currentP = NULL;
+
+    fclose(SEQ_ctxP->spool_fP);
+    SEQ_ctxP->spool_fP = NULL;
+    SEQ_ctxP->out_fP = NULL;
+}
+
+#endif /* SEQ_THREADS */
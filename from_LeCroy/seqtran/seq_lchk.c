@@ -0,0 +1,323 @@
+/************************** seq_lchk.c *************************************
+
+Checks the translator as a library (seqlchk.exe).
+
+A program using seq_lib.c decodes the segments it wants in whatever order
+it likes, the same one again as often as it likes, all in the context of
+the one SEQ_Open(). Every SEQ_Decode() is a new pass of the translation
+loop over the data file, so anything the loop keeps from one pass to the
+next (a position in the data file, the segment directory or the columnar
+cache) shows up here as the wrong segment. This program decodes the first
+segments of every channel of a data file in a fresh SEQ_Open() each, then
+in one context in turn:
+
+	1 2 3 ... n		in order
+	1 1 2 2 ... n n		each twice
+	n ... 3 2 1		backwards
+	n 1 n 2 ... n n-1	from the last to each of the others
+
+in each format, and compares the points with the fresh ones.
+
+The library reads the segments from the columnar cache of the data file
+when there is one (seqtran -c builds it), so run the check once without
+and once with it:
+
+	seqlchk [-n segments] datafile ...
+
+The packet index and the segment directory are built as SEQ_Open() does
+when asked to. The exit status is 1 if any segment differs or a data
+file cannot be read.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "seq_lib.h"
+
+/* -------------------------------------------------------------------- */
+
+#define CHECK_ERRORS	10		/* differences printed */
+
+static LONG   check_errors = 0;
+
+static BOOL   check_file();
+static BOOL   check_channel();
+static LONG   check_order();
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID main(ac, av)
+    int ac;
+    char *av[];
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Checks that SEQ_Decode() gives every segment the same points
+		whatever was decoded before it.
+
+    Inputs: ac = number of arguments (switches)
+	    av = -n segments checked of each channel (8)
+		 the data files
+
+    Outputs: exits with 1 if any segment differed or a file failed
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* main() */
+
+    CHAR  *argP;
+    LONG  segments;
+    BOOL  ok;
+    INT   files;
+    INT   i;
+
+    segments = 8;
+    files = 0;
+    ok = TRUE;
+    for (i=1; i < ac; ++i)
+    {
+	argP = &av[i][2];
+	if (!strncmp(av[i], "-n", 2))
+	{
+	    if ((*argP == EOS) && ((i+1) < ac))
+		argP = av[++i];
+	    segments = atol(argP);
+	}
+	else if (av[i][0] == '-')
+	    files = -1;
+	else if (files >= 0)
+	{
+	    ++files;
+	    if (check_file(av[i], segments) == FALSE)
+		ok = FALSE;
+	}
+    }
+
+    if ((files <= 0) || (segments < 1))
+    {
+	printf("Usage: seqlchk [-n segments] datafile ...\n");
+	exit(1);
+    }
+
+    if (check_errors != 0)
+    {
+	printf("%ld segments differ\n", (long)check_errors);
+	exit(1);
+    }
+    if (ok == FALSE)
+	exit(1);
+    exit(0);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL check_file(filenameP, segments)
+  CHAR  *filenameP;
+  LONG  segments;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Check every channel of every plugin of a data file.
+
+    Inputs: segments = how many of the first segments of each
+
+    Outputs: FALSE if the data file could not be opened or decoded
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* check_file() */
+
+    SEQ_FILE *fileP;
+    LONG  segs;
+    LONG  points;
+    INT   channels;
+    INT   p,c;
+    BOOL  ok;
+
+    if ((fileP = SEQ_Open(filenameP, TRUE)) == NULL)
+    {
+	printf("%s: cannot be opened\n", filenameP);
+	return (FALSE);
+    }
+
+    ok = TRUE;
+    for (p=0; p < 2; ++p)
+    {
+	segs = SEQ_Segments(fileP, p);
+	if (segs <= 0L)
+	    continue;
+	if (segs > segments)
+	    segs = segments;
+	points = SEQ_Points(fileP, p);
+	channels = SEQ_Channels(fileP, p);
+
+	for (c=0; c < channels; ++c)
+	    if (check_channel(fileP, filenameP, p, c, segs, points) == FALSE)
+		ok = FALSE;
+    }
+
+    SEQ_Close(fileP);
+    return (ok);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL check_channel(fileP, filenameP, plugin, channel, segs, points)
+  SEQ_FILE *fileP;
+  CHAR  *filenameP;
+  INT   plugin;
+  INT   channel;
+  LONG  segs;
+  LONG  points;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Decode the first segments of a channel in each format, in a
+		fresh context each and then in every order in fileP, and
+		compare them.
+
+    Outputs: FALSE if a segment could not be decoded in a fresh context
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* check_channel() */
+
+    SEQ_FILE *freshP;
+    BYTE  *refP;
+    BYTE  *bufferP;
+    LONG  *countP;
+    LONG  *orderP;
+    LONG  n;
+    LONG  errors;
+    size_t size;
+    INT   format;
+    LONG  s;
+
+    /* Room for a segment in the widest format, FLOATs */
+    size = (size_t)points * sizeof(FLOAT);
+    refP = (BYTE *)malloc(size * (size_t)segs);
+    bufferP = (BYTE *)malloc(size);
+    countP = (LONG *)malloc(sizeof(LONG) * (size_t)segs);
+    orderP = (LONG *)malloc(sizeof(LONG) * (size_t)(8 * segs));
+    if ((refP == NULL) || (bufferP == NULL) || (countP == NULL) ||
+	(orderP == NULL))
+    {
+	printf("Not enough memory\n");
+	exit(1);
+    }
+
+    /* The orders, one after the other */
+    n = 0L;
+    for (s=1; s <= segs; ++s)
+	orderP[n++] = s;
+    for (s=1; s <= segs; ++s)
+    {
+	orderP[n++] = s;
+	orderP[n++] = s;
+    }
+    for (s=segs; s >= 1; --s)
+	orderP[n++] = s;
+    for (s=1; s < segs; ++s)
+    {
+	orderP[n++] = segs;
+	orderP[n++] = s;
+    }
+
+    errors = 0L;
+    for (format=SEQ_FORMAT_RAW; format <= SEQ_FORMAT_COMPENSATED; ++format)
+    {
+	for (s=1; s <= segs; ++s)
+	{
+	    if ((freshP = SEQ_Open(filenameP, FALSE)) == NULL)
+		countP[s-1] = -1L;
+	    else
+	    {
+		countP[s-1] = SEQ_Decode(freshP, plugin, channel, s, format,
+				(VOID *)&refP[size * (s-1)], points);
+		SEQ_Close(freshP);
+	    }
+	    if (countP[s-1] < 0L)
+	    {
+		printf("%s: segment %ld of %c%d cannot be decoded\n",
+			filenameP, (long)s, plugin+'A', channel+1);
+		free(refP);
+		free(bufferP);
+		free(countP);
+		free(orderP);
+		return (FALSE);
+	    }
+	}
+
+	errors += check_order(fileP, plugin, channel, format, orderP, n,
+			    refP, countP, bufferP, size, points);
+    }
+
+    printf("%s: %c%d, %ld segments in 4 orders and 3 formats: %s\n",
+		filenameP, plugin+'A', channel+1, (long)segs,
+		(errors == 0L) ? "ok" : "differ");
+
+    free(refP);
+    free(bufferP);
+    free(countP);
+    free(orderP);
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static LONG check_order(fileP, plugin, channel, format, orderP, n, refP,
+			countP, bufferP, size, points)
+  SEQ_FILE *fileP;
+  INT   plugin;
+  INT   channel;
+  INT   format;
+  LONG  *orderP;
+  LONG  n;
+  BYTE  *refP;
+  LONG  *countP;
+  BYTE  *bufferP;
+  size_t size;
+  LONG  points;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Decode the segments orderP[0..n-1] one after the other in
+		fileP and compare each with the one of a fresh context.
+
+    Outputs: number of segments that differed
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* check_order() */
+
+    LONG  count;
+    LONG  errors;
+    LONG  i;
+    LONG  s;
+    size_t bytes;
+
+    errors = 0L;
+    for (i=0; i < n; ++i)
+    {
+	s = orderP[i];
+	count = SEQ_Decode(fileP, plugin, channel, s, format,
+						(VOID *)bufferP, points);
+
+	bytes = (size_t)((countP[s-1] < points) ? countP[s-1] : points);
+	bytes *= (format == SEQ_FORMAT_COMPENSATED) ? sizeof(FLOAT) :
+							sizeof(WORD);
+	if ((count == countP[s-1]) &&
+	    (memcmp((VOID *)bufferP, (VOID *)&refP[size * (s-1)], bytes) == 0))
+	    continue;
+
+	++errors;
+	if (++check_errors <= CHECK_ERRORS)
+	    printf("  %c%d format %d: segment %ld after %ld gave %ld points "
+		    "that differ\n", plugin+'A', channel+1, format, (long)s,
+		    (i == 0L) ? 0L : (long)orderP[i-1], (long)count);
+    }
+
+    return (errors);
+}
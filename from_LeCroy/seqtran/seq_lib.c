@@ -0,0 +1,473 @@
+/************************** seq_lib.c **************************************
+
+The translator as a library.
+
+A program that wants the segments of a SCSI sequence data file, rather
+than the output of seqtran, opens the data file with SEQ_Open(), asks how
+many segments, channels and points it holds, and has single segments
+translated into buffers of its own with SEQ_Decode():
+
+	SEQ_FILE *fileP;
+	FLOAT    volts[...];
+
+	fileP = SEQ_Open("capture.dat", TRUE);
+	for (seg=1; seg <= SEQ_Segments(fileP, 0); ++seg)
+	    n = SEQ_Decode(fileP, 0, 0, seg, SEQ_FORMAT_COMPENSATED,
+							volts, size);
+	SEQ_Close(fileP);
+
+The calls are declared in seq_lib.h, which is all such a program needs;
+it is linked with the objects of seqtran other than seq_main.obj.
+Every data file opened is translated in a context of its own (seq_ctx.c),
+so several can be open at once, and, with SEQ_THREADS, decoded at the
+same time in different threads (one thread per data file at a time).
+
+SEQ_Decode() runs the translation loop of seqtran (seq_tran.c) over the
+one segment asked for, with the points going into the caller's buffer
+(SEQ_OUTPUT_BUFFER) instead of to the screen or a trace file. The
+segment directory (seq_dir.c, built by SEQ_Open() when asked to) lets
+the loop go straight to the segment; without it the loop walks the data
+file from the start every time.
+
+A data file the translator cannot make sense of used to end the program.
+Inside these calls it makes the call fail instead (SEQ_Exit()); the
+messages are still printed.
+
+SEQ_Start() and SEQ_Stop() open and close the data file of the current
+context for seqtran (seq_main.c) and for SEQ_Open() and SEQ_Close().
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "seq_tran.h"
+#include "seq_lib.h"
+
+/* -------------------------------------------------------------------- */
+
+extern VOID   SEQ_interpret();
+extern VOID   SEQ_Read_Segment_Number();
+extern VOID   SEQ_default_options();
+extern BOOL   SEQ_Map_Open();
+extern BOOL   SEQ_Map_Stream();
+extern VOID   SEQ_Map_Close();
+extern BOOL   SEQ_Index_Open();
+extern VOID   SEQ_Index_Close();
+extern BOOL   SEQ_Dir_Open();
+extern VOID   SEQ_Dir_Close();
+extern LONG   SEQ_Dir_Count();
+extern BOOL   SEQ_Dmx_Open();
+extern VOID   SEQ_Dmx_Resume();
+extern VOID   SEQ_Dmx_Close();
+extern BOOL   SEQ_Ckpt_Open();
+extern BOOL   SEQ_Col_Open();
+extern VOID   SEQ_Col_Close();
+extern VOID   SEQ_Job_Stop();
+extern VOID   SEQ_Pipe_Stop();
+extern VOID   SEQ_Ahead_Stop();
+extern VOID   SEQ_Batch_Close();
+extern VOID   SEQ_fir_free();
+extern VOID   SEQ_Loop_Free();
+
+/* Make a library call's context current and have SEQ_Exit() return to
+   the call, the caller's own context and return point put back after */
+#define SEQ_ENTER(ctxP, jump, failed)					\
+	saved_ctxP = SEQ_ctxP;						\
+	saved_jumpP = SEQ_jumpP;					\
+	SEQ_ctxP = (ctxP);						\
+	SEQ_jumpP = (VOID *)(jump);					\
+	if (setjmp(jump) != 0)						\
+	{								\
+	    SEQ_ctxP = saved_ctxP;					\
+	    SEQ_jumpP = saved_jumpP;					\
+	    failed;							\
+	}
+
+#define SEQ_LEAVE							\
+	SEQ_ctxP = saved_ctxP;						\
+	SEQ_jumpP = saved_jumpP;
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Start(seq_filenameP, once)
+  CHAR  *seq_filenameP;
+  BOOL  once;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Open the data file of the current context and read its
+		descriptors, ready for SEQ_READ_SEGMENT_NUMBER.
+
+    Inputs: seq_filenameP = name of the data file, - for standard input
+	    once          = TRUE if each plugin is translated once, A
+			    before B (seqtran): plugin B's blocks are then
+			    collected while A is translated (seq_dmx.c),
+			    and an earlier run is carried on from with -r
+
+    Outputs: TRUE if the data file is open (SEQ_ctxP->seq_fP)
+
+    Notes: Errors in the data file go through SEQ_Exit().
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Start() */
+
+    FILE *seq_fP;
+    SEQ_OFFSET start[MAX_PLUGINS];
+
+    /* Open the specified data file, - being standard input */
+	if (!strcmp(seq_filenameP, "-"))
+	    seq_fP = stdin;
+	else if ((seq_fP = fopen(seq_filenameP,"rb")) == NULL)
+	{
+	    printf("Could not open file %s\n", seq_filenameP);
+	    return (FALSE);
+	}
+	SEQ_ctxP->seq_fP = seq_fP;
+
+    /* Read a pipe or a file being written as it arrives, or map the data
+       file into memory when the host supports it */
+	if (SEQ_options.stream == TRUE)
+	{
+	    if (SEQ_Map_Stream(seq_fP, SEQ_options.follow) == FALSE)
+		error_handler(OUT_OF_MEMORY);
+	}
+	else
+	    (VOID)SEQ_Map_Open(seq_fP);
+
+    /* initialize the acquisition parameters in descriptor */
+	SEQ_interpret(seq_fP, SEQ_INIT_PARAMETERS);
+
+    /* Use (or build) the packet index of the data file */
+	if (SEQ_options.stream == FALSE)
+	    (VOID)SEQ_Index_Open(seq_fP, seq_filenameP,
+					(INT)SEQ_options.build_index);
+
+    /* initialize the descriptor for all channels */
+	SEQ_interpret(seq_fP, SEQ_READ_DESCRIPTOR);
+
+    /* Use (or build) the segment directory of the data file */
+	if (SEQ_options.stream == FALSE)
+	    (VOID)SEQ_Dir_Open(seq_fP, seq_filenameP,
+					(INT)SEQ_options.build_index);
+
+    /* Read the segments from the columnar cache of the data file (built
+       first with -c), or else collect plugin B's blocks while plugin A is
+       translated */
+	if ((SEQ_Col_Open(seq_fP, seq_filenameP,
+			(INT)SEQ_options.build_cache) == FALSE) && once)
+	    (VOID)SEQ_Dmx_Open(seq_fP);
+
+    /* Carry on from where the last run with -r got to */
+	if (once && (SEQ_Ckpt_Open(seq_fP, seq_filenameP, start) == TRUE))
+	    SEQ_Dmx_Resume(seq_fP, start);
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Stop()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Close the data file of the current context and everything
+		that was opened or allocated to read and filter it.
+
+    Notes: Also after SEQ_Start() failed or was given up half way.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Stop() */
+
+    SEQ_Job_Stop();
+    SEQ_Pipe_Stop();
+    SEQ_Ahead_Stop();
+    SEQ_Dmx_Close();
+    SEQ_Col_Close();
+    SEQ_Dir_Close();
+    SEQ_Index_Close();
+    SEQ_Batch_Close();
+    SEQ_fir_free();
+    SEQ_Loop_Free();
+
+    if (SEQ_ctxP->seq_fP != NULL)
+    {
+	SEQ_Map_Close(SEQ_ctxP->seq_fP);
+	if (SEQ_ctxP->seq_fP != stdin)
+	    fclose(SEQ_ctxP->seq_fP);
+	SEQ_ctxP->seq_fP = NULL;
+    }
+
+    /* A trace file left open by a translation that was given up */
+    if (SEQ_ctxP->out_fP != NULL)
+    {
+	fclose(SEQ_ctxP->out_fP);
+	SEQ_ctxP->out_fP = NULL;
+    }
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+SEQ_FILE *SEQ_Open(filenameP, build)
+  CONST CHAR *filenameP;
+  INT   build;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Open a data file to decode segments of.
+
+    Inputs: filenameP = name of the data file
+	    build     = TRUE to build the packet index and segment
+			directory next to the data file if there are none
+			(as seqtran -i does), so that any segment can be
+			decoded without walking the file
+
+    Outputs: the open data file, NULL if it could not be opened or read
+
+    Notes: The filter kernels are those bound by the program with
+	   SEQ_Vec_Init(), once before the first SEQ_Open(); until then
+	   the original loops filter.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Open() */
+
+    SEQ_CONTEXT *ctxP;
+    SEQ_CONTEXT *saved_ctxP;
+    VOID    *saved_jumpP;
+    jmp_buf jump;
+
+    if ((filenameP == NULL) ||
+	(strlen(filenameP) >= sizeof(ctxP->filename)))
+	return (NULL);
+
+    if ((ctxP = SEQ_Context_New()) == NULL)
+	return (NULL);
+
+    SEQ_ENTER(ctxP, jump, goto failed)
+
+    SEQ_default_options();
+    SEQ_options.build_index = (build != FALSE);
+    SEQ_options.output.type = SEQ_OUTPUT_BUFFER;
+    strcpy(SEQ_ctxP->filename, filenameP);
+
+    if (SEQ_Start(SEQ_ctxP->filename, FALSE) == FALSE)
+    {
+	SEQ_LEAVE
+	goto failed;
+    }
+
+    SEQ_LEAVE
+    return (ctxP);
+
+    failed:;
+    SEQ_ctxP = ctxP;
+    SEQ_jumpP = NULL;
+    SEQ_Stop();
+    SEQ_ctxP = saved_ctxP;
+    SEQ_jumpP = saved_jumpP;
+    SEQ_Context_Free(ctxP);
+    return (NULL);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Segments(ctxP, plugin)
+  SEQ_FILE *ctxP;
+  INT   plugin;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Number of segments acquired by a plugin.
+
+    Inputs: ctxP   = data file, SEQ_Open()
+	    plugin = 0 for plugin A, 1 for plugin B
+
+    Outputs: the number of segments, -1 if not known (no segment
+		directory) or the plugin was not present
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Segments() */
+
+    SEQ_CONTEXT *saved_ctxP;
+    LONG  count;
+
+    if (SEQ_Channels(ctxP, plugin) <= 0)
+	return (-1L);
+
+    saved_ctxP = SEQ_ctxP;
+    SEQ_ctxP = ctxP;
+    count = SEQ_Dir_Count(plugin);
+    SEQ_ctxP = saved_ctxP;
+
+    return (count);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+INT SEQ_Channels(ctxP, plugin)
+  SEQ_FILE *ctxP;
+  INT   plugin;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Number of channels acquired by a plugin.
+
+    Inputs: ctxP   = data file, SEQ_Open()
+	    plugin = 0 for plugin A, 1 for plugin B
+
+    Outputs: the number of channels, 0 if the plugin was not present
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Channels() */
+
+    if ((ctxP == NULL) || (plugin < (INT)ctxP->params.first_plugin) ||
+	(plugin > (INT)ctxP->params.last_plugin))
+	return (0);
+
+    return ((INT)ctxP->params.last_channel[plugin] + 1);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Points(ctxP, plugin)
+  SEQ_FILE *ctxP;
+  INT   plugin;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Room to make for a segment of the plugin in SEQ_Decode().
+
+    Inputs: ctxP   = data file, SEQ_Open()
+	    plugin = 0 for plugin A, 1 for plugin B
+
+    Outputs: points acquired per segment (WAVE_ARRAY_1), 0 if the plugin
+		was not present
+
+    Notes: Corrected and compensated segments are a few points shorter
+	   (the filter's), SEQ_Decode() says by how much.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Points() */
+
+    if (SEQ_Channels(ctxP, plugin) <= 0)
+	return (0L);
+
+    return (ctxP->array_size[plugin]);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Decode(ctxP, plugin, channel, segno, format, bufferP, size)
+  SEQ_FILE *ctxP;
+  INT   plugin;
+  INT   channel;
+  LONG  segno;
+  INT   format;
+  VOID  *bufferP;
+  LONG  size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Translate a segment of a channel into the caller's buffer.
+
+    Inputs: ctxP    = data file, SEQ_Open()
+	    plugin  = 0 for plugin A, 1 for plugin B
+	    channel = 0..SEQ_Channels()-1
+	    segno   = segment, 1..SEQ_Segments()
+	    format  = SEQ_FORMAT_RAW: WORDs as acquired (<< 8)
+		      SEQ_FORMAT_CORRECTED: filtered WORDs
+		      SEQ_FORMAT_COMPENSATED: FLOATs in volts
+	    bufferP = where the points go
+	    size    = room in bufferP, in points
+
+    Outputs: number of points in the segment (only the first size are in
+		bufferP if it has more), -1 if the segment is not in the
+		data file or it could not be translated
+
+    Notes: The points are the ones seqtran prints for the segment.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Decode() */
+
+    SEQ_CONTEXT *saved_ctxP;
+    VOID    *saved_jumpP;
+    jmp_buf jump;
+    SEGS    *segP;
+    BYTE    p,c;
+    BYTE    t;
+
+    if ((channel < 0) || (channel >= SEQ_Channels(ctxP, plugin)) ||
+	(segno < 1L) || (format < SEQ_FORMAT_RAW) ||
+	(format > SEQ_FORMAT_COMPENSATED) || (bufferP == NULL) ||
+	(size < 0L))
+	return (-1L);
+
+    SEQ_ENTER(ctxP, jump, { SEQ_ctxP = ctxP;
+			    SEQ_Ahead_Stop();
+			    SEQ_ctxP = saved_ctxP;
+			    return (-1L); })
+
+    /* Select only this segment of this channel */
+    for (p=0; p < MAX_PLUGINS; ++p)
+	for (c=0; c < MAX_CHANNELS; ++c)
+	    for (t=0; t < MAX_SEG_TYPES; ++t)
+	    {
+		segP = SEQ_options.seg[p][c][t];
+		segP->select.n.start = -1L;
+		segP->select.n.end = -1L;
+		if (t == SEQ_TIME)
+		{
+		    segP->select.t.start = (DOUBLE)-1;
+		    segP->select.t.end = (DOUBLE)-1;
+		}
+		SEQ_ctxP->check_index[p][c][t] = 0;
+	    }
+    segP = SEQ_options.seg[plugin][channel][SEQ_SEGNO];
+    segP[0].select.n.start = segno;
+    segP[0].select.n.end = segno;
+    segP[1].select.n.start = -1L;
+    segP[1].select.n.end = -1L;
+
+    SEQ_options.format = (BYTE)format;
+    SEQ_ctxP->decodeP = bufferP;
+    SEQ_ctxP->decode_size = size;
+    SEQ_ctxP->decode_count = -1L;
+
+    SEQ_Read_Segment_Number(SEQ_ctxP->seq_fP, (BYTE)plugin, SEQ_ALL_SEGS);
+
+    SEQ_LEAVE
+    return (ctxP->decode_count);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Close(ctxP)
+  SEQ_FILE *ctxP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Close a data file opened with SEQ_Open().
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Close() */
+
+    SEQ_CONTEXT *saved_ctxP;
+
+    if (ctxP == NULL)
+	return;
+
+    saved_ctxP = SEQ_ctxP;
+    SEQ_ctxP = ctxP;
+    SEQ_Stop();
+    SEQ_ctxP = saved_ctxP;
+    SEQ_Context_Free(ctxP);
+}
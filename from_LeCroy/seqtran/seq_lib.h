@@ -0,0 +1,42 @@
+/*---------------------    SEQ_LIB.H    ---------------------------------
+
+The translator as a library: the calls a program makes to decode the
+segments of a SCSI sequence data file itself (see seq_lib.c).
+
+--------------------------------------------------------------------------*/
+
+#ifndef SEQ_LIB_H
+#define SEQ_LIB_H
+
+#include "aagen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A data file opened with SEQ_Open() */
+typedef struct SEQ_CONTEXT SEQ_FILE;
+
+/* Format of the points of SEQ_Decode(), as in seq_tran.h */
+#define SEQ_FORMAT_RAW		0	/* no corrections, raw data */
+#define SEQ_FORMAT_CORRECTED    1	/* correct data with filter coeffs */
+#define SEQ_FORMAT_COMPENSATED  2	/* correct and compensate data */
+
+/* The best filter kernels the processor has, SEQ_Vec_Init() */
+#define SEQ_KERNEL_AUTO		4
+
+extern INT      SEQ_Vec_Init(INT kernels);
+extern SEQ_FILE *SEQ_Open(CONST CHAR *filenameP, INT build);
+extern LONG     SEQ_Segments(SEQ_FILE *fileP, INT plugin);
+extern INT      SEQ_Channels(SEQ_FILE *fileP, INT plugin);
+extern LONG     SEQ_Points(SEQ_FILE *fileP, INT plugin);
+extern LONG     SEQ_Decode(SEQ_FILE *fileP, INT plugin, INT channel,
+			   LONG segno, INT format, VOID *bufferP, LONG size);
+extern VOID     SEQ_Close(SEQ_FILE *fileP);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEQ_LIB_H */
+/*------------------------- end of file ----------------------------------*/
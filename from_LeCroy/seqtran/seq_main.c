@@ -0,0 +1,132 @@
+/************************** seq_main.c *************************************
+
+Author: Christopher Eck		LeCroy Corporation
+	             		700 Chestnut Ridge Road
+				Chestnut Ridge, NY  10977
+
+The seqtran program: the translator of seq_tran.c run on the data file and
+with the options given on the command line. The same translator is in
+the library of seq_lib.c, for programs that read a data file themselves.
+
+ **********************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <dos.h>
+#include "seq_tran.h"
+#include "seq_filt.h"
+#include "seq_hdr.h"
+
+/* -------------------------------------------------------------------- */
+
+extern STATUS PCW_Print_Block();
+extern CHAR   *SEQ_process_arguments();
+extern VOID   SEQ_interpret();
+extern BOOL   SEQ_Start();
+extern VOID   SEQ_Stop();
+extern INT    SEQ_Vec_Init();
+extern BOOL   SEQ_Pool_Run();
+extern BOOL   SEQ_Shard_Run();
+extern VOID   SEQ_Shard_Open();
+extern VOID   SEQ_Shard_Close();
+
+extern struct PCW_TEMPLATE *PCW_templateP;
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID main(ac, av)
+    int ac;
+    char *av[];
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Displays sign-on message, processes any switch arguments and
+		calls the driver routine to transfer and process the SCSI
+		data.
+
+    Inputs: ac = number of arguments (switches)
+	    av = the switches as ASCII strings
+
+    Outputs: Calls sink(), the driver that does all the work.
+	     Turns off the SCSI interrupts on exit to restore proper PC
+	       operation.
+
+    Machine dependencies: IBM PC or compatible
+
+    Notes: Can define notdef to display the number of SCSI interrupts
+	     that were processed; there should be an interrupt for every
+	     block transfer of data.
+
+	   The translation is done in a context of its own (seq_ctx.c),
+	   opened and closed by SEQ_Start() and SEQ_Stop() (seq_lib.c).
+	   With -b the data files of a list are translated instead, each
+	   in a context of its own (seq_wsp.c). With -m the segments are
+	   translated in shards by processes of their own, each started
+	   again with -n (seq_shd.c).
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* main() */
+
+    CHAR *seq_filenameP;
+    BYTE p,c;
+
+    /* Print program description */
+	fprintf(stderr,
+  "LeCroy 7200A SCSI Sequence Data Translator (Version 1.1, Feb 19, 1993).\n");
+
+    /* Make the context to translate in */
+	if ((SEQ_ctxP = SEQ_Context_New()) == NULL)
+	    error_handler(OUT_OF_MEMORY);
+
+    /* Process all the arguments to this routine */
+	seq_filenameP = SEQ_process_arguments(ac, &av[0]);
+
+    /* Bind the filter kernels for this processor */
+	(VOID)SEQ_Vec_Init(SEQ_options.kernels);
+
+    /* Or translate every data file of a list or pattern (-b) */
+	if (SEQ_options.file_list == TRUE)
+	{
+	    if (SEQ_Pool_Run(seq_filenameP) == FALSE)
+		EXIT
+	    SEQ_Context_Free(SEQ_ctxP);
+	    exit (0);
+	}
+
+    /* A shard of -m is translated into files of its own */
+	SEQ_Shard_Open(seq_filenameP);
+
+    /* Open the data file and read its descriptors */
+	if (SEQ_Start(seq_filenameP, TRUE) == FALSE)
+	    EXIT
+
+    /* If the acquisition parameters should be displayed, print them out */
+	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+	{
+	    for (c=0; c <= SEQ_params.last_channel[p]; ++c)
+	    {
+		if (SEQ_options.print_params[p][c] == TRUE)
+		{
+		    printf("\nDESCRIPTOR FOR %c%d:\n",p+'A',c+1);
+		    (VOID)PCW_Print_Block(stdout,PCW_templateP,PCW_waveformP
+		       [p][c],"WAVEDESC",PCW_Regular,TRUE,2,0,(LONG)0,(LONG)0);
+		}
+	    }
+	}
+
+    /* Translate the data requested (# segments, segs after a time, ...),
+       or have the processes of -m translate it */
+	if (SEQ_Shard_Run(ac, av, seq_filenameP) == FALSE)
+	    SEQ_interpret(SEQ_ctxP->seq_fP, SEQ_READ_SEGMENT_NUMBER);
+
+    /* Close the file before ending program */
+	SEQ_Stop();
+	SEQ_Shard_Close(seq_filenameP);
+	SEQ_Context_Free(SEQ_ctxP);
+
+    exit (0);
+}
@@ -0,0 +1,705 @@
+/************************** seq_map.c **************************************
+
+This module hides how the sequence data file is accessed from the block
+readers in seq_tran.c and ris_tran.c. When compiled with SEQ_MMAP defined
+(POSIX hosts only) the whole data file is mapped into memory once, so that
+reading a packet number or skipping a block is only a pointer update and
+the payload of a block can be handed out by address. Without SEQ_MMAP, or
+if the file cannot be mapped, every call falls back to fread()/fseek() on
+the FILE pointer and the behaviour is that of the original readers.
+
+All reads and seeks on the data file MUST go through these routines once
+SEQ_Map_Open() has been called, since the position of a mapped file is
+kept here and not in the FILE structure.
+
+SEQ_Map_Read_Blocks() lets the block readers take a run of whole blocks
+in one go: the blocks are read with a single fread() (or looked at in
+place when mapped), their packet numbers are checked together and the
+payloads are packed one after the other into the caller's buffer.
+
+SEQ_Map_Stream() is used instead of SEQ_Map_Open() when the data file is
+read as it arrives: from a pipe (stdin), or from a file that acquire is
+still writing. The input is then only ever read forward, into a window of
+SEQ_STREAM_SIZE BYTEs. Seeking forward reads and drops the data in
+between. Seeking back is only possible as far as the window reaches, which
+covers the descriptors at the start of the file and the short steps back
+of the block readers. When the end of the input is reached in follow
+mode, reading waits for more data for up to the given number of seconds.
+
+Positions are SEQ_OFFSETs. With SEQ_LARGE_FILES the buffered path uses
+fseeko()/ftello(), so that files beyond 2 GB can be read on hosts where
+a long is 32 bits (compile with _FILE_OFFSET_BITS=64 there as well).
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "seq_tran.h"
+
+#ifdef SEQ_MMAP
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif /* SEQ_MMAP */
+
+#if defined(MSDOS) || defined(__WATCOMC__) || defined(__TURBOC__)
+#include <dos.h>		/* sleep() */
+#else
+#include <unistd.h>		/* sleep() */
+#endif
+
+#ifdef SEQ_LARGE_FILES
+#define SEQ_FSEEK(fP, offset, origin)	fseeko(fP, (off_t)(offset), origin)
+#define SEQ_FTELL(fP)			((SEQ_OFFSET)ftello(fP))
+#else
+#define SEQ_FSEEK(fP, offset, origin)	fseek(fP, (LONG)(offset), origin)
+#define SEQ_FTELL(fP)			ftell(fP)
+#endif /* SEQ_LARGE_FILES */
+
+/* -------------------------------------------------------------------- */
+
+typedef struct SEQ_MAP
+{
+    FILE  *fP;		/* file that is mapped, NULL if none */
+    BYTE  *baseP;	/* start of the mapped file */
+    SEQ_OFFSET size;	/* size of the file in BYTEs */
+    SEQ_OFFSET pos;	/* current read position */
+} SEQ_MAP;
+
+/* Window kept of a streamed input, and how much of it is kept behind the
+   read position when it has to move on */
+#define SEQ_STREAM_SIZE	1048576L
+#define SEQ_STREAM_BACK	(SEQ_STREAM_SIZE / 4)
+
+typedef struct SEQ_STREAM
+{
+    FILE  *fP;		/* input read forward only, NULL if none */
+    BYTE  *bufP;	/* SEQ_STREAM_SIZE BYTEs of the input */
+    SEQ_OFFSET start;	/* input offset of bufP[0] */
+    LONG  len;		/* BYTEs in bufP */
+    SEQ_OFFSET pos;	/* current read position */
+    BOOL  eof;		/* TRUE once the input has ended */
+    INT   follow;	/* seconds to wait for more input */
+} SEQ_STREAM;
+
+/* Largest run of blocks read at once when the file is not mapped */
+#define SEQ_BULK_SIZE	32768L
+
+/* State of the module in the current context (seq_ctx.c) */
+typedef struct SEQ_MAP_STATE
+{
+    SEQ_MAP    map;
+    SEQ_STREAM stream;
+    BYTE       *bulkP;
+} SEQ_MAP_STATE;
+
+#define seq_map		(SEQ_MODULE(SEQ_MOD_MAP, SEQ_MAP_STATE)->map)
+#define seq_stream	(SEQ_MODULE(SEQ_MOD_MAP, SEQ_MAP_STATE)->stream)
+#define seq_bulkP	(SEQ_MODULE(SEQ_MOD_MAP, SEQ_MAP_STATE)->bulkP)
+
+static BOOL seq_stream_fill();
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Map_Open(seq_fP)
+  FILE  *seq_fP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Map the opened data file into memory.
+
+    Inputs: seq_fP = FILE pointer to the opened data file
+
+    Outputs: TRUE if the file is mapped
+	     FALSE if the buffered fread()/fseek() path will be used
+
+    Machine dependencies: mmap() requires a POSIX host and SEQ_MMAP.
+
+    Notes: Only one file can be mapped at a time. Files larger than
+	   the address space or a SEQ_OFFSET are left to the buffered path.
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Map_Open() */
+
+#ifdef SEQ_MMAP
+    struct stat st;
+    VOID *addrP;
+
+    if (seq_map.fP != NULL)
+	return (FALSE);
+
+    if (fstat(fileno(seq_fP), &st) != 0)
+	return (FALSE);
+
+    if ((st.st_size <= 0) ||
+	((off_t)(SEQ_OFFSET)st.st_size != st.st_size) ||
+	((off_t)(size_t)st.st_size != st.st_size))
+	return (FALSE);
+
+    addrP = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED,
+					    fileno(seq_fP), (off_t)0);
+    if (addrP == MAP_FAILED)
+	return (FALSE);
+
+#ifdef MADV_SEQUENTIAL
+    (VOID)madvise(addrP, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+
+    seq_map.fP = seq_fP;
+    seq_map.baseP = (BYTE *)addrP;
+    seq_map.size = (SEQ_OFFSET)st.st_size;
+    seq_map.pos = SEQ_FTELL(seq_fP);
+    if (seq_map.pos < 0)
+	seq_map.pos = 0L;
+
+    if (SEQ_options.debug == 1)
+	printf("Mapped %.0f bytes of input\n", (DOUBLE)seq_map.size);
+
+    return (TRUE);
+#else
+    return (FALSE);
+#endif /* SEQ_MMAP */
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Map_Stream(seq_fP, follow)
+  FILE  *seq_fP;
+  INT   follow;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Read the data file forward only, as it arrives.
+
+    Inputs: seq_fP = FILE pointer to the opened data file or stdin,
+			nothing read from it yet
+	    follow = seconds to wait at the end of the input for more
+			data, 0 to stop at the first end of file
+
+    Outputs: TRUE if the input will be streamed
+	     FALSE if there is no memory for the window
+
+    Notes: Use instead of SEQ_Map_Open(). The packet index and the
+	   segment directory cannot be used on a streamed input.
+
+    Procedure:
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Map_Stream() */
+
+    if (seq_stream.fP != NULL)
+	return (FALSE);
+
+    seq_stream.bufP = (BYTE *)malloc((size_t)SEQ_STREAM_SIZE);
+    if (seq_stream.bufP == NULL)
+	return (FALSE);
+
+    seq_stream.fP = seq_fP;
+    seq_stream.start = 0L;
+    seq_stream.len = 0L;
+    seq_stream.pos = 0L;
+    seq_stream.eof = FALSE;
+    seq_stream.follow = follow;
+
+    if (SEQ_options.debug == 1)
+	printf("Streaming input, waiting %d seconds for more data\n",
+								follow);
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Map_Close(seq_fP)
+  FILE  *seq_fP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Release the mapping of the data file, if any, and leave the
+		FILE position where the mapped reader left off.
+
+    Inputs: seq_fP = FILE pointer to the opened data file
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Map_Close() */
+
+    if (seq_bulkP != NULL)
+	free(seq_bulkP);
+    seq_bulkP = NULL;
+
+    if ((seq_stream.fP != NULL) && (seq_stream.fP == seq_fP))
+    {
+	free(seq_stream.bufP);
+	seq_stream.bufP = NULL;
+	seq_stream.fP = NULL;
+	return;
+    }
+
+#ifdef SEQ_MMAP
+    if ((seq_map.fP == NULL) || (seq_map.fP != seq_fP))
+	return;
+
+    (VOID)munmap((VOID *)seq_map.baseP, (size_t)seq_map.size);
+    (VOID)SEQ_FSEEK(seq_fP, seq_map.pos, SEEK_SET);
+
+    seq_map.fP = NULL;
+    seq_map.baseP = NULL;
+    seq_map.size = 0L;
+    seq_map.pos = 0L;
+#endif /* SEQ_MMAP */
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BYTE *SEQ_Map_Ptr(seq_fP, size)
+  FILE  *seq_fP;
+  LONG  size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Hand out the address of the next size BYTEs of the data file
+		and advance past them.
+
+    Inputs: seq_fP = FILE pointer to the opened data file
+	    size   = number of BYTEs wanted
+
+    Outputs: pointer into the mapped file
+	     NULL if the file is not mapped or less than size BYTEs remain
+		(the position is not changed in that case)
+
+    Notes: The returned memory is read only and stays valid until
+	   SEQ_Map_Close() is called.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Map_Ptr() */
+
+    BYTE *bufP;
+
+    if ((seq_map.fP == NULL) || (seq_map.fP != seq_fP))
+	return (NULL);
+
+    if ((size < 0) || (seq_map.pos < 0) ||
+	(seq_map.pos > seq_map.size - (SEQ_OFFSET)size))
+	return (NULL);
+
+    bufP = seq_map.baseP + seq_map.pos;
+    seq_map.pos += size;
+
+    return (bufP);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+size_t SEQ_Map_Read(bufP, size, num, seq_fP)
+  VOID   *bufP;
+  size_t size;
+  size_t num;
+  FILE   *seq_fP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: fread() replacement for the data file.
+
+    Inputs: same as fread()
+
+    Outputs: number of complete items read, as for fread()
+
+    Notes: A short read copies whatever is left in the file, exactly as
+	   fread() would, and leaves the position at the end of file.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Map_Read() */
+
+    SEQ_OFFSET avail;
+    SEQ_OFFSET want;
+
+    if ((seq_stream.fP != NULL) && (seq_stream.fP == seq_fP))
+    {
+	if ((size == 0) || (num == 0))
+	    return (0);
+
+	want = (SEQ_OFFSET)(size * num);
+	if (seq_stream.pos < seq_stream.start)
+	{
+	    printf("Cannot go back to offset %.0f of streamed input.\n",
+						(DOUBLE)seq_stream.pos);
+	    EXIT
+	}
+	if (seq_stream_fill(seq_stream.pos + want) == FALSE)
+	{
+	    printf("Read of %.0f bytes too large for streamed input.\n",
+							(DOUBLE)want);
+	    EXIT
+	}
+
+	avail = seq_stream.start + seq_stream.len - seq_stream.pos;
+	if (avail <= 0)
+	    return (0);
+	if (want > avail)
+	    want = avail;
+
+	memcpy(bufP, (VOID *)(seq_stream.bufP +
+		    (LONG)(seq_stream.pos - seq_stream.start)), (size_t)want);
+	seq_stream.pos += want;
+
+	return ((size_t)want / size);
+    }
+
+    if ((seq_map.fP == NULL) || (seq_map.fP != seq_fP))
+	return (fread(bufP, size, num, seq_fP));
+
+    if ((size == 0) || (num == 0))
+	return (0);
+
+    avail = seq_map.size - seq_map.pos;
+    if (avail <= 0)
+	return (0);
+
+    want = (SEQ_OFFSET)(size * num);
+    if (want > avail)
+	want = avail;
+
+    memcpy(bufP, (VOID *)(seq_map.baseP + seq_map.pos), (size_t)want);
+    seq_map.pos += want;
+
+    return ((size_t)want / size);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+INT SEQ_Map_Seek(seq_fP, offset, origin)
+  FILE        *seq_fP;
+  SEQ_OFFSET  offset;
+  INT         origin;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: fseek() replacement for the data file.
+
+    Inputs: same as fseek()
+
+    Outputs: 0 if the position was changed
+	     -1 if the new position would be before the start of the file
+
+    Notes: As with fseek(), seeking beyond the end of the file is allowed;
+	   the next read then returns 0 items.
+
+	   offset is a SEQ_OFFSET, so callers need the full prototype:
+	   INT SEQ_Map_Seek(FILE *, SEQ_OFFSET, INT).
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Map_Seek() */
+
+    SEQ_OFFSET pos;
+
+    if ((seq_stream.fP != NULL) && (seq_stream.fP == seq_fP))
+    {
+	/* The end of a streamed input is not known in advance */
+	if (origin == SEEK_SET)
+	    pos = offset;
+	else if (origin == SEEK_CUR)
+	    pos = seq_stream.pos + offset;
+	else
+	    return (-1);
+
+	if (pos < 0)
+	    return (-1);
+
+	seq_stream.pos = pos;
+	return (0);
+    }
+
+    if ((seq_map.fP == NULL) || (seq_map.fP != seq_fP))
+	return (SEQ_FSEEK(seq_fP, offset, origin));
+
+    if (origin == SEEK_SET)
+	pos = offset;
+    else if (origin == SEEK_CUR)
+	pos = seq_map.pos + offset;
+    else
+	pos = seq_map.size + offset;
+
+    if (pos < 0)
+	return (-1);
+
+    seq_map.pos = pos;
+    return (0);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+SEQ_OFFSET SEQ_Map_Tell(seq_fP)
+  FILE  *seq_fP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: ftell() replacement for the data file.
+
+    Inputs: seq_fP = FILE pointer to the opened data file
+
+    Outputs: current read position in BYTEs from the start of the file
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Map_Tell() */
+
+    if ((seq_stream.fP != NULL) && (seq_stream.fP == seq_fP))
+	return (seq_stream.pos);
+
+    if ((seq_map.fP == NULL) || (seq_map.fP != seq_fP))
+	return (SEQ_FTELL(seq_fP));
+
+    return (seq_map.pos);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+SEQ_OFFSET SEQ_Map_Size(seq_fP)
+  FILE  *seq_fP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Find the size of the data file.
+
+    Inputs: seq_fP = FILE pointer to the opened data file
+
+    Outputs: size in BYTEs, with seq_fP at the end of the file
+	     -1 if the size is not known (a streamed input) or does not
+		fit in a SEQ_OFFSET
+
+    Notes: Without SEQ_LARGE_FILES ftell() fails on a file of 2 GB or
+	   more where a long is 32 bits, and a wider long may still not
+	   fit in a SEQ_OFFSET, so the value is checked before it is
+	   returned. The caller restores the position.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Map_Size() */
+
+#ifdef SEQ_LARGE_FILES
+    off_t size;
+#else
+    long  size;
+#endif /* SEQ_LARGE_FILES */
+
+    if ((seq_stream.fP != NULL) && (seq_stream.fP == seq_fP))
+	return (-1);
+
+    if ((seq_map.fP != NULL) && (seq_map.fP == seq_fP))
+    {
+	seq_map.pos = seq_map.size;
+	return (seq_map.size);
+    }
+
+    if (SEQ_FSEEK(seq_fP, 0L, SEEK_END) != 0)
+	return (-1);
+
+#ifdef SEQ_LARGE_FILES
+    size = ftello(seq_fP);
+#else
+    size = ftell(seq_fP);
+#endif /* SEQ_LARGE_FILES */
+    if ((size < 0) || ((SEQ_OFFSET)size != size))
+	return (-1);
+
+    return ((SEQ_OFFSET)size);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Map_Read_Blocks(seq_fP, bufferP, max_blocks, plugin_mask, iP)
+  FILE  *seq_fP;
+  BYTE  *bufferP;
+  LONG  max_blocks;
+  INT   plugin_mask;
+  UWORD *iP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Read a run of whole blocks of one plugin, stripping the
+		packet numbers.
+
+    Inputs: seq_fP      = FILE pointer, at the start of a block
+	    bufferP     = where to pack the payloads, NULL to skip them
+	    max_blocks  = most blocks wanted
+	    plugin_mask = plugin bit of the blocks wanted
+	    *iP         = packet number of the block before the run
+
+    Outputs: number of blocks taken; seq_fP is left at the start of the
+		block following them and *iP is the packet number of the
+		last block taken.
+
+    Notes: The run ends in front of the first block that belongs to the
+	   other plugin, is out of sequence, is the last packet (0x7fff)
+	   or is cut short, so that the caller can deal with it one block
+	   at a time as before.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Map_Read_Blocks() */
+
+    BYTE  *blockP;
+    LONG  block_size;
+    LONG  payload;
+    LONG  taken;
+    LONG  num;
+    LONG  n;
+    UWORD packet;
+    UWORD i;
+
+    block_size = SEQ_params.block_size;
+    payload = block_size - 2;
+    if ((max_blocks <= 0) || (payload <= 0))
+	return (0L);
+
+    taken = 0;
+    i = *iP;
+    while (taken < max_blocks)
+    {
+	num = max_blocks - taken;
+	if ((seq_map.fP != NULL) && (seq_map.fP == seq_fP))
+	{
+	    /* Mapped: look at the blocks where they are */
+	    if ((seq_map.size - seq_map.pos) / block_size < (SEQ_OFFSET)num)
+		num = (LONG)((seq_map.size - seq_map.pos) / block_size);
+	    blockP = SEQ_Map_Ptr(seq_fP, num * block_size);
+	}
+	else
+	{
+	    if ((seq_bulkP == NULL) && (block_size <= SEQ_BULK_SIZE))
+		seq_bulkP = (BYTE *)malloc((size_t)SEQ_BULK_SIZE);
+	    if (seq_bulkP == NULL)
+		break;
+
+	    n = SEQ_BULK_SIZE / block_size;
+	    if (num > n)
+		num = n;
+	    n = (LONG)SEQ_Map_Read((VOID *)seq_bulkP, sizeof(BYTE),
+				(size_t)(num * block_size), seq_fP);
+	    num = n / block_size;
+	    if (n != num * block_size)
+		SEQ_Map_Seek(seq_fP, (SEQ_OFFSET)(num * block_size - n),
+								SEEK_CUR);
+	    blockP = seq_bulkP;
+	}
+
+	if ((num <= 0) || (blockP == NULL))
+	    break;
+
+	/* Check the packet numbers as the block walker does */
+	for (n=0; n < num; ++n, blockP += block_size)
+	{
+	    memcpy((VOID *)&packet, (VOID *)blockP, sizeof(UWORD));
+	    if ((packet & 0x8000) != (UWORD)plugin_mask)
+		break;
+
+	    /* Only the packet that follows i; never 0x7fff (last packet),
+	       which the caller has to see for itself */
+	    if (i == 0x7ffe)
+		i = 1;	/* wrap */
+	    else if (i != 0x7fff)
+		++i;
+	    if ((i == 0x7fff) || (i != (packet & 0x7fff)))
+		break;
+
+	    if (bufferP != NULL)
+	    {
+		memcpy((VOID *)bufferP, (VOID *)(blockP + 2), (size_t)payload);
+		bufferP += payload;
+	    }
+	    *iP = i;
+	}
+
+	taken += n;
+	if (n < num)
+	{
+	    /* Give back the blocks after the run */
+	    SEQ_Map_Seek(seq_fP, (SEQ_OFFSET)(-(num - n) * block_size),
+								SEEK_CUR);
+	    break;
+	}
+    }
+
+    return (taken);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_stream_fill(end)
+  SEQ_OFFSET  end;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Read the streamed input until the window reaches offset end,
+		or the input ends.
+
+    Outputs: FALSE if the BYTEs from the read position to end cannot all
+		be held in the window
+
+    Notes: Only what is needed is read, so that a segment is translated
+	   as soon as it has arrived. To make room, the window is moved up
+	   to SEQ_STREAM_BACK BYTEs before the read position.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_stream_fill() */
+
+    SEQ_OFFSET keep;
+    LONG  drop;
+    LONG  want;
+    LONG  n;
+    INT   waited;
+
+    waited = 0;
+    while ((seq_stream.start + seq_stream.len < end) &&
+	   (seq_stream.eof == FALSE))
+    {
+	if (seq_stream.len == SEQ_STREAM_SIZE)
+	{
+	    keep = seq_stream.pos - SEQ_STREAM_BACK;
+	    if (keep > seq_stream.start + seq_stream.len)
+		keep = seq_stream.start + seq_stream.len;
+	    if (keep <= seq_stream.start)
+		return (FALSE);
+
+	    drop = (LONG)(keep - seq_stream.start);
+	    memmove((VOID *)seq_stream.bufP,
+		    (VOID *)(seq_stream.bufP + drop),
+		    (size_t)(seq_stream.len - drop));
+	    seq_stream.start += drop;
+	    seq_stream.len -= drop;
+	}
+
+	want = SEQ_STREAM_SIZE - seq_stream.len;
+	if (end - (seq_stream.start + seq_stream.len) < (SEQ_OFFSET)want)
+	    want = (LONG)(end - (seq_stream.start + seq_stream.len));
+
+	n = (LONG)fread((VOID *)(seq_stream.bufP + seq_stream.len),
+			    sizeof(BYTE), (size_t)want, seq_stream.fP);
+	seq_stream.len += n;
+	if (n > 0)
+	    waited = 0;
+	else if (waited < seq_stream.follow)
+	{
+	    /* acquire may still be writing the file */
+	    clearerr(seq_stream.fP);
+	    (VOID)sleep(1);
+	    waited++;
+	}
+	else
+	    seq_stream.eof = TRUE;
+    }
+
+    return (TRUE);
+}
@@ -14,6 +14,7 @@ Author: Gabriel Goodman		LeCroy Corporation
 #include <string.h>
 #include "seq_hdr.h"
 
+extern VOID SEQ_Exit();
 
 
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
@@ -39,7 +40,7 @@ INT	error_num;
 
     Machine dependencies: This is written for MSDOS
 
-    Notes:
+    Notes:   Ends the program, or the library call in hand (SEQ_Exit()).
 
     Procedure:
 
@@ -51,11 +52,11 @@ INT	error_num;
 	{
 		case OUT_OF_MEMORY:
 			printf("\nOut of memory\n");
-			exit(1);
+			SEQ_Exit();
 			break;
 		default:
 			printf("\nUnknown error\n");
-			exit(1);
+			SEQ_Exit();
 	}
 }
     
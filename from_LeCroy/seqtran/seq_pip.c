@@ -0,0 +1,656 @@
+/************************** seq_pip.c **************************************
+
+Reading, filtering and writing the data in a pipeline (-q).
+
+The translation loop of SEQ_Read_Segment_Number() does three things with
+every piece of a channel in turn: SEQ_Read_Piece() reads it from the data
+file, SEQ_Filter_Piece() filters and compensates it, and SEQ_Output_Seg()
+prints it (an fprintf() a point) or writes it to the trace file. While
+one of them runs the other two wait, so the filters stand still while the
+output is formatted and written.
+
+When compiled with SEQ_THREADS defined (POSIX threads and GCC) and run
+with -q, each of them is a stage of its own:
+
+	reader (main thread) --> filter thread --> writer thread
+	     ^                                          |
+	     +------------- free buffers ---------------+
+
+A piece is read into a buffer of a pool of SEQ_PIPE_BUFS, which holds
+everything the piece needs on its way (raw, corrected and compensated
+points, filter, descriptor), and the buffer itself is handed on; the
+points are never copied. The stages are joined by single producer,
+single consumer rings (SEQ_RING) without locks: only the producer moves
+the tail, only the consumer the head. A stage with nothing to take
+yields, and then sleeps a little at a time. There are as many places in
+a ring as buffers, so a ring is never full: a reader that gets ahead
+waits for a free buffer instead.
+
+The filter and the writer work in copies of the context of the main
+thread (SEQ_Context_Copy()), so that they have their own filter state
+and trace file numbering. The filter keeps the time of the points from
+a piece to the next, the reader the raw samples the filters need again.
+The main thread goes on to the next segment as soon as it has read a
+segment's pieces; SEQ_Pipe_Drain() waits for all pieces to come back
+before anything else is printed.
+
+At the end SEQ_Pipe_Stop() prints how many pieces were waiting on
+average in front of the filter and the writer, and how often each stage
+had to wait: a stage that is slower than the others has pieces queued in
+front of it, and the others wait for it.
+
+Not used with -d, -t, -r or -v, whose output comes from the main thread
+in between that of the segments, with -j (seq_job.c), nor with
+SEQ_Decode() (seq_lib.c). Without SEQ_THREADS every call does nothing.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "seq_filt.h"
+#include "seq_tran.h"
+
+#if defined(SEQ_THREADS) && defined(__GNUC__)
+#define SEQ_PIPE
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif /* SEQ_THREADS && __GNUC__ */
+
+/* -------------------------------------------------------------------- */
+
+extern BOOL   SEQ_Read_Piece();
+extern VOID   SEQ_Filter_Piece();
+extern VOID   SEQ_Output_Seg();
+extern VOID   SEQ_update_time();
+extern VOID   SEQ_Batch_Close();
+extern VOID   SEQ_fir_free();
+
+#ifdef SEQ_PIPE
+
+#define SEQ_PIPE_BUFS	16	/* pieces in the pipeline, a power of 2 */
+#define SEQ_PIPE_SPINS	64	/* yields before a wait sleeps */
+#define SEQ_PIPE_NSECS	50000L	/* and how long it then sleeps */
+
+/* A piece on its way through the pipeline */
+typedef struct SEQ_PIECE
+{
+    LONG  segno;
+    BYTE  status;			/* SEQ_FIRST_BLOCK, ... */
+    SEQ_ACQ_DATA    acq_data;
+    SEQ_FILTER_DATA filt_data;
+    FILTER          filter;		/* *filt_data.paramsP */
+    WAVE_PARAMS     wave;		/* *filt_data.waveP */
+    BYTE  desc[sizeof(PCW_Waveform[0][0])];	/* first piece, -oF */
+    BYTE  *rawP;			/* MAX_BUF_SIZE+MAX_FILTER_SIZE */
+    WORD  *corrP;			/* MAX_BUF_SIZE */
+    FLOAT *valuesP;			/* MAX_BUF_SIZE, or NULL */
+    DOUBLE *timesP;			/* MAX_BUF_SIZE, or NULL */
+} SEQ_PIECE;
+
+/* A queue from one stage to the next */
+typedef struct SEQ_RING
+{
+    SEQ_PIECE *pieceP[SEQ_PIPE_BUFS];
+    UINT  head;				/* next taken, by the consumer */
+    UINT  tail;				/* next put, by the producer */
+    LONG  puts;				/* pieces put, by the producer */
+    LONG  depth;			/* pieces found in it, added up */
+    LONG  waits;			/* takes that found it empty */
+} SEQ_RING;
+
+#endif /* SEQ_PIPE */
+
+/* State of the module in the current context (seq_ctx.c) */
+typedef struct SEQ_PIP_STATE
+{
+    INT   running;			/* 1 = started, -1 = failed */
+#ifdef SEQ_PIPE
+    SEQ_PIECE *pieceP[SEQ_PIPE_BUFS];	/* the pool */
+    SEQ_PIECE *spareP;			/* taken but not used */
+    SEQ_RING  free;			/* writer to reader */
+    SEQ_RING  filter;			/* reader to filter */
+    SEQ_RING  write;			/* filter to writer */
+    BYTE  tail[MAX_FILTER_SIZE];	/* last raw samples read */
+    SEQ_CONTEXT *filter_ctxP;
+    SEQ_CONTEXT *writer_ctxP;
+    pthread_t   filter_thread;
+    pthread_t   writer_thread;
+#endif /* SEQ_PIPE */
+} SEQ_PIP_STATE;
+
+#define seq_pipeP	SEQ_MODULE(SEQ_MOD_PIPE, SEQ_PIP_STATE)
+
+#ifdef SEQ_PIPE
+static BOOL      seq_pipe_start();
+static VOID      seq_pipe_free();
+static VOID      *seq_pipe_filter();
+static VOID      *seq_pipe_writer();
+static VOID      seq_pipe_wait();
+static VOID      seq_ring_put();
+static SEQ_PIECE *seq_ring_get();
+#endif /* SEQ_PIPE */
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Pipe_Submit(seq_fP, segno, acq_dataP, filt_dataP, total,
+							    keep_goingP)
+  FILE          *seq_fP;
+  LONG          segno;
+  SEQ_ACQ_DATA  *acq_dataP;
+  SEQ_FILTER_DATA *filt_dataP;
+  LONG          total;
+  BOOL          *keep_goingP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: The reader stage: read the pieces of a channel of a segment
+		and pass them to the filter thread.
+
+    Inputs: seq_fP     = FILE pointer to the opened data file
+	    segno      = segment number
+	    acq_dataP  = position and size of the first piece, as it would
+			 be passed to SEQ_Process_Seg()
+	    filt_dataP = as it would be passed to SEQ_Process_Seg(), with
+			 the descriptor and waveP set up for the segment
+	    total      = BYTEs of data in the channel
+
+    Outputs: TRUE if the channel has been read (as far as it could be)
+		and will be filtered and written out by the pipeline;
+		acq_dataP->block_offset is then where the reading ended,
+		and *keep_goingP is FALSE if a piece could not be read.
+	     FALSE if the caller has to translate it itself.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Pipe_Submit() */
+
+#ifdef SEQ_PIPE
+    SEQ_PIP_STATE *pipeP;
+    SEQ_PIECE     *pieceP;
+    SEQ_ACQ_DATA  acq_data;
+    SEQ_FILTER_DATA filt_data;
+    LONG  data_size;
+    LONG  keep;
+    BOOL  first_seg;
+    BYTE  status;
+
+    pipeP = seq_pipeP;
+    if ((SEQ_options.pipeline == FALSE) || (pipeP->running < 0) ||
+	(SEQ_options.debug != FALSE) || (SEQ_options.print_times == TRUE) ||
+	(SEQ_options.test_mode == TRUE) || (SEQ_options.resume == TRUE) ||
+	(SEQ_options.output.type == SEQ_OUTPUT_BUFFER) || (total <= 0))
+	return (FALSE);
+
+    if ((pipeP->running == 0) &&
+	(seq_pipe_start(pipeP, filt_dataP) == FALSE))
+    {
+	pipeP->running = -1;
+	return (FALSE);
+    }
+
+    acq_data = *acq_dataP;
+    filt_data = *filt_dataP;
+    first_seg = TRUE;
+    data_size = total;
+    while (data_size > 0)
+    {
+	/* A free buffer */
+	if ((pieceP = pipeP->spareP) == NULL)
+	    pieceP = seq_ring_get(&pipeP->free);
+	pipeP->spareP = NULL;
+
+	acq_data.baseP = pieceP->rawP;
+	acq_data.bufP = pieceP->rawP;
+	filt_data.rawP = pieceP->rawP;
+	filt_data.corrP = pieceP->corrP;
+	filt_data.valuesP = pieceP->valuesP;
+	filt_data.timesP = pieceP->timesP;
+	if (SEQ_Read_Piece(seq_fP, first_seg, &acq_data, &filt_data,
+							    TRUE) == FALSE)
+	{
+	    pipeP->spareP = pieceP;
+	    *keep_goingP = FALSE;
+	    break;
+	}
+
+	/* Put the raw samples of the last piece the filters need again
+	   in front of this one, and keep those of this one */
+	keep = (LONG)(acq_data.bufP - acq_data.baseP);
+	if (keep > 0)
+	    memcpy((VOID *)acq_data.baseP,
+		(VOID *)(pipeP->tail + MAX_FILTER_SIZE - keep), (size_t)keep);
+	if (acq_data.size >= MAX_FILTER_SIZE)
+	    memcpy((VOID *)pipeP->tail, (VOID *)(acq_data.bufP +
+		acq_data.size - MAX_FILTER_SIZE), (size_t)MAX_FILTER_SIZE);
+
+	/* Adjust data_size for amount just read */
+	data_size -= acq_data.size;
+
+	if (first_seg == FALSE)
+	{
+	    if (data_size == 0)
+		status = SEQ_LAST_BLOCK;
+	    else
+		status = SEQ_NEXT_BLOCK;
+	}
+	else
+	{
+	    status = SEQ_FIRST_BLOCK;
+	    if (data_size == 0)
+		status |= SEQ_LAST_BLOCK;
+	}
+
+	pieceP->segno = segno;
+	pieceP->status = status;
+	pieceP->acq_data = acq_data;
+	pieceP->filt_data = filt_data;
+	pieceP->filter = *filt_data.paramsP;
+	pieceP->wave = *filt_data.waveP;
+	pieceP->filt_data.paramsP = &pieceP->filter;
+	pieceP->filt_data.waveP = &pieceP->wave;
+	if ((first_seg == TRUE) &&
+	    (SEQ_options.output.type == SEQ_OUTPUT_FILE))
+	    memcpy((VOID *)pieceP->desc, (VOID *)PCW_Waveform
+		[acq_data.plugin][acq_data.channel], sizeof(pieceP->desc));
+	seq_ring_put(&pipeP->filter, pieceP);
+
+	first_seg = FALSE;
+
+	if (data_size < MAX_BUF_SIZE)
+	    acq_data.size = data_size;
+
+	SEQ_update_time(TRUE, total, data_size);
+    }
+    acq_dataP->block_offset = acq_data.block_offset;
+    acq_dataP->byte_offset = acq_data.byte_offset;
+    acq_dataP->bytes_read = acq_data.bytes_read;
+
+    return (TRUE);
+#else
+    return (FALSE);
+#endif /* SEQ_PIPE */
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Pipe_Drain()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Wait for every piece read to be filtered and written out.
+
+    Notes: Called by SEQ_Read_Segment_Number() before anything else is
+	   printed and when it is done.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Pipe_Drain() */
+
+#ifdef SEQ_PIPE
+    SEQ_PIP_STATE *pipeP;
+    UINT  back;
+    INT   spins;
+
+    if (SEQ_ctxP->moduleP[SEQ_MOD_PIPE] == NULL)
+	return;
+
+    pipeP = seq_pipeP;
+    if (pipeP->running <= 0)
+	return;
+
+    /* All buffers are back when the free ring has all but the spare */
+    back = (pipeP->spareP != NULL) ? 1 : 0;
+    spins = 0;
+    while (__atomic_load_n(&pipeP->free.tail, __ATOMIC_ACQUIRE) -
+			pipeP->free.head + back < (UINT)SEQ_PIPE_BUFS)
+	seq_pipe_wait(&spins);
+#endif /* SEQ_PIPE */
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Pipe_Stop()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Let the pipeline finish, stop its threads and print how full
+		its queues were.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Pipe_Stop() */
+
+#ifdef SEQ_PIPE
+    SEQ_PIP_STATE *pipeP;
+    LONG  pieces;
+
+    if (SEQ_ctxP->moduleP[SEQ_MOD_PIPE] == NULL)
+	return;
+
+    pipeP = seq_pipeP;
+    if (pipeP->running <= 0)
+	return;
+
+    /* A NULL piece tells the filter, and it the writer, to finish */
+    SEQ_Pipe_Drain();
+    seq_ring_put(&pipeP->filter, (SEQ_PIECE *)NULL);
+    pthread_join(pipeP->filter_thread, NULL);
+    pthread_join(pipeP->writer_thread, NULL);
+
+    /* A trace file left open by a segment that could not all be read */
+    if (pipeP->writer_ctxP->out_fP != NULL)
+	fclose(pipeP->writer_ctxP->out_fP);
+
+    pieces = pipeP->filter.puts - 1;
+    if (pieces > 0)
+	fprintf(stderr, "\nPipeline: %ld pieces, on average %.1f waiting \
+to be filtered and %.1f\nto be written (of %d); the reader waited for a \
+buffer for %ld%%, the filter\nfor a piece for %ld%% and the writer for \
+%ld%% of them\n", pieces,
+		(DOUBLE)pipeP->filter.depth / pieces,
+		(DOUBLE)pipeP->write.depth / pieces, SEQ_PIPE_BUFS,
+		(pipeP->free.waits * 100L) / pieces,
+		(pipeP->filter.waits * 100L) / pieces,
+		(pipeP->write.waits * 100L) / pieces);
+
+    seq_pipe_free(pipeP);
+    pipeP->running = 0;
+#endif /* SEQ_PIPE */
+}
+
+#ifdef SEQ_PIPE
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_pipe_start(pipeP, filt_dataP)
+  SEQ_PIP_STATE *pipeP;
+  SEQ_FILTER_DATA *filt_dataP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Make the buffers of the pipeline and start its threads.
+
+    Inputs: filt_dataP = as SEQ_Read_Segment_Number() set it up; a
+			 buffer has compensated points and their times
+			 if it has
+
+    Outputs: TRUE if the pipeline is running
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pipe_start() */
+
+    SEQ_PIECE *pieceP;
+    INT   n;
+
+    memset((VOID *)pipeP, 0, sizeof(SEQ_PIP_STATE));
+    for (n=0; n < SEQ_PIPE_BUFS; ++n)
+    {
+	pieceP = (SEQ_PIECE *)calloc((size_t)1, sizeof(SEQ_PIECE));
+	pipeP->pieceP[n] = pieceP;
+	if (pieceP == NULL)
+	    break;
+	pieceP->rawP = (BYTE *)malloc((size_t)(sizeof(BYTE) *
+				    (MAX_BUF_SIZE+MAX_FILTER_SIZE)));
+	pieceP->corrP = (WORD *)malloc((size_t)(sizeof(WORD) *
+							MAX_BUF_SIZE));
+	if (filt_dataP->valuesP != NULL)
+	    pieceP->valuesP = (FLOAT *)malloc((size_t)(sizeof(FLOAT) *
+							MAX_BUF_SIZE));
+	if (filt_dataP->timesP != NULL)
+	    pieceP->timesP = (DOUBLE *)malloc((size_t)(sizeof(DOUBLE) *
+							MAX_BUF_SIZE));
+	if ((pieceP->rawP == NULL) || (pieceP->corrP == NULL) ||
+	    ((filt_dataP->valuesP != NULL) && (pieceP->valuesP == NULL)) ||
+	    ((filt_dataP->timesP != NULL) && (pieceP->timesP == NULL)))
+	    break;
+
+	/* Every buffer starts out free */
+	pipeP->free.pieceP[n] = pieceP;
+    }
+    pipeP->free.tail = (UINT)n;
+
+    pipeP->filter_ctxP = SEQ_Context_Copy();
+    pipeP->writer_ctxP = SEQ_Context_Copy();
+    if ((n < SEQ_PIPE_BUFS) || (pipeP->filter_ctxP == NULL) ||
+	(pipeP->writer_ctxP == NULL))
+    {
+	seq_pipe_free(pipeP);
+	return (FALSE);
+    }
+
+    if (pthread_create(&pipeP->writer_thread, NULL, seq_pipe_writer,
+						    (VOID *)pipeP) != 0)
+    {
+	seq_pipe_free(pipeP);
+	return (FALSE);
+    }
+    if (pthread_create(&pipeP->filter_thread, NULL, seq_pipe_filter,
+						    (VOID *)pipeP) != 0)
+    {
+	/* The writer finishes on a NULL piece too */
+	seq_ring_put(&pipeP->write, (SEQ_PIECE *)NULL);
+	pthread_join(pipeP->writer_thread, NULL);
+	seq_pipe_free(pipeP);
+	return (FALSE);
+    }
+
+    pipeP->running = 1;
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_pipe_free(pipeP)
+  SEQ_PIP_STATE *pipeP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Release the buffers of the pipeline and the contexts of its
+		threads.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pipe_free() */
+
+    SEQ_PIECE *pieceP;
+    INT   n;
+
+    for (n=0; n < SEQ_PIPE_BUFS; ++n)
+    {
+	if ((pieceP = pipeP->pieceP[n]) == NULL)
+	    continue;
+	free(pieceP->rawP);
+	free(pieceP->corrP);
+	free(pieceP->valuesP);
+	free(pieceP->timesP);
+	free(pieceP);
+	pipeP->pieceP[n] = NULL;
+    }
+
+    SEQ_Context_Free(pipeP->filter_ctxP);
+    SEQ_Context_Free(pipeP->writer_ctxP);
+    pipeP->filter_ctxP = NULL;
+    pipeP->writer_ctxP = NULL;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID *seq_pipe_filter(argP)
+  VOID  *argP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: The filter stage: filter and compensate the pieces one after
+		the other and pass them on to the writer.
+
+    Inputs: argP = the pipeline
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pipe_filter() */
+
+    SEQ_PIP_STATE *pipeP;
+    SEQ_PIECE *pieceP;
+    DOUBLE time;
+    BOOL  first_seg;
+
+    pipeP = (SEQ_PIP_STATE *)argP;
+    SEQ_ctxP = pipeP->filter_ctxP;
+
+    time = 0.0;
+    while ((pieceP = seq_ring_get(&pipeP->filter)) != NULL)
+    {
+	first_seg = (pieceP->status & SEQ_FIRST_BLOCK) ? TRUE : FALSE;
+	if (first_seg == FALSE)
+	    pieceP->filt_data.time = time;
+	SEQ_Filter_Piece(&pieceP->acq_data, &pieceP->filt_data, first_seg);
+	time = pieceP->filt_data.time;
+
+	seq_ring_put(&pipeP->write, pieceP);
+    }
+    seq_ring_put(&pipeP->write, (SEQ_PIECE *)NULL);
+
+    SEQ_Batch_Close();
+    SEQ_fir_free();
+    return (NULL);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID *seq_pipe_writer(argP)
+  VOID  *argP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: The writer stage: print or write the pieces one after the
+		other and give their buffers back to the reader.
+
+    Inputs: argP = the pipeline
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pipe_writer() */
+
+    SEQ_PIP_STATE *pipeP;
+    SEQ_PIECE *pieceP;
+    SEQ_ACQ_DATA *acq_dataP;
+
+    pipeP = (SEQ_PIP_STATE *)argP;
+    SEQ_ctxP = pipeP->writer_ctxP;
+
+    while ((pieceP = seq_ring_get(&pipeP->write)) != NULL)
+    {
+	/* The descriptor SEQ_Init_Descriptor() made for the segment */
+	acq_dataP = &pieceP->acq_data;
+	if ((pieceP->status & SEQ_FIRST_BLOCK) &&
+	    (SEQ_options.output.type == SEQ_OUTPUT_FILE))
+	    memcpy((VOID *)PCW_Waveform[acq_dataP->plugin]
+		[acq_dataP->channel], (VOID *)pieceP->desc,
+						    sizeof(pieceP->desc));
+
+	SEQ_Output_Seg(pieceP->segno, pieceP->status, acq_dataP,
+				&pieceP->filt_data, &pieceP->wave);
+
+	/* Let a reader of the output see each segment as it arrives */
+	if ((pieceP->status & SEQ_LAST_BLOCK) &&
+	    (SEQ_options.stream == TRUE))
+	    fflush(stdout);
+
+	seq_ring_put(&pipeP->free, pieceP);
+    }
+
+    return (NULL);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_ring_put(ringP, pieceP)
+  SEQ_RING  *ringP;
+  SEQ_PIECE *pieceP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Put a piece (or NULL, to finish) into a ring, by the stage
+		before it.
+
+    Notes: Never waits: a ring has a place for every buffer there is.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_ring_put() */
+
+    UINT  tail;
+
+    tail = ringP->tail;
+    ringP->depth += (LONG)(tail -
+			__atomic_load_n(&ringP->head, __ATOMIC_ACQUIRE));
+    ++ringP->puts;
+
+    ringP->pieceP[tail % SEQ_PIPE_BUFS] = pieceP;
+    __atomic_store_n(&ringP->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_PIECE *seq_ring_get(ringP)
+  SEQ_RING  *ringP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Take the next piece out of a ring, by the stage after it,
+		waiting for one if it is empty.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_ring_get() */
+
+    SEQ_PIECE *pieceP;
+    UINT  head;
+    INT   spins;
+
+    head = ringP->head;
+    if (__atomic_load_n(&ringP->tail, __ATOMIC_ACQUIRE) == head)
+    {
+	++ringP->waits;
+	spins = 0;
+	while (__atomic_load_n(&ringP->tail, __ATOMIC_ACQUIRE) == head)
+	    seq_pipe_wait(&spins);
+    }
+
+    pieceP = ringP->pieceP[head % SEQ_PIPE_BUFS];
+    __atomic_store_n(&ringP->head, head + 1, __ATOMIC_RELEASE);
+    return (pieceP);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_pipe_wait(spinsP)
+  INT   *spinsP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Wait a little for another stage: give up the processor the
+		first SEQ_PIPE_SPINS times, then sleep.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pipe_wait() */
+
+    struct timespec delay;
+
+    if (++*spinsP <= SEQ_PIPE_SPINS)
+    {
+	sched_yield();
+	return;
+    }
+
+    delay.tv_sec = 0;
+    delay.tv_nsec = SEQ_PIPE_NSECS;
+    nanosleep(&delay, NULL);
+}
+
+#endif /* SEQ_PIPE */
@@ -0,0 +1,802 @@
+/************************** seq_shd.c **************************************
+
+Translation of one data file by several processes (-m).
+
+With -j the segments of a data file are filtered by several threads, but
+one process still reads all of it. With -mN the segments are split into
+N shards instead, and each shard is translated by a process of its own:
+seqtran started again with the same arguments and -n<shard> in place of
+-mN. The processes are started and waited for here, without any help from
+outside.
+
+The process given -mN opens the data file as usual, building the packet
+index and segment directory as -i does if there are none. A single
+process translates all the segments of plugin A, then all of plugin B;
+the segments in the directory, in that order, are cut into N runs of
+nearly the same number, one for each shard. A shard may so take the end
+of plugin A and the start of plugin B, and the shard with the end of a
+plugin also takes whatever follows the directory. A shard starts at the
+channel tag of a segment, the start of a block plus an offset into it.
+Into the directory <file>.shd go
+
+	plan		the first and last segment of each plugin of each
+			shard, 0 for the last of the plugin, -1 for a
+			plugin the shard has none of
+	<shard>.sck	the state the translation loop has at the start
+			of the shard, as a checkpoint (seq_ckp.c): the
+			block and the offset into it, the packet number
+			of the block, SEQ_params.last_packet, the time
+			stamp of segment 1, and how far SEQ_Check_Seg()
+			has got through the selections
+
+How far SEQ_Check_Seg() has got is found by taking it through the
+segments before the shard, with their times from the segment directory.
+The filters start afresh with each segment, so there is no filter
+history to pass on.
+
+A shard's process carries on from its .sck as -r would (and so, like -r,
+without the threads of -j or -q), and stops after the last segment of its
+shard. Its screen output goes to <shard>.out, its messages to <shard>.err,
+its trace files, numbered from 000, to the directory <shard>, and the
+channels of segments and the samples it translated and the seconds it
+took to <shard>.sta.
+
+When all have finished, their output is put together in the order of the
+shards: the .out files to stdout, the .err files to stderr, and the trace
+files renamed to the numbers a single process gives them, those of a
+channel in one shard following on from those in the shards before. The
+output is then the same as without -m. The totals of the .sta files are
+printed to stderr and the directory is removed. If a process fails, the
+output of the shards up to its own is put together, as a single process
+would have stopped there, and the program ends with an error.
+
+Descriptors (-a) and filter coefficients (-p) are printed by the process
+given -mN. Not with -d, -v, -r or -w, nor for a data file without a
+segment directory or with fewer than two segments: these are
+translated by one process as before. Under DOS, which has no fork(), the
+processes are run one after the other.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <time.h>
+#include "seq_tran.h"
+
+#if defined(MSDOS) || defined(__WATCOMC__) || defined(__TURBOC__)
+#include <process.h>		/* spawnvp() */
+#include <direct.h>		/* mkdir(), rmdir() */
+#define SEQ_MKDIR(nameP)	mkdir(nameP)
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>		/* fork(), execvp(), rmdir() */
+#define SEQ_MKDIR(nameP)	mkdir(nameP, 0777)
+#define SEQ_SHARD_FORK
+#endif
+
+/* -------------------------------------------------------------------- */
+
+extern LONG   SEQ_Dir_Count();
+extern DOUBLE SEQ_Dir_Stamp();
+extern BOOL   SEQ_Check_Seg();
+extern BOOL   SEQ_Ckpt_Seed();
+extern VOID   SEQ_Sidecar_Name();
+
+#define SEQ_SHARD_EXT	".shd"		/* directory of the shards */
+#define SEQ_SHARD_PLAN	"/plan"		/* where each shard starts, ends */
+
+/* A shard, as the process given -mN keeps it */
+typedef struct SEQ_SHARD
+{
+    LONG  first[MAX_PLUGINS];		/* first segment of each plugin */
+    LONG  last[MAX_PLUGINS];		/* its last, 0 = to the end,
+					   -1 = none of the plugin */
+    INT   status;			/* of its process, 0 = done */
+#ifdef SEQ_SHARD_FORK
+    pid_t pid;
+#endif /* SEQ_SHARD_FORK */
+} SEQ_SHARD;
+
+/* State of the module in the current context: in a shard's process,
+   when the shard was started */
+typedef struct SEQ_SHARD_STATE
+{
+    DOUBLE start;
+} SEQ_SHARD_STATE;
+
+#define seq_shd_start	(SEQ_MODULE(SEQ_MOD_SHARD, SEQ_SHARD_STATE)->start)
+
+VOID          SEQ_Shard_Name();
+static BOOL   seq_shd_plan();
+static VOID   seq_shd_launch();
+static BOOL   seq_shd_merge();
+static BOOL   seq_shd_copy();
+static VOID   seq_shd_remove();
+static DOUBLE seq_shd_clock();
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Shard_Run(ac, av, seq_filenameP)
+  int   ac;
+  char  *av[];
+  CHAR  *seq_filenameP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Have the segments of the data file of the current context
+		translated by -mN processes, one shard each.
+
+    Inputs: ac, av        = the arguments of the program
+	    seq_filenameP = name of the data file, open (SEQ_Start())
+
+    Outputs: TRUE if the shards were translated and put together
+	     FALSE if the data file is to be translated as usual
+
+    Notes: If a process fails, the output of the shards up to its own
+	   is put together and the program ends (SEQ_Exit()), as a single
+	   process would have ended there.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Shard_Run() */
+
+    SEQ_SHARD *shardP;
+    CHAR  **argvP;
+    CHAR  dir_name[96];
+    CHAR  shard_arg[16];
+    DOUBLE start;
+    INT   shards;
+    INT   failed;
+    INT   argc;
+    INT   i, k;
+    LONG  n, total;
+    BYTE  p;
+
+    if ((SEQ_options.shards <= 1) || (SEQ_options.shard >= 0) ||
+	(SEQ_options.debug != FALSE) || (SEQ_options.test_mode == TRUE) ||
+	(SEQ_options.resume == TRUE) || (SEQ_options.stream == TRUE))
+	return (FALSE);
+
+    /* Every shard needs a segment */
+    total = 0L;
+    for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+    {
+	if ((n = SEQ_Dir_Count((INT)p)) < 0L)
+	    return (FALSE);
+	total += n;
+    }
+    shards = SEQ_options.shards;
+    if (total < (LONG)shards)
+	shards = (INT)total;
+    if (shards < 2)
+	return (FALSE);
+
+    shardP = (SEQ_SHARD *)calloc((size_t)shards, sizeof(SEQ_SHARD));
+    if (shardP == NULL)
+	error_handler(OUT_OF_MEMORY);
+
+    SEQ_Shard_Name(seq_filenameP, -1, "", dir_name, (INT)sizeof(dir_name));
+    (VOID)SEQ_MKDIR(dir_name);
+    if (seq_shd_plan(seq_filenameP, shardP, shards) == FALSE)
+    {
+	printf("Could not write the shards into %s\n", dir_name);
+	free(shardP);
+	EXIT
+    }
+
+    /* The arguments given, with -n<shard> in place of -mN */
+    argvP = (CHAR **)malloc((size_t)(ac + 2) * sizeof(CHAR *));
+    if (argvP == NULL)
+	error_handler(OUT_OF_MEMORY);
+    argc = 0;
+    for (i=0; i < ac; ++i)
+    {
+	if ((i > 0) && !strncmp(av[i], "-m", 2))
+	{
+	    if ((av[i][2] == EOS) && ((i+1) < ac))
+		++i;
+	    continue;
+	}
+	argvP[argc++] = av[i];
+    }
+    argvP[argc + 1] = NULL;
+
+    start = seq_shd_clock();
+    for (k=0; k < shards; ++k)
+    {
+	sprintf(shard_arg, "-n%d", k);
+	argvP[argc] = shard_arg;
+	seq_shd_launch(seq_filenameP, argvP, k, &shardP[k]);
+    }
+
+#ifdef SEQ_SHARD_FORK
+    for (k=0; k < shards; ++k)
+    {
+	if (shardP[k].pid <= 0)
+	    continue;
+	if (waitpid(shardP[k].pid, &i, 0) != shardP[k].pid)
+	    shardP[k].status = -1;
+	else if (WIFEXITED(i))
+	    shardP[k].status = WEXITSTATUS(i);
+	else
+	    shardP[k].status = -1;
+    }
+#endif /* SEQ_SHARD_FORK */
+
+    /* One process would have stopped at the first shard that failed */
+    for (failed=0; (failed < shards) && (shardP[failed].status == 0);
+								++failed)
+	;
+
+    if (seq_shd_merge(seq_filenameP, shardP, (failed < shards) ?
+				failed + 1 : shards, start) == FALSE)
+    {
+	fprintf(stderr, "The shards are left in %s\n", dir_name);
+	failed = 0;
+    }
+    else
+	seq_shd_remove(seq_filenameP, shards);
+    free(argvP);
+    free(shardP);
+
+    if (failed < shards)
+	EXIT
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Shard_Open(seq_filenameP)
+  CHAR  *seq_filenameP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Make the current context translate the shard given with -n,
+		into the files of the shard.
+
+    Inputs: seq_filenameP = name of the data file
+
+    Notes: Called before SEQ_Start(), which then starts the translation
+	   from the shard's .sck (seq_ckp.c). Does nothing without -n.
+	   The shard must be in the plan made by -mN.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Shard_Open() */
+
+    FILE  *plan_fP;
+    CHAR  name[128];
+    CHAR  line[80];
+    CHAR  last[16];
+    CHAR  plugin;
+    BOOL  found;
+    INT   k;
+    BYTE  p,c;
+
+    if (SEQ_options.shard < 0)
+	return;
+
+    SEQ_Shard_Name(seq_filenameP, -1, SEQ_SHARD_PLAN, name,
+						    (INT)sizeof(name));
+    if ((plan_fP = fopen(name, "r")) == NULL)
+    {
+	printf("Could not open %s\n", name);
+	EXIT
+    }
+
+    found = FALSE;
+    while (fgets(line, (int)sizeof(line), plan_fP) != NULL)
+    {
+	if ((sscanf(line, "%d %c %*s %15s", &k, &plugin, last) != 3) ||
+	    (k != SEQ_options.shard) || (plugin < 'A') ||
+	    (plugin >= 'A' + MAX_PLUGINS))
+	    continue;
+
+	SEQ_ctxP->shard_end[plugin - 'A'] = atol(last);
+	found = TRUE;
+    }
+    fclose(plan_fP);
+
+    if (found == FALSE)
+    {
+	printf("No shard %d in %s\n", SEQ_options.shard, name);
+	EXIT
+    }
+
+    /* The output of the shard, for the process given -mN to put
+       together with that of the others */
+    SEQ_Shard_Name(seq_filenameP, SEQ_options.shard, ".out", name,
+						    (INT)sizeof(name));
+    if (freopen(name, "w", stdout) == NULL)
+	EXIT
+    SEQ_Shard_Name(seq_filenameP, SEQ_options.shard, ".err", name,
+						    (INT)sizeof(name));
+    if (freopen(name, "w", stderr) == NULL)
+	EXIT
+    SEQ_Shard_Name(seq_filenameP, SEQ_options.shard, "",
+		SEQ_ctxP->out_dir, (INT)sizeof(SEQ_ctxP->out_dir));
+
+    /* Carry on from the seed; the process given -mN printed these */
+    SEQ_options.resume = TRUE;
+    SEQ_options.print_coeffs = FALSE;
+    for (p=0; p < MAX_PLUGINS; ++p)
+	for (c=0; c < MAX_CHANNELS; ++c)
+	    SEQ_options.print_params[p][c] = FALSE;
+
+    seq_shd_start = seq_shd_clock();
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Shard_Close(seq_filenameP)
+  CHAR  *seq_filenameP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Record what the shard given with -n translated, in its .sta
+		file.
+
+    Notes: Does nothing without -n. The process given -mN takes a shard
+	   without its .sta file for one that failed.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Shard_Close() */
+
+    FILE  *sta_fP;
+    CHAR  name[128];
+    BOOL  ok;
+
+    if (SEQ_options.shard < 0)
+	return;
+
+    SEQ_Shard_Name(seq_filenameP, SEQ_options.shard, ".sta", name,
+						    (INT)sizeof(name));
+    if ((sta_fP = fopen(name, "w")) == NULL)
+    {
+	fprintf(stderr, "Could not create %s\n", name);
+	EXIT
+    }
+
+    fprintf(sta_fP, "%ld %.0f %.3f\n", SEQ_ctxP->segs_done,
+	    SEQ_ctxP->samples_done, seq_shd_clock() - seq_shd_start);
+    ok = (fclose(sta_fP) == 0) && (fflush(stdout) == 0);
+    if (ok == FALSE)
+    {
+	fprintf(stderr, "Could not write %s\n", name);
+	remove(name);
+	EXIT
+    }
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Shard_Name(seq_filenameP, shard, extP, nameP, max)
+  CHAR  *seq_filenameP;
+  INT   shard;
+  CHAR  *extP;
+  CHAR  *nameP;
+  INT   max;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Build the name of a file of the shards of a data file.
+
+    Inputs: seq_filenameP = name of the data file
+	    shard         = the shard, -1 for the directory itself
+	    extP          = what follows: an extension, a name starting
+			    with '/', or ""
+	    nameP         = buffer of max CHARs for the result
+
+    Outputs: nameP = <file>.shd[/<shard>]<extP>
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Shard_Name() */
+
+    CHAR  tail[32];
+
+    if (shard >= 0)
+	sprintf(tail, "/%d", shard);
+    else
+	tail[0] = EOS;
+    strncat(tail, extP, sizeof(tail) - strlen(tail) - 1);
+
+    SEQ_Sidecar_Name(seq_filenameP, SEQ_SHARD_EXT, nameP,
+					max - (INT)strlen(tail));
+    strcat(nameP, tail);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_shd_plan(seq_filenameP, shardP, shards)
+  CHAR  *seq_filenameP;
+  SEQ_SHARD shardP[];
+  INT   shards;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Cut the segments into shards and write the plan and the
+		.sck file of each shard.
+
+    Outputs: TRUE if they were written
+
+    Notes: Takes SEQ_Check_Seg() of the current context through the
+	   segments before each shard; nothing is translated in it
+	   afterwards.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_shd_plan() */
+
+    FILE  *plan_fP;
+    CHAR  name[128];
+    LONG  segno[MAX_PLUGINS];
+    LONG  seg[MAX_PLUGINS];
+    LONG  n, total, from, to;
+    DOUBLE first_time;
+    BOOL  keep_going;
+    BOOL  ok;
+    INT   k;
+    BYTE  p,c;
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	seg[p] = 1L;
+	for (k=0; k < shards; ++k)
+	{
+	    shardP[k].first[p] = 0L;
+	    shardP[k].last[p] = -1L;
+	}
+    }
+
+    /* Runs of nearly the same number of segments, those of plugin A
+       followed by those of plugin B as one process translates them */
+    total = 0L;
+    for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+	total += SEQ_Dir_Count((INT)p);
+    for (k=0; k < shards; ++k)
+    {
+	from = (total / shards) * k + ((total % shards) * k) / shards;
+	to = (total / shards) * (k+1) + ((total % shards) * (k+1)) / shards;
+	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+	{
+	    n = SEQ_Dir_Count((INT)p);
+	    if ((from < n) && (to > 0L))
+	    {
+		shardP[k].first[p] = (from > 0L) ? from + 1L : 1L;
+		shardP[k].last[p] = (to < n) ? to : 0L;
+	    }
+	    from -= n;
+	    to -= n;
+	}
+    }
+
+    ok = TRUE;
+    for (k=1; (k < shards) && (ok == TRUE); ++k)
+    {
+	/* Where SEQ_Check_Seg() is in the selections at the shard */
+	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+	{
+	    segno[p] = 1L;
+	    if (shardP[k].first[p] <= 1L)
+		continue;
+	    first_time = SEQ_Dir_Stamp((INT)p, 1L);
+	    for (; seg[p] < shardP[k].first[p]; ++seg[p])
+		for (c=0; c <= SEQ_params.last_channel[p]; ++c)
+		    (VOID)SEQ_Check_Seg(p, c, seg[p],
+			    SEQ_Dir_Stamp((INT)p, seg[p]) - first_time,
+			    &keep_going);
+	    segno[p] = shardP[k].first[p];
+	}
+
+	SEQ_Shard_Name(seq_filenameP, k, ".sck", name, (INT)sizeof(name));
+	ok = SEQ_Ckpt_Seed(SEQ_ctxP->seq_fP, name, segno);
+    }
+
+    SEQ_Shard_Name(seq_filenameP, -1, SEQ_SHARD_PLAN, name,
+						    (INT)sizeof(name));
+    if ((ok == FALSE) || ((plan_fP = fopen(name, "w")) == NULL))
+	return (FALSE);
+
+    for (k=0; k < shards; ++k)
+	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+	    fprintf(plan_fP, "%d %c %ld %ld\n", k, p+'A',
+				shardP[k].first[p], shardP[k].last[p]);
+
+    return (fclose(plan_fP) == 0);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_shd_launch(seq_filenameP, argvP, shard, shardP)
+  CHAR  *seq_filenameP;
+  CHAR  *argvP[];
+  INT   shard;
+  SEQ_SHARD *shardP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Start the process of a shard.
+
+    Inputs: argvP = its arguments, ending in -n<shard> and NULL
+
+    Outputs: shardP->pid, or shardP->status if it could not be started
+		(or, under DOS, once it has finished)
+
+    Notes: The directory for its trace files is made first. The banner
+	   the process prints before it knows it is a shard goes into
+	   its .err file, which it then starts over.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_shd_launch() */
+
+    CHAR  name[128];
+
+    if (SEQ_options.output.type == SEQ_OUTPUT_FILE)
+    {
+	SEQ_Shard_Name(seq_filenameP, shard, "", name, (INT)sizeof(name));
+	(VOID)SEQ_MKDIR(name);
+    }
+    SEQ_Shard_Name(seq_filenameP, shard, ".err", name, (INT)sizeof(name));
+
+    fflush(stdout);
+    fflush(stderr);
+
+#ifdef SEQ_SHARD_FORK
+    shardP->status = 0;
+    shardP->pid = fork();
+    if (shardP->pid == 0)
+    {
+	(VOID)freopen(name, "w", stderr);
+	execvp(argvP[0], argvP);
+	fprintf(stderr, "Could not run %s\n", argvP[0]);
+	_exit(127);
+    }
+    if (shardP->pid < 0)
+	shardP->status = -1;
+#else
+    shardP->status = spawnvp(P_WAIT, argvP[0], argvP);
+#endif /* SEQ_SHARD_FORK */
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_shd_merge(seq_filenameP, shardP, shards, start)
+  CHAR  *seq_filenameP;
+  SEQ_SHARD shardP[];
+  INT   shards;
+  DOUBLE start;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Put the output of the first shards together, in their
+		order, and print their totals if they all finished.
+
+    Inputs: shards = how many to put together; only the last may have
+			failed
+	    start  = seq_shd_clock() when the processes were started
+
+    Outputs: TRUE if all of it was there
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_shd_merge() */
+
+    FILE  *fP;
+    CHAR  from[128];
+    CHAR  to[sizeof(SEQ_ctxP->out_dir) + 32];
+    WORD  next[MAX_PLUGINS][MAX_CHANNELS];
+    DOUBLE sta[3];
+    DOUBLE samples, slowest, fastest, secs;
+    LONG  segs;
+    WORD  j;
+    BOOL  ok;
+    INT   k;
+    BYTE  p,c;
+
+    for (p=0; p < MAX_PLUGINS; ++p)
+	for (c=0; c < MAX_CHANNELS; ++c)
+	    next[p][c] = 0;
+
+    segs = 0L;
+    samples = slowest = (DOUBLE)0;
+    fastest = (DOUBLE)-1;
+    ok = TRUE;
+    for (k=0; (k < shards) && (ok == TRUE); ++k)
+    {
+	/* What the process translated */
+	SEQ_Shard_Name(seq_filenameP, k, ".sta", from, (INT)sizeof(from));
+	if (shardP[k].status != 0)
+	    ;
+	else if (((fP = fopen(from, "r")) == NULL) ||
+	    (fscanf(fP, "%lf %lf %lf", &sta[0], &sta[1], &sta[2]) != 3))
+	{
+	    fprintf(stderr, "Shard %d did not finish\n", k);
+	    if (fP != NULL)
+		fclose(fP);
+	    return (FALSE);
+	}
+	else
+	{
+	    fclose(fP);
+	    segs += (LONG)sta[0];
+	    samples += sta[1];
+	    if (sta[2] > slowest)
+		slowest = sta[2];
+	    if ((fastest < (DOUBLE)0) || (sta[2] < fastest))
+		fastest = sta[2];
+	}
+
+	/* Its output; one that failed may not have got to all of it */
+	SEQ_Shard_Name(seq_filenameP, k, ".out", from, (INT)sizeof(from));
+	ok = seq_shd_copy(from, stdout, (shardP[k].status == 0));
+	SEQ_Shard_Name(seq_filenameP, k, ".err", from, (INT)sizeof(from));
+	if (ok == TRUE)
+	    ok = seq_shd_copy(from, stderr, (shardP[k].status == 0));
+	if (shardP[k].status < 0)
+	    fprintf(stderr, "Shard %d did not finish\n", k);
+
+	/* The trace files, numbered on from the shards before */
+	for (p=0; (p < MAX_PLUGINS) && (ok == TRUE); ++p)
+	{
+	    for (c=0; (c < MAX_CHANNELS) && (ok == TRUE); ++c)
+	    {
+		for (j=0; ; ++j)
+		{
+		    SEQ_Shard_Name(seq_filenameP, k, "", from,
+						(INT)sizeof(from));
+		    sprintf(from + strlen(from), "/trace_%c%d.%03d",
+							p+'a', c+1, j);
+		    if ((fP = fopen(from, "rb")) == NULL)
+			break;
+		    fclose(fP);
+
+		    sprintf(to, "%s%strace_%c%d.%03d", SEQ_ctxP->out_dir,
+			    (SEQ_ctxP->out_dir[0] != EOS) ? "/" : "",
+			    p+'a', c+1, next[p][c]);
+		    remove(to);
+		    if (rename(from, to) != 0)
+		    {
+			fprintf(stderr, "Could not rename %s to %s\n",
+								from, to);
+			ok = FALSE;
+			break;
+		    }
+		    ++next[p][c];
+		}
+	    }
+	}
+    }
+    fflush(stdout);
+
+    if ((ok == FALSE) || (shardP[shards-1].status != 0))
+	return (ok);
+
+    secs = seq_shd_clock() - start;
+    fprintf(stderr, "\nShards: %d processes, %ld segments, %.1f MB of \
+samples in %.2f s", shards, segs, samples / (1024.0 * 1024.0), secs);
+    if (secs > (DOUBLE)0)
+	fprintf(stderr, ", %.1f MB/s", samples / (1024.0 * 1024.0) / secs);
+    fprintf(stderr, "\n(each shard took %.2f to %.2f s)\n", fastest,
+								slowest);
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_shd_copy(nameP, out_fP, needed)
+  CHAR  *nameP;
+  FILE  *out_fP;
+  BOOL  needed;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Copy a file of a shard to stdout or stderr.
+
+    Inputs: needed = FALSE if the file may not be there
+
+    Outputs: TRUE if it was all copied
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_shd_copy() */
+
+    FILE  *in_fP;
+    CHAR  buf[4096];
+    size_t n;
+    BOOL  ok;
+
+    if ((in_fP = fopen(nameP, "rb")) == NULL)
+    {
+	if (needed == FALSE)
+	    return (TRUE);
+	fprintf(stderr, "Could not open %s\n", nameP);
+	return (FALSE);
+    }
+
+    ok = TRUE;
+    while ((n = fread(buf, 1, sizeof(buf), in_fP)) > 0)
+    {
+	if (fwrite(buf, 1, n, out_fP) != n)
+	{
+	    ok = FALSE;
+	    break;
+	}
+    }
+    if (ferror(in_fP))
+	ok = FALSE;
+    fclose(in_fP);
+
+    return (ok);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_shd_remove(seq_filenameP, shards)
+  CHAR  *seq_filenameP;
+  INT   shards;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Remove the files of the shards, once put together, and
+		their directory.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_shd_remove() */
+
+    static CHAR *extP[] = { ".out", ".err", ".sta", ".sck", "" };
+    CHAR  name[128];
+    INT   k;
+    WORD  e;
+
+    for (k=0; k < shards; ++k)
+    {
+	for (e=0; extP[e][0] != EOS; ++e)
+	{
+	    SEQ_Shard_Name(seq_filenameP, k, extP[e], name,
+						    (INT)sizeof(name));
+	    remove(name);
+	}
+	SEQ_Shard_Name(seq_filenameP, k, "", name, (INT)sizeof(name));
+	(VOID)rmdir(name);
+    }
+
+    SEQ_Shard_Name(seq_filenameP, -1, SEQ_SHARD_PLAN, name,
+						    (INT)sizeof(name));
+    remove(name);
+    SEQ_Shard_Name(seq_filenameP, -1, "", name, (INT)sizeof(name));
+    (VOID)rmdir(name);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static DOUBLE seq_shd_clock()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Time on the wall clock, for the rate of the translation.
+
+    Outputs: seconds, to a fraction of one under POSIX, else whole ones
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_shd_clock() */
+
+#ifdef SEQ_SHARD_FORK
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((DOUBLE)now.tv_sec + (DOUBLE)now.tv_nsec / 1.0e9);
+#else
+    return ((DOUBLE)time(NULL));
+#endif /* SEQ_SHARD_FORK */
+}
@@ -0,0 +1,988 @@
+/************************** seq_test.c *************************************
+
+Checks and times the correction filters (seqtest.exe).
+
+Every faster way of filtering added to seq_filt.c and seq_vec.c claims to
+give the points of the original loops bit for bit. This program holds
+them to it before they are let loose on data anyone publishes: it makes
+up raw samples and coefficients for every sampling rate (1, 2, 4 flashes
+and 8 flashes + 7291) and number of taps, with every last_flash, and
+filters each segment with each engine in turn:
+
+	original  the loops of SEQ_fir() and SEQ_fir_7291() (-k scalar)
+	unrolled  the specialized kernels of seq_filt.c
+	lut       the lookup table kernels of seq_filt.c
+	sse4.1,   the vector kernels of seq_vec.c, as many of them as were
+	avx2,	  compiled and the processor has
+	avx512
+
+The segment is fed to SEQ_fir() a block at a time exactly as
+SEQ_Process_Seg() does it, the last raw samples of a block carried over
+to the start of the next, so the history SEQ_fir() keeps between blocks
+is checked along with the filters. The blocks are MAX_BUF_SIZE samples
+like the real ones, or shorter to cross more boundaries. The points of
+each block are put in volts with SEQ_Compensate() as well. Everything is
+compared with test_reference(), a copy of the original loops run over the
+whole segment at once. The short segment batches of SEQ_Vec_Fir_Batch()
+are checked the same way.
+
+Some of the coefficients and samples are the kind the 7200A produces,
+some are anything at all, to get the overflow, underflow and saturation
+limits into the comparison, and 7291 sums too large for the 32 bits of
+the vector kernels (seq_vec.c leaves those to the scalar loop).
+
+With -b each engine is then timed on each sampling rate and the raw
+samples filtered per second printed.
+
+	seqtest [-s seed] [-n segments] [-b]
+
+The exit status is 1 if any point differs.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <time.h>
+#include "seq_filt.h"
+#include "seq_tran.h"
+
+/* -------------------------------------------------------------------- */
+
+extern VOID   SEQ_fir();
+extern VOID   SEQ_fir_engine();
+extern BYTE   *SEQ_fir_index();
+extern VOID   SEQ_Compensate();
+extern INT    SEQ_Vec_Init();
+extern LONG   SEQ_Vec_Fir_Batch();
+
+/* The limits of the original loops, as in seq_filt.c */
+#define CA_OVERFLOW  ((long) 2080768)        /*  0x7f00 <<  6 */
+#define CA_UNDERFLOW ((long)-2097152)        /* -0x8000 <<  6 */
+
+#define POS_SATURATION ((long) 2097088)      /*  0x7fff <<  6 */
+
+#define CA1_OVERFLOW  ((long) 532676608)     /*  0x7f00 << 14 */
+#define CA1_UNDERFLOW ((long)-536870912)     /* -0x8000 << 14 */
+
+#define OVERFLOW    0x7f00
+#define UNDERFLOW   0x8000
+#define SATURATION  0x7fff
+
+/* The engines checked, as -k and SEQ_fir_engine() pick them */
+static struct
+{
+    CHAR  *nameP;
+    INT   options;		/* SEQ_options.kernels */
+    INT   level;		/* SEQ_Vec_Init() */
+    INT   engine;		/* SEQ_fir_engine() */
+} test_engines[] =
+{
+    "original", SEQ_KERNEL_SCALAR, SEQ_KERNEL_SCALAR, FIR_ENGINE_MULTIPLY,
+    "unrolled", SEQ_KERNEL_AUTO,   SEQ_KERNEL_SCALAR, FIR_ENGINE_MULTIPLY,
+    "lut",      SEQ_KERNEL_AUTO,   SEQ_KERNEL_SCALAR, FIR_ENGINE_LUT,
+    "sse4.1",   SEQ_KERNEL_AUTO,   SEQ_KERNEL_SSE41,  FIR_ENGINE_MULTIPLY,
+    "avx2",     SEQ_KERNEL_AUTO,   SEQ_KERNEL_AVX2,   FIR_ENGINE_MULTIPLY,
+    "avx512",   SEQ_KERNEL_AUTO,   SEQ_KERNEL_AVX512, FIR_ENGINE_MULTIPLY,
+    NULL,       0,                 0,                 0
+};
+
+/* Sampling rates (num_filters as read with the coefficients, 9 = 2 GSa/s
+   with the 7291 filter) and taps; the ones the 7200A uses are timed */
+static struct
+{
+    WORD  num_filters;
+    WORD  num_coeffs;
+    BOOL  timed;
+} test_modes[] =
+{
+    1,  2, TRUE,	1,  7, FALSE,	1, 13, FALSE,
+    2,  2, FALSE,	2,  7, TRUE,	2, 13, FALSE,
+    4,  2, FALSE,	4,  7, FALSE,	4, 13, TRUE,
+    9,  2, FALSE,	9,  7, FALSE,	9, 13, TRUE,
+    0,  0, FALSE
+};
+
+#define TEST_SEGMENT	(3L * MAX_BUF_SIZE)	/* longest segment */
+#define TEST_BENCH	(16L * MAX_BUF_SIZE)	/* segment timed */
+#define TEST_ERRORS	10			/* differences printed */
+
+static ULONG  test_seed = 1;
+static LONG   test_errors = 0;
+
+/* Segment, its points filtered a block at a time and at once, and the
+   same in volts and with their times */
+static BYTE   *test_rawP;
+static WORD   *test_outP;
+static WORD   *test_refP;
+static FLOAT  *test_valuesP;
+static DOUBLE *test_values64P;
+static DOUBLE *test_timesP;
+static WORD   *test_flashP;		/* the flash filtered points */
+
+/* A block as SEQ_Process_Seg() has it */
+static BYTE   *test_blockP;
+static WORD   *test_corrP;
+static FLOAT  *test_bvaluesP;
+static DOUBLE *test_bvalues64P;
+static DOUBLE *test_btimesP;
+
+static ULONG  test_random();
+static VOID   test_coeffs();
+static VOID   test_raw();
+static LONG   test_reference();
+static LONG   test_blocks();
+static VOID   test_differ();
+static VOID   test_filters();
+static VOID   test_batch();
+static VOID   test_bench();
+static VOID   test_bench_batch();
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID main(ac, av)
+    int ac;
+    char *av[];
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Checks every filter engine the processor has against the
+		original loops, then times them if asked to.
+
+    Inputs: ac = number of arguments (switches)
+	    av = -s seed of the made up data (1)
+		 -n segments of each sampling rate and taps per engine (40)
+		 -b to time the engines as well
+
+    Outputs: exits with 1 if any engine got any point different
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* main() */
+
+    CHAR  *argP;
+    CHAR  label[16];
+    LONG  segments;
+    INT   levels;
+    INT   e;
+    INT   i;
+    BOOL  bench;
+
+    /* The filters work in a context (seq_ctx.c) like the translator's */
+    if ((SEQ_ctxP = SEQ_Context_New()) == NULL)
+    {
+	printf("Out of memory\n");
+	exit(1);
+    }
+
+    segments = 40;
+    bench = FALSE;
+    for (i=1; i < ac; ++i)
+    {
+	argP = &av[i][2];
+	if (!strcmp(av[i], "-b"))
+	    bench = TRUE;
+	else if (!strncmp(av[i], "-s", 2) || !strncmp(av[i], "-n", 2))
+	{
+	    if ((*argP == EOS) && ((i+1) < ac))
+		argP = av[i+1];
+	    if (av[i][1] == 's')
+		test_seed = (ULONG)atol(argP);
+	    else
+		segments = atol(argP);
+	    if (argP == av[i+1])
+		++i;
+	}
+	else
+	{
+	    printf("Usage: seqtest [-s seed] [-n segments] [-b]\n");
+	    EXIT
+	}
+    }
+
+    test_rawP = (BYTE *)malloc((size_t)TEST_BENCH);
+    test_outP = (WORD *)malloc((size_t)(sizeof(WORD) * TEST_BENCH));
+    test_refP = (WORD *)malloc((size_t)(sizeof(WORD) * TEST_BENCH));
+    test_valuesP = (FLOAT *)malloc((size_t)(sizeof(FLOAT) * TEST_SEGMENT));
+    test_values64P = (DOUBLE *)malloc((size_t)(sizeof(DOUBLE) *
+							    TEST_SEGMENT));
+    test_timesP = (DOUBLE *)malloc((size_t)(sizeof(DOUBLE) * TEST_SEGMENT));
+    test_flashP = (WORD *)malloc((size_t)(sizeof(WORD) * TEST_SEGMENT));
+    test_blockP = (BYTE *)malloc((size_t)(MAX_BUF_SIZE + 2*13));
+    test_corrP = (WORD *)malloc((size_t)(sizeof(WORD) *
+					    (MAX_BUF_SIZE + MAX_91_COEFFS)));
+    test_bvaluesP = (FLOAT *)malloc((size_t)(sizeof(FLOAT) *
+					    (MAX_BUF_SIZE + MAX_91_COEFFS)));
+    test_bvalues64P = (DOUBLE *)malloc((size_t)(sizeof(DOUBLE) *
+					    (MAX_BUF_SIZE + MAX_91_COEFFS)));
+    test_btimesP = (DOUBLE *)malloc((size_t)(sizeof(DOUBLE) *
+					    (MAX_BUF_SIZE + MAX_91_COEFFS)));
+    if ((test_rawP == NULL) || (test_outP == NULL) || (test_refP == NULL) ||
+	(test_valuesP == NULL) || (test_values64P == NULL) ||
+	(test_timesP == NULL) || (test_flashP == NULL) ||
+	(test_blockP == NULL) ||
+	(test_corrP == NULL) || (test_bvaluesP == NULL) ||
+	(test_bvalues64P == NULL) || (test_btimesP == NULL))
+    {
+	printf("Not enough memory\n");
+	EXIT
+    }
+
+    /* What the processor has */
+    levels = SEQ_Vec_Init(SEQ_KERNEL_AUTO);
+
+    printf("Filter engines against the original loops, seed %lu:\n",
+		    (unsigned long)test_seed);
+    for (e=0; test_engines[e].nameP != NULL; ++e)
+    {
+	if (test_engines[e].level > levels)
+	{
+	    printf("  %-8s not available\n", test_engines[e].nameP);
+	    continue;
+	}
+	test_filters(e, segments);
+    }
+    if (levels >= SEQ_KERNEL_AVX2)
+	test_batch(segments);
+    else
+	printf("  %-8s not available\n", "batch");
+
+    if (bench == TRUE)
+    {
+	printf("\n%-12s", "Msamples/s");
+	for (i=0; test_modes[i].num_filters != 0; ++i)
+	    if (test_modes[i].timed == TRUE)
+	    {
+		sprintf(label, "%dx%d%s", (test_modes[i].num_filters == 9) ?
+			8 : test_modes[i].num_filters,
+			test_modes[i].num_coeffs,
+			(test_modes[i].num_filters == 9) ? "+7291" : "");
+		printf(" %10s", label);
+	    }
+	printf("\n");
+	for (e=0; test_engines[e].nameP != NULL; ++e)
+	    if (test_engines[e].level <= levels)
+		test_bench(e);
+	if (levels >= SEQ_KERNEL_AVX2)
+	    test_bench_batch();
+    }
+
+    if (test_errors != 0)
+    {
+	printf("%ld points differ\n", (long)test_errors);
+	EXIT
+    }
+    exit(0);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static ULONG test_random(range)
+  ULONG range;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: A number from 0 to range-1, the same on every machine for
+		the same seed.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* test_random() */
+
+    test_seed = (test_seed * 1103515245L + 12345) & 0xffffffffL;
+    return (((test_seed >> 8) & 0xffffffL) % range);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID test_coeffs(filterP, num_filters, num_coeffs, wild)
+  struct FILTER *filterP;
+  WORD  num_filters;
+  WORD  num_coeffs;
+  BOOL  wild;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Make up the coefficients of a segment, as
+		SEQ_read_filter_coefficients() would have read them.
+
+    Inputs: wild = FALSE for coefficients like those of a 7200A (1 in
+			the middle, small ones around it), TRUE for any
+			WORD at all
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* test_coeffs() */
+
+    INT   r, k;
+
+    memset(filterP, 0, sizeof(struct FILTER));
+    filterP->num_filters = num_filters;
+    filterP->num_coeffs = num_coeffs;
+    for (r=0; r < 8; ++r)
+	for (k=0; k < num_coeffs; ++k)
+	{
+	    if (wild)
+		filterP->coeffP[r][k] = (WORD)(test_random(65536L) - 32768L);
+	    else if (k == num_coeffs / 2)
+		filterP->coeffP[r][k] = (WORD)(14384 + test_random(4001L));
+	    else
+		filterP->coeffP[r][k] = (WORD)(test_random(6001L) - 3000);
+	}
+
+    if (num_filters == 9)
+    {
+	filterP->p91_mode = TRUE;
+	filterP->num_91coeffs = 63;
+	for (k=0; k < 63; ++k)
+	{
+	    if (wild)
+		filterP->coeff_7291[k] = (WORD)(test_random(65536L) - 32768L);
+	    else if (k == 31)
+		filterP->coeff_7291[k] = 16384;
+	    else
+		filterP->coeff_7291[k] = (WORD)(test_random(1201L) - 600);
+	}
+    }
+    else
+    {
+	filterP->p91_mode = FALSE;
+	filterP->num_91coeffs = 1;
+    }
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID test_raw(rawP, size, wild)
+  BYTE  *rawP;
+  LONG  size;
+  BOOL  wild;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Make up the raw samples of a segment.
+
+    Inputs: wild = FALSE for any samples, TRUE for runs of full scale
+			ones among them to drive the sums to their limits
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* test_raw() */
+
+    LONG  n;
+    LONG  run;
+    INT   sample;
+
+    for (n=0; n < size; )
+    {
+	run = 1;
+	sample = (INT)test_random(256L) - 128;
+	if (wild && (test_random(4L) == 0))
+	{
+	    run = 1 + test_random(40L);
+	    sample = (test_random(2L) == 0) ? -128 : 127;
+	}
+	for (; (run > 0) && (n < size); --run)
+	    rawP[n++] = (BYTE)sample;
+    }
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static LONG test_reference(filterP, raw_data, size, corr_dataP)
+  struct FILTER *filterP;
+  BYTE  *raw_data;
+  LONG  size;
+  WORD  *corr_dataP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Filter a whole segment with the original loops of SEQ_fir()
+		and SEQ_fir_7291(), for the engines to be compared with.
+
+    Inputs: size = raw samples in the segment
+
+    Outputs: returns the number of corrected points
+
+    Notes: Kept as the loops were before any engine was added to
+	   seq_filt.c; do not speed this up.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* test_reference() */
+
+    register WORD  *coeffP;
+    register LONG  temp;
+    register WORD  k;
+	     BYTE  *indexP;
+	     WORD  *flashP;
+	     LONG  n;
+	     LONG  count;
+	     INT   max_coeffs;
+	     BYTE  flash;
+
+    indexP = SEQ_fir_index(filterP->num_filters, filterP->last_flash);
+
+    if (filterP->num_filters < 8)   /* <= 1GSa/sec */
+    {
+	flash = 0;
+	for (n=filterP->num_coeffs-1; n < size; ++n,++flash)
+	{
+	    temp=0;
+	    coeffP = &filterP->coeffP[indexP[flash & 3]][0];
+
+	    for (k=0; k < filterP->num_coeffs; ++k)
+		temp += (coeffP[k] * (long)raw_data[n-k]);
+
+	    if (temp > CA_OVERFLOW)
+		*corr_dataP++ = OVERFLOW;
+	    else if (temp < CA_UNDERFLOW)
+		*corr_dataP++ = UNDERFLOW;
+	    else
+		*corr_dataP++ = (short)((temp >> 7) << 1);
+	}
+	return (size - (filterP->num_coeffs-1));
+    }
+
+    /* 2GSa/sec: every other sample, then the 7291 filter */
+    max_coeffs = 2*filterP->num_coeffs;
+    flashP = test_flashP;
+    flash = 0;
+    for (n=max_coeffs-2; n < size; ++n,++flash)
+    {
+	temp=0;
+	coeffP = &filterP->coeffP[indexP[flash & 7]][0];
+
+	for (k=0; k < max_coeffs; k += 2)
+	    temp += (*coeffP++ * (long)raw_data[n-k]);
+
+	if (temp > POS_SATURATION)
+	    *flashP++ = SATURATION;
+	else if (temp < CA_UNDERFLOW)
+	    *flashP++ = UNDERFLOW;
+	else
+	    *flashP++ = (short)((temp >> 7) << 1);
+    }
+
+    count = size - (max_coeffs-2);
+    for (n=filterP->num_91coeffs-1; n < count; ++n)
+    {
+	temp=0;
+	coeffP = &filterP->coeff_7291[0];
+
+	for (k=0; k < filterP->num_91coeffs; ++k)
+	    temp += (coeffP[k] * (long)test_flashP[n-k]);
+
+	if (temp > CA1_OVERFLOW)
+	    *corr_dataP++ = OVERFLOW;
+	else if (temp < CA1_UNDERFLOW)
+	    *corr_dataP++ = UNDERFLOW;
+	else
+	    *corr_dataP++ = (short)((temp >> 15) << 1);
+    }
+    return (count - (filterP->num_91coeffs-1));
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static LONG test_blocks(filterP, waveP, rawP, size, block, compensate)
+  struct FILTER *filterP;
+  struct WAVE_PARAMS *waveP;
+  BYTE  *rawP;
+  LONG  size;
+  LONG  block;
+  BOOL  compensate;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Filter a segment a block at a time with SEQ_fir(), and put
+		the points in volts with SEQ_Compensate() if asked to.
+
+    Inputs: size  = raw samples in the segment
+	    block = raw samples read at a time, MAX_BUF_SIZE or less
+
+    Outputs: returns the number of corrected points, in test_outP[] and
+		if compensate is TRUE in test_valuesP[], test_values64P[]
+		and test_timesP[]
+
+    Notes: Sets up the block and carries the samples over from one to
+	   the next as the reading loop of seq_tran.c and
+	   SEQ_Process_Seg() do; change this with them.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* test_blocks() */
+
+    SEQ_FILTER_DATA filt_data;
+    LONG  done;
+    LONG  out;
+    LONG  chunk;
+    LONG  count;
+    BYTE  *bufP;
+    WORD  num_coeffs, num_91_coeffs;
+    BOOL  first_seg;
+
+    memset(&filt_data, 0, sizeof(filt_data));
+    filt_data.rawP = test_blockP;
+    filt_data.corrP = test_corrP;
+    filt_data.paramsP = filterP;
+    filt_data.waveP = waveP;
+    if (compensate == TRUE)
+    {
+	filt_data.valuesP = test_bvaluesP;
+	filt_data.values64P = test_bvalues64P;
+	filt_data.timesP = test_btimesP;
+    }
+
+    num_91_coeffs = filterP->num_91coeffs-1;
+    if (filterP->p91_mode == TRUE)
+	num_coeffs = 2 * (filterP->num_coeffs-1);
+    else
+	num_coeffs = filterP->num_coeffs-1;
+
+    out = 0;
+    first_seg = TRUE;
+    for (done=0; done < size; done += chunk)
+    {
+	chunk = (size - done < block) ? size - done : block;
+
+	/* The first block on its own, the others after the last samples
+	   of the one before */
+	if (first_seg == TRUE)
+	{
+	    bufP = test_blockP;
+	    filt_data.size_91 = chunk;
+	    if (filterP->p91_mode == TRUE)
+		filt_data.size = chunk - num_coeffs;
+	    else
+		filt_data.size = chunk;
+	}
+	else
+	{
+	    bufP = test_blockP + num_coeffs;
+	    if (filterP->p91_mode == TRUE)
+	    {
+		filt_data.size_91 = chunk + num_coeffs;
+		filt_data.size = chunk + num_91_coeffs;
+	    }
+	    else
+		filt_data.size = chunk + num_coeffs;
+	}
+	memcpy(bufP, &rawP[done], (size_t)chunk);
+
+	SEQ_fir(&filt_data, first_seg);
+	if (compensate == TRUE)
+	    SEQ_Compensate(&filt_data, first_seg);
+
+	if (filterP->p91_mode == TRUE)
+	    count = filt_data.size - num_91_coeffs;
+	else
+	    count = filt_data.size - num_coeffs;
+	memcpy(&test_outP[out], test_corrP, (size_t)(sizeof(WORD) * count));
+	if (compensate == TRUE)
+	{
+	    memcpy(&test_valuesP[out], test_bvaluesP,
+				    (size_t)(sizeof(FLOAT) * count));
+	    memcpy(&test_values64P[out], test_bvalues64P,
+				    (size_t)(sizeof(DOUBLE) * count));
+	    memcpy(&test_timesP[out], test_btimesP,
+				    (size_t)(sizeof(DOUBLE) * count));
+	}
+	out += count;
+
+	/* Now copy the last filt_len-1 samples to the start of the block */
+	if (chunk == block)
+	    memcpy(test_blockP, bufP + chunk - num_coeffs, (size_t)num_coeffs);
+	first_seg = FALSE;
+    }
+
+    return (out);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID test_differ(nameP, filterP, what, size, block, n, value, ref)
+  CHAR  *nameP;
+  struct FILTER *filterP;
+  CHAR  *what;
+  LONG  size;
+  LONG  block;
+  LONG  n;
+  DOUBLE value;
+  DOUBLE ref;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Count a point that differs and print the first few.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* test_differ() */
+
+    if (++test_errors > TEST_ERRORS)
+	return;
+
+    printf("  %-8s %dx%d last flash %d, %ld samples in blocks of %ld: "
+	    "%s %ld is %.9g, not %.9g\n", nameP, filterP->num_filters,
+	    filterP->num_coeffs, filterP->last_flash, (long)size,
+	    (long)block, what, (long)n, value, ref);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID test_filters(e, segments)
+  INT   e;
+  LONG  segments;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Check an engine on segments of every sampling rate, taps
+		and last flash.
+
+    Inputs: e = test_engines[] entry
+	    segments = segments of each sampling rate and taps
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* test_filters() */
+
+    struct FILTER filter;
+    struct WAVE_PARAMS wave;
+    CHAR  *nameP;
+    LONG  errors;
+    LONG  points;
+    LONG  size;
+    LONG  block;
+    LONG  least;
+    LONG  count;
+    LONG  ref_count;
+    LONG  n;
+    LONG  s;
+    DOUBLE time;
+    FLOAT value;
+    DOUBLE value64;
+    INT   flashes;
+    INT   m;
+
+    nameP = test_engines[e].nameP;
+    SEQ_options.kernels = test_engines[e].options;
+    (VOID)SEQ_Vec_Init(test_engines[e].level);
+    SEQ_fir_engine(test_engines[e].engine);
+
+    errors = test_errors;
+    points = 0;
+    for (m=0; test_modes[m].num_filters != 0; ++m)
+    {
+	switch (test_modes[m].num_filters)
+	{
+	    case 1:  flashes = 1; break;
+	    case 2:  flashes = 3; break;
+	    case 4:  flashes = 4; break;
+	    default: flashes = 8; break;
+	}
+
+	for (s=0; s < segments; ++s)
+	{
+	    test_coeffs(&filter, test_modes[m].num_filters,
+			test_modes[m].num_coeffs, (BOOL)(s % 3 == 2));
+	    filter.last_flash = (WORD)(s % flashes);
+
+	    /* Real blocks, or short ones to cross more of them */
+	    if (s & 1)
+		block = MAX_BUF_SIZE;
+	    else
+		block = 4 * (32 + test_random(1024L));
+
+	    /* Enough for a point, or for the 7291 filter in the first
+	       block */
+	    if (filter.p91_mode == TRUE)
+		least = 2*(filter.num_coeffs-1) + filter.num_91coeffs;
+	    else
+		least = filter.num_coeffs;
+	    if (s % 4 == 0)
+		size = least + test_random(200L);
+	    else
+		size = least + test_random((ULONG)(TEST_SEGMENT - least));
+	    test_raw(test_rawP, size, (BOOL)(s % 5 == 4));
+
+	    wave.seg_start_time = (DOUBLE)test_random(100000L) * 1.0e-6;
+	    wave.time_per_point = (FLOAT)(1.0e-9 * (1 + test_random(10L)));
+	    wave.vertical_gain = (FLOAT)((1 + test_random(1000L)) * 1.0e-6);
+	    wave.vertical_offset = (FLOAT)((INT)test_random(2001L) - 1000) *
+								(FLOAT)1.0e-3;
+	    wave.horizontal_offset = (DOUBLE)test_random(1000L) * -1.0e-9;
+
+	    ref_count = test_reference(&filter, test_rawP, size, test_refP);
+	    count = test_blocks(&filter, &wave, test_rawP, size, block, TRUE);
+	    points += ref_count;
+
+	    if (count != ref_count)
+	    {
+		test_differ(nameP, &filter, "points", size, block, 0L,
+				(DOUBLE)count, (DOUBLE)ref_count);
+		continue;
+	    }
+
+	    time = wave.seg_start_time + wave.horizontal_offset;
+	    for (n=0; n < count; ++n)
+	    {
+		value = (wave.vertical_gain * test_refP[n]) -
+						    wave.vertical_offset;
+		value64 = ((DOUBLE)wave.vertical_gain * test_refP[n]) -
+					    (DOUBLE)wave.vertical_offset;
+
+		if (test_outP[n] != test_refP[n])
+		    test_differ(nameP, &filter, "point", size, block, n,
+				(DOUBLE)test_outP[n], (DOUBLE)test_refP[n]);
+		else if (memcmp(&test_valuesP[n], &value, sizeof(FLOAT)))
+		    test_differ(nameP, &filter, "volts of point", size,
+			    block, n, (DOUBLE)test_valuesP[n], (DOUBLE)value);
+		else if (memcmp(&test_values64P[n], &value64, sizeof(DOUBLE)))
+		    test_differ(nameP, &filter, "volts (DOUBLE) of point",
+			    size, block, n, test_values64P[n], value64);
+		else if (memcmp(&test_timesP[n], &time, sizeof(DOUBLE)))
+		    test_differ(nameP, &filter, "time of point", size,
+			    block, n, test_timesP[n], time);
+		time += wave.time_per_point;
+	    }
+	}
+    }
+
+    printf("  %-8s %ld points: %s\n", nameP, (long)points,
+		(test_errors == errors) ? "same" : "DIFFERENT");
+
+    SEQ_fir_engine(FIR_ENGINE_NONE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID test_batch(segments)
+  LONG  segments;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Check SEQ_Vec_Fir_Batch() on batches of short segments of
+		every sampling rate below 2 GSa/s and every taps.
+
+    Inputs: segments = batches of each sampling rate and taps
+
+    Notes: The segments are transposed as seq_bat.c does it, with
+	   some lanes left without a segment (a last flash that is not
+	   one of the sampling rate, or past the last segment).
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* test_batch() */
+
+    struct FILTER filter;
+    BYTE  *indexP[SEQ_BATCH];
+    WORD  flash[SEQ_BATCH];
+    WORD  *outP;
+    LONG  errors;
+    LONG  points;
+    LONG  size;
+    LONG  count;
+    LONG  n;
+    LONG  s;
+    INT   flashes;
+    INT   m;
+    INT   l;
+
+    SEQ_options.kernels = SEQ_KERNEL_AUTO;
+    (VOID)SEQ_Vec_Init(SEQ_KERNEL_AVX2);
+
+    errors = test_errors;
+    points = 0;
+    for (m=0; test_modes[m].num_filters != 0; ++m)
+    {
+	if (test_modes[m].num_filters >= 8)
+	    continue;
+	flashes = (test_modes[m].num_filters == 2) ? 3 :
+					test_modes[m].num_filters;
+
+	for (s=0; s < segments; ++s)
+	{
+	    test_coeffs(&filter, test_modes[m].num_filters,
+			test_modes[m].num_coeffs, (BOOL)(s % 3 == 2));
+	    size = filter.num_coeffs + test_random(160L);
+
+	    /* Segment l in test_rawP[l*size], transposed to test_blockP */
+	    for (l=0; l < SEQ_BATCH; ++l)
+	    {
+		flash[l] = (WORD)test_random((ULONG)(flashes + 1));
+		if (s % 4 == 3)
+		    flash[l] = (WORD)(l % flashes);
+		indexP[l] = SEQ_fir_index(filter.num_filters, flash[l]);
+	    }
+	    test_raw(test_rawP, size * SEQ_BATCH, (BOOL)(s % 5 == 4));
+	    for (n=0; n < size; ++n)
+		for (l=0; l < SEQ_BATCH; ++l)
+		    test_blockP[n*SEQ_BATCH + l] = test_rawP[l*size + n];
+
+	    count = SEQ_Vec_Fir_Batch(&filter, indexP, test_blockP, test_corrP,
+			    (LONG)(filter.num_coeffs-1), size);
+	    if (count != size - (filter.num_coeffs-1))
+	    {
+		test_differ("batch", &filter, "points", size, size, 0L,
+			(DOUBLE)count, (DOUBLE)(size - (filter.num_coeffs-1)));
+		continue;
+	    }
+
+	    for (l=0; l < SEQ_BATCH; ++l)
+	    {
+		if (indexP[l] == NULL)
+		    continue;
+		filter.last_flash = flash[l];
+		(VOID)test_reference(&filter, &test_rawP[l*size], size,
+							    test_refP);
+		outP = &test_corrP[l];
+		for (n=0; n < count; ++n, outP += SEQ_BATCH)
+		    if (*outP != test_refP[n])
+			test_differ("batch", &filter, "point", size, size, n,
+				(DOUBLE)*outP, (DOUBLE)test_refP[n]);
+		points += count;
+	    }
+	}
+    }
+
+    printf("  %-8s %ld points: %s\n", "batch", (long)points,
+		(test_errors == errors) ? "same" : "DIFFERENT");
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID test_bench(e)
+  INT   e;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Time an engine on each sampling rate the 7200A uses and
+		print the raw samples it filters per second.
+
+    Notes: A segment of TEST_BENCH samples filtered a MAX_BUF_SIZE block
+	   at a time like seqtran does, best of 3 runs of about 0.2 s.
+	   The points are not put in volts.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* test_bench() */
+
+    struct FILTER filter;
+    struct WAVE_PARAMS wave;
+    clock_t start, now;
+    DOUBLE rate;
+    DOUBLE best;
+    LONG  reps;
+    INT   run;
+    INT   m;
+
+    SEQ_options.kernels = test_engines[e].options;
+    (VOID)SEQ_Vec_Init(test_engines[e].level);
+    SEQ_fir_engine(test_engines[e].engine);
+    memset(&wave, 0, sizeof(wave));
+
+    printf("%-12s", test_engines[e].nameP);
+    for (m=0; test_modes[m].num_filters != 0; ++m)
+    {
+	if (test_modes[m].timed == FALSE)
+	    continue;
+	test_coeffs(&filter, test_modes[m].num_filters,
+				    test_modes[m].num_coeffs, FALSE);
+	test_raw(test_rawP, TEST_BENCH, FALSE);
+
+	best = 0;
+	for (run=0; run < 3; ++run)
+	{
+	    reps = 0;
+	    start = clock();
+	    do
+	    {
+		(VOID)test_blocks(&filter, &wave, test_rawP, TEST_BENCH,
+					    (LONG)MAX_BUF_SIZE, FALSE);
+		++reps;
+		now = clock();
+	    } while (now - start < CLOCKS_PER_SEC / 5);
+
+	    rate = (DOUBLE)TEST_BENCH * reps /
+			((DOUBLE)(now - start) / CLOCKS_PER_SEC) / 1.0e6;
+	    if (rate > best)
+		best = rate;
+	}
+	printf(" %10.1f", best);
+    }
+    printf("\n");
+
+    SEQ_fir_engine(FIR_ENGINE_NONE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID test_bench_batch()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Time SEQ_Vec_Fir_Batch() on batches of 64 point segments,
+		transposing included, for the rates below 2 GSa/s.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* test_bench_batch() */
+
+    struct FILTER filter;
+    BYTE  *indexP[SEQ_BATCH];
+    clock_t start, now;
+    DOUBLE rate;
+    DOUBLE best;
+    LONG  size;
+    LONG  reps;
+    LONG  n;
+    INT   run;
+    INT   m;
+    INT   l;
+
+    SEQ_options.kernels = SEQ_KERNEL_AUTO;
+    (VOID)SEQ_Vec_Init(SEQ_KERNEL_AVX2);
+    size = 64;
+
+    printf("%-12s", "batch (64)");
+    for (m=0; test_modes[m].num_filters != 0; ++m)
+    {
+	if (test_modes[m].timed == FALSE)
+	    continue;
+	if (test_modes[m].num_filters >= 8)
+	{
+	    printf(" %10s", "-");
+	    continue;
+	}
+	test_coeffs(&filter, test_modes[m].num_filters,
+				    test_modes[m].num_coeffs, FALSE);
+	for (l=0; l < SEQ_BATCH; ++l)
+	    indexP[l] = SEQ_fir_index(filter.num_filters, (WORD)0);
+	test_raw(test_rawP, size * SEQ_BATCH, FALSE);
+
+	best = 0;
+	for (run=0; run < 3; ++run)
+	{
+	    reps = 0;
+	    start = clock();
+	    do
+	    {
+		for (n=0; n < size; ++n)
+		    for (l=0; l < SEQ_BATCH; ++l)
+			test_blockP[n*SEQ_BATCH + l] = test_rawP[l*size + n];
+		(VOID)SEQ_Vec_Fir_Batch(&filter, indexP, test_blockP,
+			    test_corrP, (LONG)(filter.num_coeffs-1), size);
+		++reps;
+		now = clock();
+	    } while (now - start < CLOCKS_PER_SEC / 5);
+
+	    rate = (DOUBLE)(size * SEQ_BATCH) * reps /
+			((DOUBLE)(now - start) / CLOCKS_PER_SEC) / 1.0e6;
+	    if (rate > best)
+		best = rate;
+	}
+	printf(" %10.1f", best);
+    }
+    printf("\n");
+}
@@ -1,10 +1,32 @@
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_main.c
 cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_tran.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_ahd.c
 cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_args.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_bat.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_ckp.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_col.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_ctx.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_dir.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_dmx.c
 cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_filt.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_idx.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_job.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_lib.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_map.c
 cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_mtg.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_pip.c
 cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_prt.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_shd.c
 cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_util.c
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_vec.c
 cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_wfd.c
-link /CO seq_tran.obj seq_args.obj seq_filt.obj seq_mtg.obj seq_prt.obj seq_util.obj seq_wfd.obj, seq_tran,, /ST:38000
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_wsp.c
+link /CO seq_main.obj seq_tran.obj seq_ahd.obj seq_args.obj seq_bat.obj seq_ckp.obj seq_col.obj seq_ctx.obj seq_dir.obj seq_dmx.obj seq_filt.obj seq_idx.obj seq_job.obj seq_lib.obj seq_map.obj seq_mtg.obj seq_pip.obj seq_prt.obj seq_shd.obj seq_util.obj seq_vec.obj seq_wfd.obj seq_wsp.obj, seq_tran,, /ST:38000
 exepack seq_tran.exe seqtran.exe
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_test.c
+link /CO seq_test.obj seq_ctx.obj seq_filt.obj seq_vec.obj, seq_test,, /ST:38000
+exepack seq_test.exe seqtest.exe
+cl /Od /Zi -DATM_PROBE -DMSDOS -Ic:\include -I. /c /AL  seq_lchk.c
+link /CO seq_lchk.obj seq_tran.obj seq_ahd.obj seq_args.obj seq_bat.obj seq_ckp.obj seq_col.obj seq_ctx.obj seq_dir.obj seq_dmx.obj seq_filt.obj seq_idx.obj seq_job.obj seq_lib.obj seq_map.obj seq_mtg.obj seq_pip.obj seq_prt.obj seq_shd.obj seq_util.obj seq_vec.obj seq_wfd.obj seq_wsp.obj, seq_lchk,, /ST:38000
+exepack seq_lchk.exe seqlchk.exe
 
@@ -26,8 +26,6 @@ of the 7200A.
 /* -------------------------------------------------------------------- */
 
 extern CHAR   *PCW_translate_descriptor();
-extern STATUS PCW_Print_Block();
-extern CHAR   *SEQ_process_arguments();
 extern VOID   SEQ_read_filter_coefficients();
 extern VOID   SEQ_fir();
 extern VOID   SEQ_fir_7291();
@@ -38,29 +36,51 @@ extern BOOL   SEQ_Read_Blocks_Seg();
 extern VOID   seq_print_time();
 extern LONG   SEQ_Read_Desc();
 extern VOID   SEQ_Read_Segment_Number();
+extern VOID   SEQ_Loop_Buffers();
+extern VOID   SEQ_Loop_Free();
 extern BOOL   SEQ_Process_Seg();
+extern BOOL   SEQ_Read_Piece();
+extern VOID   SEQ_Filter_Piece();
+extern BOOL   SEQ_Batch_Fir();
+extern VOID   SEQ_Compensate();
 extern VOID   SEQ_Output_Seg();
+extern FILE   *SEQ_Open_Trace();
 extern VOID   SEQ_diagnostic();
 extern VOID   SEQ_91_diagnostic();
 extern BOOL   SEQ_Check_Seg();
+extern size_t SEQ_Map_Read();
+extern INT    SEQ_Map_Seek(FILE *seq_fP, SEQ_OFFSET offset, INT origin);
+extern LONG   SEQ_Map_Read_Blocks();
+extern BOOL   SEQ_Index_Read_Seg();
+extern BOOL   SEQ_Index_Read_Desc();
+extern LONG   SEQ_Next_Seg();
+extern BOOL   SEQ_Dir_Seek();
+extern VOID   SEQ_Dmx_Skip();
+extern BOOL   SEQ_Dmx_Read_Seg();
+extern BOOL   SEQ_Job_Submit();
+extern BOOL   SEQ_Job_Get();
+extern VOID   SEQ_Job_Drain();
+extern BOOL   SEQ_Pipe_Submit();
+extern VOID   SEQ_Pipe_Drain();
+extern BOOL   SEQ_Ahead_Start();
+extern BOOL   SEQ_Ahead_Get();
+extern VOID   SEQ_Ahead_Stop();
+extern LONG   SEQ_Ckpt_Resume();
+extern BOOL   SEQ_Ckpt_Whole();
+extern VOID   SEQ_Ckpt_Mark();
+extern BOOL   SEQ_Col_Seek();
+extern VOID   SEQ_Col_Rewind();
+extern BOOL   SEQ_Col_Read_Seg();
 
 /* -------------------------------------------------------------------- */
 
 #define MAX_TIME 3
 
-/* Global Variables. */
+/* Global Variables. The rest of the translator's variables are in the
+   current context (seq_ctx.c). */
 
-struct FILTER 	    SEQ_filter[MAX_PLUGINS][MAX_CHANNELS]; 
-struct PCW_BLOCK    *PCW_blockP[MAX_PLUGINS][MAX_CHANNELS];
-BYTE   		    *PCW_waveformP[MAX_PLUGINS][MAX_CHANNELS];
 struct PCW_TEMPLATE *PCW_templateP = NULL;
 
-struct SEQ_OPTIONS  SEQ_options;
-struct SEQ_PARAMS   SEQ_params;
-
-WORD SEQ_desc_size;    /* size in BYTEs of the waveform descriptor */
-FILE *out_fP = NULL;
-
 #undef RESOLUTION_1_PSEC
 #undef TESTING_HARK_PROBLEM
 
@@ -70,88 +90,17 @@ DOUBLE rel_time[2][MAX_TIMES];
 DOUBLE trig_time[2][MAX_TIMES];
 #endif /* TESTING_HARK_PROBLEM */
 
-/* -------------------------------------------------------------------- */
-
-/* Memory allocation for waveform descriptors */
-BYTE PCW_Waveform[MAX_PLUGINS][MAX_CHANNELS][800];
-
-/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
-
-VOID main(ac, av)
-    int ac;
-    char *av[];
-
-/*--------------------------------------------------------------------------
-
-    Purpose: Displays sign-on message, processes any switch arguments and 
-		calls the driver routine to transfer and process the SCSI
-		data.
-
-    Inputs: ac = number of arguments (switches)
-	    av = the switches as ASCII strings
-
-    Outputs: Calls sink(), the driver that does all the work.
-	     Turns off the SCSI interrupts on exit to restore proper PC
-	       operation.
-
-    Machine dependencies: IBM PC or compatible
-
-    Notes: Can define notdef to display the number of SCSI interrupts
-	     that were processed; there should be an interrupt for every
-	     block transfer of data.
-
-    Procedure:
-
-/CODE
---------------------------------------------------------------------------*/
-{   /* main() */
-
-    FILE *seq_fP;
-    CHAR *seq_filenameP;
-    BYTE p,c;
-
-    /* Print program description */
-	fprintf(stderr, 
-  "LeCroy 7200A SCSI Sequence Data Translator (Version 1.1, Feb 19, 1993).\n");
-
-    /* Process all the arguments to this routine */
-	seq_filenameP = SEQ_process_arguments(ac, &av[0]);
-
-    /* Open the specified data file */
-	if ((seq_fP = fopen(seq_filenameP,"rb")) == NULL)
-	{
-	    printf("Could not open file %s\n", seq_filenameP);
-	    EXIT
-	}
-
-    /* initialize the acquisition parameters in descriptor */
-	SEQ_interpret(seq_fP, SEQ_INIT_PARAMETERS);
-
-    /* initialize the descriptor for all channels */
-	SEQ_interpret(seq_fP, SEQ_READ_DESCRIPTOR);
-
-    /* If the acquisition parameters should be displayed, print them out */
-	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
-	{
-	    for (c=0; c <= SEQ_params.last_channel[p]; ++c)
-	    {
-		if (SEQ_options.print_params[p][c] == TRUE)
-		{
-		    printf("\nDESCRIPTOR FOR %c%d:\n",p+'A',c+1);
-		    (VOID)PCW_Print_Block(stdout,PCW_templateP,PCW_waveformP
-		       [p][c],"WAVEDESC",PCW_Regular,TRUE,2,0,(LONG)0,(LONG)0);
-		}
-	    }
-	}
-
-    /* Translate the data requested (# segments, segs after a time, ...) */
-	SEQ_interpret(seq_fP, SEQ_READ_SEGMENT_NUMBER);
+/* Buffers of the translation loop in the current context, kept here so
+   that SEQ_Stop() frees them when an error left the loop by SEQ_Exit() */
+typedef struct SEQ_LOOP_STATE
+{
+    BYTE   *array1P;
+    WORD   *array3P;
+    FLOAT  *valuesP;
+    DOUBLE *timesP;
+} SEQ_LOOP_STATE;
 
-    /* Close the file before ending program */
-	fclose(seq_fP);
-
-    exit (0);
-}
+#define seq_loop	(*SEQ_MODULE(SEQ_MOD_LOOP, SEQ_LOOP_STATE))
 
 
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
@@ -183,9 +132,6 @@ VOID SEQ_interpret(seq_fP, action)
 --------------------------------------------------------------------------*/
 {   /* SEQ_interpret() */
 
-extern BYTE plugin_field;
-extern BYTE channel_field[MAX_PLUGINS];
-
     INT   num_read;
     UWORD packet;
     UWORD num_chan;
@@ -194,7 +140,7 @@ extern BYTE channel_field[MAX_PLUGINS];
     UWORD other_plugin;
     BYTE  p,c;
     UWORD plugin;
-    WORD  search_size;
+    LONG  search_size;
     SEGS  *segP;
 
     if (action == SEQ_INIT_PARAMETERS)
@@ -211,9 +157,9 @@ extern BYTE channel_field[MAX_PLUGINS];
 	 ****************************************************************/
 
 	/* Initialize block size, plugins present, chan/plugin, descriptors */
-	fseek(seq_fP,0L,SEEK_SET);
+	SEQ_Map_Seek(seq_fP,0L,SEEK_SET);
 
-	num_read = fread((CHAR *)&packet,sizeof(UWORD),1,seq_fP);
+	num_read = SEQ_Map_Read((CHAR *)&packet,sizeof(UWORD),1,seq_fP);
 
 	if ((packet & 0x7fff) != 0)
 	{
@@ -236,14 +182,15 @@ extern BYTE channel_field[MAX_PLUGINS];
 	}
 
 	/* Read the block size */
-	num_read = fread((CHAR *)&SEQ_params.block_size,sizeof(ULONG),1,seq_fP);
+	num_read = SEQ_Map_Read((CHAR *)&SEQ_params.block_size,sizeof(ULONG),
+								1,seq_fP);
 
 	/* Read the number of channels */
-	num_read = fread((CHAR *)&num_chan, sizeof(UWORD),1,seq_fP);
+	num_read = SEQ_Map_Read((CHAR *)&num_chan, sizeof(UWORD),1,seq_fP);
 	SEQ_params.last_channel[plugin] = num_chan - 1;
 
 	/* Read the TMB block size */
-	num_read = fread((CHAR *)&SEQ_params.tmb_block_size[plugin], 
+	num_read = SEQ_Map_Read((CHAR *)&SEQ_params.tmb_block_size[plugin], 
 					sizeof(UWORD),1,seq_fP);
 
 	/* Search through the rest of the file looking for the presence of
@@ -251,13 +198,13 @@ extern BYTE channel_field[MAX_PLUGINS];
 	 * a max descriptor size plus filter coeff size of 600, don't search 
 	 * beyond num_chan*600 bytes for the other plugin.
 	 */
-	fseek(seq_fP, (LONG)sizeof(UWORD), SEEK_SET);
+	SEQ_Map_Seek(seq_fP, (LONG)sizeof(UWORD), SEEK_SET);
 	search_size = num_chan * 600;
 	while(search_size > 0)
 	{
-	    fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+	    SEQ_Map_Seek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
 	    search_size -= (SEQ_params.block_size-2);
-	    num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+	    num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 	    if (num_read == 0)
 		break;
 	    else if ((packet & 0x8000) == other_plugin)
@@ -268,13 +215,13 @@ extern BYTE channel_field[MAX_PLUGINS];
 		plugin = (other_plugin >> 15);
 
 		/* Skip over the block size (the same for both plugins) */
-		fseek(seq_fP, (LONG)sizeof(ULONG), SEEK_CUR);
+		SEQ_Map_Seek(seq_fP, (LONG)sizeof(ULONG), SEEK_CUR);
 
 		/* Read the number of channels for this plugin */
-		num_read = fread((CHAR *)&num_chan, sizeof(UWORD),1,seq_fP);
+		num_read = SEQ_Map_Read((CHAR *)&num_chan, sizeof(UWORD),1,seq_fP);
 		SEQ_params.last_channel[plugin] = num_chan - 1;
 		/* Read the TMB block size */
-		num_read = fread((CHAR *)&SEQ_params.tmb_block_size[plugin], 
+		num_read = SEQ_Map_Read((CHAR *)&SEQ_params.tmb_block_size[plugin], 
 						sizeof(UWORD),1,seq_fP);
 		break;
 	    }
@@ -308,6 +255,12 @@ extern BYTE channel_field[MAX_PLUGINS];
 	for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
 	{
 	    SEQ_params.seg_offset += SEQ_Read_Desc(seq_fP, p);
+
+	    /* Keep the size of the segments, which SEQ_Init_Descriptor()
+	       changes in the descriptor to that of the corrected ones */
+	    SEQ_ctxP->array_size[p] = *(LONG *)PCW_Find_Value_From_Name(
+				PCW_waveformP[p][0], (LONG)0, PCW_blockP[p][0],
+				"WAVE_ARRAY_1");
 	}
 
     }
@@ -508,8 +461,9 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
     LONG  data_size;
     LONG  total;
     BYTE  *array1P;
-    WORD  *array2P;
     WORD  *array3P;
+    FLOAT *valuesP;
+    DOUBLE *timesP;
     BYTE  *dataP;
     BOOL  keep_going;
     BOOL  first_seg;
@@ -519,10 +473,13 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
     FLOAT  trigger_delay;
     UWORD channel_tag;
     LONG  i;
+    LONG  next_segno;
+    LONG  first_segno;
     BYTE  c;
     DOUBLE diff_time;
     DOUBLE next_seg_time;
     BOOL  translate;
+    BOOL  ahead;
     BOOL  test_mode;
     BOOL  diagnostic_data;
     BYTE  status;
@@ -531,28 +488,15 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
     SEQ_ACQ_PARAMS acq_params;
     SEQ_ACQ_DATA   data,acq_data;
     SEQ_FILTER_DATA  filt_data;
-    static DOUBLE first_seg_time[MAX_PLUGINS] = {0,0};
-
+    DOUBLE *first_seg_time;
 
-    array_sizeP = (LONG *)PCW_Find_Value_From_Name(PCW_waveformP[plugin][0],
-			  (LONG)0, PCW_blockP[plugin][0], "WAVE_ARRAY_1");
 
-    /* Allocate WORDS so filtered points can be put in place */
-    array1P = (BYTE *)(malloc((size_t)(sizeof(BYTE) *
-			(MAX_BUF_SIZE+MAX_FILTER_SIZE))));
-    if (!array1P)
-	error_handler(OUT_OF_MEMORY);
+    /* Timestamps of the first segments, kept in the context */
+    first_seg_time = SEQ_ctxP->first_seg_time;
 
-    /* This array is where the 7291 flash-corrected points will go */
-    array2P = (WORD *)(malloc((size_t)(sizeof(WORD) *
-			(MAX_BUF_SIZE+MAX_FILTER_SIZE))));
-    if (!array2P)
-	error_handler(OUT_OF_MEMORY);
+    array_sizeP = &SEQ_ctxP->array_size[plugin];
 
-    /* This array is where the corrected points will go */
-    array3P = (WORD *)(malloc((size_t)(sizeof(WORD) * MAX_BUF_SIZE)));
-    if (!array3P)
-	error_handler(OUT_OF_MEMORY);
+    SEQ_Loop_Buffers(&array1P, &array3P, &valuesP, &timesP);
 
     corr_sizeP = (LONG *)PCW_Find_Value_From_Name(PCW_waveformP[plugin][0],
 			  (LONG)0, PCW_blockP[plugin][0], "PNTS_PER_SCREEN");
@@ -561,7 +505,8 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
 			(LONG)0, PCW_blockP[plugin][0], "HORIZ_INTERVAL");
 
     /* Seek to the start of the segment information before scanning */
-    fseek(seq_fP, SEQ_params.seg_offset, SEEK_SET);
+    SEQ_Map_Seek(seq_fP, SEQ_params.seg_offset, SEEK_SET);
+    SEQ_Col_Rewind(plugin);
 
     /* get the time_per_point for time conversion later */
     time_per_ptP = (FLOAT *)PCW_Find_Value_From_Name(PCW_waveformP
@@ -573,19 +518,50 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
     acq_data.block_offset = 0;
     acq_data.plugin = plugin;
     filt_data.rawP = array1P;
-    filt_data.p91_baseP = array2P;
     filt_data.corrP = array3P;
     filt_data.array_size = data_count;
+    filt_data.waveP = &wave_param;
+    filt_data.valuesP = valuesP;
+    filt_data.values64P = NULL;
+    filt_data.timesP = timesP;
+    filt_data.time = 0.0;
+
+    /* Or carry on after the last segment an earlier run got through */
+    first_segno = SEQ_Ckpt_Resume(seq_fP, plugin, &acq_data.block_offset,
+						&first_seg_time[plugin]);
 
     diagnostic_data = FALSE;
     test_mode = FALSE;
     keep_going = TRUE;
-    for (i=1; keep_going == TRUE; ++i)
+    for (i=first_segno; keep_going == TRUE; ++i)
     {
 	for (c=0; c <= SEQ_params.last_channel[plugin]; ++c)
 	{
 	    if (c == 0)
 	    {
+		/* Jump to the next segment anyone asked for */
+		if ((i > 1) && (test_mode == FALSE))
+		{
+		    next_segno = SEQ_Next_Seg(plugin, i);
+		    if ((next_segno > i) && ((SEQ_Col_Seek(plugin, next_segno,
+			    &acq_data.block_offset) == TRUE) ||
+			(SEQ_Dir_Seek(seq_fP, plugin, next_segno,
+			    &acq_data.block_offset) == TRUE)))
+			i = next_segno;
+		}
+
+		/* A shard of -m ends where the next one starts (seq_shd.c) */
+		if ((SEQ_ctxP->shard_end[plugin] != 0L) &&
+		    (i > SEQ_ctxP->shard_end[plugin]))
+		    goto leave;
+
+		/* Leave a segment still being acquired to a later run: its
+		   channel tag, acquisition parameters and channels' data */
+		if ((test_mode == FALSE) && (SEQ_Ckpt_Whole(seq_fP, plugin, i,
+			acq_data.block_offset, 14L + acq_data.array_size *
+			(SEQ_params.last_channel[plugin] + 1)) == FALSE))
+		    goto leave;
+
 		/* Read the channel tag */
 		data.bufP = (BYTE *)&channel_tag;
 		data.size = 2L;
@@ -593,7 +569,11 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
 		data.byte_offset = 0L;
 		data.plugin = plugin;
 		if (SEQ_Read_Blocks_Seg(seq_fP, &data, TRUE) == FALSE)
+		{
+		    SEQ_Job_Drain();
+		    SEQ_Pipe_Drain();
 		    EXIT
+		}
 
 		if (channel_tag == SEQ_DIAGNOSTIC_BLOCK)
 		{
@@ -606,7 +586,7 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
 			test_mode = TRUE;
 		    }
 		    else
-			return;
+			goto leave;
 
 
 		}
@@ -616,7 +596,11 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
 		    data.bufP = (BYTE *)&acq_params;
 		    data.size = 12L;
 		    if (SEQ_Read_Blocks_Seg(seq_fP, &data, TRUE) == FALSE)
+		    {
+			SEQ_Job_Drain();
+			SEQ_Pipe_Drain();
 			EXIT
+		    }
 
 		    acq_data.block_offset = data.block_offset;
 		    if (i == 1)
@@ -657,6 +641,9 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
 		}
 		else
 		{
+		    /* After the segments -j and -q still have */
+		    SEQ_Job_Drain();
+		    SEQ_Pipe_Drain();
 		    if (SEQ_params.last_packet[plugin] == FALSE)
 			printf("Invalid channel tag: 0x%04x\n", channel_tag);
 
@@ -689,7 +676,6 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
 		acq_data.byte_offset = 0;
 		if (filt_data.paramsP->p91_mode == TRUE)
 		{
-		    filt_data.p91P = array2P;
 		    filt_data.size_91 = acq_data.size;
 		    filt_data.size = acq_data.size -
 				(2*(filt_data.paramsP->num_coeffs-1));
@@ -721,7 +707,6 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
 		acq_data.bufP = array1P;
 		if (filt_data.paramsP->p91_mode == TRUE)
 		{
-		    filt_data.p91P = array2P;
 		    filt_data.size_91 = acq_data.size;
 		    filt_data.size = acq_data.size -
 				(2*(filt_data.paramsP->num_coeffs-1));
@@ -734,9 +719,14 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
 		wave_param.seg_start_time = diff_time;
 		SEQ_Init_Descriptor(&acq_data, &filt_data, &wave_param, 
 					acq_params.fine_count);
-
-		/* Print status information */
-		fprintf(stderr, "\n%c%d, Segment %ld:\n", plugin+'A', c+1, i);
+		++SEQ_ctxP->segs_done;
+		SEQ_ctxP->samples_done += (DOUBLE)acq_data.array_size;
+
+		/* Print status information (not for every file of -b) */
+		if ((SEQ_options.output.type != SEQ_OUTPUT_BUFFER) &&
+		    (SEQ_options.file_list == FALSE))
+		    fprintf(stderr, "\n%c%d, Segment %ld:\n",
+						    plugin+'A', c+1, i);
 	    }
 	    else
 	    {
@@ -750,6 +740,18 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
 
 	    SEQ_update_time(FALSE, 0, 0);
 
+	    /* Hand the segment to the threads of -j or to the pipeline
+	       of -q, or else read the pieces of a long segment while
+	       filtering */
+	    ahead = FALSE;
+	    if ((translate == TRUE) && ((SEQ_Job_Submit(seq_fP, i, &acq_data,
+			    &filt_data, data_size, &keep_going) == TRUE) ||
+		(SEQ_Pipe_Submit(seq_fP, i, &acq_data, &filt_data, data_size,
+						    &keep_going) == TRUE)))
+		data_size = 0;
+	    else if (translate == TRUE)
+		ahead = SEQ_Ahead_Start(seq_fP, &acq_data, data_size);
+
 	    while ((data_size > 0) && (keep_going == TRUE))
 	    {
 		if (SEQ_Process_Seg(seq_fP, first_seg, &acq_data, 
@@ -792,15 +794,118 @@ VOID SEQ_Read_Segment_Number(seq_fP, plugin, segno)
 
 		SEQ_update_time(TRUE, total, data_size);
 	    }
+
+	    if (ahead == TRUE)
+		SEQ_Ahead_Stop();
 	}
+
+	/* Remember that this segment is done */
+	if ((keep_going == TRUE) && (test_mode == FALSE))
+	    SEQ_Ckpt_Mark(seq_fP, plugin, i + 1, acq_data.block_offset,
+						first_seg_time[plugin]);
+
+	/* Let a reader of the output see each segment as it arrives */
+	if (SEQ_options.stream == TRUE)
+	    fflush(stdout);
     }
 
     leave:;
-    free(array1P);
-    free(array2P);
-    free(array3P);
+    SEQ_Job_Drain();
+    SEQ_Pipe_Drain();
+    SEQ_Loop_Free();
+}
+
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Loop_Buffers(array1PP, array3PP, valuesPP, timesPP)
+  BYTE   **array1PP;
+  WORD   **array3PP;
+  FLOAT  **valuesPP;
+  DOUBLE **timesPP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Allocate the buffers a segment is translated through, for
+		SEQ_Read_Segment_Number() and the threads of -j.
+
+    Outputs: *array1PP = the raw points, with room to filter in place
+	     *array3PP = the corrected points
+	     *valuesPP = the points in volts, NULL unless they are printed
+			 or go to the caller's buffer
+	     *timesPP  = their times, NULL unless they are printed
+
+    Notes: They belong to the current context until SEQ_Loop_Free(),
+	   which also frees any that a translation given up by
+	   SEQ_Exit() left behind.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Loop_Buffers() */
+
+    SEQ_Loop_Free();
+
+    /* Allocate WORDS so filtered points can be put in place */
+    seq_loop.array1P = (BYTE *)(malloc((size_t)(sizeof(BYTE) *
+			(MAX_BUF_SIZE+MAX_FILTER_SIZE))));
+    if (!seq_loop.array1P)
+	error_handler(OUT_OF_MEMORY);
+
+    /* This array is where the corrected points will go */
+    seq_loop.array3P = (WORD *)(malloc((size_t)(sizeof(WORD) *
+							MAX_BUF_SIZE)));
+    if (!seq_loop.array3P)
+	error_handler(OUT_OF_MEMORY);
+
+    /* And where they go in volts, with their times, for the screen or
+       the caller's buffer */
+    if ((SEQ_options.format == SEQ_FORMAT_COMPENSATED) &&
+	(SEQ_options.output.type != SEQ_OUTPUT_FILE))
+    {
+	seq_loop.valuesP = (FLOAT *)(malloc((size_t)(sizeof(FLOAT) *
+							MAX_BUF_SIZE)));
+	if (!seq_loop.valuesP)
+	    error_handler(OUT_OF_MEMORY);
+	if (SEQ_options.output.format == SEQ_SCREEN_OUTPUT_2)
+	{
+	    seq_loop.timesP = (DOUBLE *)(malloc((size_t)(sizeof(DOUBLE) *
+							MAX_BUF_SIZE)));
+	    if (!seq_loop.timesP)
+		error_handler(OUT_OF_MEMORY);
+	}
+    }
+
+    *array1PP = seq_loop.array1P;
+    *array3PP = seq_loop.array3P;
+    *valuesPP = seq_loop.valuesP;
+    *timesPP = seq_loop.timesP;
 }
 
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+VOID SEQ_Loop_Free()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Free the buffers of SEQ_Loop_Buffers() in the current
+		context.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Loop_Free() */
+
+    if (SEQ_ctxP->moduleP[SEQ_MOD_LOOP] == NULL)
+	return;
+
+    free(seq_loop.array1P);
+    free(seq_loop.array3P);
+    free(seq_loop.valuesP);
+    free(seq_loop.timesP);
+    seq_loop.array1P = NULL;
+    seq_loop.array3P = NULL;
+    seq_loop.valuesP = NULL;
+    seq_loop.timesP = NULL;
+}
 
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
 
@@ -837,9 +942,9 @@ BOOL SEQ_Process_Seg(seq_fP, first_seg, acq_dataP, filt_dataP, process)
 		      FLASH FIR FILTER
 			     |
 			     V
-	     -------------------------------------------  filt_dataP->p91P
-   array2P   | acq_dataP->size - (flash_filt_len-1)    |  filt_dataP->size_91
-	     -------------------------------------------
+		       -------------------------  FIR_TILE at a time
+   p91_tile[]  | 62 | <= FIR_TILE points |  (seq_filt.c)
+		       -------------------------
 			     |
 			7291 FIR FILTER
 			     |
@@ -857,10 +962,10 @@ BOOL SEQ_Process_Seg(seq_fP, first_seg, acq_dataP, filt_dataP, process)
 		      FLASH FIR FILTER
 			     |
 			     V
---------------------------------------------------------  filt_dataP->p91P
-|   62       | acq_dataP->size (MAX_BUF_SIZE)          |  filt_dataP->size_91+62
---------------------------------------------------------  
- past samples                |
+		       -------------------------  FIR_TILE at a time
+   p91_tile[]  | 62 | <= FIR_TILE points |  (seq_filt.c)
+		       -------------------------
+		 past samples        |
 			7291 FIR FILTER
 			     |
 			     V
@@ -882,17 +987,15 @@ BOOL SEQ_Process_Seg(seq_fP, first_seg, acq_dataP, filt_dataP, process)
 
 			filt_dataP Definitions
 			----------------------
-	p91_baseP = buffer containing all the flash-corrected data points
-	p91P = ptr to write the flash-corrected data points in 7291 mode
-		  On the first block, p91_baseP=p91P; after the
-		  first block, the 62 flash-corrected points that are still
-		  needed in future 7291 filters are copied to p91_baseP and
-		  p91P is advanced by 62.
 	size_91 = number of raw data points in acq_dataP->baseP that can be used
-		  to pass across the flash filter, the corrected points of 
-		  which are put into p91P. size_91 equals block size for first 
-		  block and is block_size+24 on subsequent blocks to account 
-		  for the 24 extra raw data points in acq_dataP->baseP.
+		  to pass across the flash filter in 7291 mode. The
+		  flash-corrected points never go to memory as a whole:
+		  SEQ_fir() passes them through the 7291 filter a tile at
+		  a time, keeping the 62 points still needed by the next
+		  tile (and block) itself. size_91 equals block size for
+		  first block and is block_size+24 on subsequent blocks to
+		  account for the 24 extra raw data points in
+		  acq_dataP->baseP.
 
 	corrP = buffer to put "corrected" results. For non-7291 operation,
 		these "corrected" points are the result of the flash
@@ -901,8 +1004,9 @@ BOOL SEQ_Process_Seg(seq_fP, first_seg, acq_dataP, filt_dataP, process)
 	size  = For non-7291 operation, equals number of raw data points in
 		acq_dataP->baseP that can be used to pass across the flash
 		filters. For 7291 operation, equals number of flash-corrected 
-		WORDs in p91_baseP that can be used to pass across the 7291 
-		filter the corrected points of which are put into corrP. 
+		WORDs, with the 62 of the last block, that can be used to
+		pass across the 7291 filter the corrected points of which
+		are put into corrP. 
 		For non-7291 data, size equals block_size on the first block 
 		and block_size+(flash_filter_len-1) on subsequent blocks. 
 		For 7291 data, size equals block_size on the first block 
@@ -918,24 +1022,56 @@ BOOL SEQ_Process_Seg(seq_fP, first_seg, acq_dataP, filt_dataP, process)
 --------------------------------------------------------------------------*/
 {   /* SEQ_Process_Seg() */
 
-    register IWORD data;
+    if (SEQ_Read_Piece(seq_fP, first_seg, acq_dataP, filt_dataP,
+							process) == FALSE)
+	return(FALSE);
+
+    if (process)
+	SEQ_Filter_Piece(acq_dataP, filt_dataP, first_seg);
+
+    return(TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Read_Piece(seq_fP, first_seg, acq_dataP, filt_dataP, process)
+    FILE  	  *seq_fP;
+    BOOL          first_seg;
+    SEQ_ACQ_DATA  *acq_dataP;
+    SEQ_FILTER_DATA *filt_dataP;
+    BOOL	  process;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: The first half of SEQ_Process_Seg(): set up the buffers for
+		the piece and read it.
+
+    Inputs: as for SEQ_Process_Seg()
+
+    Outputs: returns TRUE if no errors and caller can continue
+	     returns FALSE if an error occurred and we should terminate
+
+    Notes: A piece after the first is read past the raw samples kept
+	   from the one before (acq_dataP->bufP - acq_dataP->baseP of
+	   them), which must be in place before it is filtered.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Read_Piece() */
+
     register WORD  i;
-    BYTE  *buf1P,*buf2P;
-    WORD  *buf1_wP,*buf2_wP;
     WORD  num_coeffs, num_91_coeffs;
 
     static UWORD count=0;
     UWORD  *buf_wP;
+    BOOL   status;
 
     if (filt_dataP->paramsP->p91_mode == TRUE)
     {
 	num_coeffs = 2 * (filt_dataP->paramsP->num_coeffs-1);
 	num_91_coeffs = filt_dataP->paramsP->num_91coeffs-1;
 	if (first_seg == FALSE)
-	{
-	    filt_dataP->p91P = filt_dataP->p91_baseP + num_91_coeffs;
 	    filt_dataP->size_91 = acq_dataP->size + num_coeffs;
-	}
     }
     else
 	num_coeffs = filt_dataP->paramsP->num_coeffs-1;
@@ -950,60 +1086,92 @@ BOOL SEQ_Process_Seg(seq_fP, first_seg, acq_dataP, filt_dataP, process)
 	    filt_dataP->size = acq_dataP->size + num_coeffs;
     }
 
-    /* Copy the uncorrected raw data into the buffer */
-    if (SEQ_Read_Blocks_Seg(seq_fP, acq_dataP, process) == FALSE)
+    /* Copy the uncorrected raw data into the buffer, or take it from
+       the read-ahead thread if one is running, or in a thread of -j
+       from the segment it was given */
+    if ((SEQ_Job_Get(acq_dataP, &status) == FALSE) &&
+	(SEQ_Ahead_Get(acq_dataP, &status) == FALSE))
+	status = SEQ_Read_Blocks_Seg(seq_fP, acq_dataP, process);
+    if (status == FALSE)
 	return(FALSE);
 
-    /* Translate the data from Intel Lo/Hi to Motorola Hi/Lo format */
-    if (process)
+    /* Check the counting pattern of a test file */
+    if ((process) && (SEQ_options.debug == 2))
     {
-	if (SEQ_options.debug == 2)
-	{
-	    if ((acq_dataP->channel == 0) && (first_seg == TRUE))
-		count += 7;
+	if ((acq_dataP->channel == 0) && (first_seg == TRUE))
+	    count += 7;
 
-	    buf_wP = (UWORD *)acq_dataP->bufP;
-	    for (i=0; i < (acq_dataP->size/2); ++i)
+	buf_wP = (UWORD *)acq_dataP->bufP;
+	for (i=0; i < (acq_dataP->size/2); ++i)
+	{
+	    if (count != buf_wP[i])
 	    {
-		if (count != buf_wP[i])
-		{
-		    printf("Expected 0x%04x, read 0x%04x\n", count,
-				buf_wP[i]);
-		    EXIT;
-		}
-		else
-		    ++count;
+		printf("Expected 0x%04x, read 0x%04x\n", count,
+			    buf_wP[i]);
+		EXIT;
 	    }
+	    else
+		++count;
 	}
-	else if (SEQ_options.format != SEQ_FORMAT_RAW)
-	{
-	    /* Call a routine to filter the data if requested */
-	    SEQ_fir(filt_dataP, first_seg);
+    }
 
-	    /* Now copy the last filt_len-1 points to the start of the buffer */
-	    if (acq_dataP->size == MAX_BUF_SIZE)
-	    {
-		buf1P = filt_dataP->rawP;
-		buf2P = acq_dataP->bufP + acq_dataP->size - num_coeffs;
+    return(TRUE);
+}
 
-		for (i=num_coeffs; i > 0; --i)
-		    *buf1P++ = *buf2P++;
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
 
-		/* In 7291 mode, must also copy 7291 filter points to start */
-		if (filt_dataP->paramsP->p91_mode == TRUE)
-		{
-		    buf1_wP = filt_dataP->p91_baseP;
-		    buf2_wP = filt_dataP->p91P + 
-			    (filt_dataP->size_91 - num_coeffs) - num_91_coeffs; 
+VOID SEQ_Filter_Piece(acq_dataP, filt_dataP, first_seg)
+    SEQ_ACQ_DATA  *acq_dataP;
+    SEQ_FILTER_DATA *filt_dataP;
+    BOOL          first_seg;
 
-		    for (i=num_91_coeffs; i > 0; --i)
-			*buf1_wP++ = *buf2_wP++;
-		}
-	    }
-	}
-    }
+/*--------------------------------------------------------------------------
 
-    return(TRUE);
+    Purpose: The second half of SEQ_Process_Seg(): filter the piece just
+		read and compensate it.
+
+    Inputs: as for SEQ_Process_Seg()
+
+    Outputs: Filters the data in-place in the buffer.
+
+    Notes: Does nothing for raw data or with -v1 (test file).
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Filter_Piece() */
+
+    register WORD  i;
+    BYTE  *buf1P,*buf2P;
+    WORD  num_coeffs;
+
+    if ((SEQ_options.debug == 2) || (SEQ_options.format == SEQ_FORMAT_RAW))
+	return;
+
+    if (filt_dataP->paramsP->p91_mode == TRUE)
+	num_coeffs = 2 * (filt_dataP->paramsP->num_coeffs-1);
+    else
+	num_coeffs = filt_dataP->paramsP->num_coeffs-1;
+
+    /* Call a routine to filter the data if requested, unless the
+       segment was filtered with others read from the cache */
+    if ((first_seg == FALSE) ||
+	(SEQ_Batch_Fir(acq_dataP, filt_dataP) == FALSE))
+	SEQ_fir(filt_dataP, first_seg);
+
+    /* Put them in volts while they are still in the cache */
+    if ((SEQ_options.format == SEQ_FORMAT_COMPENSATED) &&
+	(filt_dataP->valuesP != NULL))
+	SEQ_Compensate(filt_dataP, first_seg);
+
+    /* Now copy the last filt_len-1 points to the start of the buffer */
+    if (acq_dataP->size == MAX_BUF_SIZE)
+    {
+	buf1P = filt_dataP->rawP;
+	buf2P = acq_dataP->bufP + acq_dataP->size - num_coeffs;
+
+	for (i=num_coeffs; i > 0; --i)
+	    *buf1P++ = *buf2P++;
+    }
 }
 
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
@@ -1072,6 +1240,21 @@ register LONG num_packets;
     LONG byte_skip;
     BYTE *bufferP;
     BYTE direction;
+    BOOL status;
+    LONG blocks;
+    UWORD last_i;
+
+    /* Take the segments from the columnar cache if there is one */
+    if (SEQ_Col_Read_Seg(seq_fP, dataP, (INT)read, &status) == TRUE)
+	return (status);
+
+    /* Go straight to the block if the file has a packet index */
+    if (SEQ_Index_Read_Seg(seq_fP, dataP, (INT)read, &status) == TRUE)
+	return (status);
+
+    /* Or use the blocks collected while another plugin was read */
+    if (SEQ_Dmx_Read_Seg(seq_fP, dataP, (INT)read, &status) == TRUE)
+	return (status);
 
     /* Setup the mask to determine which blocks are significant */
     plugin_mask = (dataP->plugin << 15);
@@ -1082,7 +1265,7 @@ register LONG num_packets;
     size = dataP->size;
     dataP->bytes_read = 0L;
     num_packets = 0;
-    num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+    num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 
     if (offset >= 0)
 	direction = 1;
@@ -1111,7 +1294,23 @@ register LONG num_packets;
 			++i;
 		    if ((packet & 0x7fff) != 0)
 			offset -= (SEQ_params.block_size-2);
-		    fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+		    SEQ_Map_Seek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+
+		    /* Skip the whole blocks that follow in one go */
+		    if ((offset >= (SEQ_params.block_size-2)) &&
+			(i != 0) && (i != 0x7fff) && (SEQ_options.debug != 1))
+		    {
+			last_i = (i == 1) ? 0x7ffe : i - 1;
+			blocks = SEQ_Map_Read_Blocks(seq_fP, (BYTE *)NULL,
+				offset / (LONG)(SEQ_params.block_size-2),
+				(INT)plugin_mask, &last_i);
+			if (blocks > 0)
+			{
+			    i = (last_i == 0x7ffe) ? 1 : last_i + 1;
+			    offset -= blocks * (SEQ_params.block_size-2);
+			    num_packets += blocks;
+			}
+		    }
 		}
 		else if ((packet & 0x7fff) != 0x7fff)  /* 7fff = last packet */
 		{
@@ -1130,7 +1329,7 @@ register LONG num_packets;
 			--i;
 		    if ((packet & 0x7fff) != 0)
 			offset += (SEQ_params.block_size-2);
-		    fseek(seq_fP, (LONG)(-SEQ_params.block_size-2), SEEK_CUR);
+		    SEQ_Map_Seek(seq_fP, (LONG)(-SEQ_params.block_size-2), SEEK_CUR);
 		}
 		else if ((packet & 0x7fff) != 0x7fff)  /* 7fff = last packet */
 		{
@@ -1144,12 +1343,12 @@ register LONG num_packets;
 	{
 	    /* skip over other plugin data to the next/previous block */
 	    if (direction > 0)
-		fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+		SEQ_Dmx_Skip(seq_fP, (INT)packet, (INT)dataP->plugin);
 	    else
-		fseek(seq_fP, (LONG)(-SEQ_params.block_size-2), SEEK_CUR);
+		SEQ_Map_Seek(seq_fP, (LONG)(-SEQ_params.block_size-2), SEEK_CUR);
 	}
 
-	num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+	num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 	if ((i == 0x7fff) && ((packet & 0x8000) == plugin_mask))
 	    i = packet & 0x7fff;
 	num_packets++;
@@ -1164,7 +1363,7 @@ register LONG num_packets;
       if (size > 0)
       {
 	/* Found block, now seek to offset within block */
-	fseek(seq_fP, (LONG)offset, SEEK_CUR);
+	SEQ_Map_Seek(seq_fP, (LONG)offset, SEEK_CUR);
 	bytes_remaining = (UWORD)(SEQ_params.block_size - 2 - offset);
 
 	while (size > 0)
@@ -1176,12 +1375,12 @@ register LONG num_packets;
 
 	    /* Read the bytes into the supplied buffer */
 	    if (read == TRUE)
-		num_read = fread((CHAR *)bufferP, sizeof(BYTE), 
+		num_read = SEQ_Map_Read((CHAR *)bufferP, sizeof(BYTE), 
 				    (size_t)count, seq_fP);
 	    else
 	    {
 		num_read = (LONG)count;
-		fseek(seq_fP, (LONG)count, SEEK_CUR);
+		SEQ_Map_Seek(seq_fP, (LONG)count, SEEK_CUR);
 	    }
 
 	    if (num_read != (UWORD)count)
@@ -1199,21 +1398,37 @@ register LONG num_packets;
 	    {
 		bufferP += count;
 
+		/* Take the whole blocks that follow in one go, leaving
+		   the last one to be read below */
+		last_i = i;
+		blocks = SEQ_Map_Read_Blocks(seq_fP,
+				(read == TRUE) ? bufferP : (BYTE *)NULL,
+				(size-1) / (LONG)(SEQ_params.block_size-2),
+				(INT)plugin_mask, &last_i);
+		if (blocks > 0)
+		{
+		    i = last_i;
+		    count = (UWORD)(SEQ_params.block_size - 2);
+		    size -= blocks * count;
+		    dataP->bytes_read += blocks * count;
+		    bufferP += blocks * count;
+		}
+
 		if (i == 0x7ffe)
 		    i = 1;	/* wrap */
 		else if (i != 0x7fff)
 		    ++i;
 
 		/* Read the beginning of the next block */
-		num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+		num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 		if (i == 0x7fff)
 		    i = packet & 0x7fff;
 
 		while ( ((packet & 0x8000) != plugin_mask) && (num_read != 0))
 		{
 		    /* skip to the next block */
-		    fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
-		    num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+		    SEQ_Dmx_Skip(seq_fP, (INT)packet, (INT)dataP->plugin);
+		    num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 		    num_packets++;
 		}
 
@@ -1242,10 +1457,10 @@ register LONG num_packets;
 	} /* WHILE */
 
 	/* Seek back to the beginning of this block: offset+2 */
-	fseek(seq_fP, (LONG)(-offset-2), SEEK_CUR);
+	SEQ_Map_Seek(seq_fP, (LONG)(-offset-2), SEEK_CUR);
       }
       else
-	fseek(seq_fP, (LONG)(-2), SEEK_CUR);
+	SEQ_Map_Seek(seq_fP, (LONG)(-2), SEEK_CUR);
 
       /* Update the params so we know where we left off */
 	dataP->block_offset = offset;
@@ -1258,7 +1473,7 @@ register LONG num_packets;
     else
     {
 	printf("Could not find requested block in data file.\n");
-	fseek(seq_fP, SEQ_params.seg_offset, SEEK_SET);
+	SEQ_Map_Seek(seq_fP, SEQ_params.seg_offset, SEEK_SET);
 	return (FALSE);
     }
 
@@ -1384,13 +1599,19 @@ BOOL SEQ_Read_Blocks_Desc(seq_fP, bufferP, plugin, size, offset)
     UWORD i;
     UWORD bytes_remaining;
     UWORD count;
+    BOOL  status;
+
+    /* Go straight to the block if the file has a packet index */
+    if (SEQ_Index_Read_Desc(seq_fP, bufferP, (INT)plugin, size, offset,
+							&status) == TRUE)
+	return (status);
 
     /* Setup the mask to determine which blocks are significant */
     plugin_mask = (plugin << 15);
 
     /* Advance to the nearest whole block before the required data */
-    fseek(seq_fP, 0L, SEEK_SET);
-    num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+    SEQ_Map_Seek(seq_fP, 0L, SEEK_SET);
+    num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 
     if (SEQ_options.debug == 1)
 	printf("Found packet 0x%04x...mask = 0x%04x\n", packet, plugin_mask);
@@ -1418,8 +1639,8 @@ BOOL SEQ_Read_Blocks_Desc(seq_fP, bufferP, plugin, size, offset)
 	}
 
 	/* skip to the next block */
-	fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
-	num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+	SEQ_Map_Seek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+	num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 
 	if (SEQ_options.debug == 1)
 	    printf("Found packet 0x%04x...offset = %ld\n", packet,offset);
@@ -1429,7 +1650,7 @@ BOOL SEQ_Read_Blocks_Desc(seq_fP, bufferP, plugin, size, offset)
     if (num_read != 0)
     {
 	/* Found block, now seek to offset within block */
-	fseek(seq_fP, (LONG)offset, SEEK_CUR);
+	SEQ_Map_Seek(seq_fP, (LONG)offset, SEEK_CUR);
 	bytes_remaining = (UWORD)(SEQ_params.block_size - 2 - offset);
 
 	while (size > 0)
@@ -1439,7 +1660,7 @@ BOOL SEQ_Read_Blocks_Desc(seq_fP, bufferP, plugin, size, offset)
 	    else
 		count = bytes_remaining;
 
-	    num_read = fread((CHAR *)bufferP, sizeof(BYTE), 
+	    num_read = SEQ_Map_Read((CHAR *)bufferP, sizeof(BYTE), 
 				    (size_t)count, seq_fP);
 
 	    if (num_read != (UWORD)count)
@@ -1460,13 +1681,13 @@ BOOL SEQ_Read_Blocks_Desc(seq_fP, bufferP, plugin, size, offset)
 	    if (size > 0)
 	    {
 		/* Read the beginning of the next block */
-		num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+		num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 
 		while ( ((packet & 0x8000) != plugin_mask) && (num_read != 0))
 		{
 		    /* skip to the next block */
-		    fseek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
-		    num_read = fread((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
+		    SEQ_Map_Seek(seq_fP, (LONG)(SEQ_params.block_size-2), SEEK_CUR);
+		    num_read = SEQ_Map_Read((CHAR *)&packet, sizeof(UWORD), 1, seq_fP);
 		}
 
 		if (num_read == 0)
@@ -1530,7 +1751,13 @@ VOID SEQ_Output_Seg(segno, status, acq_dataP, filt_dataP, paramsP)
 
     Machine dependencies: 
 			 
-    Notes: 
+    Notes: Compensated points are printed as SEQ_Compensate() left them
+	   in filt_dataP->valuesP and timesP when the block was filtered.
+
+	   With SEQ_OUTPUT_BUFFER the points go into the buffer of
+	   SEQ_Decode() instead, as many as fit: raw points as WORDs
+	   (<< 8, as printed), corrected points as WORDs, compensated
+	   ones as FLOATs.
 
     Procedure:
 
@@ -1543,23 +1770,13 @@ VOID SEQ_Output_Seg(segno, status, acq_dataP, filt_dataP, paramsP)
     UWORD corr_limit;
     CHAR  format[16];
     CHAR  time_fmt[16];
-    CHAR  filename[32];
     WORD  p;
     WORD  c;
     register BYTE *buf_bP;
     register WORD *buf_wP;
     register UWORD j;
-
-    static DOUBLE time;
-    static WORD file_ext[MAX_PLUGINS][MAX_CHANNELS] = {
-	-1,-1,-1,-1,			/* Plugin A */
-	-1,-1,-1,-1			/* Plugin B */
-    };
-
-    static LONG old_segno[MAX_PLUGINS][MAX_CHANNELS] = {
-	-1,-1,-1,-1,			/* Plugin A */
-	-1,-1,-1,-1			/* Plugin B */
-    };
+    FILE  *outP;
+    DOUBLE time;
 
     if (SEQ_options.debug == 2)
     	return;
@@ -1587,42 +1804,68 @@ VOID SEQ_Output_Seg(segno, status, acq_dataP, filt_dataP, paramsP)
     {
 	/* If first segment, write the descriptor to a created file */
 	/* else append this block of data to the end of the opened file */
+	/* (a thread of -j writes to its output, seq_job.c) */
 	if (status & SEQ_FIRST_BLOCK)
 	{
-	    if (segno != old_segno[p][c])
-	    {
-		old_segno[p][c] = segno;
-		++file_ext[p][c];
-	    }
-	}
-
-	if (status & SEQ_FIRST_BLOCK)
-	{
-	    sprintf(filename, "trace_%c%d.%03d", p+'a', c+1, file_ext[p][c]);
-	    if ((out_fP = fopen(filename,"wb")) == NULL)
-	    {
-		printf("Could not open file %s for writing.\n", filename);
-		EXIT
-	    }
+	    if (SEQ_ctxP->spool_fP != NULL)
+		SEQ_ctxP->out_fP = SEQ_ctxP->spool_fP;
+	    else
+		SEQ_ctxP->out_fP = SEQ_Open_Trace(p, c, segno);
 
 	    /* Write the corrected descriptor to a file */
 	    fwrite(PCW_Waveform[p][c], sizeof(BYTE), (size_t)SEQ_desc_size, 
-					out_fP);
+					SEQ_ctxP->out_fP);
 	}
-	fwrite(filt_dataP->corrP, sizeof(WORD), (size_t)corr_limit, out_fP);
+	fwrite(filt_dataP->corrP, sizeof(WORD), (size_t)corr_limit,
+					SEQ_ctxP->out_fP);
 
 	if (status & SEQ_LAST_BLOCK)
 	{
-	    fclose(out_fP);
-	    out_fP = NULL;
+	    if (SEQ_ctxP->out_fP != SEQ_ctxP->spool_fP)
+		fclose(SEQ_ctxP->out_fP);
+	    SEQ_ctxP->out_fP = NULL;
 	}
     }
+    else if (SEQ_options.output.type == SEQ_OUTPUT_BUFFER)
+    {
+	if (status & SEQ_FIRST_BLOCK)
+	    SEQ_ctxP->decode_count = 0L;
+
+	/* Count every point, keep those that fit */
+	i = SEQ_ctxP->decode_count;
+	if (SEQ_options.format == SEQ_FORMAT_RAW)
+	{
+	    buf_bP = acq_dataP->bufP;
+	    for (j=0; j < raw_limit; ++j, ++i)
+		if (i < SEQ_ctxP->decode_size)
+		    ((WORD *)SEQ_ctxP->decodeP)[i] = buf_bP[j] << 8;
+	}
+	else if (SEQ_options.format == SEQ_FORMAT_CORRECTED)
+	{
+	    buf_wP = filt_dataP->corrP;
+	    for (j=0; j < corr_limit; ++j, ++i)
+		if (i < SEQ_ctxP->decode_size)
+		    ((WORD *)SEQ_ctxP->decodeP)[i] = buf_wP[j];
+	}
+	else  /* SEQ_FORMAT_COMPENSATED, by SEQ_Compensate() */
+	{
+	    for (j=0; j < corr_limit; ++j, ++i)
+		if (i < SEQ_ctxP->decode_size)
+		    ((FLOAT *)SEQ_ctxP->decodeP)[i] = filt_dataP->valuesP[j];
+	}
+	SEQ_ctxP->decode_count = i;
+    }
     else  /* SEQ_OUTPUT_SCREEN */
     {
 	if (status & SEQ_FIRST_BLOCK)
 	{
-	    time = paramsP->seg_start_time + paramsP->horizontal_offset;
+	    SEQ_ctxP->time = paramsP->seg_start_time +
+					    paramsP->horizontal_offset;
 	}
+	time = SEQ_ctxP->time;
+
+	/* A thread of -j prints to its output, seq_job.c */
+	outP = (SEQ_ctxP->spool_fP != NULL) ? SEQ_ctxP->spool_fP : stdout;
 
 	if (SEQ_options.output.format == SEQ_SCREEN_OUTPUT_1)
 	{
@@ -1632,7 +1875,7 @@ VOID SEQ_Output_Seg(segno, status, acq_dataP, filt_dataP, paramsP)
 		buf_bP = acq_dataP->bufP;
 		for (j=0; j < raw_limit; j++)
 		{
-		    printf(format, buf_bP[j] << 8);
+		    fprintf(outP, format, buf_bP[j] << 8);
 		}
 	    }
 	    else if (SEQ_options.format == SEQ_FORMAT_CORRECTED)
@@ -1640,16 +1883,14 @@ VOID SEQ_Output_Seg(segno, status, acq_dataP, filt_dataP, paramsP)
 		buf_wP = filt_dataP->corrP;
 		for (j=0; j < corr_limit; ++j)
 		{
-		    printf(format, buf_wP[j]);
+		    fprintf(outP, format, buf_wP[j]);
 		}
 	    }
-	    else  /* SEQ_FORMAT_COMPENSATED */
+	    else  /* SEQ_FORMAT_COMPENSATED, by SEQ_Compensate() */
 	    {
-		buf_wP = filt_dataP->corrP;
 		for (j=0; j < corr_limit; ++j)
 		{
-		    printf(format, (paramsP->vertical_gain * buf_wP[j]) -
-				    paramsP->vertical_offset);
+		    fprintf(outP, format, filt_dataP->valuesP[j]);
 		}
 	    }
 	}
@@ -1661,7 +1902,7 @@ VOID SEQ_Output_Seg(segno, status, acq_dataP, filt_dataP, paramsP)
 		buf_bP = acq_dataP->bufP;
 		for (j=0; j < raw_limit; j++)
 		{
-		    printf(format, time, buf_bP[j] << 8);
+		    fprintf(outP, format, time, buf_bP[j] << 8);
 		    time += paramsP->time_per_point;
 		}
 	    }
@@ -1670,23 +1911,68 @@ VOID SEQ_Output_Seg(segno, status, acq_dataP, filt_dataP, paramsP)
 		buf_wP = filt_dataP->corrP;
 		for (j=0; j < corr_limit; ++j)
 		{
-		    printf(format, time, buf_wP[j]);
+		    fprintf(outP, format, time, buf_wP[j]);
 		    time += paramsP->time_per_point;
 		}
 	    }
-	    else  /* SEQ_FORMAT_COMPENSATED */
+	    else  /* SEQ_FORMAT_COMPENSATED, by SEQ_Compensate() */
 	    {
-		buf_wP = filt_dataP->corrP;
 		for (j=0; j < corr_limit; ++j)
 		{
-		    printf(format, time, (paramsP->vertical_gain * buf_wP[j]) -
-				    paramsP->vertical_offset);
-		    time += paramsP->time_per_point;
+		    fprintf(outP, format, filt_dataP->timesP[j],
+					    filt_dataP->valuesP[j]);
 		}
 	    }
 	}
+	SEQ_ctxP->time = time;
     }
 }
 
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+FILE *SEQ_Open_Trace(p, c, segno)
+    WORD  p;
+    WORD  c;
+    LONG  segno;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Create the trace_PC.nnn file of a segment of a channel.
+
+    Inputs: p     = plugin
+	    c     = channel
+	    segno = segment number
+
+    Outputs: the file, open for writing
+
+    Notes: The files of a channel are numbered from 000 in the order the
+	   segments are written, a number for every segment. They are made
+	   in SEQ_ctxP->out_dir if there is one (seq_wsp.c).
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Open_Trace() */
+
+    CHAR  filename[sizeof(SEQ_ctxP->out_dir) + 32];
+    FILE  *fP;
+
+    if (segno != SEQ_ctxP->old_segno[p][c])
+    {
+	SEQ_ctxP->old_segno[p][c] = segno;
+	++SEQ_file_ext[p][c];
+    }
+
+    sprintf(filename, "%s%strace_%c%d.%03d", SEQ_ctxP->out_dir,
+	    (SEQ_ctxP->out_dir[0] != EOS) ? "/" : "", p+'a', c+1,
+	    SEQ_file_ext[p][c]);
+    if ((fP = fopen(filename,"wb")) == NULL)
+    {
+	printf("Could not open file %s for writing.\n", filename);
+	EXIT
+    }
+
+    return (fP);
+}
+
 /* -------------------------------------------------------------------- */
 
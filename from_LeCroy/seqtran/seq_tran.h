@@ -11,14 +11,19 @@ Author: Christopher Eck		LeCroy Corporation
 #ifndef SEQ_TRAN_H
 #define SEQ_TRAN_H
 
+#include <stdio.h>
 #include "aagen.h"
 #include "seq_filt.h"
+#include "seq_hdr.h"
          
 /* System definitions based on existing plugins and available memory */
 #define MAX_PLUGINS  	    2
 #define MAX_CHANNELS 	    4
 #define MAX_SEGS	  100	/* Max uncontinuous segs to translate */
 #define MAX_FILTER_SIZE    64	/* Room to copy the extra filter points */
+#define SEQ_FOLLOW_SECS    10	/* Default wait for a file being written */
+#define SEQ_MAX_JOBS	   64	/* Most threads translating segments */
+#define SEQ_MAX_SHARDS	   64	/* Most processes translating shards */
 
 /* Max filter buffer...cannot be less than 63+13=76 */
 #define MAX_BUF_SIZE    16384    /* MUST BE DIVISIBLE BY 4 */
@@ -50,6 +55,13 @@ Author: Christopher Eck		LeCroy Corporation
 #define SEQ_FORMAT_CORRECTED    1	/* correct data with filter coeffs */
 #define SEQ_FORMAT_COMPENSATED  2	/* correct and compensate data */
 
+/* Filter kernels (-k), each instruction set including the ones before */
+#define SEQ_KERNEL_SCALAR	0	/* the original loops only */
+#define SEQ_KERNEL_SSE41	1
+#define SEQ_KERNEL_AVX2		2
+#define SEQ_KERNEL_AVX512	3
+#define SEQ_KERNEL_AUTO		4	/* the best the processor has */
+
 /* Definitions of which block is being processed */
 #define SEQ_FIRST_BLOCK		(1 << 0)
 #define SEQ_NEXT_BLOCK		(1 << 1)
@@ -63,7 +75,7 @@ Author: Christopher Eck		LeCroy Corporation
 	 + ((DOUBLE)((ts.lmw * 65536.0) + ts.llw)))		  	\
 
 #define EXIT								\
-	exit(1);
+	SEQ_Exit();
 
 #define PAUSE1								\
     if (kbhit())							\
@@ -74,6 +86,19 @@ Author: Christopher Eck		LeCroy Corporation
 	EXIT								\
     }
 
+/* Offsets into the data file. Captures can be larger than a LONG can
+   address; with SEQ_LARGE_FILES (POSIX hosts with fseeko()/ftello())
+   offsets are 64 bits wide. */
+#ifdef SEQ_LARGE_FILES
+typedef long long SEQ_OFFSET;
+#else
+typedef LONG SEQ_OFFSET;
+#endif /* SEQ_LARGE_FILES */
+
+/* File offset of BYTE byte of block number n of the data file */
+#define SEQ_BLOCK_POS(n, byte)						\
+	((SEQ_OFFSET)(n) * SEQ_params.block_size + (byte))
+
 typedef union IWORD		/* Intel word format */
 {
   struct
@@ -110,6 +135,7 @@ typedef struct SEQ_ACQ_PARAMS {
 
 #define SEQ_OUTPUT_FILE	    0	/* output data to a file */
 #define SEQ_OUTPUT_SCREEN   1	/* output data to the screen */
+#define SEQ_OUTPUT_BUFFER   2	/* to the caller's buffer, SEQ_Decode() */
 
 #define SEQ_SCREEN_OUTPUT_1 0	/* output screen data only in 1 column */
 #define SEQ_SCREEN_OUTPUT_2 1	/* output screen time,data in 2 columns */
@@ -143,6 +169,17 @@ typedef struct SEQ_OPTIONS {
     BYTE format;		/* format of output data: RAW,COR,COM */
     CHAR prt_fmt[8];		/* %d, %g, or %04x output format */
     DEST output;		/* output format: file, 1 col, 2 cols */
+    BOOL build_index;		/* Build packet index if none */
+    BOOL stream;		/* Read the data file forward only */
+    INT  follow;		/* Secs to wait for a file being written */
+    BOOL resume;		/* Carry on from the last run (.sck) */
+    BOOL build_cache;		/* Build columnar cache (.col) if none */
+    INT  kernels;		/* Filter kernels to use (SEQ_KERNEL_...) */
+    INT  jobs;			/* Threads translating segments (-j) */
+    BOOL pipeline;		/* Read, filter and write in 3 threads */
+    BOOL file_list;		/* The file is a list of data files (-b) */
+    INT  shards;		/* Processes translating shards (-m) */
+    INT  shard;			/* Shard translated here (-n), -1 = all */
 #ifdef RIS
     CHAR process_plugin;	/* plugin to process */
     CHAR process_chan;		/* channel to process */
@@ -161,7 +198,7 @@ typedef struct SEQ_PARAMS {
     BYTE last_plugin;			/* Last plugin present */
     BYTE last_channel[MAX_PLUGINS];	/* Last channel present per plugin */
     LONG block_size;			/* Block size of each packet */
-    LONG seg_offset;			/* Absolute offset to start of segs */
+    SEQ_OFFSET seg_offset;		/* Absolute offset to start of segs */
     BOOL last_packet[MAX_PLUGINS];	/* Flag set if processed last packet */
 #ifdef RIS
     UWORD *waveP[MAX_PLUGINS][MAX_CHANNELS];
@@ -192,14 +229,17 @@ typedef struct SEQ_ACQ_DATA {
 typedef struct SEQ_FILTER_DATA {
 
     BYTE   *rawP;		/* ptr to raw BYTES to correct */
-    WORD   *p91P;		/* ptr to 7291 filter buffer */
-    WORD   *p91_baseP;		/* start of memory for 7291 filter buffer */
     WORD   *corrP;		/* ptr to corrected WORDs */
     FILTER *paramsP;
     LONG   num_bytes;
     LONG   size;		/* amt of data in corrP */
-    LONG   size_91;		/* amt of data in p91P */
+    LONG   size_91;		/* amt of raw data to flash filter in 7291 mode */
     LONG   array_size;		/* corrected array size */
+    struct WAVE_PARAMS *waveP;	/* gain, offset and times of the segment */
+    FLOAT  *valuesP;		/* corrected points compensated, or NULL */
+    DOUBLE *values64P;		/* the same in DOUBLEs, or NULL */
+    DOUBLE *timesP;		/* time of each of these points, or NULL */
+    DOUBLE time;		/* time of the next point */
 
 } SEQ_FILTER_DATA;
 
@@ -213,8 +253,104 @@ typedef struct WAVE_PARAMS {
 
 } WAVE_PARAMS;
 
-extern SEQ_OPTIONS SEQ_options;
-extern SEQ_PARAMS  SEQ_params;
+/* Modules with state of their own in a context, see SEQ_Module() */
+#define SEQ_MOD_MAP		0	/* seq_map.c */
+#define SEQ_MOD_INDEX		1	/* seq_idx.c */
+#define SEQ_MOD_DIR		2	/* seq_dir.c */
+#define SEQ_MOD_DMX		3	/* seq_dmx.c */
+#define SEQ_MOD_COL		4	/* seq_col.c */
+#define SEQ_MOD_CKPT		5	/* seq_ckp.c */
+#define SEQ_MOD_AHEAD		6	/* seq_ahd.c */
+#define SEQ_MOD_BATCH		7	/* seq_bat.c */
+#define SEQ_MOD_FIR		8	/* seq_filt.c */
+#define SEQ_MOD_JOBS		9	/* seq_job.c */
+#define SEQ_MOD_PIPE		10	/* seq_pip.c */
+#define SEQ_MOD_SHARD		11	/* seq_shd.c */
+#define SEQ_MOD_LOOP		12	/* seq_tran.c */
+#define SEQ_MODULES		13
+
+/* Everything a translation works on: the options, the data file, its
+   descriptors and filter coefficients, how far the output has got, and
+   the state of each module. The translator works on the current context,
+   SEQ_ctxP (see seq_ctx.c), so that several data files can be translated
+   side by side, each in a thread with a context of its own. */
+typedef struct SEQ_CONTEXT {
+
+    SEQ_OPTIONS options;
+    SEQ_PARAMS  params;
+    FILE   *seq_fP;			/* the data file, SEQ_Open() */
+    CHAR   filename[80];		/* its name */
+    BYTE   plugin_field;		/* plugins asked for */
+    BYTE   channel_field[MAX_PLUGINS]; /* channels asked for */
+
+    /* Descriptors and filter coefficients of each channel */
+    FILTER filter[MAX_PLUGINS][MAX_CHANNELS];
+    struct PCW_BLOCK *blockP[MAX_PLUGINS][MAX_CHANNELS];
+    BYTE   *waveformP[MAX_PLUGINS][MAX_CHANNELS];
+    BYTE   waveform[MAX_PLUGINS][MAX_CHANNELS][800];
+    WORD   desc_size;			/* size in BYTEs of descriptor */
+    LONG   array_size[MAX_PLUGINS];	/* WAVE_ARRAY_1 as acquired */
+    struct PCW_OFFSETS offsets;		/* PCW_Load_Block_Offsets() */
+    BOOL   translated[MAX_PLUGINS][MAX_CHANNELS]; /* SEQ_Init_Descriptor() */
+
+    /* How far the translation has got */
+    DOUBLE first_seg_time[MAX_PLUGINS];	/* time stamp of segment 1 */
+    WORD   check_index[MAX_PLUGINS][MAX_CHANNELS][MAX_SEG_TYPES];
+    WORD   old_time;			/* SEQ_update_time() */
+    LONG   shard_end[MAX_PLUGINS];	/* last segment of a shard, 0 = all,
+					   -1 = none */
+    LONG   segs_done;			/* channels of segments translated */
+    DOUBLE samples_done;		/* and their samples */
+
+    /* Where the translated segments go, SEQ_Output_Seg() */
+    FILE   *out_fP;
+    FILE   *spool_fP;			/* a worker's output, seq_job.c */
+    CHAR   out_dir[80];			/* of the trace files, "" = here */
+    WORD   file_ext[MAX_PLUGINS][MAX_CHANNELS]; /* last trace_PC.nnn */
+    LONG   old_segno[MAX_PLUGINS][MAX_CHANNELS];
+    DOUBLE time;			/* of the next point printed */
+    VOID   *decodeP;			/* SEQ_OUTPUT_BUFFER: the buffer */
+    LONG   decode_size;			/* its size in points */
+    LONG   decode_count;		/* points of the segment so far */
+
+    VOID   *moduleP[SEQ_MODULES];	/* state of each module, or NULL */
+
+} SEQ_CONTEXT;
+
+/* The current context, one per thread with SEQ_THREADS, and where
+   SEQ_Exit() returns to in the thread (a jmp_buf, or NULL) */
+#if defined(SEQ_THREADS) && defined(__GNUC__)
+extern __thread SEQ_CONTEXT *SEQ_ctxP;
+extern __thread VOID *SEQ_jumpP;
+#else
+extern SEQ_CONTEXT *SEQ_ctxP;
+extern VOID *SEQ_jumpP;
+#endif
+
+extern SEQ_CONTEXT *SEQ_Context_New();
+extern SEQ_CONTEXT *SEQ_Context_Copy();
+extern VOID        SEQ_Context_Free();
+extern VOID        *SEQ_Module();
+extern VOID        SEQ_Exit();
+extern VOID        SEQ_Lock();
+extern VOID        SEQ_Unlock();
+
+/* State of module id in the current context, made on first use */
+#define SEQ_MODULE(id, type)						\
+	((type *)(SEQ_ctxP->moduleP[id] != NULL ?			\
+		    SEQ_ctxP->moduleP[id] : SEQ_Module(id, sizeof(type))))
+
+/* The translator's variables, in the current context */
+#define SEQ_options	(SEQ_ctxP->options)
+#define SEQ_params	(SEQ_ctxP->params)
+#define SEQ_filter	(SEQ_ctxP->filter)
+#define SEQ_desc_size	(SEQ_ctxP->desc_size)
+#define SEQ_file_ext	(SEQ_ctxP->file_ext)
+#define PCW_blockP	(SEQ_ctxP->blockP)
+#define PCW_waveformP	(SEQ_ctxP->waveformP)
+#define PCW_Waveform	(SEQ_ctxP->waveform)
+#define plugin_field	(SEQ_ctxP->plugin_field)
+#define channel_field	(SEQ_ctxP->channel_field)
 
 #endif /* SEQ_TRAN_H */
 /*------------------------- end of file ----------------------------------*/
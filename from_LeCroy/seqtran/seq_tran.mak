@@ -46,13 +46,29 @@ LINK=link /CO
 # Specify in one place all source modules
 #
 CSOURCES =\
+		seq_main.c\
 		seq_tran.c\
+		seq_ahd.c\
 		seq_args.c\
+		seq_bat.c\
+		seq_ckp.c\
+		seq_col.c\
+		seq_ctx.c\
+		seq_dir.c\
+		seq_dmx.c\
 		seq_filt.c\
+		seq_idx.c\
+		seq_job.c\
+		seq_lib.c\
+		seq_map.c\
 		seq_mtg.c\
+		seq_pip.c\
 		seq_prt.c\
+		seq_shd.c\
 		seq_util.c\
-		seq_wfd.c
+		seq_vec.c\
+		seq_wfd.c\
+		seq_wsp.c
 
 SOURCES = $(CSOURCES)
 
@@ -70,19 +86,98 @@ seq_tran,, /ST:38000
 <
     exepack seq_tran.exe seqtran.exe
 
+# The filter check and timing program (seq_test.c), not part of seqtran
+#
+TOBJS = seq_test.obj seq_ctx.obj seq_filt.obj seq_vec.obj
+
+seq_test.exe : $(TOBJS)
+		$(LINK) $[s,"+",$(TOBJS)], seq_test,, /ST:38000
+    exepack seq_test.exe seqtest.exe
+
+# The library check program (seq_lchk.c), linked like any program that
+# uses seq_lib.c: with the objects of seqtran other than seq_main.obj
+#
+LOBJS =\
+		seq_lchk.obj\
+		seq_tran.obj\
+		seq_ahd.obj\
+		seq_args.obj\
+		seq_bat.obj\
+		seq_ckp.obj\
+		seq_col.obj\
+		seq_ctx.obj\
+		seq_dir.obj\
+		seq_dmx.obj\
+		seq_filt.obj\
+		seq_idx.obj\
+		seq_job.obj\
+		seq_lib.obj\
+		seq_map.obj\
+		seq_mtg.obj\
+		seq_pip.obj\
+		seq_prt.obj\
+		seq_shd.obj\
+		seq_util.obj\
+		seq_vec.obj\
+		seq_wfd.obj\
+		seq_wsp.obj
+
+seq_lchk.exe : $(LOBJS)
+		$(LINK) <@<
+$[s,"+\n",$(LOBJS)],
+seq_lchk,, /ST:38000
+<
+    exepack seq_lchk.exe seqlchk.exe
+
 
 # The source file dependencies
 #
+seq_ahd.obj   :  seq_tran.h
+
+seq_bat.obj   :  seq_filt.h seq_tran.h
+
+seq_ckp.obj   :  seq_tran.h
+
+seq_col.obj   :  seq_tran.h seq_hdr.h
+
+seq_ctx.obj   :  seq_tran.h
+
+seq_dir.obj   :  seq_tran.h seq_hdr.h
+
+seq_dmx.obj   :  seq_tran.h
+
 seq_filt.obj  :  seq_filt.h seq_tran.h
 
+seq_idx.obj   :  seq_tran.h
+
+seq_lchk.obj  :  seq_lib.h
+
+seq_job.obj   :  seq_filt.h seq_tran.h
+
+seq_lib.obj   :  seq_tran.h seq_lib.h
+
+seq_main.obj  :  seq_filt.h seq_hdr.h seq_tran.h
+
+seq_map.obj   :  seq_tran.h
+
 seq_wfd.obj   :  seq_hdr.h
 
+seq_wsp.obj   :  seq_tran.h
+
 seq_mtg.obj   :  seq_hdr.h
 
+seq_pip.obj   :  seq_filt.h seq_tran.h
+
 seq_prt.obj   :  seq_hdr.h
 
+seq_shd.obj   :  seq_tran.h
+
+seq_test.obj  :  seq_filt.h seq_tran.h
+
 seq_util.obj  :  seq_tran.h seq_hdr.h
 
+seq_vec.obj   :  seq_filt.h seq_tran.h
+
 seq_tran.obj  :  seq_filt.h seq_hdr.h seq_tran.h
 
 seq_args.obj  :  seq_tran.h
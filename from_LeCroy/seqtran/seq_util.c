@@ -17,14 +17,20 @@ Author: Gabriel Goodman		LeCroy Corporation
 #include "seq_hdr.h"
 #include "seq_tran.h"
 
-extern struct PCW_BLOCK *PCW_blockP[MAX_PLUGINS][MAX_CHANNELS];
-extern BYTE   	 	*PCW_waveformP[MAX_PLUGINS][MAX_CHANNELS];
 extern VOID    		*PCW_Find_Value_From_Name();
 extern VOID   		SEQ_update_time();
 
 #define MAX_TIME 3
 
+/* Where the blocks of the last descriptor are, in the current context */
+#define regular_blocks	(SEQ_ctxP->offsets.regular_blocks)
+#define array_blocks	(SEQ_ctxP->offsets.array_blocks)
+
 #ifndef RIS
+
+/* Selection of each plugin/channel that SEQ_Check_Seg() has got to */
+#define seq_check_index	(SEQ_ctxP->check_index)
+
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
 
 VOID SEQ_Init_Descriptor(acq_dataP, filt_dataP, wave_dataP, fine_count)
@@ -74,11 +80,6 @@ VOID SEQ_Init_Descriptor(acq_dataP, filt_dataP, wave_dataP, fine_count)
 struct PCW_BLOCK *blockP;
     BYTE   	 *waveformP;
 
-    static BOOL translated[MAX_PLUGINS][MAX_CHANNELS] = {
-	FALSE,FALSE,FALSE,FALSE,		/* Plugin A */
-	FALSE,FALSE,FALSE,FALSE			/* Plugin B */
-    };
-
     p = acq_dataP->plugin;
     c = acq_dataP->channel;
     blockP = PCW_blockP[p][c];
@@ -86,9 +87,9 @@ struct PCW_BLOCK *blockP;
     data_count = filt_dataP->array_size;
 
     /* Update the basic parameters once only */
-    if (translated[p][c] == FALSE)
+    if (SEQ_ctxP->translated[p][c] == FALSE)
     {
-	translated[p][c] = TRUE;
+	SEQ_ctxP->translated[p][c] = TRUE;
 
 	/* Change the record type to be single sweep for read-back into 7200A */
 	    wP = (WORD *)PCW_Find_Value_From_Name(waveformP, (LONG)0, blockP,
@@ -220,11 +221,6 @@ BOOL SEQ_Check_Seg(p, c, segno, time, keep_goingP)
 --------------------------------------------------------------------------*/
 {   /* SEQ_Check_Seg() */
 
-    static WORD index[MAX_PLUGINS][MAX_CHANNELS][MAX_SEG_TYPES] = {
-      0,0, 0,0, 0,0, 0,0,   /* Plugin A, Chan 1..4, bot seg types */
-      0,0, 0,0, 0,0, 0,0    /* Plugin B, Chan 1..4, bot seg types */
-    };
-
     SEGS *segP,*seg1P,*seg2P;
     BOOL process;
     BOOL single_seg;
@@ -237,13 +233,20 @@ BOOL SEQ_Check_Seg(p, c, segno, time, keep_goingP)
     /* Check this plugin/chan segment against any the user may have selected */
     if (process == FALSE)
     {
-	segP = &SEQ_options.seg[p][c][SEQ_SEGNO][index[p][c][SEQ_SEGNO]];
+	segP = &SEQ_options.seg[p][c][SEQ_SEGNO]
+				    [seq_check_index[p][c][SEQ_SEGNO]];
 	if (segP->select.n.start != -1L)
 	{
-	    if (segno > segP->select.n.end)
-		++index[p][c][SEQ_SEGNO];
+	    /* Pass all selections that end before this segment; the caller
+	       may have jumped over several segments at once */
+	    while ((segP->select.n.start != -1L) &&
+		   (segno > segP->select.n.end))
+	    {
+		++seq_check_index[p][c][SEQ_SEGNO];
+		segP = &SEQ_options.seg[p][c][SEQ_SEGNO]
+					    [seq_check_index[p][c][SEQ_SEGNO]];
+	    }
 
-	    segP = &SEQ_options.seg[p][c][SEQ_SEGNO][index[p][c][SEQ_SEGNO]];
 	    if (segP->select.n.start != -1L)
 	    {
 		if ((segP->select.n.start <= segno) &&
@@ -257,19 +260,19 @@ BOOL SEQ_Check_Seg(p, c, segno, time, keep_goingP)
 
     if (process == FALSE)
     {
-	segP = &SEQ_options.seg[p][c][SEQ_TIME][index[p][c][SEQ_TIME]];
+	segP = &SEQ_options.seg[p][c][SEQ_TIME]
+				    [seq_check_index[p][c][SEQ_TIME]];
 	if (segP->select.t.start != (DOUBLE)-1)
 	{
-	    if (segP->select.t.start == segP->select.t.end)
-		single_seg = TRUE;
-	    else
+	    single_seg = (segP->select.t.start == segP->select.t.end);
+	    while ((single_seg == FALSE) && (time > segP->select.t.end))
 	    {
-		single_seg = FALSE;
-		if (time > segP->select.t.end)
-		    ++index[p][c][SEQ_TIME];
+		++seq_check_index[p][c][SEQ_TIME];
+		segP = &SEQ_options.seg[p][c][SEQ_TIME]
+					    [seq_check_index[p][c][SEQ_TIME]];
+		single_seg = (segP->select.t.start == segP->select.t.end);
 	    }
 
-	    segP = &SEQ_options.seg[p][c][SEQ_TIME][index[p][c][SEQ_TIME]];
 	    if (segP->select.t.start != (DOUBLE)-1)
 	    {
 		if ((segP->select.t.start <= time) &&
@@ -281,7 +284,7 @@ BOOL SEQ_Check_Seg(p, c, segno, time, keep_goingP)
 		{
 		    /* Process the first seg after a single specified time */
 		    process = TRUE;
-		    ++index[p][c][SEQ_TIME];
+		    ++seq_check_index[p][c][SEQ_TIME];
 		}
 	    }
 	}
@@ -295,8 +298,10 @@ BOOL SEQ_Check_Seg(p, c, segno, time, keep_goingP)
 	{
 	    for (c=0; c <= SEQ_params.last_channel[p]; ++c)
 	    {
-		seg1P=&SEQ_options.seg[p][c][SEQ_TIME][index[p][c][SEQ_TIME]];
-		seg2P=&SEQ_options.seg[p][c][SEQ_SEGNO][index[p][c][SEQ_SEGNO]];
+		seg1P=&SEQ_options.seg[p][c][SEQ_TIME]
+					    [seq_check_index[p][c][SEQ_TIME]];
+		seg2P=&SEQ_options.seg[p][c][SEQ_SEGNO]
+					    [seq_check_index[p][c][SEQ_SEGNO]];
 
 		if ((SEQ_options.test_mode == TRUE) ||
 		    (SEQ_options.print_times == TRUE) ||
@@ -315,6 +320,28 @@ BOOL SEQ_Check_Seg(p, c, segno, time, keep_goingP)
 
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
 
+WORD *SEQ_Check_Index(p, c)
+  BYTE   p;
+  BYTE   c;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Give access to how far SEQ_Check_Seg() has got through the
+		selections of a plugin/channel, so that a later run can
+		carry on from there (seq_ckp.c).
+
+    Outputs: pointer to the MAX_SEG_TYPES selection indexes, SEQ_SEGNO
+		and SEQ_TIME
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Check_Index() */
+
+    return (seq_check_index[p][c]);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
 VOID SEQ_diagnostic(seq_fP, acq_dataP, filt_dataP, size)
     FILE  	  *seq_fP;
     SEQ_ACQ_DATA  *acq_dataP;
@@ -773,7 +800,7 @@ VOID SEQ_update_time(update, total, left)
 
     Machine dependencies: 
 			 
-    Notes:
+    Notes: Quiet when decoding into a buffer (SEQ_Decode()).
 
     Procedure:
 
@@ -783,29 +810,31 @@ VOID SEQ_update_time(update, total, left)
 
     FLOAT percentage;
     struct dostime_t time;
-    static WORD  old_time;
+
+    if (SEQ_options.output.type == SEQ_OUTPUT_BUFFER)
+	return;
 
     if (update == FALSE)
     {
 	_dos_gettime(&time);
-	old_time = time.second;
+	SEQ_ctxP->old_time = time.second;
     }
     else  /* Update the percentage done so far */
     {
 	_dos_gettime(&time);
-	if (time.second < old_time)
+	if (time.second < SEQ_ctxP->old_time)
 	{
-	    if ((time.second+60-old_time) > MAX_TIME)
+	    if ((time.second+60-SEQ_ctxP->old_time) > MAX_TIME)
 	    {
-		old_time = time.second;
+		SEQ_ctxP->old_time = time.second;
 		percentage = (FLOAT)(
 		   ((FLOAT)(total - left) / (FLOAT)total) * 100.0);
 		fprintf(stderr, "%d%%\r", (WORD)percentage);
 	    }
 	}
-	else if ((time.second - old_time) > MAX_TIME)
+	else if ((time.second - SEQ_ctxP->old_time) > MAX_TIME)
 	{
-	    old_time = time.second;
+	    SEQ_ctxP->old_time = time.second;
 	    percentage = (FLOAT)(
 	       ((FLOAT)(total - left) / (FLOAT)total) * 100.0);
 	    fprintf(stderr, "%d%%\r", (WORD)percentage);
@@ -0,0 +1,1160 @@
+/************************** seq_vec.c **************************************
+
+Vector versions of the correction filters in seq_filt.c.
+
+SEQ_fir() computes every corrected point on its own: up to 13 WORD
+coefficients times BYTE samples, with the coefficient row picked through
+the flash index table for every point. Below 2 GSa/s the row only depends
+on the point's position modulo 4, so a vector of consecutive points always
+uses the same rows in the same lane order. The rows are therefore laid out
+once per block in a bank of coefficient pairs in lane order, and the
+points are computed 8 (SSE4.1) or 16 (AVX2) at a time with pmaddwd: the
+samples are widened to 16 bits, each pair of taps is interleaved with the
+next older sample and multiplied and added in one instruction into 32 bit
+sums, exactly as the scalar loop sums them.
+
+The limits and the DSP rounding are applied to the sums as min/max and
+shifts: CA_OVERFLOW and CA_UNDERFLOW are multiples of 128 that round to
+OVERFLOW and UNDERFLOW themselves, so clamping the sum first gives what
+the comparisons in SEQ_fir() give. The results are bit for bit those of
+the scalar code.
+
+At 2 GSa/s the two channels are interleaved and each point is filtered
+with every other sample before it, with the row now depending on the
+point's position modulo 8. SEQ_Vec_Fir_Interleaved() needs no separate
+deinterleaving for this: the samples for a tap are loaded from where that
+tap starts, so every lane walks back through its own channel, and the
+lanes of the lower and upper half of each group of 8 points take their
+bank of rows from phases 0-3 and 4-7. Above POS_SATURATION the point is
+set to SATURATION, as in SEQ_fir().
+
+The 63 tap 7291 filter that follows at 2 GSa/s is the most expensive
+stage: WORD coefficients times WORD points. SEQ_Vec_Fir_7291() does it
+the same way, the pair of taps broadcast to every lane, 16 (AVX2) or 32
+(AVX-512) points at a time, in 32 bit sums. The scalar loop sums in a
+LONG, so a filter whose coefficients could take a sum past 32 bits (the
+magnitudes adding up to more than SEQ_VEC_SUM_91) is left to it. The
+7291 filters of the 7200A come nowhere near that. CA1_OVERFLOW and
+CA1_UNDERFLOW round to OVERFLOW and UNDERFLOW as well, so again min/max
+and shifts give the scalar results.
+
+Segments of a few hundred points spend much of their time outside the
+vector loops: laying out the bank, the points before the first full
+vector and after the last. SEQ_Vec_Fir_Batch() filters SEQ_BATCH such
+segments of one channel at once instead (seq_bat.c gathers them), with a
+lane per segment: the samples are transposed so that a vector holds the
+same point of every segment, each lane has the rows of its own segment's
+last flash, and every point of the segments is a whole vector. Only AVX2
+does this faster than a segment at a time, and only up to a hundred and
+some points; SSE4.1 hardly ever does.
+
+SEQ_Vec_Compensate() puts the corrected points of a block in volts right
+after they are filtered, 8 (AVX2) or 4 (SSE4.1) at a time: the WORDs are
+widened to FLOATs, multiplied by the gain and the offset taken off, each
+a single rounding as in the scalar expression, so again the values are
+the same. The DOUBLE values are done the same way in DOUBLEs.
+
+The kernels are only compiled with SEQ_SIMD defined. With gcc or clang
+on x86 every kernel is compiled, each for its own instruction set, and
+SEQ_Vec_Init() binds the best ones the processor has when the program
+starts (or those asked for with -k), so one binary runs at full speed
+on any machine. Other compilers only get the kernels for the instruction
+sets they were told to generate code for (SSE4.1, AVX2, AVX-512). With
+no kernel, and for the points left over at the end of a block, SEQ_fir()
+and SEQ_fir_7291() do the work.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "seq_filt.h"
+#include "seq_tran.h"
+
+#if defined(SEQ_SIMD) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SEQ_VEC_SSE41
+#define SEQ_VEC_AVX2
+#define SEQ_VEC_AVX512
+#define SEQ_VEC_CPUID				/* ask the processor */
+#define SEQ_VEC_TARGET(isa)	__attribute__((target(isa)))
+#else
+
+#if defined(SEQ_SIMD) && defined(__SSE4_1__)
+#include <smmintrin.h>
+#define SEQ_VEC_SSE41
+#endif
+
+#if defined(SEQ_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define SEQ_VEC_AVX2
+#endif
+
+#if defined(SEQ_SIMD) && defined(__AVX512BW__)
+#define SEQ_VEC_AVX512
+#endif
+
+#define SEQ_VEC_TARGET(isa)
+#endif
+
+/* -------------------------------------------------------------------- */
+
+/* Limits of the flash filter sums, see seq_filt.c */
+#define CA_OVERFLOW  ((long) 2080768)        /*  0x7f00 <<  6 */
+#define CA_UNDERFLOW ((long)-2097152)        /* -0x8000 <<  6 */
+
+#define POS_SATURATION ((long) 2097088)      /*  0x7fff <<  6 */
+
+#define SATURATION  0x7fff
+
+/* Limits of the 7291 filter sums */
+#define CA1_OVERFLOW  ((long) 532676608)     /*  0x7f00 << 14 */
+#define CA1_UNDERFLOW ((long)-536870912)     /* -0x8000 << 14 */
+
+/* Pairs of taps of the longest flash filter (13 coefficients) */
+#define SEQ_VEC_PAIRS	7
+
+/* Pairs of taps of the longest 7291 filter (64 coefficients) */
+#define SEQ_VEC_PAIRS_91	32
+
+/* Most the magnitudes of the 7291 coefficients may add up to, for any
+   sum of points (-32768..32767) times them to fit in 32 bits */
+#define SEQ_VEC_SUM_91	65535L
+
+static CHAR *seq_vec_names[] = { "scalar", "sse4.1", "avx2", "avx512" };
+
+/* The kernels bound by SEQ_Vec_Init(), NULL if none */
+static LONG (*seq_vec_firP)() = NULL;
+static LONG (*seq_vec_interleavedP)() = NULL;
+static LONG (*seq_vec_7291P)() = NULL;
+static LONG (*seq_vec_batchP)() = NULL;
+static LONG (*seq_vec_compP)() = NULL;
+
+static INT  seq_vec_cpu();
+static VOID seq_vec_bank();
+
+#ifdef SEQ_VEC_SSE41
+static LONG seq_vec_fir_sse41();
+static LONG seq_vec_interleaved_sse41();
+static LONG seq_vec_comp_sse41();
+#endif
+#ifdef SEQ_VEC_AVX2
+static LONG seq_vec_fir_avx2();
+static LONG seq_vec_interleaved_avx2();
+static LONG seq_vec_7291_avx2();
+static LONG seq_vec_batch_avx2();
+static LONG seq_vec_comp_avx2();
+#endif
+#ifdef SEQ_VEC_AVX512
+static LONG seq_vec_7291_avx512();
+#endif
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+INT SEQ_Vec_Init(kernels)
+  INT   kernels;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Bind the filter kernels for the processor the program runs on.
+
+    Inputs: kernels = SEQ_KERNEL_AUTO for the best the processor and the
+			compiler allow, or the instruction set asked for
+			with -k (SEQ_KERNEL_SCALAR for the original loops)
+
+    Outputs: the instruction set of the kernels bound
+
+    Notes: Asking for more than the processor has gives what it has.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Vec_Init() */
+
+    INT   level;
+
+    level = seq_vec_cpu();
+    if ((kernels != SEQ_KERNEL_AUTO) && (kernels < level))
+	level = kernels;
+    else if ((kernels != SEQ_KERNEL_AUTO) && (kernels > level))
+	fprintf(stderr, "%s kernels not available, using %s\n",
+			seq_vec_names[kernels], seq_vec_names[level]);
+
+    seq_vec_firP = NULL;
+    seq_vec_interleavedP = NULL;
+    seq_vec_7291P = NULL;
+    seq_vec_batchP = NULL;
+    seq_vec_compP = NULL;
+
+#ifdef SEQ_VEC_SSE41
+    if (level >= SEQ_KERNEL_SSE41)
+    {
+	seq_vec_firP = seq_vec_fir_sse41;
+	seq_vec_interleavedP = seq_vec_interleaved_sse41;
+	seq_vec_compP = seq_vec_comp_sse41;
+    }
+#endif
+#ifdef SEQ_VEC_AVX2
+    if (level >= SEQ_KERNEL_AVX2)
+    {
+	seq_vec_firP = seq_vec_fir_avx2;
+	seq_vec_interleavedP = seq_vec_interleaved_avx2;
+	seq_vec_7291P = seq_vec_7291_avx2;
+	seq_vec_batchP = seq_vec_batch_avx2;
+	seq_vec_compP = seq_vec_comp_avx2;
+    }
+#endif
+#ifdef SEQ_VEC_AVX512
+    if (level >= SEQ_KERNEL_AVX512)
+	seq_vec_7291P = seq_vec_7291_avx512;
+#endif
+
+    /* A program using the library (seq_lib.c) binds them before it has
+       any context */
+    if ((SEQ_ctxP != NULL) && (SEQ_options.debug == 1))
+	printf("Filter kernels: %s\n", seq_vec_names[level]);
+
+    return (level);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static INT seq_vec_cpu()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Find the best instruction set there are kernels for.
+
+    Outputs: SEQ_KERNEL_SCALAR .. SEQ_KERNEL_AVX512
+
+    Notes: Without SEQ_VEC_CPUID the compiler flags decide.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_vec_cpu() */
+
+    INT   level;
+
+    level = SEQ_KERNEL_SCALAR;
+#ifdef SEQ_VEC_CPUID
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1"))
+	level = SEQ_KERNEL_SSE41;
+    if ((level == SEQ_KERNEL_SSE41) && __builtin_cpu_supports("avx2"))
+	level = SEQ_KERNEL_AVX2;
+    if ((level == SEQ_KERNEL_AVX2) && __builtin_cpu_supports("avx512f") &&
+					__builtin_cpu_supports("avx512bw"))
+	level = SEQ_KERNEL_AVX512;
+#else
+#ifdef SEQ_VEC_SSE41
+    level = SEQ_KERNEL_SSE41;
+#endif
+#ifdef SEQ_VEC_AVX2
+    level = SEQ_KERNEL_AVX2;
+#endif
+#ifdef SEQ_VEC_AVX512
+    level = SEQ_KERNEL_AVX512;
+#endif
+#endif /* SEQ_VEC_CPUID */
+
+    return (level);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Vec_Fir(filterP, indexP, flash, raw_data, corr_dataP, first, count)
+  struct FILTER *filterP;
+  BYTE  *indexP;
+  INT   flash;
+  BYTE  *raw_data;
+  WORD  *corr_dataP;
+  LONG  first;
+  LONG  count;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Flash filter (<= 1 GSa/s) as many points of a block as can
+		be done a vector at a time.
+
+    Inputs: filterP    = coefficients, num_coeffs of them per flash
+	    indexP     = row of the flash index table for last_flash
+	    flash      = flash counter of SEQ_fir() for point first
+	    raw_data   = raw samples of the block
+	    corr_dataP = where the corrected point first goes
+	    first      = first point to filter (num_coeffs - 1)
+	    count      = number of raw samples
+
+    Outputs: number of points filtered, from first on; SEQ_fir() carries
+		on with the rest
+
+    Notes: Returns 0 if no vector kernel is bound.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Vec_Fir() */
+
+    WORD  bank[SEQ_VEC_PAIRS][16];
+    INT   num_coeffs;
+
+    num_coeffs = filterP->num_coeffs;
+    if ((seq_vec_firP == NULL) ||
+	(num_coeffs < 1) || (num_coeffs > 2 * SEQ_VEC_PAIRS))
+	return (0L);
+
+    seq_vec_bank(filterP, indexP, flash, 4, bank);
+    return ((*seq_vec_firP)(bank, (num_coeffs + 1) / 2, num_coeffs & 1,
+				raw_data, corr_dataP, first, count));
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Vec_Fir_Interleaved(filterP, indexP, flash, raw_data, p91P,
+							    first, count)
+  struct FILTER *filterP;
+  BYTE  *indexP;
+  INT   flash;
+  BYTE  *raw_data;
+  WORD  *p91P;
+  LONG  first;
+  LONG  count;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Flash filter (2 GSa/s, channels interleaved) as many points
+		of a block as can be done a vector at a time.
+
+    Inputs: filterP  = coefficients, num_coeffs of them per flash
+	    indexP   = row of the 8 flash index table for last_flash
+	    flash    = flash counter of SEQ_fir() for point first
+	    raw_data = raw samples of the block, Ch1 and Ch2 interleaved
+	    p91P     = where the flash-corrected point first goes
+	    first    = first point to filter (2 * num_coeffs - 2)
+	    count    = number of raw samples
+
+    Outputs: number of points filtered, from first on; SEQ_fir() carries
+		on with the rest
+
+    Notes: Returns 0 if no vector kernel is bound.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Vec_Fir_Interleaved() */
+
+    WORD  bank[SEQ_VEC_PAIRS][16];
+    INT   num_coeffs;
+
+    num_coeffs = filterP->num_coeffs;
+    if ((seq_vec_interleavedP == NULL) ||
+	(num_coeffs < 1) || (num_coeffs > 2 * SEQ_VEC_PAIRS))
+	return (0L);
+
+    seq_vec_bank(filterP, indexP, flash, 8, bank);
+    return ((*seq_vec_interleavedP)(bank, (num_coeffs + 1) / 2,
+			num_coeffs & 1, raw_data, p91P, first, count));
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Vec_Fir_7291(filterP, size, data, corr_dataP, first)
+  struct FILTER *filterP;
+  LONG  size;
+  WORD  *data;
+  WORD  *corr_dataP;
+  LONG  first;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: 7291 filter as many points of a block as can be done a
+		vector at a time.
+
+    Inputs: filterP    = coeff_7291[], num_91coeffs of them
+	    size       = number of flash filtered points
+	    data       = flash filtered points
+	    corr_dataP = where the corrected point first goes
+	    first      = first point to filter (num_91coeffs - 1)
+
+    Outputs: number of points filtered, from first on; SEQ_fir_7291()
+		carries on with the rest
+
+    Notes: Returns 0 if no AVX2 (or AVX-512) kernel is bound, or if
+	   the sums could overflow the 32 bits of the kernels.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Vec_Fir_7291() */
+
+    ULONG pair[SEQ_VEC_PAIRS_91];
+    LONG  sum;
+    INT   pairs;
+    INT   num_coeffs;
+    INT   p;
+
+    num_coeffs = filterP->num_91coeffs;
+    if ((seq_vec_7291P == NULL) ||
+	(num_coeffs < 1) || (num_coeffs > 2 * SEQ_VEC_PAIRS_91))
+	return (0L);
+
+    /* The scalar loop does not wrap at 32 bits */
+    sum = 0L;
+    for (p=0; p < num_coeffs; ++p)
+	sum += (filterP->coeff_7291[p] < 0) ?
+		-(LONG)filterP->coeff_7291[p] : (LONG)filterP->coeff_7291[p];
+    if (sum > SEQ_VEC_SUM_91)
+	return (0L);
+
+    /* Taps 2p and 2p+1 side by side, as pmaddwd wants them */
+    pairs = (num_coeffs + 1) / 2;
+    for (p=0; p < pairs; ++p)
+	pair[p] = (UWORD)filterP->coeff_7291[2*p] |
+		    ((ULONG)(UWORD)((2*p + 1 < num_coeffs) ?
+			    filterP->coeff_7291[2*p + 1] : 0) << 16);
+
+    return ((*seq_vec_7291P)(pair, pairs, num_coeffs & 1, data, corr_dataP,
+							first, size));
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Vec_Fir_Batch(filterP, indexPP, rawP, outP, first, count)
+  struct FILTER *filterP;
+  BYTE  **indexPP;
+  BYTE  *rawP;
+  WORD  *outP;
+  LONG  first;
+  LONG  count;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Flash filter (<= 1 GSa/s) SEQ_BATCH segments of the same
+		length and filter at once, a segment per lane.
+
+    Inputs: filterP = coefficients, num_coeffs of them per flash
+	    indexPP = row of the flash index table for the last_flash of
+			each segment, NULL for a lane with no segment
+	    rawP    = rawP[n*SEQ_BATCH + l] = raw sample n of segment l
+	    outP    = where outP[(n-first)*SEQ_BATCH + l] = corrected
+			point n of segment l goes
+	    first   = first point to filter (num_coeffs - 1)
+	    count   = number of raw samples of each segment
+
+    Outputs: number of points filtered, count - first, or 0 if no AVX2
+		kernel is bound (nothing is then filtered)
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Vec_Fir_Batch() */
+
+    WORD  bank[4][SEQ_VEC_PAIRS][SEQ_BATCH][2];
+    WORD  *coeffP;
+    INT   num_coeffs;
+    INT   ph, l, k;
+
+    num_coeffs = filterP->num_coeffs;
+    if ((seq_vec_batchP == NULL) || (first >= count) ||
+	(num_coeffs < 1) || (num_coeffs > 2 * SEQ_VEC_PAIRS))
+	return (0L);
+
+    /* Taps 2p and 2p+1 of the filter of each lane, for the 4 phases */
+    for (ph=0; ph < 4; ++ph)
+	for (l=0; l < SEQ_BATCH; ++l)
+	{
+	    coeffP = (indexPP[l] != NULL) ?
+			&filterP->coeffP[indexPP[l][ph]][0] : (WORD *)NULL;
+	    for (k=0; k < 2 * SEQ_VEC_PAIRS; ++k)
+		bank[ph][k / 2][l][k & 1] =
+		    ((coeffP != NULL) && (k < num_coeffs)) ? coeffP[k] : 0;
+	}
+
+    return ((*seq_vec_batchP)(bank, (num_coeffs + 1) / 2, num_coeffs & 1,
+					    rawP, outP, first, count));
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+LONG SEQ_Vec_Compensate(corrP, count, gain, offset, valuesP, values64P)
+  WORD  *corrP;
+  LONG  count;
+  DOUBLE gain;
+  DOUBLE offset;
+  FLOAT *valuesP;
+  DOUBLE *values64P;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Compensate as many corrected points of a block as can be
+		done a vector at a time.
+
+    Inputs: corrP     = corrected points
+	    count     = number of them
+	    gain      = vertical gain, a FLOAT
+	    offset    = vertical offset, a FLOAT
+	    valuesP   = where gain * point - offset goes, in FLOATs, or NULL
+	    values64P = the same in DOUBLEs, or NULL
+
+    Outputs: number of points done, from the first on; SEQ_Compensate()
+		carries on with the rest
+
+    Notes: Returns 0 if no vector kernel is bound.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Vec_Compensate() */
+
+    if (seq_vec_compP == NULL)
+	return (0L);
+
+    return ((*seq_vec_compP)(corrP, count, gain, offset, valuesP,
+							    values64P));
+}
+
+#ifdef SEQ_VEC_SSE41
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_VEC_TARGET("sse4.1")
+LONG seq_vec_fir_sse41(bank, pairs, odd, raw_data, corr_dataP, first, count)
+  WORD  (*bank)[16];
+  INT   pairs;
+  INT   odd;
+  BYTE  *raw_data;
+  WORD  *corr_dataP;
+  LONG  first;
+  LONG  count;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Vec_Fir() 8 points at a time.
+
+    Inputs: bank  = rows laid out by seq_vec_bank(), pairs pairs of taps,
+			the last one a single tap if odd
+	    the rest as for SEQ_Vec_Fir()
+
+    Outputs: number of points filtered, from first on
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_vec_fir_sse41() */
+
+    __m128i c[SEQ_VEC_PAIRS];
+    __m128i x0, x1, lo, hi;
+    __m128i over, under, zero;
+    INT   p;
+    LONG  n;
+
+    for (p=0; p < pairs; ++p)
+	c[p] = _mm_loadu_si128((__m128i *)&bank[p][0]);
+    over = _mm_set1_epi32((INT)CA_OVERFLOW);
+    under = _mm_set1_epi32((INT)CA_UNDERFLOW);
+    zero = _mm_setzero_si128();
+
+    for (n=first; n + 7 < count; n += 8)
+    {
+	lo = zero;
+	hi = zero;
+	for (p=0; p < pairs; ++p)
+	{
+	    /* Points n..n+7 against taps 2p and 2p+1 */
+	    x0 = _mm_cvtepi8_epi16(_mm_loadl_epi64(
+			    (__m128i *)&raw_data[n - 2*p]));
+	    if (odd && (p == pairs - 1))
+		x1 = zero;
+	    else
+		x1 = _mm_cvtepi8_epi16(_mm_loadl_epi64(
+			    (__m128i *)&raw_data[n - 2*p - 1]));
+	    lo = _mm_add_epi32(lo, _mm_madd_epi16(
+			    _mm_unpacklo_epi16(x0, x1), c[p]));
+	    hi = _mm_add_epi32(hi, _mm_madd_epi16(
+			    _mm_unpackhi_epi16(x0, x1), c[p]));
+	}
+
+	/* Limit, round like the DSP and put the points back in order */
+	lo = _mm_max_epi32(_mm_min_epi32(lo, over), under);
+	hi = _mm_max_epi32(_mm_min_epi32(hi, over), under);
+	lo = _mm_slli_epi32(_mm_srai_epi32(lo, 7), 1);
+	hi = _mm_slli_epi32(_mm_srai_epi32(hi, 7), 1);
+	_mm_storeu_si128((__m128i *)&corr_dataP[n - first],
+			    _mm_packs_epi32(lo, hi));
+    }
+
+    return (n - first);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_VEC_TARGET("sse4.1")
+LONG seq_vec_interleaved_sse41(bank, pairs, odd, raw_data, p91P, first,
+								count)
+  WORD  (*bank)[16];
+  INT   pairs;
+  INT   odd;
+  BYTE  *raw_data;
+  WORD  *p91P;
+  LONG  first;
+  LONG  count;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Vec_Fir_Interleaved() 8 points at a time.
+
+    Inputs: bank  = rows laid out by seq_vec_bank() for 8 phases, pairs
+			pairs of taps, the last one a single tap if odd
+	    the rest as for SEQ_Vec_Fir_Interleaved()
+
+    Outputs: number of points filtered, from first on
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_vec_interleaved_sse41() */
+
+    __m128i c_lo[SEQ_VEC_PAIRS], c_hi[SEQ_VEC_PAIRS];
+    __m128i x0, x1, lo, hi, r_lo, r_hi;
+    __m128i pos, under, sat, zero;
+    INT   p;
+    LONG  n;
+
+    for (p=0; p < pairs; ++p)
+    {
+	c_lo[p] = _mm_loadu_si128((__m128i *)&bank[p][0]);
+	c_hi[p] = _mm_loadu_si128((__m128i *)&bank[p][8]);
+    }
+    pos = _mm_set1_epi32((INT)POS_SATURATION);
+    under = _mm_set1_epi32((INT)CA_UNDERFLOW);
+    sat = _mm_set1_epi32(SATURATION);
+    zero = _mm_setzero_si128();
+
+    for (n=first; n + 7 < count; n += 8)
+    {
+	lo = zero;
+	hi = zero;
+	for (p=0; p < pairs; ++p)
+	{
+	    /* Points n..n+7 against taps 2p and 2p+1 of their own
+	       channel, 4p and 4p+2 samples back */
+	    x0 = _mm_cvtepi8_epi16(_mm_loadl_epi64(
+			    (__m128i *)&raw_data[n - 4*p]));
+	    if (odd && (p == pairs - 1))
+		x1 = zero;
+	    else
+		x1 = _mm_cvtepi8_epi16(_mm_loadl_epi64(
+			    (__m128i *)&raw_data[n - 4*p - 2]));
+	    lo = _mm_add_epi32(lo, _mm_madd_epi16(
+			    _mm_unpacklo_epi16(x0, x1), c_lo[p]));
+	    hi = _mm_add_epi32(hi, _mm_madd_epi16(
+			    _mm_unpackhi_epi16(x0, x1), c_hi[p]));
+	}
+
+	/* Rail like the DSP, round and put the points back in order */
+	r_lo = _mm_slli_epi32(_mm_srai_epi32(
+			    _mm_max_epi32(lo, under), 7), 1);
+	r_hi = _mm_slli_epi32(_mm_srai_epi32(
+			    _mm_max_epi32(hi, under), 7), 1);
+	r_lo = _mm_blendv_epi8(r_lo, sat, _mm_cmpgt_epi32(lo, pos));
+	r_hi = _mm_blendv_epi8(r_hi, sat, _mm_cmpgt_epi32(hi, pos));
+	_mm_storeu_si128((__m128i *)&p91P[n - first],
+			    _mm_packs_epi32(r_lo, r_hi));
+    }
+
+    return (n - first);
+}
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_VEC_TARGET("sse4.1")
+LONG seq_vec_comp_sse41(corrP, count, gain, offset, valuesP, values64P)
+  WORD  *corrP;
+  LONG  count;
+  DOUBLE gain;
+  DOUBLE offset;
+  FLOAT *valuesP;
+  DOUBLE *values64P;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Vec_Compensate() 4 points at a time.
+
+    Outputs: number of points done, from the first on
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_vec_comp_sse41() */
+
+    __m128  g, o;
+    __m128d gd, od;
+    __m128i x;
+    LONG  n;
+
+    count &= ~3L;
+
+    if (valuesP != NULL)
+    {
+	g = _mm_set1_ps((FLOAT)gain);
+	o = _mm_set1_ps((FLOAT)offset);
+	for (n=0; n < count; n += 4)
+	    _mm_storeu_ps(&valuesP[n], _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+			    _mm_cvtepi16_epi32(_mm_loadl_epi64(
+			    (__m128i *)&corrP[n]))), g), o));
+    }
+
+    if (values64P != NULL)
+    {
+	gd = _mm_set1_pd(gain);
+	od = _mm_set1_pd(offset);
+	for (n=0; n < count; n += 4)
+	{
+	    x = _mm_cvtepi16_epi32(_mm_loadl_epi64((__m128i *)&corrP[n]));
+	    _mm_storeu_pd(&values64P[n], _mm_sub_pd(_mm_mul_pd(
+			    _mm_cvtepi32_pd(x), gd), od));
+	    _mm_storeu_pd(&values64P[n + 2], _mm_sub_pd(_mm_mul_pd(
+			    _mm_cvtepi32_pd(_mm_srli_si128(x, 8)), gd), od));
+	}
+    }
+
+    return (count);
+}
+#endif /* SEQ_VEC_SSE41 */
+
+#ifdef SEQ_VEC_AVX2
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_VEC_TARGET("avx2")
+LONG seq_vec_fir_avx2(bank, pairs, odd, raw_data, corr_dataP, first, count)
+  WORD  (*bank)[16];
+  INT   pairs;
+  INT   odd;
+  BYTE  *raw_data;
+  WORD  *corr_dataP;
+  LONG  first;
+  LONG  count;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Vec_Fir() 16 points at a time, the rest of 8 with
+		seq_vec_fir_sse41().
+
+    Inputs: as for seq_vec_fir_sse41()
+
+    Outputs: number of points filtered, from first on
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_vec_fir_avx2() */
+
+    __m256i c[SEQ_VEC_PAIRS];
+    __m256i x0, x1, lo, hi;
+    __m256i over, under, zero;
+    INT   p;
+    LONG  n;
+
+    for (p=0; p < pairs; ++p)
+	c[p] = _mm256_broadcastsi128_si256(
+			    _mm_loadu_si128((__m128i *)&bank[p][0]));
+    over = _mm256_set1_epi32((INT)CA_OVERFLOW);
+    under = _mm256_set1_epi32((INT)CA_UNDERFLOW);
+    zero = _mm256_setzero_si256();
+
+    for (n=first; n + 15 < count; n += 16)
+    {
+	lo = zero;
+	hi = zero;
+	for (p=0; p < pairs; ++p)
+	{
+	    /* Points n..n+15 against taps 2p and 2p+1 */
+	    x0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(
+			    (__m128i *)&raw_data[n - 2*p]));
+	    if (odd && (p == pairs - 1))
+		x1 = zero;
+	    else
+		x1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(
+			    (__m128i *)&raw_data[n - 2*p - 1]));
+	    lo = _mm256_add_epi32(lo, _mm256_madd_epi16(
+			    _mm256_unpacklo_epi16(x0, x1), c[p]));
+	    hi = _mm256_add_epi32(hi, _mm256_madd_epi16(
+			    _mm256_unpackhi_epi16(x0, x1), c[p]));
+	}
+
+	/* Limit, round like the DSP and put the points back in order */
+	lo = _mm256_max_epi32(_mm256_min_epi32(lo, over), under);
+	hi = _mm256_max_epi32(_mm256_min_epi32(hi, over), under);
+	lo = _mm256_slli_epi32(_mm256_srai_epi32(lo, 7), 1);
+	hi = _mm256_slli_epi32(_mm256_srai_epi32(hi, 7), 1);
+	_mm256_storeu_si256((__m256i *)&corr_dataP[n - first],
+			    _mm256_packs_epi32(lo, hi));
+    }
+
+    /* The bank repeats every 4 points, so it still fits point n */
+    return ((n - first) + seq_vec_fir_sse41(bank, pairs, odd, raw_data,
+				&corr_dataP[n - first], n, count));
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_VEC_TARGET("avx2")
+LONG seq_vec_interleaved_avx2(bank, pairs, odd, raw_data, p91P, first,
+								count)
+  WORD  (*bank)[16];
+  INT   pairs;
+  INT   odd;
+  BYTE  *raw_data;
+  WORD  *p91P;
+  LONG  first;
+  LONG  count;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Vec_Fir_Interleaved() 16 points at a time, the rest of
+		8 with seq_vec_interleaved_sse41().
+
+    Inputs: as for seq_vec_interleaved_sse41()
+
+    Outputs: number of points filtered, from first on
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_vec_interleaved_avx2() */
+
+    __m256i c_lo[SEQ_VEC_PAIRS], c_hi[SEQ_VEC_PAIRS];
+    __m256i x0, x1, lo, hi, r_lo, r_hi;
+    __m256i pos, under, sat, zero;
+    INT   p;
+    LONG  n;
+
+    for (p=0; p < pairs; ++p)
+    {
+	c_lo[p] = _mm256_broadcastsi128_si256(
+			    _mm_loadu_si128((__m128i *)&bank[p][0]));
+	c_hi[p] = _mm256_broadcastsi128_si256(
+			    _mm_loadu_si128((__m128i *)&bank[p][8]));
+    }
+    pos = _mm256_set1_epi32((INT)POS_SATURATION);
+    under = _mm256_set1_epi32((INT)CA_UNDERFLOW);
+    sat = _mm256_set1_epi32(SATURATION);
+    zero = _mm256_setzero_si256();
+
+    for (n=first; n + 15 < count; n += 16)
+    {
+	lo = zero;
+	hi = zero;
+	for (p=0; p < pairs; ++p)
+	{
+	    /* Points n..n+15 against taps 2p and 2p+1 of their own
+	       channel, 4p and 4p+2 samples back */
+	    x0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(
+			    (__m128i *)&raw_data[n - 4*p]));
+	    if (odd && (p == pairs - 1))
+		x1 = zero;
+	    else
+		x1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(
+			    (__m128i *)&raw_data[n - 4*p - 2]));
+	    lo = _mm256_add_epi32(lo, _mm256_madd_epi16(
+			    _mm256_unpacklo_epi16(x0, x1), c_lo[p]));
+	    hi = _mm256_add_epi32(hi, _mm256_madd_epi16(
+			    _mm256_unpackhi_epi16(x0, x1), c_hi[p]));
+	}
+
+	/* Rail like the DSP, round and put the points back in order */
+	r_lo = _mm256_slli_epi32(_mm256_srai_epi32(
+			    _mm256_max_epi32(lo, under), 7), 1);
+	r_hi = _mm256_slli_epi32(_mm256_srai_epi32(
+			    _mm256_max_epi32(hi, under), 7), 1);
+	r_lo = _mm256_blendv_epi8(r_lo, sat, _mm256_cmpgt_epi32(lo, pos));
+	r_hi = _mm256_blendv_epi8(r_hi, sat, _mm256_cmpgt_epi32(hi, pos));
+	_mm256_storeu_si256((__m256i *)&p91P[n - first],
+			    _mm256_packs_epi32(r_lo, r_hi));
+    }
+
+    /* The bank repeats every 8 points, so it still fits point n */
+    return ((n - first) + seq_vec_interleaved_sse41(bank, pairs, odd,
+				raw_data, &p91P[n - first], n, count));
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_VEC_TARGET("avx2")
+LONG seq_vec_7291_avx2(pair, pairs, odd, data, corr_dataP, first, size)
+  ULONG *pair;
+  INT   pairs;
+  INT   odd;
+  WORD  *data;
+  WORD  *corr_dataP;
+  LONG  first;
+  LONG  size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Vec_Fir_7291() 16 points at a time.
+
+    Inputs: pair  = taps 2p and 2p+1 in the low and high half, pairs of
+			them, the last one a single tap if odd
+	    the rest as for SEQ_Vec_Fir_7291()
+
+    Outputs: number of points filtered, from first on
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_vec_7291_avx2() */
+
+    __m256i c, x0, x1, lo, hi;
+    __m256i over, under, zero;
+    INT   p;
+    LONG  n;
+
+    over = _mm256_set1_epi32((INT)CA1_OVERFLOW);
+    under = _mm256_set1_epi32((INT)CA1_UNDERFLOW);
+    zero = _mm256_setzero_si256();
+
+    for (n=first; n + 15 < size; n += 16)
+    {
+	lo = zero;
+	hi = zero;
+	for (p=0; p < pairs; ++p)
+	{
+	    /* Points n..n+15 against taps 2p and 2p+1 */
+	    c = _mm256_set1_epi32((INT)pair[p]);
+	    x0 = _mm256_loadu_si256((__m256i *)&data[n - 2*p]);
+	    if (odd && (p == pairs - 1))
+		x1 = zero;
+	    else
+		x1 = _mm256_loadu_si256((__m256i *)&data[n - 2*p - 1]);
+	    lo = _mm256_add_epi32(lo, _mm256_madd_epi16(
+			    _mm256_unpacklo_epi16(x0, x1), c));
+	    hi = _mm256_add_epi32(hi, _mm256_madd_epi16(
+			    _mm256_unpackhi_epi16(x0, x1), c));
+	}
+
+	/* Limit, round like the DSP and put the points back in order */
+	lo = _mm256_max_epi32(_mm256_min_epi32(lo, over), under);
+	hi = _mm256_max_epi32(_mm256_min_epi32(hi, over), under);
+	lo = _mm256_slli_epi32(_mm256_srai_epi32(lo, 15), 1);
+	hi = _mm256_slli_epi32(_mm256_srai_epi32(hi, 15), 1);
+	_mm256_storeu_si256((__m256i *)&corr_dataP[n - first],
+			    _mm256_packs_epi32(lo, hi));
+    }
+
+    return (n - first);
+}
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_VEC_TARGET("avx2")
+LONG seq_vec_batch_avx2(bank, pairs, odd, rawP, outP, first, count)
+  WORD  (*bank)[SEQ_VEC_PAIRS][SEQ_BATCH][2];
+  INT   pairs;
+  INT   odd;
+  BYTE  *rawP;
+  WORD  *outP;
+  LONG  first;
+  LONG  count;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Vec_Fir_Batch() a point of 8 segments per vector.
+
+    Inputs: bank  = bank[ph][p][l][0..1] = taps 2p and 2p+1 of the filter
+			of segment l for the points of phase ph
+	    pairs = pairs of taps
+	    odd   = TRUE if the last pair only has its first tap
+	    the others as for SEQ_Vec_Fir_Batch()
+
+    Outputs: number of points filtered, from first on
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_vec_batch_avx2() */
+
+    __m128i x0, x1;
+    __m256i lo, hi;
+    __m256i over, under;
+    WORD  (*cP)[SEQ_BATCH][2];
+    INT   p;
+    LONG  n;
+
+    over = _mm256_set1_epi32((INT)CA_OVERFLOW);
+    under = _mm256_set1_epi32((INT)CA_UNDERFLOW);
+
+    for (n=first; n < count; ++n)
+    {
+	cP = bank[(n - first) & 3];
+	lo = _mm256_setzero_si256();
+	hi = _mm256_setzero_si256();
+	for (p=0; p < pairs; ++p)
+	{
+	    /* Samples n-2p and n-2p-1 of segments 0-7 and 8-15 */
+	    x0 = _mm_loadu_si128((__m128i *)&rawP[(n - 2*p) * SEQ_BATCH]);
+	    if (odd && (p == pairs - 1))
+		x1 = _mm_setzero_si128();
+	    else
+		x1 = _mm_loadu_si128(
+			    (__m128i *)&rawP[(n - 2*p - 1) * SEQ_BATCH]);
+	    lo = _mm256_add_epi32(lo, _mm256_madd_epi16(
+			    _mm256_cvtepi8_epi16(_mm_unpacklo_epi8(x0, x1)),
+			    _mm256_loadu_si256((__m256i *)&cP[p][0][0])));
+	    hi = _mm256_add_epi32(hi, _mm256_madd_epi16(
+			    _mm256_cvtepi8_epi16(_mm_unpackhi_epi8(x0, x1)),
+			    _mm256_loadu_si256((__m256i *)&cP[p][8][0])));
+	}
+
+	/* Limit, round like the DSP and put the segments back in order */
+	lo = _mm256_max_epi32(_mm256_min_epi32(lo, over), under);
+	hi = _mm256_max_epi32(_mm256_min_epi32(hi, over), under);
+	lo = _mm256_slli_epi32(_mm256_srai_epi32(lo, 7), 1);
+	hi = _mm256_slli_epi32(_mm256_srai_epi32(hi, 7), 1);
+	_mm256_storeu_si256((__m256i *)&outP[(n - first)*SEQ_BATCH],
+		_mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8));
+    }
+
+    return (count - first);
+}
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_VEC_TARGET("avx2")
+LONG seq_vec_comp_avx2(corrP, count, gain, offset, valuesP, values64P)
+  WORD  *corrP;
+  LONG  count;
+  DOUBLE gain;
+  DOUBLE offset;
+  FLOAT *valuesP;
+  DOUBLE *values64P;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Vec_Compensate() 8 points at a time.
+
+    Outputs: number of points done, from the first on
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_vec_comp_avx2() */
+
+    __m256  g, o;
+    __m256d gd, od;
+    __m128i x;
+    LONG  n;
+
+    count &= ~7L;
+
+    if (valuesP != NULL)
+    {
+	g = _mm256_set1_ps((FLOAT)gain);
+	o = _mm256_set1_ps((FLOAT)offset);
+	for (n=0; n < count; n += 8)
+	    _mm256_storeu_ps(&valuesP[n], _mm256_sub_ps(_mm256_mul_ps(
+			    _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+			    _mm_loadu_si128((__m128i *)&corrP[n]))), g), o));
+    }
+
+    if (values64P != NULL)
+    {
+	gd = _mm256_set1_pd(gain);
+	od = _mm256_set1_pd(offset);
+	for (n=0; n < count; n += 8)
+	{
+	    x = _mm_loadu_si128((__m128i *)&corrP[n]);
+	    _mm256_storeu_pd(&values64P[n], _mm256_sub_pd(_mm256_mul_pd(
+			    _mm256_cvtepi32_pd(_mm_cvtepi16_epi32(x)), gd), od));
+	    _mm256_storeu_pd(&values64P[n + 4], _mm256_sub_pd(_mm256_mul_pd(
+			    _mm256_cvtepi32_pd(_mm_cvtepi16_epi32(
+			    _mm_srli_si128(x, 8))), gd), od));
+	}
+    }
+
+    return (count);
+}
+#endif /* SEQ_VEC_AVX2 */
+
+#ifdef SEQ_VEC_AVX512
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static SEQ_VEC_TARGET("avx512f,avx512bw")
+LONG seq_vec_7291_avx512(pair, pairs, odd, data, corr_dataP, first, size)
+  ULONG *pair;
+  INT   pairs;
+  INT   odd;
+  WORD  *data;
+  WORD  *corr_dataP;
+  LONG  first;
+  LONG  size;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: SEQ_Vec_Fir_7291() 32 points at a time, the rest of 16 with
+		seq_vec_7291_avx2().
+
+    Inputs: as for seq_vec_7291_avx2()
+
+    Outputs: number of points filtered, from first on
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_vec_7291_avx512() */
+
+    __m512i c, x0, x1, lo, hi;
+    __m512i over, under, zero;
+    INT   p;
+    LONG  n;
+
+    over = _mm512_set1_epi32((INT)CA1_OVERFLOW);
+    under = _mm512_set1_epi32((INT)CA1_UNDERFLOW);
+    zero = _mm512_setzero_si512();
+
+    for (n=first; n + 31 < size; n += 32)
+    {
+	lo = zero;
+	hi = zero;
+	for (p=0; p < pairs; ++p)
+	{
+	    c = _mm512_set1_epi32((INT)pair[p]);
+	    x0 = _mm512_loadu_si512((VOID *)&data[n - 2*p]);
+	    if (odd && (p == pairs - 1))
+		x1 = zero;
+	    else
+		x1 = _mm512_loadu_si512((VOID *)&data[n - 2*p - 1]);
+	    lo = _mm512_add_epi32(lo, _mm512_madd_epi16(
+			    _mm512_unpacklo_epi16(x0, x1), c));
+	    hi = _mm512_add_epi32(hi, _mm512_madd_epi16(
+			    _mm512_unpackhi_epi16(x0, x1), c));
+	}
+
+	lo = _mm512_max_epi32(_mm512_min_epi32(lo, over), under);
+	hi = _mm512_max_epi32(_mm512_min_epi32(hi, over), under);
+	lo = _mm512_slli_epi32(_mm512_srai_epi32(lo, 15), 1);
+	hi = _mm512_slli_epi32(_mm512_srai_epi32(hi, 15), 1);
+	_mm512_storeu_si512((VOID *)&corr_dataP[n - first],
+			    _mm512_packs_epi32(lo, hi));
+    }
+
+    return ((n - first) + seq_vec_7291_avx2(pair, pairs, odd, data,
+				&corr_dataP[n - first], n, size));
+}
+#endif /* SEQ_VEC_AVX512 */
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_vec_bank(filterP, indexP, flash, phases, bank)
+  struct FILTER *filterP;
+  BYTE  *indexP;
+  INT   flash;
+  INT   phases;
+  WORD  bank[SEQ_VEC_PAIRS][16];
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Lay out the flash filters in the order a vector of points
+		starting at flash needs them.
+
+    Inputs: phases = 4 (<= 1 GSa/s) or 8 (2 GSa/s) points after which the
+			filters repeat
+
+    Outputs: bank[p][2*l], bank[p][2*l+1] = taps 2p and 2p+1 of the filter
+		of the l-th point of every phases (0 past the last tap)
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_vec_bank() */
+
+    WORD  *coeffP;
+    INT   l, k;
+
+    for (l=0; l < phases; ++l)
+    {
+	coeffP = &filterP->coeffP[indexP[(flash + l) & (phases - 1)]][0];
+	for (k=0; k < 2 * SEQ_VEC_PAIRS; ++k)
+	    bank[k / 2][2*l + (k & 1)] =
+			(k < filterP->num_coeffs) ? coeffP[k] : 0;
+    }
+}
@@ -16,6 +16,9 @@ Author: Gabriel Goodman		LeCroy Corporation
 #include "seq_hdr.h"
 
 extern struct PCW_TEMPLATE *PCW_templateP;
+extern VOID   SEQ_Exit();
+extern VOID   SEQ_Lock();
+extern VOID   SEQ_Unlock();
 
 /*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
 
@@ -34,7 +37,7 @@ struct  PCW_BLOCK   **blkP;
 
     Machine dependencies:
 
-    Notes:
+    Notes: The template is read once for all contexts (seq_ctx.c).
 
     Procedure:
 
@@ -51,15 +54,17 @@ struct  PCW_BLOCK   **blkP;
     static BOOL		translated = FALSE;
 
 
+    SEQ_Lock();
     if (!translated)
     {
 	template_file = "7200.TPL";
 
 	if ((fP = fopen(template_file,"r")) == NULL)
 	{
+	    SEQ_Unlock();
 	    printf("\nCannot open template file: 7200.tpl\n");
 	    printf("Must have 7200.tpl in current directory\n");
-	    exit(1);
+	    SEQ_Exit();
 	}
 
 	PCW_templateP = PCW_Get_Template(fP);   /* Generate machine template */
@@ -67,11 +72,12 @@ struct  PCW_BLOCK   **blkP;
 
 	translated = TRUE;
     }
+    SEQ_Unlock();
 
     if (*waveformP != 'W')
     {
         printf("\nInvalid Waveform Header\n");
-        exit(1);
+        SEQ_Exit();
     }
 
 
@@ -0,0 +1,1056 @@
+/************************** seq_wsp.c **************************************
+
+Translation of many data files at once (-b).
+
+One run of the digitizer leaves hundreds of data files. With -b the file
+named on the command line is a list of them instead: @list, a file with
+the name of a data file on each line, or a pattern such as "run*.dat",
+which may name a directory as well (quoted, for seqtran to expand). Every data file is translated with the
+options given, into trace files as with -oF.
+
+The work is cut into tasks. The first task of a data file opens it,
+builds its packet index and segment directory as -i does, and makes a
+task for each run of about SEQ_POOL_BYTES of samples of the segments
+selected in a channel. With SEQ_THREADS (POSIX threads and GCC) the
+-jN threads of the pool each have a deque of tasks. A thread takes its
+newest task; when it has none left it takes the oldest one of another
+thread's. So the segments of one large data file are shared out among
+all the threads at the end, rather than left to the thread that opened
+it while the others stand idle. A thread keeps the data file of its last
+task open for the next one, which is mostly of the same file.
+
+The trace files of a data file go into the directory <file>.trc, named
+and numbered as seqtran -oF would name them for that data file alone: a
+task that starts further into a channel starts with the number of the
+segments selected before it. A channel with segments selected by time
+is translated in one task, as is every channel of a data file without a
+segment directory.
+
+At the end the data files, tasks and segments done and the rate at which
+the samples were translated are printed to stderr.
+
+Without SEQ_THREADS the tasks are run one after the other.
+
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <setjmp.h>
+#include <time.h>
+#include "seq_tran.h"
+
+#if defined(MSDOS) || defined(__WATCOMC__) || defined(__TURBOC__)
+#include <direct.h>		/* mkdir() */
+#include <dos.h>		/* _dos_findfirst() */
+#define SEQ_MKDIR(nameP)	mkdir(nameP)
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glob.h>
+#define SEQ_MKDIR(nameP)	mkdir(nameP, 0777)
+#endif
+
+#if defined(SEQ_THREADS) && defined(__GNUC__)
+#define SEQ_POOL_THREADS
+#include <pthread.h>
+#define SEQ_POOL_LOCK(lock)	pthread_mutex_lock(&(lock))
+#define SEQ_POOL_UNLOCK(lock)	pthread_mutex_unlock(&(lock))
+#else
+#define SEQ_POOL_LOCK(lock)
+#define SEQ_POOL_UNLOCK(lock)
+#endif /* SEQ_THREADS && __GNUC__ */
+
+/* -------------------------------------------------------------------- */
+
+extern BOOL   SEQ_Start();
+extern VOID   SEQ_Stop();
+extern VOID   SEQ_Read_Segment_Number();
+extern LONG   SEQ_Dir_Count();
+extern VOID   SEQ_Sidecar_Name();
+
+#define SEQ_POOL_BYTES	(4L * 1024L * 1024L)	/* samples of a task */
+#define SEQ_POOL_TASKS	64		/* room made in a deque at a time */
+#define SEQ_POOL_FILES	64		/* room made in the list at a time */
+#define SEQ_POOL_EXT	".trc"		/* directory of the trace files */
+#define SEQ_POOL_END	0x7fffffffL	/* last segment of an open task */
+
+/* A piece of work: a data file to open and make the tasks of, or the
+   segments first..last of one of its channels to translate */
+typedef struct SEQ_POOL_TASK
+{
+    INT   file;				/* index in the list */
+    BOOL  plan;				/* TRUE: open it, make the tasks */
+    BYTE  plugin;
+    BYTE  channel;
+    BOOL  whole;			/* TRUE: the selections as given */
+    LONG  first;			/* first segment */
+    LONG  last;				/* last, -1 = to the end */
+    LONG  before;			/* segments selected before first */
+} SEQ_POOL_TASK;
+
+/* The tasks of a thread: its own newest at the bottom, the oldest, for
+   the other threads to take, at the top */
+typedef struct SEQ_POOL_DEQUE
+{
+    SEQ_POOL_TASK *taskP;		/* [size] */
+    LONG  size;
+    LONG  top;				/* oldest task */
+    LONG  bottom;			/* one past the newest */
+#ifdef SEQ_POOL_THREADS
+    pthread_mutex_t lock;
+#endif /* SEQ_POOL_THREADS */
+} SEQ_POOL_DEQUE;
+
+/* A thread of the pool */
+typedef struct SEQ_POOL_WORKER
+{
+    struct SEQ_POOL *poolP;
+    INT   id;
+    SEQ_POOL_DEQUE deque;
+    SEQ_CONTEXT *ctxP;			/* data file open, or NULL */
+    INT   file;				/* which one */
+    LONG  tasks;			/* tasks run */
+    LONG  stolen;			/* of them taken from others */
+    LONG  channels;			/* channels planned */
+    LONG  segs;				/* segments translated */
+    DOUBLE bytes;			/* their samples */
+#ifdef SEQ_POOL_THREADS
+    pthread_t thread;
+#endif /* SEQ_POOL_THREADS */
+} SEQ_POOL_WORKER;
+
+typedef struct SEQ_POOL
+{
+    CHAR  **nameP;			/* the data files */
+    INT   files;
+    INT   room;				/* names nameP has room for */
+    BOOL  *failedP;			/* [files], given up */
+    SEQ_CONTEXT *mainP;			/* the options to translate with */
+    SEQ_POOL_WORKER worker[SEQ_MAX_JOBS];
+    INT   workers;
+    LONG  queued;			/* tasks in the deques */
+    LONG  outstanding;			/* tasks not yet done */
+#ifdef SEQ_POOL_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+#endif /* SEQ_POOL_THREADS */
+} SEQ_POOL;
+
+static VOID   seq_pool_names();
+static VOID   seq_pool_add();
+static VOID   seq_pool_push();
+static BOOL   seq_pool_get();
+static BOOL   seq_pool_take();
+static VOID   *seq_pool_worker();
+static VOID   seq_pool_task();
+static BOOL   seq_pool_open();
+static VOID   seq_pool_close();
+static VOID   seq_pool_fail();
+static VOID   seq_pool_plan();
+static VOID   seq_pool_select();
+static DOUBLE seq_pool_clock();
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+BOOL SEQ_Pool_Run(patternP)
+  CHAR  *patternP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Translate every data file of a list or pattern (-b) with the
+		options of the current context.
+
+    Inputs: patternP = @ and the name of a file listing the data files,
+		       or a pattern of data file names
+
+    Outputs: TRUE if every data file was translated
+
+    Notes: The messages of the translation are printed as the threads
+	   come to them; a data file that is given up is named on stderr.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* SEQ_Pool_Run() */
+
+    SEQ_POOL *poolP;
+    SEQ_POOL_WORKER *workerP;
+    SEQ_POOL_TASK task;
+    SEQ_CONTEXT *saved_ctxP;
+    VOID  *saved_jumpP;
+    DOUBLE start;
+    DOUBLE secs;
+    DOUBLE bytes;
+    LONG  tasks, stolen, channels, segs;
+    INT   failed;
+    INT   f, n;
+
+    poolP = (SEQ_POOL *)calloc((size_t)1, sizeof(SEQ_POOL));
+    if (poolP == NULL)
+	error_handler(OUT_OF_MEMORY);
+    poolP->mainP = SEQ_ctxP;
+
+    seq_pool_names(poolP, patternP);
+    if (poolP->files == 0)
+    {
+	printf("No data files in %s\n", patternP);
+	free(poolP);
+	return (FALSE);
+    }
+
+    poolP->failedP = (BOOL *)calloc((size_t)poolP->files, sizeof(BOOL));
+    if (poolP->failedP == NULL)
+	error_handler(OUT_OF_MEMORY);
+
+#ifdef SEQ_POOL_THREADS
+    poolP->workers = SEQ_options.jobs;
+    pthread_mutex_init(&poolP->lock, NULL);
+    pthread_cond_init(&poolP->cond, NULL);
+#else
+    poolP->workers = 1;
+#endif /* SEQ_POOL_THREADS */
+
+    for (n=0; n < poolP->workers; ++n)
+    {
+	workerP = &poolP->worker[n];
+	workerP->poolP = poolP;
+	workerP->id = n;
+	workerP->file = -1;
+#ifdef SEQ_POOL_THREADS
+	pthread_mutex_init(&workerP->deque.lock, NULL);
+#endif /* SEQ_POOL_THREADS */
+    }
+
+    /* Deal the data files out, each thread's first on top of its deque */
+    task.plan = TRUE;
+    for (f=poolP->files-1; f >= 0; --f)
+    {
+	task.file = f;
+	seq_pool_push(poolP, &poolP->worker[f % poolP->workers], &task);
+    }
+
+    saved_ctxP = SEQ_ctxP;
+    saved_jumpP = SEQ_jumpP;
+    start = seq_pool_clock();
+
+#ifdef SEQ_POOL_THREADS
+    for (n=0; n < poolP->workers; ++n)
+    {
+	if (pthread_create(&poolP->worker[n].thread, NULL,
+			    seq_pool_worker, (VOID *)&poolP->worker[n]) != 0)
+	    break;
+    }
+
+    /* Too few threads: the main thread does the work of the rest, the
+       others taking from its deques as from any */
+    for (f=n; f < poolP->workers; ++f)
+	(VOID)seq_pool_worker((VOID *)&poolP->worker[f]);
+    while (--n >= 0)
+	pthread_join(poolP->worker[n].thread, NULL);
+#else
+    (VOID)seq_pool_worker((VOID *)&poolP->worker[0]);
+#endif /* SEQ_POOL_THREADS */
+
+    secs = seq_pool_clock() - start;
+    SEQ_ctxP = saved_ctxP;
+    SEQ_jumpP = saved_jumpP;
+
+    /* Add up what the threads did */
+    tasks = stolen = channels = segs = 0L;
+    bytes = (DOUBLE)0;
+    for (n=0; n < poolP->workers; ++n)
+    {
+	workerP = &poolP->worker[n];
+	tasks += workerP->tasks;
+	stolen += workerP->stolen;
+	channels += workerP->channels;
+	segs += workerP->segs;
+	bytes += workerP->bytes;
+	free(workerP->deque.taskP);
+#ifdef SEQ_POOL_THREADS
+	pthread_mutex_destroy(&workerP->deque.lock);
+#endif /* SEQ_POOL_THREADS */
+    }
+    failed = 0;
+    for (f=0; f < poolP->files; ++f)
+    {
+	if (poolP->failedP[f] == TRUE)
+	    ++failed;
+	free(poolP->nameP[f]);
+    }
+
+    fprintf(stderr, "\nBatch: %d data files (%d given up), %ld channels \
+in %ld tasks (%ld taken by\nanother thread of %d): %ld segments, %.1f MB \
+of samples in %.2f s", poolP->files, failed, channels, tasks, stolen,
+	    poolP->workers, segs, bytes / (1024.0 * 1024.0), secs);
+    if (secs > (DOUBLE)0)
+	fprintf(stderr, ", %.1f MB/s", bytes / (1024.0 * 1024.0) / secs);
+    fprintf(stderr, "\n");
+
+#ifdef SEQ_POOL_THREADS
+    pthread_cond_destroy(&poolP->cond);
+    pthread_mutex_destroy(&poolP->lock);
+#endif /* SEQ_POOL_THREADS */
+    free(poolP->failedP);
+    free(poolP->nameP);
+    free(poolP);
+
+    return (failed == 0);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_pool_names(poolP, patternP)
+  SEQ_POOL *poolP;
+  CHAR  *patternP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Make the list of data files to translate.
+
+    Inputs: patternP = @list or a pattern, as for SEQ_Pool_Run()
+
+    Outputs: poolP->nameP, files
+
+    Notes: Empty lines of a list and those starting with # are passed
+	   over. The names a pattern matches are in alphabetical order
+	   on POSIX hosts, in the order of the directory on MS-DOS.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_names() */
+
+    FILE  *fP;
+    CHAR  line[256];
+    CHAR  *charP;
+    INT   len;
+#if defined(MSDOS) || defined(__WATCOMC__) || defined(__TURBOC__)
+    struct find_t find;
+    CHAR  name[256];
+#else
+    glob_t names;
+    size_t i;
+#endif
+
+    if (*patternP == '@')
+    {
+	if ((fP = fopen(patternP + 1, "r")) == NULL)
+	{
+	    printf("Could not open file %s\n", patternP + 1);
+	    return;
+	}
+	while (fgets(line, (INT)sizeof(line), fP) != NULL)
+	{
+	    len = (INT)strlen(line);
+	    while ((len > 0) && ((line[len-1] == '\n') ||
+		   (line[len-1] == '\r') || (line[len-1] == ' ') ||
+		   (line[len-1] == '\t')))
+		line[--len] = EOS;
+	    for (charP = line; (*charP == ' ') || (*charP == '\t'); ++charP)
+		;
+	    if ((*charP != EOS) && (*charP != '#'))
+		seq_pool_add(poolP, charP);
+	}
+	fclose(fP);
+	return;
+    }
+
+#if defined(MSDOS) || defined(__WATCOMC__) || defined(__TURBOC__)
+    /* The names found are without the directory of the pattern */
+    len = 0;
+    for (charP = patternP; *charP != EOS; ++charP)
+	if ((*charP == '/') || (*charP == '\\') || (*charP == ':'))
+	    len = (INT)(charP - patternP) + 1;
+    if ((len + 13 > (INT)sizeof(name)) ||
+	(_dos_findfirst(patternP, _A_NORMAL | _A_RDONLY, &find) != 0))
+	return;
+    do
+    {
+	strncpy(name, patternP, (size_t)len);
+	strcpy(name + len, find.name);
+	seq_pool_add(poolP, name);
+    }
+    while (_dos_findnext(&find) == 0);
+#else
+    if (glob(patternP, 0, NULL, &names) != 0)
+	return;
+    for (i=0; i < names.gl_pathc; ++i)
+	seq_pool_add(poolP, names.gl_pathv[i]);
+    globfree(&names);
+#endif
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_pool_add(poolP, nameP)
+  SEQ_POOL *poolP;
+  CHAR  *nameP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Add a data file to the list, once.
+
+    Notes: A name too long for a context is passed over with a message.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_add() */
+
+    CHAR  **newP;
+    INT   f;
+
+    if (strlen(nameP) >= sizeof(poolP->mainP->filename))
+    {
+	printf("File name too long: %s\n", nameP);
+	return;
+    }
+
+    for (f=0; f < poolP->files; ++f)
+	if (!strcmp(poolP->nameP[f], nameP))
+	    return;
+
+    if (poolP->files == poolP->room)
+    {
+	newP = (CHAR **)realloc((VOID *)poolP->nameP, (size_t)
+		(poolP->room + SEQ_POOL_FILES) * sizeof(CHAR *));
+	if (newP == NULL)
+	    error_handler(OUT_OF_MEMORY);
+	poolP->nameP = newP;
+	poolP->room += SEQ_POOL_FILES;
+    }
+
+    poolP->nameP[poolP->files] = (CHAR *)malloc(strlen(nameP) + 1);
+    if (poolP->nameP[poolP->files] == NULL)
+	error_handler(OUT_OF_MEMORY);
+    strcpy(poolP->nameP[poolP->files], nameP);
+    ++poolP->files;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_pool_push(poolP, workerP, taskP)
+  SEQ_POOL *poolP;
+  SEQ_POOL_WORKER *workerP;
+  SEQ_POOL_TASK *taskP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Put a task at the bottom of a thread's deque.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_push() */
+
+    SEQ_POOL_DEQUE *dequeP;
+    SEQ_POOL_TASK  *newP;
+
+    dequeP = &workerP->deque;
+    SEQ_POOL_LOCK(dequeP->lock);
+    if (dequeP->bottom == dequeP->size)
+    {
+	if (dequeP->top > 0)
+	{
+	    /* Move the tasks up into the room taken ones have left */
+	    memmove((VOID *)dequeP->taskP,
+		    (VOID *)(dequeP->taskP + dequeP->top), (size_t)
+		    (dequeP->bottom - dequeP->top) * sizeof(SEQ_POOL_TASK));
+	    dequeP->bottom -= dequeP->top;
+	    dequeP->top = 0L;
+	}
+	else
+	{
+	    newP = (SEQ_POOL_TASK *)realloc((VOID *)dequeP->taskP, (size_t)
+		    (dequeP->size + SEQ_POOL_TASKS) * sizeof(SEQ_POOL_TASK));
+	    if (newP == NULL)
+		error_handler(OUT_OF_MEMORY);
+	    dequeP->taskP = newP;
+	    dequeP->size += SEQ_POOL_TASKS;
+	}
+    }
+    dequeP->taskP[dequeP->bottom++] = *taskP;
+    SEQ_POOL_UNLOCK(dequeP->lock);
+
+    SEQ_POOL_LOCK(poolP->lock);
+    ++poolP->queued;
+    ++poolP->outstanding;
+#ifdef SEQ_POOL_THREADS
+    pthread_cond_signal(&poolP->cond);
+#endif /* SEQ_POOL_THREADS */
+    SEQ_POOL_UNLOCK(poolP->lock);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_pool_get(dequeP, taskP, oldest)
+  SEQ_POOL_DEQUE *dequeP;
+  SEQ_POOL_TASK  *taskP;
+  BOOL  oldest;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Take a task out of a deque.
+
+    Inputs: oldest = TRUE to take it from the top (another thread's
+		     deque), FALSE from the bottom (the thread's own)
+
+    Outputs: TRUE if there was one, in *taskP
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_get() */
+
+    BOOL  got;
+
+    SEQ_POOL_LOCK(dequeP->lock);
+    got = (dequeP->top < dequeP->bottom);
+    if (got == TRUE)
+    {
+	if (oldest == TRUE)
+	    *taskP = dequeP->taskP[dequeP->top++];
+	else
+	    *taskP = dequeP->taskP[--dequeP->bottom];
+	if (dequeP->top == dequeP->bottom)
+	    dequeP->top = dequeP->bottom = 0L;
+    }
+    SEQ_POOL_UNLOCK(dequeP->lock);
+
+    return (got);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_pool_take(poolP, workerP, taskP)
+  SEQ_POOL *poolP;
+  SEQ_POOL_WORKER *workerP;
+  SEQ_POOL_TASK *taskP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Find a thread its next task: its own newest, or else the
+		oldest of the next thread that has one.
+
+    Outputs: TRUE if there is one, in *taskP; FALSE when every task is
+		done
+
+    Notes: A thread that finds none waits until a task is made or the
+	   last one is done; a task being run may still make more.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_take() */
+
+    SEQ_POOL_WORKER *victimP;
+    BOOL  done;
+    INT   n;
+
+    for (;;)
+    {
+	if (seq_pool_get(&workerP->deque, taskP, FALSE) == TRUE)
+	    break;
+
+	for (n=1; n < poolP->workers; ++n)
+	{
+	    victimP = &poolP->worker[(workerP->id + n) % poolP->workers];
+	    if (seq_pool_get(&victimP->deque, taskP, TRUE) == TRUE)
+	    {
+		++workerP->stolen;
+		break;
+	    }
+	}
+	if (n < poolP->workers)
+	    break;
+
+	SEQ_POOL_LOCK(poolP->lock);
+#ifdef SEQ_POOL_THREADS
+	while ((poolP->queued == 0) && (poolP->outstanding > 0))
+	    pthread_cond_wait(&poolP->cond, &poolP->lock);
+#endif /* SEQ_POOL_THREADS */
+	done = (poolP->outstanding == 0);
+	SEQ_POOL_UNLOCK(poolP->lock);
+	if (done == TRUE)
+	    return (FALSE);
+    }
+
+    SEQ_POOL_LOCK(poolP->lock);
+    --poolP->queued;
+    SEQ_POOL_UNLOCK(poolP->lock);
+
+    return (TRUE);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID *seq_pool_worker(argP)
+  VOID  *argP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: A thread of the pool: run tasks until all are done.
+
+    Inputs: argP = the thread's SEQ_POOL_WORKER
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_worker() */
+
+    SEQ_POOL_WORKER *workerP;
+    SEQ_POOL *poolP;
+    SEQ_POOL_TASK task;
+
+    workerP = (SEQ_POOL_WORKER *)argP;
+    poolP = workerP->poolP;
+
+    while (seq_pool_take(poolP, workerP, &task) == TRUE)
+    {
+	seq_pool_task(poolP, workerP, &task);
+
+	SEQ_POOL_LOCK(poolP->lock);
+	if (--poolP->outstanding == 0)
+	{
+#ifdef SEQ_POOL_THREADS
+	    pthread_cond_broadcast(&poolP->cond);
+#endif /* SEQ_POOL_THREADS */
+	}
+	SEQ_POOL_UNLOCK(poolP->lock);
+    }
+
+    seq_pool_close(workerP);
+    return (NULL);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_pool_task(poolP, workerP, taskP)
+  SEQ_POOL *poolP;
+  SEQ_POOL_WORKER *workerP;
+  SEQ_POOL_TASK *taskP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Run a task in the context of its data file.
+
+    Notes: A data file that could not be opened or translated (SEQ_Exit())
+	   is given up; its other tasks are then passed over.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_task() */
+
+    jmp_buf jump;
+    BOOL  failed;
+    LONG  segs;
+    BYTE  p,c;
+
+    SEQ_POOL_LOCK(poolP->lock);
+    failed = poolP->failedP[taskP->file];
+    SEQ_POOL_UNLOCK(poolP->lock);
+    if (failed == TRUE)
+	return;
+
+    ++workerP->tasks;
+    SEQ_jumpP = (VOID *)jump;
+    if (setjmp(jump) != 0)
+    {
+	SEQ_jumpP = NULL;
+	seq_pool_close(workerP);
+	seq_pool_fail(poolP, taskP->file);
+	return;
+    }
+
+    if (((workerP->ctxP == NULL) || (workerP->file != taskP->file)) &&
+	(seq_pool_open(poolP, workerP, taskP->file) == FALSE))
+    {
+	SEQ_jumpP = NULL;
+	seq_pool_close(workerP);
+	seq_pool_fail(poolP, taskP->file);
+	return;
+    }
+
+    if (taskP->plan == TRUE)
+	seq_pool_plan(poolP, workerP, taskP->file);
+    else
+    {
+	p = taskP->plugin;
+	c = taskP->channel;
+	seq_pool_select(poolP, taskP);
+	SEQ_Read_Segment_Number(SEQ_ctxP->seq_fP, p, SEQ_ALL_SEGS);
+
+	/* A trace file was numbered for each segment translated */
+	segs = (LONG)SEQ_file_ext[p][c] + 1L - taskP->before;
+	workerP->segs += segs;
+	workerP->bytes += (DOUBLE)segs * (DOUBLE)SEQ_ctxP->array_size[p];
+    }
+
+    SEQ_jumpP = NULL;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static BOOL seq_pool_open(poolP, workerP, file)
+  SEQ_POOL *poolP;
+  SEQ_POOL_WORKER *workerP;
+  INT   file;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Open a data file in a context of the thread's own, closing
+		the one it had open.
+
+    Outputs: TRUE if it is open; the context is current
+
+    Notes: The options are those given, without the ones that do not
+	   go with -b, and with the packet index and segment directory
+	   built if there are none (-i).
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_open() */
+
+    SEQ_CONTEXT *ctxP;
+
+    seq_pool_close(workerP);
+
+    /* The main context has the options and no data file open */
+    SEQ_ctxP = poolP->mainP;
+    if ((ctxP = SEQ_Context_Copy()) == NULL)
+	error_handler(OUT_OF_MEMORY);
+    SEQ_ctxP = ctxP;
+    workerP->ctxP = ctxP;
+    workerP->file = file;
+
+    SEQ_options.debug = FALSE;
+    SEQ_options.test_mode = FALSE;
+    SEQ_options.print_times = FALSE;
+    SEQ_options.print_coeffs = FALSE;
+    SEQ_options.stream = FALSE;
+    SEQ_options.resume = FALSE;
+    SEQ_options.build_index = TRUE;
+    SEQ_options.jobs = 1;
+    SEQ_options.pipeline = FALSE;
+
+    strcpy(ctxP->filename, poolP->nameP[file]);
+    SEQ_Sidecar_Name(ctxP->filename, SEQ_POOL_EXT, ctxP->out_dir,
+					(INT)sizeof(ctxP->out_dir));
+    (VOID)SEQ_MKDIR(ctxP->out_dir);
+
+    return (SEQ_Start(ctxP->filename, FALSE));
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_pool_close(workerP)
+  SEQ_POOL_WORKER *workerP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Close the data file a thread has open, if any.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_close() */
+
+    if (workerP->ctxP == NULL)
+	return;
+
+    SEQ_ctxP = workerP->ctxP;
+    SEQ_Stop();
+    SEQ_Context_Free(workerP->ctxP);
+    workerP->ctxP = NULL;
+    workerP->file = -1;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_pool_fail(poolP, file)
+  SEQ_POOL *poolP;
+  INT   file;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Give up a data file, and say so the first time.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_fail() */
+
+    SEQ_POOL_LOCK(poolP->lock);
+    if (poolP->failedP[file] == FALSE)
+    {
+	poolP->failedP[file] = TRUE;
+	fprintf(stderr, "%s: given up\n", poolP->nameP[file]);
+    }
+    SEQ_POOL_UNLOCK(poolP->lock);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_pool_plan(poolP, workerP, file)
+  SEQ_POOL *poolP;
+  SEQ_POOL_WORKER *workerP;
+  INT   file;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Make the tasks that translate the data file open in the
+		current context.
+
+    Notes: The tasks go on the thread's own deque, the first ones last
+	   so that it goes through a channel from the start, while the
+	   other threads take the last ones.
+
+	   Segments past the segment directory (the last one, still being
+	   written when the file was closed) are left to the last task of
+	   a channel, which carries on as SEQ_interpret() would.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_plan() */
+
+    SEQ_OPTIONS   *optP;
+    SEQ_POOL_TASK task;
+    SEQ_POOL_TASK *chunkP;
+    SEQ_POOL_TASK *newP;
+    SEGS  *segP;
+    LONG  count;
+    LONG  per;
+    LONG  selected;
+    LONG  end;
+    LONG  k;
+    INT   chunks;
+    INT   room;
+    BYTE  p,c;
+
+    optP = &poolP->mainP->options;
+
+    /* The plugins and channels asked for must have been acquired */
+    for (p=0; p < MAX_PLUGINS; ++p)
+    {
+	if ((plugin_field & (1 << p)) && ((p < SEQ_params.first_plugin) ||
+					  (p > SEQ_params.last_plugin)))
+	{
+	    fprintf(stderr, "%s: Plugin %c never acquired.\n",
+					    poolP->nameP[file], p+'A');
+	    EXIT
+	}
+	for (c=0; c < MAX_CHANNELS; ++c)
+	{
+	    if ((channel_field[p] & (1 << c)) &&
+		(c > SEQ_params.last_channel[p]))
+	    {
+		fprintf(stderr, "%s: Channel %d never acquired.\n",
+					    poolP->nameP[file], c+1);
+		EXIT
+	    }
+	}
+    }
+
+    chunkP = NULL;
+    room = 0;
+    task.file = file;
+    task.plan = FALSE;
+    for (p=SEQ_params.first_plugin; p <= SEQ_params.last_plugin; ++p)
+    {
+	for (c=0; c <= SEQ_params.last_channel[p]; ++c)
+	{
+	    segP = optP->seg[p][c][SEQ_SEGNO];
+	    if ((optP->all_segs[p][c] == FALSE) &&
+		(segP->select.n.start == -1L) &&
+		(optP->seg[p][c][SEQ_TIME][0].select.t.start == (DOUBLE)-1))
+		continue;
+
+	    ++workerP->channels;
+	    task.plugin = p;
+	    task.channel = c;
+	    task.first = 1L;
+	    task.last = -1L;
+	    task.before = 0L;
+
+	    /* In one piece without a directory, or selected by time */
+	    count = SEQ_Dir_Count((INT)p);
+	    if ((count < 0L) ||
+		(optP->seg[p][c][SEQ_TIME][0].select.t.start != (DOUBLE)-1))
+	    {
+		task.whole = TRUE;
+		seq_pool_push(poolP, workerP, &task);
+		continue;
+	    }
+	    task.whole = FALSE;
+
+	    /* Cut the segments selected into runs of SEQ_POOL_BYTES */
+	    per = SEQ_POOL_BYTES / SEQ_ctxP->array_size[p];
+	    if (per < 1L)
+		per = 1L;
+	    chunks = 0;
+	    selected = 0L;
+	    for (k=1L; k <= count; ++k)
+	    {
+		if (optP->all_segs[p][c] == FALSE)
+		{
+		    while ((segP->select.n.start != -1L) &&
+			   (k > segP->select.n.end))
+			++segP;
+		    if (segP->select.n.start == -1L)
+			break;
+		    if (k < segP->select.n.start)
+		    {
+			k = segP->select.n.start - 1L;
+			continue;
+		    }
+		}
+
+		if (selected % per == 0L)
+		{
+		    if (chunks == room)
+		    {
+			newP = (SEQ_POOL_TASK *)realloc((VOID *)chunkP,
+			    (size_t)(room + SEQ_POOL_TASKS) *
+						sizeof(SEQ_POOL_TASK));
+			if (newP == NULL)
+			    error_handler(OUT_OF_MEMORY);
+			chunkP = newP;
+			room += SEQ_POOL_TASKS;
+		    }
+		    chunkP[chunks] = task;
+		    chunkP[chunks].first = k;
+		    chunkP[chunks].before = selected;
+		    ++chunks;
+		}
+		chunkP[chunks-1].last = k;
+		++selected;
+	    }
+
+	    /* Any segment selected past the directory */
+	    end = (optP->all_segs[p][c] == TRUE) ? SEQ_POOL_END : 0L;
+	    for (segP = optP->seg[p][c][SEQ_SEGNO];
+		 segP->select.n.start != -1L; ++segP)
+		if (segP->select.n.end > end)
+		    end = segP->select.n.end;
+	    if (end > count)
+	    {
+		if (chunks == 0)
+		{
+		    task.first = count + 1L;
+		    task.before = selected;
+		    seq_pool_push(poolP, workerP, &task);
+		    continue;
+		}
+		chunkP[chunks-1].last = -1L;
+	    }
+
+	    while (--chunks >= 0)
+		seq_pool_push(poolP, workerP, &chunkP[chunks]);
+	}
+    }
+    free(chunkP);
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static VOID seq_pool_select(poolP, taskP)
+  SEQ_POOL *poolP;
+  SEQ_POOL_TASK *taskP;
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Select the segments of a task, and only those, in the
+		current context, as SEQ_Decode() does.
+
+    Notes: The trace files are numbered on from the segments selected
+	   before the task's first.
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_select() */
+
+    SEQ_OPTIONS *optP;
+    SEGS  *fromP;
+    SEGS  *toP;
+    LONG  last;
+    BYTE  p,c;
+    BYTE  t;
+
+    optP = &poolP->mainP->options;
+    for (p=0; p < MAX_PLUGINS; ++p)
+	for (c=0; c < MAX_CHANNELS; ++c)
+	{
+	    SEQ_options.all_segs[p][c] = FALSE;
+	    for (t=0; t < MAX_SEG_TYPES; ++t)
+	    {
+		toP = SEQ_options.seg[p][c][t];
+		toP->select.n.start = -1L;
+		toP->select.n.end = -1L;
+		if (t == SEQ_TIME)
+		{
+		    toP->select.t.start = (DOUBLE)-1;
+		    toP->select.t.end = (DOUBLE)-1;
+		}
+		SEQ_ctxP->check_index[p][c][t] = 0;
+	    }
+	}
+
+    p = taskP->plugin;
+    c = taskP->channel;
+    if (taskP->whole == TRUE)
+    {
+	SEQ_options.all_segs[p][c] = optP->all_segs[p][c];
+	memcpy((VOID *)SEQ_options.seg[p][c], (VOID *)optP->seg[p][c],
+					    sizeof(SEQ_options.seg[p][c]));
+    }
+    else
+    {
+	last = (taskP->last < 0L) ? SEQ_POOL_END : taskP->last;
+	toP = SEQ_options.seg[p][c][SEQ_SEGNO];
+	if (optP->all_segs[p][c] == TRUE)
+	{
+	    toP->select.n.start = taskP->first;
+	    toP->select.n.end = last;
+	    ++toP;
+	}
+	else
+	{
+	    for (fromP = optP->seg[p][c][SEQ_SEGNO];
+		 fromP->select.n.start != -1L; ++fromP)
+	    {
+		if ((fromP->select.n.end < taskP->first) ||
+		    (fromP->select.n.start > last))
+		    continue;
+		toP->select.n.start = (fromP->select.n.start > taskP->first) ?
+				    fromP->select.n.start : taskP->first;
+		toP->select.n.end = (fromP->select.n.end < last) ?
+				    fromP->select.n.end : last;
+		++toP;
+	    }
+	}
+	toP->select.n.start = -1L;
+	toP->select.n.end = -1L;
+    }
+
+    SEQ_file_ext[p][c] = (WORD)(taskP->before - 1L);
+    SEQ_ctxP->old_segno[p][c] = -1L;
+}
+
+/*XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX*/
+
+static DOUBLE seq_pool_clock()
+
+/*--------------------------------------------------------------------------
+
+    Purpose: Time on the wall clock, for the rate of the translation.
+
+    Outputs: seconds, to a fraction of one with POSIX threads, else
+		whole ones
+
+/CODE
+--------------------------------------------------------------------------*/
+{   /* seq_pool_clock() */
+
+#ifdef SEQ_POOL_THREADS
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((DOUBLE)now.tv_sec + (DOUBLE)now.tv_nsec / 1.0e9);
+#else
+    return ((DOUBLE)time(NULL));
+#endif /* SEQ_POOL_THREADS */
+}